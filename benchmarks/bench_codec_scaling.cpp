@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Benchmarks of encoding commands and decoding events for several adapters in parallel, one
+// thread per adapter, built for each SoftDevice API version
+
+#include "app_ble_gap.h"
+#include "ble.h"
+#include "ble_app.h"
+#include "ble_common.h"
+#include "ble_gap_app.h"
+#include "nrf_error.h"
+#include "serialization_transport.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+const int MaxAdapters = 8;
+
+const uint16_t NotificationLength = 20;
+const uint16_t ConnHandle         = 0x0001;
+
+// GAP states the adapters encode and decode with, in the driver each adapter has its own
+adapter_ble_gap_state_t *gapStates[MaxAdapters];
+
+void createGapStates()
+{
+    static const auto errorCode = [] {
+        for (auto &gapState : gapStates)
+        {
+            gapState = app_ble_gap_state_create();
+        }
+
+        return NRF_SUCCESS;
+    }();
+    (void)errorCode;
+}
+
+void put_u16(std::vector<uint8_t> &buffer, const uint16_t value)
+{
+    buffer.push_back(static_cast<uint8_t>(value));
+    buffer.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+// Encoded BLE_GATTC_EVT_HVX event as received from the connectivity firmware
+std::vector<uint8_t> hvx()
+{
+    std::vector<uint8_t> packet;
+    put_u16(packet, BLE_GATTC_EVT_HVX);
+    put_u16(packet, ConnHandle);
+    put_u16(packet, BLE_GATT_STATUS_SUCCESS);
+    put_u16(packet, 0); // Error handle
+    put_u16(packet, 0x000E);
+    packet.push_back(BLE_GATT_HVX_NOTIFICATION);
+    put_u16(packet, NotificationLength);
+    packet.insert(packet.end(), NotificationLength, 0x5A);
+    return packet;
+}
+
+// Each thread is an adapter encoding a command and decoding an event per iteration, as the
+// thread calling the command and the event thread of the adapter do. Adapters do not share any
+// codec state, throughput is expected to scale with the number of threads.
+void BM_codec_adapters(benchmark::State &state)
+{
+    if (state.thread_index() == 0)
+    {
+        createGapStates();
+    }
+
+    const auto gapState = gapStates[state.thread_index()];
+
+    const auto event  = hvx();
+    const auto length = static_cast<uint32_t>(event.size());
+    std::vector<uint32_t> decodeBuffer(MaxEventLength / sizeof(uint32_t) + 1);
+    const auto decoded = reinterpret_cast<ble_evt_t *>(decodeBuffer.data());
+
+    const ble_gap_conn_params_t connParams{BLE_GAP_CP_MIN_CONN_INTVL_MIN,
+                                           BLE_GAP_CP_MIN_CONN_INTVL_MIN, 0, 400};
+    uint8_t command[64];
+
+    for (auto _ : state)
+    {
+        {
+            RequestReplyCodecContext context(gapState);
+            uint32_t commandLength = sizeof(command);
+
+            if (ble_gap_conn_param_update_req_enc(ConnHandle, &connParams, command,
+                                                  &commandLength) != NRF_SUCCESS)
+            {
+                state.SkipWithError("Failed to encode command");
+                break;
+            }
+
+            benchmark::DoNotOptimize(command);
+        }
+
+        {
+            EventCodecContext context(gapState);
+            auto decodedLength = MaxEventLength;
+
+            if (ble_event_dec(event.data(), length, decoded, &decodedLength) != NRF_SUCCESS)
+            {
+                state.SkipWithError("Failed to decode event");
+                break;
+            }
+
+            benchmark::DoNotOptimize(decoded->header.evt_id);
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+    state.SetLabel("sd_api_v" + std::to_string(NRF_SD_BLE_API_VERSION));
+}
+
+BENCHMARK(BM_codec_adapters)->ThreadRange(1, MaxAdapters)->UseRealTime();
+
+} // namespace
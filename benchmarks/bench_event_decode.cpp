@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Benchmarks of decoding the most frequent events, built for each SoftDevice API version
+
+#include "app_ble_gap.h"
+#include "ble.h"
+#include "ble_app.h"
+#include "ble_common.h"
+#include "ble_hci.h"
+#include "nrf_error.h"
+#include "serialization_transport.h"
+
+#include <benchmark/benchmark.h>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace {
+
+const uint8_t AdvertisingDataLength = 31;
+const uint16_t NotificationLength   = 20;
+const uint16_t ConnHandle           = 0x0001;
+
+#if NRF_SD_BLE_API_VERSION >= 6
+uint8_t scanBuffer[BLE_GAP_SCAN_BUFFER_MIN];
+#endif
+
+// An encoded event as received from the connectivity firmware, without the packet type
+struct Event
+{
+    std::vector<uint8_t> packet;
+
+    // The event is stored in the scan buffer the application provides when resuming scanning
+    bool usesScanBuffer;
+};
+
+struct Encoder
+{
+    std::vector<uint8_t> &buffer;
+
+    void u8(const uint8_t value)
+    {
+        buffer.push_back(value);
+    }
+
+    void u16(const uint16_t value)
+    {
+        u8(static_cast<uint8_t>(value));
+        u8(static_cast<uint8_t>(value >> 8));
+    }
+
+    void u32(const uint32_t value)
+    {
+        u16(static_cast<uint16_t>(value));
+        u16(static_cast<uint16_t>(value >> 16));
+    }
+
+    void bytes(const uint8_t value, const size_t count)
+    {
+        buffer.insert(buffer.end(), count, value);
+    }
+
+    void address()
+    {
+#if NRF_SD_BLE_API_VERSION == 2
+        u8(BLE_GAP_ADDR_TYPE_RANDOM_STATIC);
+#else
+        u8(BLE_GAP_ADDR_TYPE_RANDOM_STATIC << 1);
+#endif
+        bytes(0xC0, BLE_GAP_ADDR_LEN);
+    }
+
+    void connParams()
+    {
+        u16(BLE_GAP_CP_MIN_CONN_INTVL_MIN);
+        u16(BLE_GAP_CP_MIN_CONN_INTVL_MIN);
+        u16(0);   // Slave latency
+        u16(400); // Supervision timeout
+    }
+};
+
+// GAP state the events are decoded with, in the driver each adapter has its own
+adapter_ble_gap_state_t *decodeGapState()
+{
+    static const auto gapState = app_ble_gap_state_create();
+    return gapState;
+}
+
+Event advReport()
+{
+    Event event{{}, false};
+    Encoder encoder{event.packet};
+    encoder.u16(BLE_GAP_EVT_ADV_REPORT);
+    encoder.u16(BLE_CONN_HANDLE_INVALID);
+
+#if NRF_SD_BLE_API_VERSION >= 6
+    int scanBufferId;
+
+    {
+        RequestReplyCodecContext context(decodeGapState());
+        scanBufferId = app_ble_gap_adv_buf_register(scanBuffer);
+    }
+
+    event.usesScanBuffer = true;
+    encoder.u16(0x0003); // Connectable and scannable, complete
+    encoder.address();
+    encoder.address();
+    encoder.u8(BLE_GAP_PHY_1MBPS);
+    encoder.u8(BLE_GAP_PHY_NOT_SET);
+    encoder.u8(static_cast<uint8_t>(BLE_GAP_POWER_LEVEL_INVALID));
+    encoder.u8(static_cast<uint8_t>(-60)); // RSSI
+    encoder.u8(37);                        // Channel index
+    encoder.u8(BLE_GAP_ADV_REPORT_SET_ID_NOT_AVAILABLE);
+    encoder.u16(0); // Data id
+    encoder.u32(static_cast<uint32_t>(scanBufferId));
+    encoder.u16(AdvertisingDataLength);
+    encoder.u8(1); // Data present
+    encoder.bytes(0xAD, AdvertisingDataLength);
+    encoder.u16(0); // Aux pointer offset
+    encoder.u8(0);  // Aux pointer PHY
+#elif NRF_SD_BLE_API_VERSION >= 3
+    encoder.address();
+    encoder.address();
+    encoder.u8(static_cast<uint8_t>(-60)); // RSSI
+    encoder.u8(0);                         // Connectable undirected, not a scan response
+    encoder.u8(AdvertisingDataLength);
+    encoder.u8(1); // Data present
+    encoder.bytes(0xAD, AdvertisingDataLength);
+#else
+    encoder.address();
+    encoder.u8(static_cast<uint8_t>(-60)); // RSSI
+    encoder.u8(AdvertisingDataLength << 3);
+    encoder.bytes(0xAD, AdvertisingDataLength);
+#endif
+
+    return event;
+}
+
+Event connected()
+{
+    Event event{{}, false};
+    Encoder encoder{event.packet};
+    encoder.u16(BLE_GAP_EVT_CONNECTED);
+    encoder.u16(ConnHandle);
+    encoder.address();
+#if NRF_SD_BLE_API_VERSION == 2
+    encoder.address(); // Own address
+#endif
+    encoder.u8(BLE_GAP_ROLE_CENTRAL);
+#if NRF_SD_BLE_API_VERSION == 2
+    encoder.u8(0); // No IRK match
+#endif
+    encoder.connParams();
+#if NRF_SD_BLE_API_VERSION >= 6
+    encoder.u8(BLE_GAP_ADV_SET_HANDLE_NOT_SET);
+
+    // No advertising and scan response data buffers
+    for (auto i = 0; i < 2; i++)
+    {
+        encoder.u32(0);
+        encoder.u16(0);
+        encoder.u8(0);
+    }
+#endif
+
+    return event;
+}
+
+Event disconnected()
+{
+    Event event{{}, false};
+    Encoder encoder{event.packet};
+    encoder.u16(BLE_GAP_EVT_DISCONNECTED);
+    encoder.u16(ConnHandle);
+    encoder.u8(BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+    return event;
+}
+
+Event hvx()
+{
+    Event event{{}, false};
+    Encoder encoder{event.packet};
+    encoder.u16(BLE_GATTC_EVT_HVX);
+    encoder.u16(ConnHandle);
+    encoder.u16(BLE_GATT_STATUS_SUCCESS);
+    encoder.u16(0); // Error handle
+    encoder.u16(0x000E);
+    encoder.u8(BLE_GATT_HVX_NOTIFICATION);
+    encoder.u16(NotificationLength);
+    encoder.bytes(0x5A, NotificationLength);
+    return event;
+}
+
+// Decodes the event as the event thread of the driver does, in the event codec context
+void BM_ble_event_dec(benchmark::State &state, Event (*createEvent)())
+{
+    const auto event = createEvent();
+    const auto length = static_cast<uint32_t>(event.packet.size());
+    std::vector<uint32_t> decodeBuffer(MaxEventLength / sizeof(uint32_t) + 1);
+    const auto decoded = reinterpret_cast<ble_evt_t *>(decodeBuffer.data());
+
+    for (auto _ : state)
+    {
+#if NRF_SD_BLE_API_VERSION >= 6
+        // The application provides the scan buffer again for the next report
+        if (event.usesScanBuffer)
+        {
+            RequestReplyCodecContext context(decodeGapState());
+            app_ble_gap_adv_buf_register(scanBuffer);
+        }
+#endif
+
+        EventCodecContext context(decodeGapState());
+        auto decodedLength = MaxEventLength;
+
+        if (ble_event_dec(event.packet.data(), length, decoded, &decodedLength) != NRF_SUCCESS)
+        {
+            state.SkipWithError("Failed to decode event");
+            break;
+        }
+
+        benchmark::DoNotOptimize(decoded->header.evt_id);
+    }
+
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * length);
+    state.SetLabel("sd_api_v" + std::to_string(NRF_SD_BLE_API_VERSION));
+}
+
+BENCHMARK_CAPTURE(BM_ble_event_dec, BLE_GAP_EVT_ADV_REPORT, advReport);
+BENCHMARK_CAPTURE(BM_ble_event_dec, BLE_GAP_EVT_CONNECTED, connected);
+BENCHMARK_CAPTURE(BM_ble_event_dec, BLE_GAP_EVT_DISCONNECTED, disconnected);
+BENCHMARK_CAPTURE(BM_ble_event_dec, BLE_GATTC_EVT_HVX, hvx);
+
+} // namespace
@@ -0,0 +1,329 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// End to end benchmarks of an adapter connected to the connectivity firmware simulator of the
+// tests: opening the adapter, command round trips and event throughput
+
+// Logging support, used by the simulator
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+#include "connectivity_simulator.h"
+
+#include "ble.h"
+#include "nrf_error.h"
+#include "sd_rpc.h"
+
+#include <benchmark/benchmark.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+
+const std::chrono::seconds WaitTimeout(5);
+
+// Events received by the adapter of the running benchmark, the event handler is a plain function
+struct ReceivedEvents
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint16_t connHandle;
+    uint64_t connected;
+    uint64_t notifications;
+} received;
+
+// Asynchronous commands completed by the adapter of the running benchmark
+struct CompletedCommands
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint32_t count;
+    uint32_t failed;
+} completed;
+
+void status_handler(adapter_t *, sd_rpc_app_status_t, const char *) {}
+
+void log_handler(adapter_t *, sd_rpc_log_severity_t, const char *) {}
+
+void event_handler(adapter_t *, ble_evt_t *event)
+{
+    std::lock_guard<std::mutex> lock(received.mutex);
+
+    if (event->header.evt_id == BLE_GAP_EVT_CONNECTED)
+    {
+        received.connHandle = event->evt.gap_evt.conn_handle;
+        received.connected++;
+    }
+    else if (event->header.evt_id == BLE_GATTC_EVT_HVX)
+    {
+        received.notifications++;
+    }
+
+    received.changed.notify_all();
+}
+
+uint32_t tx_power_set_command(adapter_t *adapter, void *)
+{
+    return sd_ble_gap_tx_power_set(adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0);
+}
+
+void command_complete(adapter_t *, uint32_t result, void *)
+{
+    std::lock_guard<std::mutex> lock(completed.mutex);
+    completed.count++;
+    completed.failed += result == NRF_SUCCESS ? 0 : 1;
+    completed.changed.notify_all();
+}
+
+adapter_t *createAdapter(const std::string &path)
+{
+    const auto phy             = sd_rpc_physical_layer_create_local(path.c_str());
+    const auto data_link_layer = sd_rpc_data_link_layer_create_bt_three_wire(phy, 250);
+    const auto transport_layer = sd_rpc_transport_layer_create(data_link_layer, 1000);
+
+    return sd_rpc_adapter_create(transport_layer);
+}
+
+// Simulator and an adapter connected to it, for the duration of one benchmark run
+struct Session
+{
+    Session()
+        : simulator("/tmp/ble-driver-benchmark-" + std::to_string(getpid()))
+    {
+        {
+            std::lock_guard<std::mutex> lock(received.mutex);
+            received.connHandle    = BLE_CONN_HANDLE_INVALID;
+            received.connected     = 0;
+            received.notifications = 0;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(completed.mutex);
+            completed.count  = 0;
+            completed.failed = 0;
+        }
+
+        simulator.start();
+        adapter = createAdapter(simulator.path());
+    }
+
+    ~Session()
+    {
+        sd_rpc_close(adapter);
+        sd_rpc_adapter_delete(adapter);
+        simulator.stop();
+    }
+
+    bool open()
+    {
+        return sd_rpc_open(adapter, status_handler, event_handler, log_handler) == NRF_SUCCESS;
+    }
+
+    ConnectivitySimulator simulator;
+    adapter_t *adapter;
+};
+
+// Time to open an adapter, including the H5 link establishment
+void BM_sd_rpc_open(benchmark::State &state)
+{
+    Session session;
+
+    for (auto _ : state)
+    {
+        if (!session.open())
+        {
+            state.SkipWithError("Failed to open the adapter");
+            break;
+        }
+
+        state.PauseTiming();
+        sd_rpc_close(session.adapter);
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_sd_rpc_open)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+// Round trip time of a synchronous command
+void BM_command_round_trip(benchmark::State &state)
+{
+    Session session;
+
+    if (!session.open())
+    {
+        state.SkipWithError("Failed to open the adapter");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        if (sd_ble_gap_tx_power_set(session.adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) !=
+            NRF_SUCCESS)
+        {
+            state.SkipWithError("Command failed");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()));
+}
+BENCHMARK(BM_command_round_trip)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// Asynchronous commands queued at once, up to the size of the H5 sliding window of them wait for
+// their responses at the same time
+void BM_command_async(benchmark::State &state)
+{
+    Session session;
+
+    if (!session.open())
+    {
+        state.SkipWithError("Failed to open the adapter");
+        return;
+    }
+
+    const auto commandCount = static_cast<uint32_t>(state.range(0));
+    uint32_t expected       = 0;
+
+    for (auto _ : state)
+    {
+        uint32_t queued = 0;
+
+        while (queued < commandCount &&
+               sd_rpc_command_async(session.adapter, tx_power_set_command, command_complete,
+                                    nullptr) == NRF_SUCCESS)
+        {
+            queued++;
+        }
+
+        expected += queued;
+
+        std::unique_lock<std::mutex> lock(completed.mutex);
+
+        if (!completed.changed.wait_for(lock, WaitTimeout,
+                                        [&] { return completed.count == expected; }) ||
+            queued != commandCount || completed.failed != 0)
+        {
+            state.SkipWithError("Commands failed");
+            break;
+        }
+    }
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * commandCount);
+}
+BENCHMARK(BM_command_async)->Arg(1)->Arg(7)->Arg(64)->Unit(benchmark::kMicrosecond)->UseRealTime();
+
+// Notifications received per second on one connection, the simulator sends them as fast as the
+// link allows
+void BM_event_throughput(benchmark::State &state)
+{
+    constexpr uint64_t EventsPerIteration = 100;
+    const auto length                     = static_cast<uint16_t>(state.range(0));
+
+    Session session;
+
+    if (!session.open())
+    {
+        state.SkipWithError("Failed to open the adapter");
+        return;
+    }
+
+    ble_gap_addr_t peer          = {};
+    ble_gap_scan_params_t scan   = {};
+    ble_gap_conn_params_t params = {};
+    scan.interval                = 0x00A0;
+    scan.window                  = 0x0050;
+    scan.scan_phys               = BLE_GAP_PHY_1MBPS;
+    params.min_conn_interval     = BLE_GAP_CP_MIN_CONN_INTVL_MIN;
+    params.max_conn_interval     = BLE_GAP_CP_MIN_CONN_INTVL_MIN;
+    params.conn_sup_timeout      = 400;
+
+    if (sd_ble_gap_connect(session.adapter, &peer, &scan, &params, BLE_CONN_CFG_TAG_DEFAULT) !=
+        NRF_SUCCESS)
+    {
+        state.SkipWithError("Failed to connect");
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock(received.mutex);
+
+        if (!received.changed.wait_for(lock, WaitTimeout, [] { return received.connected > 0; }))
+        {
+            state.SkipWithError("No connection");
+            return;
+        }
+    }
+
+    session.simulator.setNotificationRate(ConnectivitySimulator::Unlimited, length);
+
+    uint64_t start;
+
+    {
+        std::lock_guard<std::mutex> lock(received.mutex);
+        start = received.notifications;
+    }
+
+    uint64_t expected = start;
+
+    for (auto _ : state)
+    {
+        expected += EventsPerIteration;
+
+        std::unique_lock<std::mutex> lock(received.mutex);
+
+        if (!received.changed.wait_for(lock, WaitTimeout,
+                                       [&] { return received.notifications >= expected; }))
+        {
+            state.SkipWithError("Notifications stopped");
+            break;
+        }
+    }
+
+    session.simulator.setNotificationRate(0);
+
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * EventsPerIteration));
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * EventsPerIteration) *
+                            length);
+}
+BENCHMARK(BM_event_throughput)->Arg(20)->Arg(244)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+} // namespace
@@ -0,0 +1,331 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Benchmarks of the transport layer hot paths, the code is common to all SoftDevice API versions
+
+#include "crc16.h"
+#include "h5.h"
+#include "h5_transport.h"
+#include "nrf_error.h"
+#include "slip.h"
+#include "transport.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Packet lengths from a short command to the largest serialization packet
+#if NRF_SD_BLE_API == 2
+const int SerializationMaxPacketSize = 512;
+#else
+const int SerializationMaxPacketSize = 768;
+#endif
+
+void packetLengths(benchmark::internal::Benchmark *benchmark)
+{
+    for (const auto length : {4, 16, 64, 256, SerializationMaxPacketSize})
+    {
+        benchmark->Arg(length);
+    }
+}
+
+// Deterministic data, contains SLIP END and ESC bytes at the rate random data has them
+std::vector<uint8_t> randomData(const size_t length)
+{
+    std::vector<uint8_t> data(length);
+    uint32_t seed = 0xC0FFEE;
+
+    for (auto &byte : data)
+    {
+        seed = seed * 1103515245 + 12345;
+        byte = static_cast<uint8_t>(seed >> 16);
+    }
+
+    return data;
+}
+
+void setBytesProcessed(benchmark::State &state, const int64_t bytesPerIteration)
+{
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations()) * bytesPerIteration);
+}
+
+void BM_slip_encode(benchmark::State &state)
+{
+    const auto packet = randomData(static_cast<size_t>(state.range(0)));
+    std::vector<uint8_t> encoded;
+
+    for (auto _ : state)
+    {
+        encoded.clear();
+        slip_encode(packet, encoded);
+        benchmark::DoNotOptimize(encoded.data());
+    }
+
+    setBytesProcessed(state, state.range(0));
+}
+BENCHMARK(BM_slip_encode)->Apply(packetLengths);
+
+void BM_slip_decode(benchmark::State &state)
+{
+    std::vector<uint8_t> encoded;
+    slip_encode(randomData(static_cast<size_t>(state.range(0))), encoded);
+    std::vector<uint8_t> decoded;
+
+    for (auto _ : state)
+    {
+        decoded.clear();
+        benchmark::DoNotOptimize(slip_decode(encoded, decoded));
+        benchmark::DoNotOptimize(decoded.data());
+    }
+
+    setBytesProcessed(state, state.range(0));
+}
+BENCHMARK(BM_slip_decode)->Apply(packetLengths);
+
+void BM_h5_encode(benchmark::State &state)
+{
+    const auto payload = randomData(static_cast<size_t>(state.range(0)));
+    std::vector<uint8_t> packet;
+
+    for (auto _ : state)
+    {
+        packet.clear();
+        h5_encode(payload, packet, 3, 5, true, true, VENDOR_SPECIFIC_PACKET);
+        benchmark::DoNotOptimize(packet.data());
+    }
+
+    setBytesProcessed(state, state.range(0));
+}
+BENCHMARK(BM_h5_encode)->Apply(packetLengths);
+
+// The single pass H5 and SLIP encoding H5Transport sends packets with
+void BM_h5_slip_encode(benchmark::State &state)
+{
+    const auto payload = randomData(static_cast<size_t>(state.range(0)));
+    std::vector<uint8_t> packet;
+
+    for (auto _ : state)
+    {
+        h5_slip_encode(payload.data(), payload.size(), packet, 3, 5, true, true,
+                       VENDOR_SPECIFIC_PACKET);
+        benchmark::DoNotOptimize(packet.data());
+    }
+
+    setBytesProcessed(state, state.range(0));
+}
+BENCHMARK(BM_h5_slip_encode)->Apply(packetLengths);
+
+void BM_h5_decode(benchmark::State &state)
+{
+    std::vector<uint8_t> packet;
+    h5_encode(randomData(static_cast<size_t>(state.range(0))), packet, 3, 5, true, true,
+              VENDOR_SPECIFIC_PACKET);
+
+    const uint8_t *payload = nullptr;
+    uint8_t seqNum;
+    uint8_t ackNum;
+    uint16_t payloadLength;
+    bool reliable;
+    h5_pkt_type_t type;
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(h5_decode(packet.data(), packet.size(), &payload, &seqNum,
+                                           &ackNum, nullptr, &payloadLength, nullptr, &reliable,
+                                           &type));
+        benchmark::DoNotOptimize(payload);
+    }
+
+    setBytesProcessed(state, state.range(0));
+}
+BENCHMARK(BM_h5_decode)->Apply(packetLengths);
+
+void BM_calculate_crc16_checksum(benchmark::State &state)
+{
+    const auto data = randomData(static_cast<size_t>(state.range(0)) + H5_HEADER_LENGTH);
+
+    for (auto _ : state)
+    {
+        benchmark::DoNotOptimize(crc16_calculate(data.data(), data.data() + data.size()));
+    }
+
+    setBytesProcessed(state, static_cast<int64_t>(data.size()));
+}
+BENCHMARK(BM_calculate_crc16_checksum)->Apply(packetLengths);
+
+// Lower transport of H5Transport answering the link establishment like the connectivity firmware
+// does. Data is given to H5Transport with receive().
+class LinkPeer : public Transport
+{
+  public:
+    uint32_t close() override
+    {
+        std::lock_guard<std::mutex> lock(responsesMutex);
+
+        for (auto &response : responses)
+        {
+            response.wait();
+        }
+
+        responses.clear();
+        return NRF_SUCCESS;
+    }
+
+    uint32_t send(const std::vector<uint8_t> &data) override
+    {
+        // Only link control packets are answered, skip the decoding of ACK packets
+        if (data.size() < 3 || (data[2] & 0x0F) != LINK_CONTROL_PACKET)
+        {
+            return NRF_SUCCESS;
+        }
+
+        std::vector<uint8_t> packet;
+        std::vector<uint8_t> payload;
+        slip_decode(data, packet);
+
+        uint8_t seqNum;
+        uint8_t ackNum;
+        bool reliable;
+        h5_pkt_type_t type;
+
+        if (h5_decode(packet, payload, &seqNum, &ackNum, nullptr, nullptr, nullptr, &reliable,
+                      &type) != NRF_SUCCESS)
+        {
+            return NRF_SUCCESS;
+        }
+
+        if (H5Transport::isSyncPacket(payload))
+        {
+            respond(CONTROL_PKT_SYNC_RESPONSE);
+        }
+        else if (H5Transport::isSyncConfigPacket(payload))
+        {
+            respond(CONTROL_PKT_SYNC_CONFIG_RESPONSE);
+        }
+
+        return NRF_SUCCESS;
+    }
+
+    void receive(const uint8_t *data, const size_t length)
+    {
+        upperDataCallback(data, length);
+    }
+
+  private:
+    // The state machine holds its lock while sending, the response is received from another
+    // thread
+    void respond(const control_pkt_type type)
+    {
+        std::vector<uint8_t> response;
+        h5_slip_encode(H5Transport::getPktPattern(type).data(),
+                       H5Transport::getPktPattern(type).size(), response, 0, 0, false, false,
+                       LINK_CONTROL_PACKET);
+
+        std::lock_guard<std::mutex> lock(responsesMutex);
+        responses.push_back(std::async(std::launch::async, [this, response] {
+            receive(response.data(), response.size());
+        }));
+    }
+
+    std::mutex responsesMutex;
+    std::vector<std::future<void>> responses;
+};
+
+// H5Transport::dataHandler with reliable packets split into fragments of the given length, as
+// received from the serial port
+void BM_H5Transport_dataHandler(benchmark::State &state)
+{
+    const auto fragmentLength = static_cast<size_t>(state.range(0));
+    const size_t payloadLength = 64;
+
+    // One packet per sequence number so the stream can be received repeatedly
+    std::vector<uint8_t> stream;
+    const auto payload = randomData(payloadLength);
+
+    for (uint8_t seqNum = 0; seqNum < 8; seqNum++)
+    {
+        std::vector<uint8_t> packet;
+        h5_slip_encode(payload.data(), payload.size(), packet, seqNum, 0, true, true,
+                       VENDOR_SPECIFIC_PACKET);
+        stream.insert(stream.end(), packet.begin(), packet.end());
+    }
+
+    auto peer = new LinkPeer();
+    H5Transport h5(peer, 250);
+    uint64_t packetsReceived = 0;
+
+    const auto errorCode = h5.open([](const sd_rpc_app_status_t, const std::string &) {},
+                                   [&packetsReceived](const uint8_t *, const size_t) {
+                                       packetsReceived++;
+                                   },
+                                   [](const sd_rpc_log_severity_t, const std::string &) {});
+
+    if (errorCode != NRF_SUCCESS)
+    {
+        state.SkipWithError("Failed to open H5Transport");
+        return;
+    }
+
+    for (auto _ : state)
+    {
+        for (size_t offset = 0; offset < stream.size(); offset += fragmentLength)
+        {
+            peer->receive(stream.data() + offset, std::min(fragmentLength, stream.size() - offset));
+        }
+    }
+
+    h5.close();
+
+    if (packetsReceived != static_cast<uint64_t>(state.iterations()) * 8)
+    {
+        state.SkipWithError("Packets were dropped");
+    }
+
+    setBytesProcessed(state, static_cast<int64_t>(stream.size()));
+    state.counters["packets"] =
+        benchmark::Counter(static_cast<double>(packetsReceived), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_H5Transport_dataHandler)->Arg(1)->Arg(16)->Arg(64)->Arg(256)->UseRealTime();
+
+} // namespace
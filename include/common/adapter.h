@@ -62,6 +62,11 @@ typedef struct
     void *internal;
 } physical_layer_t;
 
+typedef struct
+{
+    void *internal;
+} sd_rpc_runtime_t;
+
 #ifdef __cplusplus
 }
 #endif
@@ -38,40 +38,81 @@
 #ifndef ADAPTER_INTERNAL_H__
 #define ADAPTER_INTERNAL_H__
 
+#include "app_ble_gap.h"
+#include "buffer_pool.h"
+#include "command_queue.h"
+#include "h5_transport.h"
 #include "sd_rpc_types.h"
 #include "serialization_transport.h"
+#include "transport_stats.h"
 
 #include "ble.h"
 #include "nrf_error.h"
 
+#include <memory>
 #include <string>
 
+// Asynchronous commands waiting for their responses at once, one for each packet of the H5
+// sliding window
+constexpr size_t CommandPipelineDepth = SlidingWindowSizeMax;
+
+// Buffer pool used when the adapter is created without a buffer pool configuration. It has a
+// buffer for each of the first DefaultBufferPoolEventCount events queued, each packet of the H5
+// sliding window and the request and response of each command in flight. Events queued beyond
+// those use the heap, the pool is not sized for the full event queue.
+constexpr uint32_t DefaultBufferPoolEventCount  = 256;
+constexpr uint32_t DefaultBufferPoolBufferSize  = 1024;
+constexpr uint32_t DefaultBufferPoolBufferCount =
+    DefaultBufferPoolEventCount + SlidingWindowSizeMax + 2 * CommandPipelineDepth;
+
 class AdapterInternal
 {
   public:
     explicit AdapterInternal(SerializationTransport *transport);
+    AdapterInternal(SerializationTransport *transport,
+                    const sd_rpc_buffer_pool_config_t &bufferPoolConfig);
+    AdapterInternal(SerializationTransport *transport, const std::shared_ptr<Runtime> &runtime);
     ~AdapterInternal();
     uint32_t open(const sd_rpc_status_handler_t status_callback,
                   const sd_rpc_evt_handler_t event_callback,
                   const sd_rpc_log_handler_t log_callback);
+    uint32_t open(const sd_rpc_status_handler_t status_callback,
+                  const sd_rpc_evt_batch_handler_t event_batch_callback,
+                  const sd_rpc_log_handler_t log_callback,
+                  const sd_rpc_evt_batch_config_t &batchConfig);
+    uint32_t open(const sd_rpc_status_handler_t status_callback,
+                  const sd_rpc_log_handler_t log_callback);
     uint32_t close();
+    uint32_t commandAsync(adapter_t *adapter, const sd_rpc_command_handler_t command,
+                          const sd_rpc_command_complete_handler_t complete_handler,
+                          void *context);
     uint32_t logSeverityFilterSet(const sd_rpc_log_severity_t severity_filter);
     static bool isInternalError(const uint32_t error_code);
 
     void statusHandler(const sd_rpc_app_status_t code, const std::string &error);
     void eventHandler(ble_evt_t *event);
+    void eventBatchHandler(ble_evt_t **events, const uint32_t count);
     void logHandler(const sd_rpc_log_severity_t severity, const std::string &log_message);
 
     SerializationTransport *transport;
+    std::shared_ptr<BufferPool> bufferPool; // Shared by all layers of the adapter
+    std::shared_ptr<TransportStats> stats;  // Counted by all layers of the adapter
+    // Used by the codecs of the adapter, cleared when the adapter is closed
+    std::shared_ptr<adapter_ble_gap_state_t> gapState;
 
   private:
     sd_rpc_evt_handler_t eventCallback;
+    sd_rpc_evt_batch_handler_t eventBatchCallback;
     sd_rpc_status_handler_t statusCallback;
     sd_rpc_log_handler_t logCallback;
     sd_rpc_log_severity_t logSeverityFilter;
 
     bool isOpen;
     std::mutex publicMethodMutex;
+
+    // Asynchronous commands, not locked by publicMethodMutex so completion handlers can queue
+    // new commands while the adapter is closed
+    CommandQueue commandQueue;
 };
 
 #endif // ADAPTER_INTERNAL_H__
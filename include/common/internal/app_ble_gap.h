@@ -54,6 +54,7 @@
 #include "ble_gap.h"
 #include "ble_types.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -86,37 +87,64 @@ typedef enum {
     EVENT_CODEC_CONTEXT
 } app_ble_gap_adapter_codec_context_t;
 
+/**@brief GAP state of one adapter, used by the codecs while a codec context is set */
+typedef struct adapter_ble_gap_state_t adapter_ble_gap_state_t;
+
 /**
- * @brief Create GAP states for a given adapter
+ * @brief Create a GAP state for an adapter
+ *
+ * The adapter keeps the GAP state and passes it to the codec contexts it sets, the GAP state is
+ * not looked up by the codecs.
  *
- * The purpose of this function is to create a GAP state for a given adapter.
+ * @retval GAP state, deleted with @ref app_ble_gap_state_delete
+ */
+adapter_ble_gap_state_t *app_ble_gap_state_create(void);
+
+/**
+ * @brief Delete a GAP state created with @ref app_ble_gap_state_create
  *
- * @param[in] key Key that represents the adapter, used by other functions to select GAP state for a
- * adapter
+ * @param[in] gap_state GAP state, no codec context may be set with it
  */
-uint32_t app_ble_gap_state_create(void *key);
+void app_ble_gap_state_delete(adapter_ble_gap_state_t *gap_state);
 
 /**
- * @brief Delete GAP states for a given adapter
+ * @brief Clear a GAP state, it is then the same as a GAP state just created
  *
- * The purpose of this function is to delete the GAP state for a given adapter.
+ * Waits for the codecs using the GAP state on other threads.
  *
- * @param[in] key Key that represents the adapter
+ * @param[in] gap_state GAP state to clear
  */
-uint32_t app_ble_gap_state_delete(void *key);
+void app_ble_gap_state_clear(adapter_ble_gap_state_t *gap_state);
 
-/**@brief Set the current GAP adapter to be used by codecs
+/**@brief Set the GAP state to be used by the codecs of the calling thread
  *
- * @param[in]     adapter_id    Adapter to be used by codecs
+ * @param[in]     gap_state     GAP state of the adapter encoding or decoding
  * @param[in]     codec_context Codec context
  */
-void app_ble_gap_set_current_adapter_id(void *adapter_id,
-                                        const app_ble_gap_adapter_codec_context_t codec_context);
+void app_ble_gap_set_current_gap_state(adapter_ble_gap_state_t *gap_state,
+                                       const app_ble_gap_adapter_codec_context_t codec_context);
 
-/**@brief Unset the current GAP adapter used by codecs
+/**@brief Unset the GAP state used by the codecs of the calling thread
  * @param[in]     codec_context Unset the given codec context
  */
-void app_ble_gap_unset_current_adapter_id(const app_ble_gap_adapter_codec_context_t codec_context);
+void app_ble_gap_unset_current_gap_state(const app_ble_gap_adapter_codec_context_t codec_context);
+
+/**@brief Let other threads use the GAP state of the codec context of the calling thread
+ *
+ * Called while a command waits for its response, other commands of the adapter are encoded and
+ * decoded meanwhile. The codec context stays set, the calling thread does not use it until
+ * @ref app_ble_gap_resume_current_gap_state is called.
+ *
+ * @param[in]     codec_context Codec context to pause
+ */
+void app_ble_gap_pause_current_gap_state(const app_ble_gap_adapter_codec_context_t codec_context);
+
+/**@brief Use the GAP state of a codec context paused with @ref app_ble_gap_pause_current_gap_state
+ * again
+ *
+ * @param[in]     codec_context Codec context to resume
+ */
+void app_ble_gap_resume_current_gap_state(const app_ble_gap_adapter_codec_context_t codec_context);
 
 /**@brief Check if current adapter is set
  * @param[in] codec_context       Check if adapter GAP state is set for codec context
@@ -47,16 +47,18 @@ typedef std::function<uint32_t(uint8_t *, uint32_t, uint32_t *)> decode_function
 uint32_t encode_decode(adapter_t *adapter, const encode_function_t &encode_function,
                        const decode_function_t &decode_function);
 
+struct adapter_ble_gap_state_t;
+
 /*
  * We do not want to change the codecs provided by the SDK too much. The BLESecurityContext provides
- * a way to set the root security context before calling the codecs. Typically the root context is
- * the SerializationTransport object.
+ * a way to set the root security context before calling the codecs. The root context is the GAP
+ * state of the adapter, see app_ble_gap.h.
  */
 
 class RequestReplyCodecContext
 {
   public:
-    explicit RequestReplyCodecContext(void *adapterId);
+    explicit RequestReplyCodecContext(adapter_ble_gap_state_t *gapState);
     ~RequestReplyCodecContext();
     RequestReplyCodecContext(const RequestReplyCodecContext &) = delete;
     RequestReplyCodecContext &operator=(const RequestReplyCodecContext &) = delete;
@@ -67,7 +69,7 @@ class RequestReplyCodecContext
 class EventCodecContext
 {
   public:
-    explicit EventCodecContext(void *adapterId);
+    explicit EventCodecContext(adapter_ble_gap_state_t *gapState);
     ~EventCodecContext();
     EventCodecContext(const EventCodecContext &) = delete;
     EventCodecContext &operator=(const EventCodecContext &) = delete;
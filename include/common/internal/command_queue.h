@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef COMMAND_QUEUE_H__
+#define COMMAND_QUEUE_H__
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <cstddef>
+#include <stdint.h>
+
+// Number of asynchronous commands queued before new commands are rejected
+constexpr size_t CommandQueueCapacity = 256;
+
+typedef std::function<uint32_t()> command_t;
+typedef std::function<void(uint32_t result)> command_complete_t;
+
+// Runs commands queued by any thread on worker threads, up to pipelineDepth commands at a time.
+// A command is started when the command queued before it has sent its request, so requests are
+// sent in the order the commands are queued and several commands wait for their responses at
+// once. Results are passed to the completion functions in the same order, one at a time. The
+// queue accepts commands after start, workers are started as commands are queued.
+class CommandQueue
+{
+  public:
+    explicit CommandQueue(const size_t pipelineDepth);
+    ~CommandQueue();
+
+    CommandQueue(const CommandQueue &) = delete;
+    CommandQueue &operator=(const CommandQueue &) = delete;
+
+    // Queues a command, returns NRF_ERROR_INVALID_STATE if the queue is stopped and
+    // NRF_ERROR_NO_MEM if it is full
+    uint32_t push(const command_t &command, const command_complete_t &complete);
+
+    // Accepts commands until stop is called
+    void start();
+
+    // Waits for the running commands and completes the queued commands with
+    // NRF_ERROR_INVALID_STATE without running them. Returns NRF_ERROR_INVALID_STATE if called
+    // from a command or a completion function.
+    uint32_t stop();
+
+    // Called by a command when it has sent its request, the next command is then started. Does
+    // nothing on a thread not running a command. A command that returns without calling it sends
+    // no request.
+    static void requestSent();
+
+  private:
+    struct Command
+    {
+        command_t command;
+        command_complete_t complete;
+    };
+
+    void runner();
+    void passTurn(const uint64_t sequence);
+
+    const size_t pipelineDepth;
+
+    std::mutex mutex;
+    std::condition_variable queued;
+    std::condition_variable turnTaken; // Signalled when startTurn or completeTurn advances
+    std::deque<Command> commands;
+    bool isRunning;
+    std::vector<std::thread> workers;
+    size_t idleWorkers;
+
+    // Commands are numbered in the order they are taken from the queue. startTurn is the number of
+    // the command allowed to start, completeTurn the number of the command completed next.
+    uint64_t nextSequence;
+    uint64_t startTurn;
+    uint64_t completeTurn;
+};
+
+#endif // COMMAND_QUEUE_H__
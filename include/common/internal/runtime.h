@@ -0,0 +1,89 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RUNTIME_H__
+#define RUNTIME_H__
+
+#include <asio.hpp>
+
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+
+// Threads shared by the adapters created with the runtime. The I/O threads run the physical
+// layers of the adapters, the dispatch threads pass their events to the application. The threads
+// run until the runtime is destroyed, adapters keep the runtime alive.
+class Runtime
+{
+  public:
+    // Starts the threads, throws std::system_error if a thread can not be started. The last owner
+    // may release the runtime on one of its threads, the threads are then stopped by another one.
+    static std::shared_ptr<Runtime> create(const uint32_t ioThreadCount,
+                                           const uint32_t dispatchThreadCount);
+    ~Runtime();
+
+    Runtime(const Runtime &) = delete;
+    Runtime &operator=(const Runtime &) = delete;
+
+    // Runs the asynchronous I/O of the physical layers. Handlers of one physical layer may run on
+    // any I/O thread, a layer serializes its own handlers. Handlers must never wait for an
+    // application callback or for room in a queue, that would stall every adapter sharing the
+    // thread.
+    asio::io_service &ioService();
+
+    // Runs task on a dispatch thread. Tasks posted while another one runs may run in parallel with
+    // it, callers keep the order of their own tasks.
+    void dispatch(const std::function<void()> &task);
+
+  private:
+    Runtime(const uint32_t ioThreadCount, const uint32_t dispatchThreadCount);
+
+    static void destroy(Runtime *runtime);
+    bool onRuntimeThread() const;
+    void stop();
+
+    asio::io_service io;
+    asio::io_service dispatchService;
+    std::unique_ptr<asio::io_service::work> ioWork;
+    std::unique_ptr<asio::io_service::work> dispatchWork;
+    std::vector<std::thread> threads;
+};
+
+#endif // RUNTIME_H__
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include "sd_rpc_types.h"
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdint.h>
+
+class BufferPool;
+
+// Reference counted buffer from a BufferPool. Copies refer to the same memory, the buffer is
+// returned to the pool when the last copy is destroyed. Buffers are allocated on the heap when
+// the pool is exhausted or the requested size is larger than the buffers in the pool.
+class PooledBuffer
+{
+  public:
+    PooledBuffer() noexcept;
+    PooledBuffer(const PooledBuffer &other) noexcept;
+    PooledBuffer(PooledBuffer &&other) noexcept;
+    PooledBuffer &operator=(PooledBuffer other) noexcept;
+    ~PooledBuffer() noexcept;
+
+    uint8_t *data() const noexcept;
+    size_t size() const noexcept;
+    size_t capacity() const noexcept;
+    // Sets the number of bytes used, limited to the capacity of the buffer
+    void resize(const size_t size) noexcept;
+
+    explicit operator bool() const noexcept;
+
+  private:
+    friend class BufferPool;
+
+    struct Header
+    {
+        std::atomic<uint32_t> references;
+        BufferPool *pool; // nullptr if the buffer is allocated on the heap
+        uint32_t index;
+        size_t capacity;
+        size_t size;
+        uint8_t *data;
+    };
+
+    explicit PooledBuffer(Header *header) noexcept;
+    void release() noexcept;
+
+    Header *header;
+};
+
+// Fixed number of fixed size buffers. Buffers are acquired and released without locks so the
+// pool can be shared by all threads of an adapter.
+//
+// The pool must outlive the buffers acquired from it, users keep it alive with a shared_ptr.
+class BufferPool
+{
+  public:
+    BufferPool(const size_t buffer_size, const size_t buffer_count);
+    ~BufferPool() noexcept;
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // Returns a buffer with room for size bytes, falls back to the heap if needed
+    PooledBuffer acquire(const size_t size);
+
+    // Allocates a buffer on the heap, used when there is no pool
+    static PooledBuffer allocate(const size_t size);
+
+    sd_rpc_buffer_pool_stats_t stats() const;
+
+  private:
+    friend class PooledBuffer;
+
+    void release(PooledBuffer::Header *header) noexcept;
+
+    const size_t bufferSize;
+    const size_t bufferCount;
+
+    std::unique_ptr<uint8_t[]> memory;
+    std::unique_ptr<PooledBuffer::Header[]> headers;
+    std::unique_ptr<std::atomic<uint32_t>[]> next; // Free list links, indexed as headers
+
+    // Head of the free list. The lower 32 bits are the index of the first free buffer, the upper
+    // 32 bits a tag incremented on each change to detect that the list changed (ABA problem).
+    std::atomic<uint64_t> freeList;
+
+    std::atomic<uint32_t> inUse;
+    std::atomic<uint32_t> highWaterMark;
+    std::atomic<uint32_t> exhaustedCount;
+    std::atomic<uint32_t> heapFallbackCount;
+};
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef FD_TRANSPORT_H
+#define FD_TRANSPORT_H
+
+#include "transport.h"
+#include "uart_defines.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/uio.h>
+
+/**
+ * @brief The FdTransport class reads and writes a file descriptor, such as a serial port or a
+ * socket. All I/O is done by one thread waiting on epoll, or by the I/O threads of the runtime if
+ * one is set. Derived classes open the descriptor.
+ */
+class FdTransport : public Transport
+{
+  public:
+    ~FdTransport() noexcept override;
+
+    /**
+     *@brief Opens the descriptor and starts the I/O thread.
+     */
+    uint32_t open(const status_cb_t &status_callback, const data_cb_t &data_callback,
+                  const log_cb_t &log_callback) override;
+
+    /**
+     *@brief Stops the I/O thread and closes the descriptor.
+     */
+    uint32_t close() override;
+
+    /**
+     *@brief Writes data to the descriptor. Data that can not be written immediately is written
+     * by the I/O thread when the descriptor is ready.
+     */
+    uint32_t send(const std::vector<uint8_t> &data) override;
+    uint32_t send(const transport_segment_t *segments, const size_t count) override;
+
+    /**
+     *@brief Sets the handler called on the I/O thread when the timer, a timerfd waited for
+     * together with the descriptor, expires.
+     */
+    bool setTimerHandler(const timer_cb_t &handler) override;
+    void scheduleTimer(const std::chrono::steady_clock::time_point deadline) override;
+
+    /**
+     *@brief Stores statistics of data written to the descriptor in stats.
+     */
+    uint32_t physicalLayerStats(sd_rpc_physical_layer_stats_t *stats) override;
+
+  protected:
+    explicit FdTransport(const std::string &name);
+
+    /**
+     *@brief Opens and configures the non-blocking descriptor to read and write.
+     *
+     * Called from open(), throws std::system_error on failure.
+     */
+    virtual int openDescriptor() = 0;
+
+    /**
+     *@brief Writes to the descriptor, returns the number of bytes written or -1 with errno set.
+     */
+    virtual ssize_t writeDescriptor(const iovec *iov, const int count);
+
+    std::string name;
+    int fd;
+
+  private:
+    // Descriptor of the epoll instance waited for by the runtime, asio is kept out of this header
+    // as it does not compile together with the termios definitions of the derived classes
+    struct RuntimeDescriptor;
+
+    void ioWorker();
+    void waitForEvents();
+    bool handleEvents(const int timeout);
+    void readAvailable();
+    void writePending();
+    void setWriteInterest(const bool enabled);
+    void timerExpired();
+
+    int epollFd; // Waits for fd, wakeFd and timerFd
+    int wakeFd;  // eventfd used to stop the I/O thread
+    int timerFd; // timerfd expiring at timerDeadline
+
+    timer_cb_t timerHandler;
+    std::mutex timerMutex; // Serializes setting timerFd
+    std::atomic<std::chrono::steady_clock::time_point> timerDeadline;
+
+    std::array<uint8_t, BUFFER_SIZE_LARGE> readBuffer;
+
+    std::mutex writeMutex;
+    std::vector<uint8_t> pendingWrite; // Data waiting for the descriptor to become writable
+    bool writeInterest;                // If epoll waits for the descriptor to become writable
+    WriteStats writeStats;             // Protected by writeMutex
+
+    std::thread ioThread;
+
+    // With a runtime the epoll instance is waited for by the I/O threads of the runtime, one wait
+    // at a time
+    std::unique_ptr<RuntimeDescriptor> runtimeDescriptor;
+    bool runtimeWaiting;
+    std::mutex runtimeMutex;
+    std::condition_variable runtimeStopped;
+    std::atomic<bool> isOpen;
+    std::mutex publicMethodMutex;
+};
+
+#endif // FD_TRANSPORT_H
@@ -38,10 +38,15 @@
 #ifndef H5_H
 #define H5_H
 
+#include "transport.h"
+
+#include <cstddef>
 #include <stdint.h>
 #include <vector>
 
 const uint32_t H5_HEADER_LENGTH = 4;
+const uint32_t H5_MAX_PAYLOAD_LENGTH = 0xFFF;
+const uint32_t H5_MAX_PACKET_LENGTH = H5_HEADER_LENGTH + H5_MAX_PAYLOAD_LENGTH + 2;
 
 typedef enum
 {
@@ -74,6 +79,42 @@ void h5_encode(const std::vector<uint8_t> &in_packet,
                bool reliable_packet,
                h5_pkt_type_t packet_type);
 
+// Builds the H5 packet from a list of segments. Replaces the content of out_packet, the capacity
+// of out_packet is reused.
+void h5_encode(const transport_segment_t *segments,
+               const size_t count,
+               std::vector<uint8_t> &out_packet,
+               uint8_t seq_num,
+               uint8_t ack_num,
+               bool crc_present,
+               bool reliable_packet,
+               h5_pkt_type_t packet_type);
+
+// Changes the acknowledgement number of a packet built by h5_encode. The header checksum and the
+// CRC are updated in place. Returns false if the packet already has the acknowledgement number.
+bool h5_set_ack_num(std::vector<uint8_t> &h5_packet, uint8_t ack_num);
+
+// Builds the H5 packet and SLIP encodes it in one pass, without intermediate buffers. Replaces
+// the content of out_packet, the capacity of out_packet is reused.
+void h5_slip_encode(const uint8_t *payload,
+                    const size_t payload_length,
+                    std::vector<uint8_t> &out_packet,
+                    uint8_t seq_num,
+                    uint8_t ack_num,
+                    bool crc_present,
+                    bool reliable_packet,
+                    h5_pkt_type_t packet_type);
+
+// As above, with the payload given as a list of segments
+void h5_slip_encode(const transport_segment_t *segments,
+                    const size_t count,
+                    std::vector<uint8_t> &out_packet,
+                    uint8_t seq_num,
+                    uint8_t ack_num,
+                    bool crc_present,
+                    bool reliable_packet,
+                    h5_pkt_type_t packet_type);
+
 uint32_t h5_decode(const std::vector<uint8_t> &slip_dec_packet,
 	std::vector<uint8_t> &h5_dec_packet,
 	uint8_t *seq_num,
@@ -84,4 +125,16 @@ uint32_t h5_decode(const std::vector<uint8_t> &slip_dec_packet,
 	bool *reliable_packet,
 	h5_pkt_type_t *packet_type);
 
+// Decodes the packet in place, payload is set to point to the payload inside packet
+uint32_t h5_decode(const uint8_t *packet,
+    const size_t length,
+    const uint8_t **payload,
+    uint8_t *seq_num,
+    uint8_t *ack_num,
+    bool *_data_integrity,
+    uint16_t *_payload_length,
+    uint8_t *_header_checksum,
+    bool *reliable_packet,
+    h5_pkt_type_t *packet_type);
+
 #endif //H5_H
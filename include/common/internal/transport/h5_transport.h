@@ -40,14 +40,16 @@
 
 #include "transport.h"
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
 
 #include <vector>
 
 #include "h5.h"
-#include "h5_transport_exit_criterias.h"
-#include <map>
+#include "slip.h"
 #include <stdint.h>
 #include <thread>
 
@@ -63,6 +65,19 @@ typedef enum {
     STATE_UNKNOWN
 } h5_state_t;
 
+// Events moving the state machine between states
+typedef enum {
+    EVENT_OPENED,                // The layer below is opened
+    EVENT_IO_ERROR,              // The layer below failed
+    EVENT_CLOSE,                 // The transport is closed
+    EVENT_TIMEOUT,               // The timer of the state expired and no retries are left
+    EVENT_SYNC_RESPONSE,         // SYNC RESPONSE received
+    EVENT_SYNC_CONFIG_RESPONSE,  // CONFIG RESPONSE received
+    EVENT_SYNC,                  // SYNC received on an active link, peer was reset
+    EVENT_SYNC_ERROR,            // ACK outside of the sliding window received on an active link
+    EVENT_COUNT
+} h5_event_t;
+
 constexpr uint8_t SyncFirstByte           = 0x01;
 constexpr uint8_t SyncSecondByte          = 0x7E;
 constexpr uint8_t SyncRspFirstByte        = 0x02;
@@ -73,22 +88,34 @@ constexpr uint8_t SyncConfigRspFirstByte  = 0x04;
 constexpr uint8_t SyncConfigRspSecondByte = 0x7B;
 constexpr uint8_t SyncConfigField         = 0x11;
 
-using state_action_t = std::function<h5_state_t()>;
-using payload_t      = std::vector<uint8_t>;
+// Bits in the configuration field carrying the sliding window size
+constexpr uint8_t SyncConfigSlidingWindowMask = 0x07;
+// Largest number of unacknowledged reliable packets the three wire protocol allows
+constexpr uint8_t SlidingWindowSizeMax = 7;
+
+using payload_t = std::vector<uint8_t>;
 
 class H5Transport : public Transport
 {
   public:
     H5Transport() = delete;
-    H5Transport(Transport *nextTransportLayer, const uint32_t retransmission_interval);
+    H5Transport(Transport *nextTransportLayer, const uint32_t retransmission_interval,
+                const uint8_t sliding_window_size = SlidingWindowSizeMax,
+                const uint32_t ack_delay = 0);
     ~H5Transport() noexcept;
 
     uint32_t open(const status_cb_t &status_callback, const data_cb_t &data_callback,
                   const log_cb_t &log_callback) override;
     uint32_t close() override;
     uint32_t send(const std::vector<uint8_t> &data) override;
+    uint32_t send(const transport_segment_t *segments, const size_t count) override;
+    void setBufferPool(const std::shared_ptr<BufferPool> &pool) override;
+    void setRuntime(const std::shared_ptr<Runtime> &sharedRuntime) override;
+    void setLogSeverityFilter(const sd_rpc_log_severity_t severity) override;
 
     h5_state_t state() const;
+    uint8_t slidingWindowSize() const;
+    sd_rpc_rtt_estimate_t rttEstimate();
 
     static bool isSyncPacket(const payload_t &packet, const uint8_t offset = 0);
     static bool isSyncResponsePacket(const payload_t &packet, const uint8_t offset = 0);
@@ -104,15 +131,36 @@ class H5Transport : public Transport
   private:
     void dataHandler(const uint8_t *data, const size_t length);
     void statusHandler(const sd_rpc_app_status_t code, const std::string &error);
-    void processPacket(const payload_t &packet);
+    void processPacket(const uint8_t *packet, const size_t length, const uint32_t slip_err_code);
 
     void sendControlPacket(control_pkt_type type);
+    void sendAck();       // Locks ackMutex
+    void unlockAckSend(); // Locks ackMutex
+    uint32_t sendSlipPacket(const payload_t &slipPacket);
+    void encodeControlPackets();
 
     void incrementSeqNum();
     void incrementAckNum();
 
+    // Sliding window related, the caller must hold ackMutex unless stated otherwise
+    uint8_t syncConfigField() const;
+    uint8_t packetsInFlight() const;
+    std::chrono::steady_clock::time_point nextRetransmission() const;
+    bool processAck(const uint8_t ack_num);                        // Locks ackMutex
+    void negotiateSlidingWindowSize(const payload_t &configPacket); // Locks ackMutex
+    void resetSlidingWindow();                                     // Locks ackMutex
+    bool retransmitExpiredPackets();                               // Locks ackMutex
+
+    // Round-trip time estimation related, the caller must hold ackMutex
+    void updateRttEstimate(const std::chrono::microseconds rtt);
+    void backOffRetransmissionTimeout();
+
+    // Delayed acknowledgement related, the caller must hold ackMutex unless stated otherwise
+    bool delayAck();
+    std::chrono::steady_clock::time_point nextAckFlush() const;
+    void flushDelayedAck(); // Locks ackMutex
+
     Transport *nextTransportLayer;
-    std::vector<uint8_t> lastPacket;
 
     // Callbacks used by lower transports
     // These callbacks invoke upper callbacks
@@ -120,64 +168,137 @@ class H5Transport : public Transport
     data_cb_t dataCallback;
 
     // Variables used for reliable packets
-    uint8_t seqNum;
-    uint8_t ackNum;
-
-    bool c0Found;
-    std::vector<uint8_t> unprocessedData;
-
-    std::mutex stateMachineMutex; // Mutex controlling access to state machine variables
-    std::condition_variable
-        stateMachineChange; // Condition variable to communicate changes to state machine
+    uint8_t seqNum;         // Sequence number of the next reliable packet to send
+    uint8_t ackNum;         // Sequence number of the next reliable packet expected from peer
+    uint8_t unackedSeqNum;  // Sequence number of the oldest packet not acknowledged by peer
+
+    // Reliable packets sent but not acknowledged, indexed by sequence number
+    // The buffers are reused for all packets with this sequence number. The H5 packet is kept so
+    // that a retransmission carries the current acknowledgement number without decoding it.
+    struct OutstandingPacket
+    {
+        payload_t h5Packet;
+        payload_t slipPacket;
+        std::chrono::steady_clock::time_point sentAt;
+        uint8_t retransmissions;
+    };
+
+    std::array<OutstandingPacket, 8> outstandingPackets;
+
+    // Sliding window size this side supports and the one negotiated with peer
+    const uint8_t localSlidingWindowSize;
+    uint8_t negotiatedSlidingWindowSize;
+
+    // Incremented each time the sliding window is dropped
+    uint32_t slidingWindowResets;
+
+    // Round-trip time estimate and the retransmission timeout derived from it (RFC 6298).
+    // The retransmission timeout is kept between the min and max values.
+    std::chrono::microseconds smoothedRtt;
+    std::chrono::microseconds rttVariation;
+    std::chrono::milliseconds retransmissionTimeout;
+    const std::chrono::milliseconds retransmissionTimeoutMin;
+    const std::chrono::milliseconds retransmissionTimeoutMax;
+    uint32_t rttSampleCount;
+
+    // Received reliable packets not yet acknowledged to peer and when the acknowledgement is due.
+    // The acknowledgement is sent with the next reliable packet or as an ACK packet when due.
+    const std::chrono::milliseconds ackDelay;
+    uint8_t pendingAcks;
+    std::chrono::steady_clock::time_point ackDeadline;
+
+    // SLIP encoded control packets indexed by control_pkt_type, and ACK packets indexed by
+    // acknowledgement number. The packets never change so they are encoded once.
+    std::array<payload_t, CONTROL_PKT_SYNC_CONFIG_RESPONSE + 1> controlPackets;
+    std::array<payload_t, 8> ackPackets;
+
+    // Packets carrying an acknowledgement number are encoded and sent with ackSendMutex held,
+    // peer receives the numbers in order. The I/O thread and the timer do not wait for it, the
+    // thread holding it sends the ACK or restarts the timer they requested when releasing it.
+    std::mutex ackSendMutex;
+    std::atomic<bool> ackSendRequested;
+    std::atomic<bool> retransmitRequested;
+
+    // Decodes packets directly from the data received from the lower transport
+    SlipDecoder slipDecoder;
 
     // Variables used in state ACTIVE
-    std::chrono::milliseconds retransmissionInterval;
-    std::mutex ackMutex;
-    std::condition_variable ackWaitCondition;
+    std::chrono::milliseconds retransmissionInterval; // Initial retransmission timeout
+    std::mutex ackMutex;                      // Protects the sliding window variables
+    std::condition_variable ackWaitCondition; // Signalled when room is made in the window
+    uint32_t windowWaiters;                   // Senders waiting for room in the window
 
     // Debugging related
     uint32_t incomingPacketCount;
     uint32_t outgoingPacketCount;
     uint32_t errorPacketCount;
 
-    void logPacket(const bool outgoing, const payload_t &packet);
+    void logPacket(const bool outgoing, const uint8_t *packet, const size_t length);
+    void logOutgoingPacket(const payload_t &slipPacket);
     void logStateTransition(const h5_state_t from, const h5_state_t to) const;
     static std::string asHex(const payload_t &packet);
     static std::string hciPacketLinkControlToString(const payload_t &payload);
-    std::string h5PktToString(const bool out, const payload_t &h5Packet) const;
-
-    // State machine related
-    h5_state_t currentState;
-    std::thread stateMachineThread;
-
-    bool stateMachineReady;
-
-    std::map<h5_state_t, state_action_t> stateActions;
-    void setupStateMachine();
-    void startStateMachine();
-    void stopStateMachine();
-
-    std::map<h5_state_t, std::shared_ptr<ExitCriterias>> exitCriterias;
+    std::string h5PktToString(const bool out, const uint8_t *h5Packet, const size_t length) const;
 
-    void stateMachineWorker();
+    // State machine related. The state machine does not block, it is driven by the events
+    // raised by the I/O thread of the layer below and by its timer. The current state is read
+    // without locking, it is changed with stateMachineMutex held.
+    std::atomic<h5_state_t> currentState;
+    std::mutex stateMachineMutex;
+    std::condition_variable stateChanged; // Signalled when the state is changed
 
-    // Mutex that allows threads to wait for a given state in the state machine
-    std::mutex stateMutex;
+    void handleEvent(const h5_event_t event); // Caller holds stateMachineMutex
+    void changeState(const h5_state_t nextState);
     bool waitForState(h5_state_t state, std::chrono::milliseconds timeout);
-    std::condition_variable stateWaitCondition;
 
-    bool isOpen;
+    // Timer of the state machine, the caller holds stateMachineMutex unless stated otherwise
+    void timerExpired(); // Locks stateMachineMutex
+    void scheduleTimer(const std::chrono::steady_clock::time_point deadline); // Any lock
+    void startStateTimer(const std::chrono::milliseconds duration);
+    bool stateTimerExpired();
+
+    std::chrono::steady_clock::time_point stateDeadline; // Timer of the current state
+    uint8_t syncRetransmissions; // SYNC or CONFIG packets left to send in the current state
+
+    // Runs the timer when the layer below has no I/O thread to run it on
+    void timerWorker();
+    void stopTimerThread();
+    bool ownTimer;
+    std::thread timerThread;
+    std::mutex timerMutex;
+    std::condition_variable timerChanged;
+    std::chrono::steady_clock::time_point timerDeadline;
+    bool timerStopped;
+
+    // Changed with publicMethodMutex held. send does not take publicMethodMutex, a sender waiting
+    // for room in the sliding window must not hold up close.
+    std::atomic<bool> isOpen;
     std::mutex publicMethodMutex;
 
-    // Actions associated with each state
-    h5_state_t stateActionStart();
-    h5_state_t stateActionReset();
-    h5_state_t stateActionUninitialized();
-    h5_state_t stateActionInitialized();
-    h5_state_t stateActionActive();
-    h5_state_t stateActionFailed();
-    h5_state_t stateActionClosed();
-    h5_state_t stateActionNoResponse();
+    // Actions of each state, indexed by h5_state_t. enter is called when the state is entered,
+    // timeout when the timer of the state is due. The caller holds stateMachineMutex.
+    struct StateActions
+    {
+        void (H5Transport::*enter)();
+        void (H5Transport::*timeout)();
+    };
+
+    static const std::array<StateActions, STATE_UNKNOWN> stateActions;
+
+    void enterReset();
+    void enterUninitialized();
+    void enterInitialized();
+    void enterActive();
+    void enterFailed();
+    void enterClosed();
+    void enterNoResponse();
+
+    void timeoutReset();
+    void timeoutUninitialized();
+    void timeoutInitialized();
+    void timeoutActive();
+
+    void resendSyncPacket(const control_pkt_type type);
 };
 
 #endif // H5_TRANSPORT_H
@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef RECORDING_TRANSPORT_H
+#define RECORDING_TRANSPORT_H
+
+#include "transport.h"
+
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+// Recording file format, all values are little endian.
+//
+// The file starts with RecordingMagic followed by a version byte. Each read from and write to the
+// physical layer is stored as a record:
+//   uint8_t  direction, recording_direction_t
+//   uint32_t microseconds since the previous record, or since the recording started
+//   uint16_t length of data
+//   data
+// Reads and writes larger than RecordingMaxDataLength are stored as several records.
+constexpr char RecordingMagic[]                = {'N', 'R', 'F', 'H', '5'};
+constexpr uint8_t RecordingVersion             = 1;
+constexpr size_t RecordingHeaderLength         = sizeof(RecordingMagic) + 1;
+constexpr size_t RecordingRecordHeaderLength   = 7;
+constexpr size_t RecordingMaxDataLength        = 0xFFFF;
+
+typedef enum {
+    RECORDING_DIRECTION_READ  = 0,
+    RECORDING_DIRECTION_WRITE = 1
+} recording_direction_t;
+
+/**
+ * @brief The RecordingTransport class is placed on top of a physical layer and records all data
+ * read from and written to it, with timestamps, in a file. The recording can be replayed without
+ * hardware with ReplayTransport.
+ */
+class RecordingTransport : public Transport
+{
+  public:
+    /**
+     *@brief Records the traffic of nextTransportLayer to file path. Takes ownership of
+     * nextTransportLayer.
+     */
+    RecordingTransport(Transport *nextTransportLayer, const std::string &path);
+    ~RecordingTransport() noexcept override;
+
+    /**
+     *@brief Creates the recording file, overwriting an existing file, and opens the physical
+     * layer.
+     */
+    uint32_t open(const status_cb_t &status_callback, const data_cb_t &data_callback,
+                  const log_cb_t &log_callback) override;
+
+    /**
+     *@brief Closes the physical layer and completes the recording file.
+     */
+    uint32_t close() override;
+
+    uint32_t send(const std::vector<uint8_t> &data) override;
+    uint32_t send(const transport_segment_t *segments, const size_t count) override;
+    void setBufferPool(const std::shared_ptr<BufferPool> &pool) override;
+    void setRuntime(const std::shared_ptr<Runtime> &sharedRuntime) override;
+    void setLogSeverityFilter(const sd_rpc_log_severity_t severity) override;
+    bool setTimerHandler(const timer_cb_t &handler) override;
+    void scheduleTimer(const std::chrono::steady_clock::time_point deadline) override;
+    uint32_t physicalLayerStats(sd_rpc_physical_layer_stats_t *stats) override;
+
+  private:
+    void dataHandler(const uint8_t *data, const size_t length);
+    void record(const recording_direction_t direction, const transport_segment_t *segments,
+                const size_t count);
+    void writeRecord(const recording_direction_t direction, const uint8_t *data,
+                     const size_t length);
+
+    Transport *nextTransportLayer;
+    std::string path;
+
+    std::mutex fileMutex; // Reads and writes are recorded from different threads
+    std::ofstream file;
+    std::chrono::steady_clock::time_point lastRecordTime;
+    std::vector<uint8_t> recordBuffer;
+    bool isOpen;
+
+    std::mutex publicMethodMutex;
+};
+
+#endif // RECORDING_TRANSPORT_H
@@ -0,0 +1,145 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef REPLAY_TRANSPORT_H
+#define REPLAY_TRANSPORT_H
+
+#include "recording_transport.h"
+#include "transport.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <stdint.h>
+
+/**
+ * @brief The ReplayTransport class is a physical layer that plays back a recording made with
+ * RecordingTransport. No hardware is needed.
+ *
+ * The recorded reads are passed to the upper layer as fast as possible, or with the timing of the
+ * recording. The upper layer has to send the same packets as when the recording was made. Replay
+ * waits for the upper layer at each H5 SYNC, SYNC CONFIG and new reliable packet in the recording,
+ * the reads following them answer what the upper layer has sent. Other writes, such as
+ * acknowledgements, are not waited for.
+ */
+class ReplayTransport : public Transport
+{
+  public:
+    /**@brief Time replay waits for the upper layer to send a packet before it continues anyway. */
+    static constexpr std::chrono::milliseconds WaitForSendTimeout{2000};
+
+    ReplayTransport(const std::string &path, const bool originalTiming);
+    ~ReplayTransport() noexcept override;
+
+    /**
+     *@brief Opens the recording and starts replaying it.
+     */
+    uint32_t open(const status_cb_t &status_callback, const data_cb_t &data_callback,
+                  const log_cb_t &log_callback) override;
+
+    /**
+     *@brief Stops replaying and closes the recording.
+     */
+    uint32_t close() override;
+
+    /**
+     *@brief Compares data with the recording, data is not sent anywhere.
+     */
+    uint32_t send(const std::vector<uint8_t> &data) override;
+    uint32_t send(const transport_segment_t *segments, const size_t count) override;
+
+    /**
+     *@brief Waits until all records are replayed. Returns false on timeout.
+     */
+    bool waitForCompletion(const std::chrono::milliseconds timeout);
+
+  private:
+    // H5 packets replay waits for the upper layer to send
+    typedef enum {
+        LINK_PACKET_OTHER,
+        LINK_PACKET_SYNC,
+        LINK_PACKET_SYNC_CONFIG,
+        LINK_PACKET_RELIABLE
+    } link_packet_t;
+
+    // Keeps track of the packets sent on one side of the link
+    struct LinkPacketCounter
+    {
+        uint32_t syncCount;
+        uint32_t syncConfigCount;
+        uint32_t reliableCount;
+        link_packet_t lastPacket;
+        uint8_t lastReliableSeqNum;
+
+        LinkPacketCounter();
+
+        // Counts the SLIP encoded packet in data if it is new, returns the type counted.
+        // Repeated SYNC and SYNC CONFIG packets and retransmitted reliable packets are not
+        // counted, they are sent a varying number of times depending on timing.
+        link_packet_t count(const uint8_t *data, const size_t length);
+        uint32_t countOf(const link_packet_t packet) const;
+    };
+
+    void replayWorker();
+    bool readRecord(recording_direction_t &direction, uint32_t &delta,
+                    std::vector<uint8_t> &data);
+    void waitForSend(const link_packet_t packet, const uint32_t count);
+
+    std::string path;
+    bool originalTiming;
+
+    std::ifstream file;
+    std::thread replayThread;
+    std::atomic<bool> isOpen;
+    std::mutex publicMethodMutex;
+
+    LinkPacketCounter recorded; // Packets in the recording replayed so far
+
+    std::mutex stateMutex; // Protects the members below
+    std::condition_variable stateChanged;
+    LinkPacketCounter sent; // Packets sent by the upper layer
+    bool stopping;
+    bool completed;
+};
+
+#endif // REPLAY_TRANSPORT_H
@@ -38,22 +38,39 @@
 #ifndef SERIALIZATION_TRANSPORT_H
 #define SERIALIZATION_TRANSPORT_H
 
+#include "event_notifier.h"
+#include "spsc_ring.h"
 #include "transport.h"
 
 #include "ble.h"
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
 #include <thread>
 
+#include <cstddef>
 #include <cstdint>
-#include <queue>
 
 typedef uint32_t (*transport_rsp_handler_t)(const uint8_t *p_buffer, uint16_t length);
 typedef std::function<void(ble_evt_t *p_ble_evt)> evt_cb_t;
+typedef std::function<void(ble_evt_t **pp_ble_evts, uint32_t count)> evt_batch_cb_t;
 
-constexpr uint32_t MaxPossibleEventLength = 700;
+struct adapter_ble_gap_state_t;
+
+// Length of the largest decoded event of the SD API version the library is built for
+extern const uint32_t MaxEventLength;
+
+// Number of received events waiting for the application before events are dropped. The receiving
+// thread never waits for the application, it also handles responses and the data link layer, so
+// the queue holds a burst of events the application handles late. Dropped events are counted.
+constexpr size_t EventQueueCapacity = 2048;
+
+// Number of events handled by a dispatch thread of the runtime before other adapters get a turn
+constexpr uint32_t EventDispatchBudget = 64;
 
 struct eventData_t
 {
@@ -70,6 +87,9 @@ typedef enum {
     SERIALIZATION_RESET_CMD = 5
 } serialization_pkt_type_t;
 
+// Bytes reserved in front of a command for the serialization packet type
+constexpr size_t SerializationHeadroom = 1;
+
 class SerializationTransport
 {
   public:
@@ -83,17 +103,62 @@ class SerializationTransport
 
     uint32_t open(const status_cb_t &status_callback, const evt_cb_t &event_callback,
                   const log_cb_t &log_callback);
+    // Opens the transport with events passed to event_batch_callback, up to batchSize at a time.
+    // The first event of a batch waits at most maxLatency for more events.
+    uint32_t open(const status_cb_t &status_callback, const evt_batch_cb_t &event_batch_callback,
+                  const log_cb_t &log_callback, const uint32_t batchSize,
+                  const std::chrono::milliseconds maxLatency);
+    // Opens the transport without an event thread, the application gets events with getEvent
+    uint32_t open(const status_cb_t &status_callback, const log_cb_t &log_callback);
     uint32_t close();
+
+    // Decodes the next event into dest, as sd_ble_evt_get does. With dest nullptr only the length
+    // of the next event is returned. Only for a transport opened without an event callback.
+    uint32_t getEvent(uint8_t *dest, uint16_t *length);
+    // Descriptor readable while events are pending, -1 if not opened without an event callback
+    int eventFd();
     uint32_t send(const std::vector<uint8_t> &cmdBuffer,
-                  std::shared_ptr<std::vector<uint8_t>> rspBuffer,
+                  PooledBuffer rspBuffer,
                   serialization_pkt_type_t pktType = SERIALIZATION_COMMAND);
+    // Sends a packet where the first SerializationHeadroom bytes are reserved for the packet type.
+    // The packet type is written into the reserved bytes so the command is not copied. sent is
+    // called when the packet is passed to the layer below, before the response is waited for.
+    uint32_t sendPacket(uint8_t *packet, const size_t length, PooledBuffer rspBuffer,
+                        serialization_pkt_type_t pktType = SERIALIZATION_COMMAND,
+                        const std::function<void()> &sent = nullptr);
+
+    // Sets the buffer pool used for responses and events, and forwards it to the layers below
+    void setBufferPool(const std::shared_ptr<BufferPool> &pool);
+
+    // Sets the statistics of the adapter, and forwards them to the layers below
+    void setTransportStats(const std::shared_ptr<TransportStats> &stats);
+
+    // Sets the GAP state of the adapter, events are decoded with it
+    void setGapState(const std::shared_ptr<adapter_ble_gap_state_t> &state);
+
+    // Sets the runtime whose dispatch threads handle events instead of an event thread, and
+    // forwards it to the layers below
+    void setRuntime(const std::shared_ptr<Runtime> &sharedRuntime);
+
+    // Forwards the lowest severity the adapter logs to the layers below
+    void setLogSeverityFilter(const sd_rpc_log_severity_t severity);
 
   private:
+    PooledBuffer acquireBuffer(const size_t size) const;
+    uint32_t sendSegments(const transport_segment_t *segments, const size_t count,
+                          PooledBuffer rspBuffer, const std::function<void()> &sent);
     void readHandler(const uint8_t *data, const size_t length);
+    uint32_t openTransport(const status_cb_t &status_callback, const log_cb_t &log_callback);
     void eventHandlingRunner();
+    void scheduleEventDispatch();
+    void dispatchEvents();
+    void handleEventBatch(const std::chrono::milliseconds maxLatency);
+    bool decodeEvent(const PooledBuffer &eventData, ble_evt_t *event);
+    ble_evt_t *eventSlot(const uint32_t index) const;
 
     status_cb_t statusCallback;
     evt_cb_t eventCallback;
+    evt_batch_cb_t eventBatchCallback;
     log_cb_t logCallback;
 
     data_cb_t dataCallback;
@@ -101,18 +166,58 @@ class SerializationTransport
     std::shared_ptr<Transport> nextTransportLayer;
     uint32_t responseTimeout;
 
-    bool responseReceived;
-    std::shared_ptr<std::vector<uint8_t>> responseBuffer;
+    std::shared_ptr<BufferPool> bufferPool;
+    std::shared_ptr<TransportStats> transportStats;
+    std::shared_ptr<adapter_ble_gap_state_t> gapState;
+
+    // A command waiting for its response, kept by the sending thread
+    struct ResponseWaiter
+    {
+        PooledBuffer buffer;
+        bool received;
+    };
+
+    // A command sent and not answered yet. The waiter is nullptr when the sending thread no longer
+    // waits, the response is then discarded.
+    struct SentCommand
+    {
+        uint8_t opcode;
+        ResponseWaiter *waiter;
+    };
+
+    bool commandsAwaitingResponse() const;
 
-    std::mutex sendMutex;
+    std::mutex sendMutex; // Commands are queued in sentCommands in the order they are sent
 
+    // Several commands wait for their responses at once. The connectivity firmware answers the
+    // commands in the order they are received, a response is for the oldest command sent.
+    std::deque<SentCommand> sentCommands;
     std::mutex responseMutex;
     std::condition_variable responseWaitCondition;
 
-    std::mutex eventMutex;
-    std::condition_variable eventWaitCondition;
     std::thread eventThread;
-    std::queue<std::vector<uint8_t>> eventQueue;
+    SpscRing<PooledBuffer> eventQueue; // Filled by readHandler, emptied by the event thread
+
+    // Events are decoded into the arena by the event thread, one slot aligned for ble_evt_t per
+    // event of a batch
+    std::unique_ptr<std::max_align_t[]> eventDecodeArena;
+    uint32_t eventDecodeArenaSlots;
+    std::unique_ptr<ble_evt_t *[]> eventBatch; // Decoded events passed to eventBatchCallback
+    uint32_t eventBatchSize;
+    std::chrono::milliseconds eventBatchLatency;
+
+    // With a runtime, events are handled by a task on a dispatch thread. At most one task is
+    // scheduled at a time so the events of the adapter are handled in order.
+    std::shared_ptr<Runtime> runtime;
+    std::atomic<bool> eventDispatchScheduled;
+    std::mutex eventDispatchMutex;
+    std::condition_variable eventDispatchIdle;
+
+    // Events are pulled by the application with getEvent
+    std::atomic<bool> eventPullMode;
+    std::unique_ptr<EventNotifier> eventNotifier;
+    uint16_t pendingEventLength; // Length of the event decoded but not yet taken by getEvent
+    std::mutex eventGetMutex;    // Pulling threads take turns as the consumer of eventQueue
 
     std::atomic<bool> isOpen; // Variable is shared between threads
     std::mutex publicMethodMutex;
@@ -38,10 +38,53 @@
 #ifndef SLIP_H
 #define SLIP_H
 
+#include <cstddef>
+#include <functional>
 #include <stdint.h>
 #include <vector>
 
+constexpr uint8_t SLIP_END     = 0xC0;
+constexpr uint8_t SLIP_ESC     = 0xDB;
+constexpr uint8_t SLIP_ESC_END = 0xDC;
+constexpr uint8_t SLIP_ESC_ESC = 0xDD;
+
 void slip_encode(const std::vector<uint8_t> &in_packet, std::vector<uint8_t> &out_packet);
+// Escapes length bytes from in to out without adding the END delimiters. out must have room for
+// length * 2 bytes. Returns the position in out after the last byte written.
+uint8_t *slip_escape(const uint8_t *in, const size_t length, uint8_t *out);
 uint32_t slip_decode(const std::vector<uint8_t> &packet, std::vector<uint8_t> &out_packet);
 
+// Returns the offset of the first SLIP END or ESC byte in data, or length if there is none.
+// Uses the SIMD instructions available on the CPU (SSE2, AVX2 or NEON).
+size_t slip_find_special(const uint8_t *data, const size_t length);
+// Name of the implementation used by slip_find_special
+const char *slip_find_special_implementation();
+
+// Decodes a stream of SLIP encoded packets. Received data is unescaped directly into a frame
+// buffer that is allocated once and reused for all packets.
+class SlipDecoder
+{
+  public:
+    // Called for each packet found in the stream. packet is only valid until the callback returns.
+    typedef std::function<void(const uint8_t *packet, const size_t length, const uint32_t err_code)>
+        packet_cb_t;
+
+    SlipDecoder(const packet_cb_t &packet_callback, const size_t max_packet_length);
+
+    void decode(const uint8_t *data, const size_t length);
+    void reset();
+
+  private:
+    void appendToFrame(const uint8_t *data, const size_t length);
+    void endOfPacket();
+
+    packet_cb_t packetCallback;
+
+    std::vector<uint8_t> frame;
+    size_t frameLength;
+    bool frameStarted;
+    bool escapeFound;
+    uint32_t frameError;
+};
+
 #endif
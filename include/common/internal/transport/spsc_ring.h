@@ -0,0 +1,270 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <memory>
+#include <stdint.h>
+
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#else
+#include <condition_variable>
+#include <mutex>
+#endif
+
+// Puts a thread to sleep until another thread wakes it. The sleeper announces itself before it
+// checks its condition a last time, a wake up between the check and the sleep is not lost.
+// Waking costs one atomic load when nobody sleeps. Uses a futex on Linux.
+class Waiter
+{
+  public:
+    Waiter()
+        : sleeping(0)
+    {}
+
+    Waiter(const Waiter &) = delete;
+    Waiter &operator=(const Waiter &) = delete;
+
+    // Sleeps until woken, unless ready returns true after the thread announced it sleeps.
+    // May return spuriously, callers check their condition again.
+    template <typename Ready> void wait(const Ready &ready)
+    {
+        sleeping.store(1, std::memory_order_seq_cst);
+
+        if (ready())
+        {
+            sleeping.store(0, std::memory_order_relaxed);
+            return;
+        }
+
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&sleeping), FUTEX_WAIT_PRIVATE, 1,
+                nullptr, nullptr, 0);
+#else
+        std::unique_lock<std::mutex> lock(mutex);
+        woken.wait(lock, [this] { return sleeping.load(std::memory_order_seq_cst) == 0; });
+#endif
+        sleeping.store(0, std::memory_order_relaxed);
+    }
+
+    // As wait, but returns when timeout has passed
+    template <typename Ready>
+    void waitFor(const Ready &ready, const std::chrono::nanoseconds timeout)
+    {
+        sleeping.store(1, std::memory_order_seq_cst);
+
+        if (ready())
+        {
+            sleeping.store(0, std::memory_order_relaxed);
+            return;
+        }
+
+#if defined(__linux__)
+        const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+        timespec relativeTimeout;
+        relativeTimeout.tv_sec  = static_cast<time_t>(seconds.count());
+        relativeTimeout.tv_nsec = static_cast<long>((timeout - seconds).count());
+
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&sleeping), FUTEX_WAIT_PRIVATE, 1,
+                &relativeTimeout, nullptr, 0);
+#else
+        std::unique_lock<std::mutex> lock(mutex);
+        woken.wait_for(lock, timeout,
+                       [this] { return sleeping.load(std::memory_order_seq_cst) == 0; });
+#endif
+        sleeping.store(0, std::memory_order_relaxed);
+    }
+
+    void wake()
+    {
+        if (sleeping.load(std::memory_order_seq_cst) == 0 ||
+            sleeping.exchange(0, std::memory_order_seq_cst) == 0)
+        {
+            return;
+        }
+
+#if defined(__linux__)
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&sleeping), FUTEX_WAKE_PRIVATE, 1,
+                nullptr, nullptr, 0);
+#else
+        std::lock_guard<std::mutex> lock(mutex);
+        woken.notify_one();
+#endif
+    }
+
+  private:
+    std::atomic<uint32_t> sleeping;
+
+#if !defined(__linux__)
+    std::mutex mutex;
+    std::condition_variable woken;
+#endif
+};
+
+// Bounded lock-free queue with one producer thread and one consumer thread. The capacity is
+// rounded up to a power of two. The consumer is woken only when it waits for an empty queue, the
+// producer only when it waits for a full queue.
+template <typename T> class SpscRing
+{
+  public:
+    explicit SpscRing(const size_t capacity)
+        : mask(roundUpToPowerOfTwo(capacity) - 1)
+        , slots(new T[mask + 1])
+        , headPadding()
+        , head(0)
+        , tailPadding()
+        , tail(0)
+        , waiterPadding()
+    {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer. Moves item into the queue and returns true, or returns false if the queue is full.
+    bool push(T &&item)
+    {
+        const auto currentTail = tail.load(std::memory_order_relaxed);
+
+        if (currentTail - head.load(std::memory_order_acquire) > mask)
+        {
+            return false;
+        }
+
+        slots[currentTail & mask] = std::move(item);
+        tail.store(currentTail + 1, std::memory_order_seq_cst);
+        consumer.wake();
+        return true;
+    }
+
+    // Consumer. Moves the oldest item to item and returns true, or returns false if the queue is
+    // empty.
+    bool pop(T &item)
+    {
+        const auto currentHead = head.load(std::memory_order_relaxed);
+
+        if (currentHead == tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        item = std::move(slots[currentHead & mask]);
+        slots[currentHead & mask] = T();
+        head.store(currentHead + 1, std::memory_order_seq_cst);
+        producer.wake();
+        return true;
+    }
+
+    // Consumer. Waits until the queue is not empty or stop returns true.
+    template <typename Stop> void waitWhileEmpty(const Stop &stop)
+    {
+        consumer.wait([&] { return !empty() || stop(); });
+    }
+
+    // Consumer. Waits until the queue is not empty, stop returns true or timeout has passed.
+    template <typename Stop>
+    void waitWhileEmptyFor(const Stop &stop, const std::chrono::nanoseconds timeout)
+    {
+        consumer.waitFor([&] { return !empty() || stop(); }, timeout);
+    }
+
+    // Producer. Waits until the queue is not full or stop returns true.
+    template <typename Stop> void waitWhileFull(const Stop &stop)
+    {
+        producer.wait([&] { return size() <= mask || stop(); });
+    }
+
+    // Wakes the waiting threads, after the condition of their stop function changed
+    void wakeAll()
+    {
+        consumer.wake();
+        producer.wake();
+    }
+
+    bool empty() const
+    {
+        return size() == 0;
+    }
+
+    size_t size() const
+    {
+        return tail.load(std::memory_order_seq_cst) - head.load(std::memory_order_seq_cst);
+    }
+
+    size_t capacity() const
+    {
+        return mask + 1;
+    }
+
+  private:
+    static size_t roundUpToPowerOfTwo(const size_t value)
+    {
+        size_t result = 1;
+
+        while (result < value)
+        {
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+    static constexpr size_t CacheLineSize = 64;
+
+    const size_t mask;
+    std::unique_ptr<T[]> slots;
+
+    // Written by one thread each, padded to keep them on separate cache lines. The ring is
+    // allocated with new, which does not guarantee alignment beyond alignof(max_align_t).
+    char headPadding[CacheLineSize];
+    std::atomic<size_t> head; // Next slot to pop
+    char tailPadding[CacheLineSize - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> tail; // Next slot to push
+    char waiterPadding[CacheLineSize - sizeof(std::atomic<size_t>)];
+
+    Waiter consumer;
+    Waiter producer;
+};
+
+#endif // SPSC_RING_H
@@ -38,9 +38,15 @@
 #ifndef TRANSPORT_H
 #define TRANSPORT_H
 
+#include "buffer_pool.h"
 #include "sd_rpc_types.h"
+#include "transport_stats.h"
 
+#include <atomic>
+#include <chrono>
+#include <cstddef>
 #include <functional>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -50,6 +56,17 @@ typedef std::function<void(const sd_rpc_app_status_t code, const std::string &me
 typedef std::function<void(const uint8_t *data, const size_t length)> data_cb_t;
 typedef std::function<void(const sd_rpc_log_severity_t severity, const std::string &message)>
     log_cb_t;
+typedef std::function<void()> timer_cb_t;
+
+class Runtime;
+
+// A contiguous part of a packet. A packet can be sent as a list of segments, headers and payload
+// then do not have to be concatenated into one buffer before they are sent.
+struct transport_segment_t
+{
+    const uint8_t *data;
+    size_t length;
+};
 
 class Transport
 {
@@ -60,8 +77,40 @@ class Transport
     virtual uint32_t close() = 0;
 
     virtual uint32_t send(const std::vector<uint8_t> &data) = 0;
+    // Sends the segments as one packet. The data is no longer referenced when the call returns.
+    // The default implementation concatenates the segments and calls send with the result.
+    virtual uint32_t send(const transport_segment_t *segments, const size_t count);
+
+    // Sets the buffer pool of the adapter, layers forward it to the layer below
+    virtual void setBufferPool(const std::shared_ptr<BufferPool> &pool);
+
+    // Sets the statistics of the adapter the layer counts into
+    virtual void setTransportStats(const std::shared_ptr<TransportStats> &stats);
+
+    // Sets the runtime whose threads run the adapter, layers forward it to the layer below. Set
+    // before the layer is opened.
+    virtual void setRuntime(const std::shared_ptr<Runtime> &sharedRuntime);
+
+    // Sets the lowest severity the adapter logs, layers forward it to the layer below. Layers
+    // check it with logEnabled before building log messages that are expensive to build.
+    virtual void setLogSeverityFilter(const sd_rpc_log_severity_t severity);
+
+    // Sets the handler the layer calls on its I/O thread when the timer expires, layers forward
+    // it to the layer below. Set before the layer is opened. Returns false if the layer has no
+    // I/O thread to run the timer on, the default.
+    virtual bool setTimerHandler(const timer_cb_t &handler);
+
+    // Makes the timer expire no later than deadline. The handler is called once for the earliest
+    // deadline scheduled since it was last called, and may be called early. It schedules the
+    // deadlines it still needs again. Cheap when an earlier deadline is already scheduled.
+    virtual void scheduleTimer(const std::chrono::steady_clock::time_point deadline);
+
+    // Stores the write statistics of a physical layer in stats. Returns NRF_ERROR_NOT_SUPPORTED
+    // if the layer keeps no write statistics, the default. Wrapping layers forward it.
+    virtual uint32_t physicalLayerStats(sd_rpc_physical_layer_stats_t *stats);
 
     void log(const sd_rpc_log_severity_t severity, const std::string &message) const;
+    bool logEnabled(const sd_rpc_log_severity_t severity) const;
     void status(const sd_rpc_app_status_t code, const std::string &message) const;
 
   protected:
@@ -70,6 +119,18 @@ class Transport
     status_cb_t upperStatusCallback;
     data_cb_t upperDataCallback;
     log_cb_t upperLogCallback;
+
+    // Returns a buffer from the buffer pool, or from the heap if no pool is set
+    PooledBuffer acquireBuffer(const size_t size) const;
+    std::shared_ptr<BufferPool> bufferPool;
+
+    // Statistics of the adapter, nullptr if the layer is used without an adapter
+    std::shared_ptr<TransportStats> transportStats;
+
+    // Threads shared with other adapters, nullptr if the layer runs its own threads
+    std::shared_ptr<Runtime> runtime;
+
+    std::atomic<sd_rpc_log_severity_t> logSeverityFilter;
 };
 
 #endif // TRANSPORT_H
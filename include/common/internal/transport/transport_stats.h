@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef TRANSPORT_STATS_H
+#define TRANSPORT_STATS_H
+
+#include "sd_rpc_types.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <stdint.h>
+
+// Runtime statistics of an adapter, shared by all its layers. Counters are updated with relaxed
+// atomic operations only, so they can stay enabled in production.
+class TransportStats
+{
+  public:
+    TransportStats();
+
+    TransportStats(const TransportStats &) = delete;
+    TransportStats &operator=(const TransportStats &) = delete;
+
+    // Data link layer
+    void packetSent(const size_t bytes);
+    void packetReceived();
+    void dataReceived(const size_t bytes);
+    void retransmission();
+    void decodeError();
+
+    // Serialization layer
+    void eventQueued();
+    void eventDequeued();
+    void eventsDropped(const uint32_t count);
+    void commandCompleted(const uint8_t opcode, const std::chrono::steady_clock::duration latency);
+    void commandTimedOut();
+
+    void stats(sd_rpc_stats_t *stats) const;
+
+  private:
+    struct Histogram
+    {
+        std::atomic<uint32_t> count;
+        std::atomic<uint32_t> max;
+        std::atomic<uint64_t> total;
+        std::array<std::atomic<uint32_t>, SD_RPC_LATENCY_BUCKET_COUNT> buckets;
+    };
+
+    std::atomic<uint64_t> packetsSent;
+    std::atomic<uint64_t> packetsReceived;
+    std::atomic<uint64_t> bytesSent;
+    std::atomic<uint64_t> bytesReceived;
+    std::atomic<uint64_t> retransmissionCount;
+    std::atomic<uint64_t> decodeErrorCount;
+    std::atomic<uint64_t> eventsReceived;
+    std::atomic<uint64_t> droppedEventCount;
+    std::atomic<uint32_t> eventQueueDepth;
+    std::atomic<uint32_t> eventQueueHighWaterMark;
+    std::atomic<uint64_t> commandTimeoutCount;
+
+    std::array<Histogram, SD_RPC_OPCODE_COUNT> commandLatency;
+};
+
+// Write statistics of a physical layer. Not thread safe, the physical layer updates and reads it
+// while holding the lock of the data it has queued for writing.
+class WriteStats
+{
+  public:
+    WriteStats();
+
+    void queued(const size_t bytes);
+    void written(const size_t bytes); // One write operation
+
+    void stats(sd_rpc_physical_layer_stats_t *stats, const size_t pending) const;
+
+  private:
+    uint64_t bytesQueued;
+    uint64_t bytesWritten;
+    uint64_t writeCount;
+    uint32_t writesInRateWindow;
+    uint32_t writesPerSecond;
+    std::chrono::steady_clock::time_point rateWindowStart;
+};
+
+#endif // TRANSPORT_STATS_H
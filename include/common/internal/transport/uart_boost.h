@@ -45,14 +45,21 @@
 #include <asio.hpp>
 
 #include <array>
-#include <deque>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include <stdint.h>
 
 /**
  * @brief The UartBoost class opens, reads and writes a serial port using the boost asio library
+ *
+ * The handlers run on a thread of the serial port, or on the I/O threads of the runtime if one is
+ * set.
  */
 class UartBoost : public Transport
 {
@@ -78,9 +85,32 @@ class UartBoost : public Transport
 
     /**
      *@brief sends data to serial port to write.
+     *
+     * Waits for room in the write ring, except on the I/O thread of the serial port. The I/O
+     * thread makes the room, data it sends while the ring is full is queued behind the ring.
      */
     uint32_t send(const std::vector<uint8_t> &data) override;
 
+    /**
+     *@brief sends the segments to serial port to write, the segments are written with one
+     * gather write.
+     */
+    uint32_t send(const transport_segment_t *segments, const size_t count) override;
+
+    /**
+     *@brief Stores statistics of data written to the serial port in stats.
+     */
+    uint32_t physicalLayerStats(sd_rpc_physical_layer_stats_t *stats) override;
+
+    /**
+     *@brief Runs the serial port on the I/O threads of the runtime.
+     */
+    void setRuntime(const std::shared_ptr<Runtime> &sharedRuntime) override;
+
+    // The timer expires on the I/O service of the serial port, in the strand with a runtime
+    bool setTimerHandler(const timer_cb_t &handler) override;
+    void scheduleTimer(const std::chrono::steady_clock::time_point deadline) override;
+
   private:
     /**
      *@brief Called when background thread receives bytes from uart.
@@ -107,15 +137,44 @@ class UartBoost : public Transport
      */
     void asyncWrite();
 
+    /**
+     *@brief Called at the end of a read or write handler.
+     */
+    void operationCompleted();
+
+    void timerWaitHandler(const asio::error_code &errorCode);
+
+    /**
+     *@brief Returns true if called from a handler of the serial port.
+     */
+    bool runningInIoThread() const;
+
+    /**
+     *@brief Copies data to the end of the write ring, queueMutex must be held.
+     */
+    void copyToWriteRing(const uint8_t *data, const size_t length);
+
     std::array<uint8_t, BUFFER_SIZE> readBuffer;
-    std::vector<uint8_t> writeBufferVector;
-    std::deque<uint8_t> writeQueue;
-    std::mutex queueMutex;
-    std::mutex publicMethodMutex;
-    bool isOpen;
+    // Data waiting to be written. The data from writeRingHead and writeRingUsed bytes on, wrapping
+    // at the end, is queued. Everything queued is handed to asio in one write, as up to two
+    // contiguous regions.
+    std::vector<uint8_t> writeRing;
+    size_t writeRingHead;
+    size_t writeRingUsed;
+    // Data sent by the I/O thread while the write ring is full, moved to the ring as writes
+    // complete. Other senders wait until it is empty to keep the order of the data.
+    std::vector<uint8_t> writeOverflow;
+    std::condition_variable writeRingSpaceAvailable;
+    std::mutex queueMutex; // Protects the write ring and the write statistics
+
+    WriteStats writeStats; // Protected by queueMutex
+
+    std::mutex publicMethodMutex; // Not taken by the I/O thread, senders hold it while waiting
+    std::atomic<bool> isOpen;
 
     std::function<void(const asio::error_code, const size_t)> callbackReadHandle;
     std::function<void(const asio::error_code, const size_t)> callbackWriteHandle;
+    std::function<void(const asio::error_code)> callbackTimerHandle;
 
     UartSettingsBoost uartSettingsBoost;
     bool asyncWriteInProgress;
@@ -126,6 +185,19 @@ class UartBoost : public Transport
 
     asio::io_service::work *workNotifier;
 
+    // With a runtime the read and write handlers run in a strand on the I/O threads of the
+    // runtime, close waits for the outstanding operations to complete
+    std::unique_ptr<asio::io_service::strand> strand;
+    size_t pendingOperations;
+    std::mutex operationsMutex;
+    std::condition_variable operationsCompleted;
+
+    // Timer of the layer above. timerDeadline is the deadline waited for, max if none and min
+    // when closed.
+    std::unique_ptr<asio::steady_timer> timer;
+    timer_cb_t timerHandler;
+    std::mutex timerMutex; // Serializes use of timer
+    std::atomic<std::chrono::steady_clock::time_point> timerDeadline;
 };
 
 #endif // UART_BOOST_H
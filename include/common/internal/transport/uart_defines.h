@@ -48,4 +48,8 @@
 #define BUFFER_SIZE 256
 #define BUFFER_SIZE_LARGE 8192
 
+/**@brief Size of the ring buffer holding data waiting to be written to the serial port
+ */
+#define WRITE_RING_BUFFER_SIZE 65536
+
 #endif // UARTDEFINES_H
@@ -74,6 +74,79 @@ SD_RPC_API uint32_t sd_rpc_serial_port_enum(sd_rpc_serial_port_desc_t serial_por
  */
 SD_RPC_API physical_layer_t *sd_rpc_physical_layer_create_uart(const char * port_name, uint32_t baud_rate, sd_rpc_flow_control_t flow_control, sd_rpc_parity_t parity);
 
+/**@brief Create a new serial physical layer using the operating system's serial port interface
+ *        directly.
+ *
+ * The port is read and written without going through boost::asio, which gives lower latency on
+ * drivers supporting low latency mode. Only available on Linux.
+ *
+ * @param[in]  port_name  The serial port name.
+ * @param[in]  baud_rate  The serial port speed.
+ * @param[in]  flow_control  The flow control scheme to use.
+ * @param[in]  parity  The parity scheme to use.
+ *
+ * @retval The physical layer or NULL if not supported on this platform.
+ */
+SD_RPC_API physical_layer_t *sd_rpc_physical_layer_create_uart_native(const char * port_name, uint32_t baud_rate, sd_rpc_flow_control_t flow_control, sd_rpc_parity_t parity);
+
+/**@brief Create a new physical layer connected to a local peer process instead of a device.
+ *
+ * Lets an adapter run against a connectivity firmware simulator or a test peer, without any
+ * hardware attached. Only available on Linux.
+ *
+ * @param[in]  path  A Unix domain stream socket the peer listens on, or the slave side of a
+ *                   pseudo terminal the peer holds the master side of. The socket must exist when
+ *                   this function is called.
+ *
+ * @retval The physical layer or NULL if not supported on this platform.
+ */
+SD_RPC_API physical_layer_t *sd_rpc_physical_layer_create_local(const char * path);
+
+/**@brief Create a new physical layer recording the traffic of another physical layer.
+ *
+ * Every read from and write to physical_layer is stored with a timestamp in a binary file, which
+ * can be replayed with @ref sd_rpc_physical_layer_create_replay. The file is created when the
+ * adapter is opened, an existing file is overwritten.
+ *
+ * @param[in]  physical_layer  The physical layer to record, owned by the returned physical layer.
+ * @param[in]  file_path  The recording file to create.
+ *
+ * @retval The physical layer or NULL.
+ */
+SD_RPC_API physical_layer_t *sd_rpc_physical_layer_create_recording(physical_layer_t *physical_layer, const char * file_path);
+
+/**@brief Create a new physical layer replaying a recording instead of communicating with a device.
+ *
+ * The recorded reads are passed to the data link layer as fast as possible, or with the timing
+ * they were recorded with. The application must issue the same commands as when the recording
+ * was made, replay waits for the data link layer to send each packet the recording has a
+ * response to. No hardware is needed.
+ *
+ * @param[in]  file_path  A recording made with @ref sd_rpc_physical_layer_create_recording.
+ * @param[in]  timing  The timing to replay with.
+ *
+ * @retval The physical layer or NULL.
+ */
+SD_RPC_API physical_layer_t *sd_rpc_physical_layer_create_replay(const char * file_path, sd_rpc_replay_timing_t timing);
+
+/**@brief Get write statistics of a physical layer.
+ *
+ * Data sent while a write is in progress is written together with all other data queued in the
+ * meantime, compare write_count with bytes_written to see how well writes are coalesced.
+ *
+ * The uart, uart_native and local physical layers keep write statistics, a recording physical
+ * layer returns the statistics of the physical layer it records. The replay physical layer keeps
+ * none.
+ *
+ * @param[in]  physical_layer  The physical layer to get statistics from.
+ * @param[out] stats  The write statistics.
+ *
+ * @retval NRF_SUCCESS  The statistics are stored in stats.
+ * @retval NRF_ERROR_NULL  physical_layer or stats is NULL.
+ * @retval NRF_ERROR_NOT_SUPPORTED  The physical layer does not provide statistics.
+ */
+SD_RPC_API uint32_t sd_rpc_physical_layer_stats_get(physical_layer_t *physical_layer, sd_rpc_physical_layer_stats_t *stats);
+
 /**@brief Create a new data link layer.
  *
  * @param[in]  physical_layer  The physical layer to use with this data link layer.
@@ -83,6 +156,38 @@ SD_RPC_API physical_layer_t *sd_rpc_physical_layer_create_uart(const char * port
  */
 SD_RPC_API data_link_layer_t *sd_rpc_data_link_layer_create_bt_three_wire(physical_layer_t *physical_layer, uint32_t retransmission_interval);
 
+/**@brief Create a new data link layer that delays acknowledgements of received packets.
+ *
+ * Acknowledgements are sent with the next packet sent to the device. An acknowledgement is only
+ * sent separately if no packet is sent to the device within ack_delay, or when half of the sliding
+ * window is waiting to be acknowledged. With a sliding window of one packet, as used by the
+ * connectivity firmware, the device can not send its next packet before the acknowledgement is
+ * received. A delay that is not ended by a packet sent to the device then slows down the packets
+ * received by up to ack_delay each.
+ *
+ * @param[in]  physical_layer  The physical layer to use with this data link layer.
+ * @param[in]  retransmission_interval  Response timeout of the data link layer.
+ * @param[in]  ack_delay  Max time in milliseconds to delay an acknowledgement, 0 disables delaying.
+ *                        Limited to half of retransmission_interval.
+ *
+ * @retval The data link layer or NULL.
+ */
+SD_RPC_API data_link_layer_t *sd_rpc_data_link_layer_create_bt_three_wire_delayed_ack(physical_layer_t *physical_layer, uint32_t retransmission_interval, uint32_t ack_delay);
+
+/**@brief Get the round-trip time estimate of a data link layer.
+ *
+ * The retransmission timeout of the data link layer is derived from the round-trip times
+ * measured on the link. The retransmission interval given when the data link layer is created is
+ * used until a round-trip time is measured.
+ *
+ * @param[in]  data_link_layer  The data link layer to get the estimate from.
+ * @param[out] rtt_estimate  The round-trip time estimate.
+ *
+ * @retval NRF_SUCCESS  The estimate is stored in rtt_estimate.
+ * @retval NRF_ERROR_NULL  data_link_layer or rtt_estimate is NULL.
+ */
+SD_RPC_API uint32_t sd_rpc_data_link_layer_rtt_estimate_get(data_link_layer_t *data_link_layer, sd_rpc_rtt_estimate_t *rtt_estimate);
+
 /**@brief Create a new transport layer.
  *
  * @param[in]  data_link_layer  The data linkk layer to use with this transport.
@@ -100,6 +205,93 @@ SD_RPC_API transport_layer_t *sd_rpc_transport_layer_create(data_link_layer_t *d
  */
 SD_RPC_API adapter_t *sd_rpc_adapter_create(transport_layer_t* transport_layer);
 
+/**@brief Create a new transport adapter with a configured buffer pool.
+ *
+ * Buffers for commands, responses and events are taken from a pool owned by the adapter, shared
+ * by all the layers of the adapter. Buffers are allocated on the heap when the pool is exhausted,
+ * see @ref sd_rpc_buffer_pool_stats_get. sd_rpc_adapter_create uses a pool of 265 buffers of 1024
+ * bytes, one for each of the first 256 events queued, the 7 packets of the largest H5 sliding
+ * window and the request and response of a command.
+ *
+ * @param[in]  transport_layer  The transport layer to use with this adapter.
+ * @param[in]  buffer_pool_config  Size and number of buffers in the pool.
+ *
+ * @retval The adapter or NULL if buffer_pool_config is NULL.
+ */
+SD_RPC_API adapter_t *sd_rpc_adapter_create_with_buffer_pool(transport_layer_t* transport_layer, const sd_rpc_buffer_pool_config_t *buffer_pool_config);
+
+/**@brief Create a runtime that adapters share instead of starting threads of their own.
+ *
+ * The I/O threads of the runtime read and write the physical layers of the adapters, the dispatch
+ * threads call the event handlers. The events of an adapter are handled in order, one at a time.
+ * The timers of the H5 data link layer run on the I/O thread of its physical layer. The data link
+ * layer only keeps a timer thread of its own when the physical layer does not run timers, which is
+ * the case for the replay physical layer.
+ *
+ * The adapters of a runtime are isolated from each other, an I/O thread never waits for an
+ * adapter. Events an event handler has not yet taken are queued, and dropped when too many are
+ * queued, see @ref sd_rpc_stats_get. An event handler that blocks holds one dispatch thread, the
+ * other adapters keep running when there are more dispatch threads than blocked handlers. The
+ * status and log handlers may be called on the I/O threads and must not block.
+ *
+ * @param[in]  runtime_config  Number of I/O and dispatch threads.
+ *
+ * @retval The runtime or NULL if runtime_config is NULL or invalid, or the threads can not be
+ *         started.
+ */
+SD_RPC_API sd_rpc_runtime_t *sd_rpc_runtime_create(const sd_rpc_runtime_config_t *runtime_config);
+
+/**@brief Delete a runtime.
+ *
+ * Adapters created with the runtime keep it running until they are deleted. The last adapter or
+ * runtime deleted stops the threads. When that happens in an event handler the threads are stopped
+ * after the handler returns.
+ *
+ * @param[in]  runtime  The runtime.
+ *
+ * @retval NRF_SUCCESS  The runtime was deleted.
+ * @retval NRF_ERROR_NULL  runtime is NULL.
+ * @retval NRF_ERROR_INVALID_STATE  The runtime is already deleted.
+ */
+SD_RPC_API uint32_t sd_rpc_runtime_delete(sd_rpc_runtime_t *runtime);
+
+/**@brief Create a new transport adapter that runs on a shared runtime.
+ *
+ * sd_rpc_open and sd_rpc_open_batch handle the events of the adapter on the dispatch threads of
+ * the runtime. sd_rpc_close fails when called from an event handler of the adapter.
+ *
+ * @param[in]  transport_layer  The transport layer to use with this adapter.
+ * @param[in]  runtime  The runtime created with sd_rpc_runtime_create.
+ *
+ * @retval The adapter or NULL if runtime is NULL or deleted.
+ */
+SD_RPC_API adapter_t *sd_rpc_adapter_create_with_runtime(transport_layer_t* transport_layer, sd_rpc_runtime_t *runtime);
+
+/**@brief Get usage statistics of the buffer pool of an adapter.
+ *
+ * @param[in]  adapter  The transport adapter.
+ * @param[out] stats  The buffer pool statistics.
+ *
+ * @retval NRF_SUCCESS  The statistics are stored in stats.
+ * @retval NRF_ERROR_NULL  adapter or stats is NULL.
+ * @retval NRF_ERROR_INVALID_PARAM  The adapter is deleted.
+ */
+SD_RPC_API uint32_t sd_rpc_buffer_pool_stats_get(adapter_t *adapter, sd_rpc_buffer_pool_stats_t *stats);
+
+/**@brief Get runtime statistics of an adapter.
+ *
+ * The statistics are counted by all layers of the adapter without taking any locks. The values
+ * are read one by one while the adapter is running, they are not a consistent snapshot.
+ *
+ * @param[in]  adapter  The transport adapter.
+ * @param[out] stats  The statistics.
+ *
+ * @retval NRF_SUCCESS  The statistics are stored in stats.
+ * @retval NRF_ERROR_NULL  adapter or stats is NULL.
+ * @retval NRF_ERROR_INVALID_PARAM  The adapter is deleted.
+ */
+SD_RPC_API uint32_t sd_rpc_stats_get(adapter_t *adapter, sd_rpc_stats_t *stats);
+
 /**@brief Delete a transport adapter.
  *
  * @param[in]  adapter  The transport adapter.
@@ -122,17 +314,131 @@ SD_RPC_API void sd_rpc_adapter_delete(adapter_t *adapter);
  */
 SD_RPC_API uint32_t sd_rpc_open(adapter_t *adapter, sd_rpc_status_handler_t status_handler, sd_rpc_evt_handler_t event_handler, sd_rpc_log_handler_t log_handler);
 
+/**@brief Initialize the SoftDevice RPC module with an event handler that receives events in
+ *        batches.
+ *
+ * @note The events queued when the event thread wakes up are decoded and passed to the handler
+ *       together, up to config.max_batch_size events. The first event of a batch waits at most
+ *       config.max_latency_ms for more events to arrive. The events are valid until the handler
+ *       returns.
+ *
+ * @param[in]  adapter  The transport adapter.
+ * @param[in]  status_handler  The status handler callback.
+ * @param[in]  evt_batch_handler  The batch event handler callback.
+ * @param[in]  log_handler  The log handler callback.
+ * @param[in]  config  The batch configuration.
+ *
+ * @retval NRF_SUCCESS  The module was opened successfully.
+ * @retval NRF_ERROR_NULL  adapter or config is NULL.
+ * @retval NRF_ERROR_INVALID_PARAM  The adapter is deleted or the batch size is out of range.
+ * @retval NRF_ERROR    There was an error opening the module.
+ */
+SD_RPC_API uint32_t sd_rpc_open_batch(adapter_t *adapter, sd_rpc_status_handler_t status_handler,
+                                      sd_rpc_evt_batch_handler_t evt_batch_handler,
+                                      sd_rpc_log_handler_t log_handler,
+                                      const sd_rpc_evt_batch_config_t *config);
+
+/**@brief Initialize the SoftDevice RPC module without an event handler, the application gets the
+ *        events with @ref sd_rpc_evt_get.
+ *
+ * @note No event thread is started. Events are queued until the application gets them. The
+ *       transport never waits for the application, when 2048 events are queued further events are
+ *       dropped and counted in events_dropped of @ref sd_rpc_stats_get. Commands are answered
+ *       while events are queued. Use @ref sd_rpc_evt_fd to wait for events in a poll, select or
+ *       epoll loop.
+ *
+ * @param[in]  adapter  The transport adapter.
+ * @param[in]  status_handler  The status handler callback.
+ * @param[in]  log_handler  The log handler callback.
+ *
+ * @retval NRF_SUCCESS  The module was opened successfully.
+ * @retval NRF_ERROR_NULL  adapter is NULL.
+ * @retval NRF_ERROR_INVALID_PARAM  The adapter is deleted.
+ * @retval NRF_ERROR    There was an error opening the module.
+ */
+SD_RPC_API uint32_t sd_rpc_open_pull(adapter_t *adapter, sd_rpc_status_handler_t status_handler,
+                                     sd_rpc_log_handler_t log_handler);
+
+/**@brief Get an event from an adapter opened with @ref sd_rpc_open_pull.
+ *
+ * @note Works as sd_ble_evt_get of the SoftDevice. The event is decoded into p_dest, with p_dest
+ *       NULL only the length of the next event is stored in p_len. Call the function until it
+ *       returns NRF_ERROR_NOT_FOUND before waiting for the descriptor from @ref sd_rpc_evt_fd
+ *       again. Must not be called from more than one thread at a time.
+ *
+ * @param[in]  adapter  The transport adapter.
+ * @param[out] p_dest  Buffer aligned as ble_evt_t for the event, or NULL.
+ * @param[in, out] p_len  Length of p_dest, set to the length of the event.
+ *
+ * @retval NRF_SUCCESS  The event is stored in p_dest, or its length in p_len if p_dest is NULL.
+ * @retval NRF_ERROR_NULL  adapter or p_len is NULL.
+ * @retval NRF_ERROR_NOT_FOUND  No events are pending.
+ * @retval NRF_ERROR_DATA_SIZE  p_dest is too small for the event, its length is stored in p_len.
+ * @retval NRF_ERROR_INVALID_STATE  The adapter is not opened with @ref sd_rpc_open_pull.
+ * @retval NRF_ERROR_INVALID_PARAM  The adapter is deleted.
+ */
+SD_RPC_API uint32_t sd_rpc_evt_get(adapter_t *adapter, uint8_t *p_dest, uint16_t *p_len);
+
+/**@brief Get a file descriptor that is readable while events are pending.
+ *
+ * @note The descriptor belongs to the adapter, do not read or close it. It stays the same when the
+ *       adapter is opened again and is closed when the adapter is deleted.
+ *
+ * @param[in]  adapter  The transport adapter.
+ *
+ * @return The descriptor, or -1 if the adapter is not opened with @ref sd_rpc_open_pull or the
+ *         platform has no such descriptor (Windows).
+ */
+SD_RPC_API int sd_rpc_evt_fd(adapter_t *adapter);
+
 /**@brief Close the SoftDevice RPC module.
  *
  * @note This function will close the serial port and release allocated resources.
  *
+ * @note Events received but not yet passed to the application are discarded and counted in
+ *       events_dropped of @ref sd_rpc_stats_get, they are not passed on when the adapter is opened
+ *       again.
+ *
  * @param[in]  adapter  The transport adapter.
  *
  * @retval NRF_SUCCESS  The module was closed successfully.
+ * @retval NRF_ERROR_INVALID_STATE  Called from a command or complete_handler of
+ *                                  @ref sd_rpc_command_async.
  * @retval NRF_ERROR    There was an error closing the module.
  */
 SD_RPC_API uint32_t sd_rpc_close(adapter_t *adapter);
 
+/**@brief Queue a command to be run asynchronously on a worker thread of the adapter.
+ *
+ * @note command typically calls one sd_ble_* function with the parameters in p_context, and
+ *       complete_handler gets its return value. Output parameters of the sd_ble_* function are
+ *       written before complete_handler is called, they must stay valid until then. Commands are
+ *       queued from any number of threads and their requests are sent in that order. A command is
+ *       started when the command queued before it has sent its request, so up to 7 commands,
+ *       the size of the H5 sliding window, wait for their responses at once. A command making
+ *       more than one sd_ble_* call holds up the commands after it until its first call is sent.
+ *
+ * @note complete_handler is called on a worker thread, in the order the commands are queued and
+ *       one at a time. It may queue another command. A command running when the adapter is closed
+ *       completes with its own result, @ref sd_rpc_close waits for it. Commands not run are
+ *       completed with NRF_ERROR_INVALID_STATE. @ref sd_rpc_close must not be called from a
+ *       command or complete_handler, it returns NRF_ERROR_INVALID_STATE there.
+ *
+ * @param[in]  adapter  The transport adapter.
+ * @param[in]  command  The command to run.
+ * @param[in]  complete_handler  Called with the result of command on the worker thread, or NULL.
+ * @param[in]  p_context  Passed to command and complete_handler.
+ *
+ * @retval NRF_SUCCESS  The command is queued.
+ * @retval NRF_ERROR_NULL  adapter or command is NULL.
+ * @retval NRF_ERROR_INVALID_STATE  The adapter is not open.
+ * @retval NRF_ERROR_NO_MEM  Too many commands are queued.
+ * @retval NRF_ERROR_INVALID_PARAM  The adapter is deleted.
+ */
+SD_RPC_API uint32_t sd_rpc_command_async(adapter_t *adapter, sd_rpc_command_handler_t command,
+                                         sd_rpc_command_complete_handler_t complete_handler,
+                                         void *p_context);
+
 /**@brief Set the lowest log level for messages to be logged to handler.
  *        Default log handler severity filter is LOG_INFO.
  *
@@ -90,12 +90,120 @@ typedef enum { SD_RPC_FLOW_CONTROL_NONE, SD_RPC_FLOW_CONTROL_HARDWARE } sd_rpc_f
 /**@brief Parity modes */
 typedef enum { SD_RPC_PARITY_NONE, SD_RPC_PARITY_EVEN } sd_rpc_parity_t;
 
+/**@brief Replay timing modes */
+typedef enum {
+    SD_RPC_REPLAY_TIMING_FAST,     /** Replay as fast as the application keeps up. */
+    SD_RPC_REPLAY_TIMING_ORIGINAL, /** Replay with the timing of the recording. */
+} sd_rpc_replay_timing_t;
+
 /**@brief Reset modes to specify how the connectivity firmware will perform a reset. */
 typedef enum {
     SYS_RESET,  /** System reset of the connectivity chip, all state is reset. */
     SOFT_RESET, /** Reset transport and SoftDevice related states only. */
 } sd_rpc_reset_t;
 
+/**@brief Round-trip time estimate of a data link layer. */
+typedef struct
+{
+    uint32_t srtt;         /**< Smoothed round-trip time in microseconds. */
+    uint32_t rttvar;       /**< Round-trip time variation in microseconds. */
+    uint32_t rto;          /**< Retransmission timeout in milliseconds. */
+    uint32_t sample_count; /**< Number of round-trip times measured, 0 if there is no estimate. */
+} sd_rpc_rtt_estimate_t;
+
+/**@brief Write statistics of a physical layer. */
+typedef struct
+{
+    uint64_t bytes_queued;      /**< Bytes queued for writing since the layer was created. */
+    uint64_t bytes_written;     /**< Bytes written since the layer was created. */
+    uint64_t write_count;       /**< Number of writes since the layer was created. */
+    uint32_t bytes_pending;     /**< Bytes queued but not yet written. */
+    uint32_t writes_per_second; /**< Write rate measured over the last second with writes. */
+} sd_rpc_physical_layer_stats_t;
+
+/**@brief Configuration of the buffer pool of an adapter. */
+typedef struct
+{
+    uint32_t buffer_size;  /**< Size of each buffer in bytes. */
+    uint32_t buffer_count; /**< Number of buffers, 0 allocates all buffers on the heap. */
+} sd_rpc_buffer_pool_config_t;
+
+/**@brief Maximum number of I/O or dispatch threads of a runtime. */
+#define SD_RPC_RUNTIME_THREADS_MAX 64
+
+/**@brief Configuration of a runtime shared by adapters. */
+typedef struct
+{
+    uint32_t io_threads;       /**< Threads reading and writing the physical layers, 1 or more. */
+    uint32_t dispatch_threads; /**< Threads calling the event handlers, 1 or more. */
+} sd_rpc_runtime_config_t;
+
+/**@brief Usage statistics of the buffer pool of an adapter. */
+typedef struct
+{
+    uint32_t buffer_size;         /**< Size of each buffer in bytes. */
+    uint32_t buffer_count;        /**< Number of buffers in the pool. */
+    uint32_t in_use;              /**< Number of buffers currently in use. */
+    uint32_t high_water_mark;     /**< Highest number of buffers in use at the same time. */
+    uint32_t exhausted_count;     /**< Number of times a buffer was requested from an empty pool. */
+    uint32_t heap_fallback_count; /**< Number of buffers allocated on the heap instead, either
+                                       because the pool was empty or the buffer was too large. */
+} sd_rpc_buffer_pool_stats_t;
+
+/**@brief Largest number of events passed to a batch event handler at a time. */
+#define SD_RPC_EVT_BATCH_SIZE_MAX 256
+
+/**@brief Configuration of batch event delivery, see @ref sd_rpc_open_batch. */
+typedef struct
+{
+    uint32_t max_batch_size; /**< Most events passed to the handler at a time, 1 to
+                                  @ref SD_RPC_EVT_BATCH_SIZE_MAX. */
+    uint32_t max_latency_ms; /**< Longest time in milliseconds the first event of a batch waits for
+                                  more events, 0 passes the events already received. */
+} sd_rpc_evt_batch_config_t;
+
+/**@brief Number of serialization opcodes, the size of the command latency table. */
+#define SD_RPC_OPCODE_COUNT 256
+
+/**@brief Number of buckets in a latency histogram. */
+#define SD_RPC_LATENCY_BUCKET_COUNT 16
+
+/**@brief Histogram of command round-trip times, from sending a command until its response is
+ *        received.
+ *
+ * Bucket 0 counts round-trip times below 128 microseconds. Each following bucket counts times
+ * below twice the limit of the bucket before it, the last bucket counts all longer times.
+ */
+typedef struct
+{
+    uint32_t count; /**< Number of responses received. */
+    uint32_t max;   /**< Longest round-trip time in microseconds. */
+    uint64_t total; /**< Sum of all round-trip times in microseconds. */
+    uint32_t buckets[SD_RPC_LATENCY_BUCKET_COUNT]; /**< Number of round-trip times per bucket. */
+} sd_rpc_latency_histogram_t;
+
+/**@brief Runtime statistics of an adapter, counted since the adapter was created. */
+typedef struct
+{
+    uint64_t packets_sent;     /**< Data link layer packets sent, including acknowledgements and
+                                    retransmissions. */
+    uint64_t packets_received; /**< Data link layer packets received. */
+    uint64_t bytes_sent;       /**< Bytes sent to the physical layer. */
+    uint64_t bytes_received;   /**< Bytes received from the physical layer. */
+    uint64_t retransmissions;  /**< Packets sent again because they were not acknowledged. */
+    uint64_t decode_errors;    /**< Packets dropped because they could not be decoded. */
+    uint64_t events_received;  /**< Events received from the connectivity firmware. */
+    uint64_t events_dropped;   /**< Events not passed to the application, because they could not
+                                    be decoded, too many events were queued or the adapter was
+                                    closed before they were handled. */
+    uint32_t event_queue_depth;           /**< Events waiting to be passed to the application. */
+    uint32_t event_queue_high_water_mark; /**< Highest number of events waiting at once. */
+    uint64_t command_timeouts; /**< Commands not answered within the response timeout. */
+    sd_rpc_latency_histogram_t
+        command_latency[SD_RPC_OPCODE_COUNT]; /**< Round-trip times of commands answered,
+                                                   indexed by serialization opcode. */
+} sd_rpc_stats_t;
+
 /**@bref Error codes for SD_RPC related errors */
 #define NRF_ERROR_SD_RPC_BASE_NUM (NRF_ERROR_BASE_NUM + 0x8000)
 
@@ -132,9 +240,16 @@ typedef enum {
 typedef void (*sd_rpc_status_handler_t)(adapter_t *adapter, sd_rpc_app_status_t code,
                                         const char *message);
 typedef void (*sd_rpc_evt_handler_t)(adapter_t *adapter, ble_evt_t *p_ble_evt);
+typedef void (*sd_rpc_evt_batch_handler_t)(adapter_t *adapter, ble_evt_t **pp_ble_evts,
+                                           uint32_t count);
 typedef void (*sd_rpc_log_handler_t)(adapter_t *adapter, sd_rpc_log_severity_t severity,
                                      const char *log_message);
 
+/**@brief Function pointer types for asynchronous commands, see @ref sd_rpc_command_async. */
+typedef uint32_t (*sd_rpc_command_handler_t)(adapter_t *adapter, void *p_context);
+typedef void (*sd_rpc_command_complete_handler_t)(adapter_t *adapter, uint32_t result,
+                                                  void *p_context);
+
 #ifdef __cplusplus
 }
 #endif
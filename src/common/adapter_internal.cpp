@@ -41,16 +41,40 @@
 #include "nrf_error.h"
 #include "serialization_transport.h"
 
+#include <chrono>
 #include <string>
 
 AdapterInternal::AdapterInternal(SerializationTransport *_transport)
+    : AdapterInternal(_transport, sd_rpc_buffer_pool_config_t{DefaultBufferPoolBufferSize,
+                                                              DefaultBufferPoolBufferCount})
+{}
+
+AdapterInternal::AdapterInternal(SerializationTransport *_transport,
+                                 const sd_rpc_buffer_pool_config_t &bufferPoolConfig)
     : transport(_transport)
+    , bufferPool(std::make_shared<BufferPool>(bufferPoolConfig.buffer_size,
+                                              bufferPoolConfig.buffer_count))
+    , stats(std::make_shared<TransportStats>())
+    , gapState(app_ble_gap_state_create(), app_ble_gap_state_delete)
     , eventCallback(nullptr)
+    , eventBatchCallback(nullptr)
     , statusCallback(nullptr)
     , logCallback(nullptr)
     , logSeverityFilter(SD_RPC_LOG_TRACE)
     , isOpen(false)
-{}
+    , commandQueue(CommandPipelineDepth)
+{
+    transport->setBufferPool(bufferPool);
+    transport->setTransportStats(stats);
+    transport->setGapState(gapState);
+}
+
+AdapterInternal::AdapterInternal(SerializationTransport *_transport,
+                                 const std::shared_ptr<Runtime> &runtime)
+    : AdapterInternal(_transport)
+{
+    transport->setRuntime(runtime);
+}
 
 AdapterInternal::~AdapterInternal()
 {
@@ -69,10 +93,12 @@ uint32_t AdapterInternal::open(const sd_rpc_status_handler_t status_callback,
     }
 
     isOpen = true;
+    commandQueue.start();
 
-    statusCallback = status_callback;
-    eventCallback  = event_callback;
-    logCallback    = log_callback;
+    statusCallback     = status_callback;
+    eventCallback      = event_callback;
+    eventBatchCallback = nullptr;
+    logCallback        = log_callback;
 
     const auto boundStatusHandler = std::bind(&AdapterInternal::statusHandler, this,
                                               std::placeholders::_1, std::placeholders::_2);
@@ -83,6 +109,62 @@ uint32_t AdapterInternal::open(const sd_rpc_status_handler_t status_callback,
     return transport->open(boundStatusHandler, boundEventHandler, boundLogHandler);
 }
 
+uint32_t AdapterInternal::open(const sd_rpc_status_handler_t status_callback,
+                               const sd_rpc_evt_batch_handler_t event_batch_callback,
+                               const sd_rpc_log_handler_t log_callback,
+                               const sd_rpc_evt_batch_config_t &batchConfig)
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (isOpen)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    isOpen = true;
+    commandQueue.start();
+
+    statusCallback     = status_callback;
+    eventCallback      = nullptr;
+    eventBatchCallback = event_batch_callback;
+    logCallback        = log_callback;
+
+    const auto boundStatusHandler = std::bind(&AdapterInternal::statusHandler, this,
+                                              std::placeholders::_1, std::placeholders::_2);
+    const auto boundEventBatchHandler = std::bind(&AdapterInternal::eventBatchHandler, this,
+                                                  std::placeholders::_1, std::placeholders::_2);
+    const auto boundLogHandler =
+        std::bind(&AdapterInternal::logHandler, this, std::placeholders::_1, std::placeholders::_2);
+    return transport->open(boundStatusHandler, boundEventBatchHandler, boundLogHandler,
+                           batchConfig.max_batch_size,
+                           std::chrono::milliseconds(batchConfig.max_latency_ms));
+}
+
+uint32_t AdapterInternal::open(const sd_rpc_status_handler_t status_callback,
+                               const sd_rpc_log_handler_t log_callback)
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (isOpen)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    isOpen = true;
+    commandQueue.start();
+
+    statusCallback     = status_callback;
+    eventCallback      = nullptr;
+    eventBatchCallback = nullptr;
+    logCallback        = log_callback;
+
+    const auto boundStatusHandler = std::bind(&AdapterInternal::statusHandler, this,
+                                              std::placeholders::_1, std::placeholders::_2);
+    const auto boundLogHandler =
+        std::bind(&AdapterInternal::logHandler, this, std::placeholders::_1, std::placeholders::_2);
+    return transport->open(boundStatusHandler, boundLogHandler);
+}
+
 uint32_t AdapterInternal::close()
 {
     std::lock_guard<std::mutex> lck(publicMethodMutex);
@@ -92,9 +174,38 @@ uint32_t AdapterInternal::close()
         return NRF_ERROR_INVALID_STATE;
     }
 
+    // Commands queued but not run are completed with NRF_ERROR_INVALID_STATE
+    const auto errorCode = commandQueue.stop();
+
+    if (errorCode != NRF_SUCCESS)
+    {
+        return errorCode;
+    }
+
     isOpen = false;
 
-    return transport->close();
+    const auto closeError = transport->close();
+
+    // The adapter is opened again with the GAP state of a new adapter
+    app_ble_gap_state_clear(gapState.get());
+
+    return closeError;
+}
+
+uint32_t AdapterInternal::commandAsync(adapter_t *adapter, const sd_rpc_command_handler_t command,
+                                       const sd_rpc_command_complete_handler_t complete_handler,
+                                       void *context)
+{
+    const auto boundCommand = [adapter, command, context] { return command(adapter, context); };
+
+    if (complete_handler == nullptr)
+    {
+        return commandQueue.push(boundCommand, nullptr);
+    }
+
+    return commandQueue.push(boundCommand, [adapter, complete_handler, context](uint32_t result) {
+        complete_handler(adapter, result, context);
+    });
 }
 
 void AdapterInternal::statusHandler(const sd_rpc_app_status_t code, const std::string &message)
@@ -120,6 +231,18 @@ void AdapterInternal::eventHandler(ble_evt_t *event)
     }
 }
 
+void AdapterInternal::eventBatchHandler(ble_evt_t **events, const uint32_t count)
+{
+    // Event Thread
+    adapter_t adapter = {};
+    adapter.internal  = static_cast<void *>(this);
+
+    if (eventBatchCallback != nullptr)
+    {
+        eventBatchCallback(&adapter, events, count);
+    }
+}
+
 void AdapterInternal::logHandler(const sd_rpc_log_severity_t severity,
                                  const std::string &log_message)
 {
@@ -141,5 +264,6 @@ uint32_t AdapterInternal::logSeverityFilterSet(const sd_rpc_log_severity_t sever
 {
     std::lock_guard<std::mutex> lck(publicMethodMutex);
     logSeverityFilter = severity_filter;
+    transport->setLogSeverityFilter(severity_filter);
     return NRF_SUCCESS;
 }
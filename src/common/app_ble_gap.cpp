@@ -41,10 +41,9 @@
 #include "nrf_error.h"
 
 #include <cstring>
-#include <map>
+#include <iostream>
 #include <memory>
 #include <mutex>
-#include <iostream>
 
 #include <sd_rpc_types.h>
 
@@ -59,7 +58,7 @@ typedef struct
 /**
  * @brief This structure keeps GAP states for one adapter
  */
-typedef struct
+struct adapter_ble_gap_state_t
 {
     // GAP connection - BLE security keys table for storage.
     ser_ble_gap_app_keyset_t app_keys_table[SER_MAX_CONNECTIONS]{};
@@ -70,98 +69,134 @@ typedef struct
     ble_data_t scan_data = {nullptr, 0};
     int scan_data_id{0};
     void *ble_gap_adv_buf_addr[APP_BLE_GAP_ADV_BUF_COUNT]{};
+    // Advertisement set buffers, replaced when the advertisement set is configured again
+    adv_set_data_t adv_set_data[BLE_GAP_ADV_SET_COUNT_MAX]{
+        {BLE_GAP_ADV_SET_HANDLE_NOT_SET, nullptr, nullptr}};
 #endif // NRF_SD_BLE_API_VERSION >= 6
-} adapter_ble_gap_state_t;
-
-/**
- * @brief This map keeps the GAP states (see @ref adapter_ble_gap_state_t) for adapters used
- */
-static std::map<void *, std::shared_ptr<adapter_ble_gap_state_t>> adapters_gap_state;
-
-/**
- * @brief This structure keeps information related to an adapter key
- *
- * An adapter key is used to tell the codecs what adapter_ble_gap_state_t to
- * use during encoding and decoding.
- *
- */
-typedef struct
-{
-    /**
-     * @brief adapter_id that points to the @ref adapter_ble_gap_state_t [adapter GAP state]
-     * currently used by codecs
-     */
-    void *adapter_id{nullptr};
 
     /**
-     * @brief Mutex that protects changing the adapter GAP state while encoding/decoding is in
-     * progress
+     * @brief Mutexes that protect the GAP state while encoding/decoding is in progress
+     *
+     * Each adapter has its own mutexes so that adapters encode and decode in parallel.
      */
-    std::mutex codec_mutex;
-} adapter_codec_context_t;
+    std::mutex request_reply_codec_mutex;
+    std::mutex event_codec_mutex;
+};
 
 /**
- * @brief Adapter key used for encoding/decoding request reply commands
+ * @brief GAP state used by the codecs encoding and decoding request reply commands
+ *
+ * The codecs run on the thread calling the command. The codecs provided by the SDK take no
+ * adapter argument, the codec context of the adapter sets its GAP state for the calling thread.
  */
-static adapter_codec_context_t current_request_reply_context;
+static thread_local adapter_ble_gap_state_t *current_request_reply_gap_state = nullptr;
 
 /**
- * @brief Adapter key used for decoding events
+ * @brief GAP state used by the codecs decoding events, set as current_request_reply_gap_state
  */
-static adapter_codec_context_t current_event_context;
+static thread_local adapter_ble_gap_state_t *current_event_gap_state = nullptr;
 
-uint32_t app_ble_gap_state_create(void *adapter_id)
+static adapter_ble_gap_state_t *request_reply_gap_state()
 {
-    if (adapters_gap_state.count(adapter_id) == 1)
-    {
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
-    }
+    return current_request_reply_gap_state;
+}
+
+static adapter_ble_gap_state_t *event_gap_state()
+{
+    return current_event_gap_state;
+}
 
-    adapters_gap_state[adapter_id] = std::make_shared<adapter_ble_gap_state_t>();
+adapter_ble_gap_state_t *app_ble_gap_state_create(void)
+{
+    return new adapter_ble_gap_state_t();
+}
 
-    return NRF_SUCCESS;
+void app_ble_gap_state_delete(adapter_ble_gap_state_t *gap_state)
+{
+    delete gap_state;
 }
 
-uint32_t app_ble_gap_state_delete(void *adapter_id)
+void app_ble_gap_state_clear(adapter_ble_gap_state_t *gap_state)
 {
-    if (adapters_gap_state.erase(adapter_id) != 1)
+    std::lock_guard<std::mutex> requestReplyLock(gap_state->request_reply_codec_mutex);
+    std::lock_guard<std::mutex> eventLock(gap_state->event_codec_mutex);
+
+    for (auto &keys : gap_state->app_keys_table)
     {
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
+        keys = ser_ble_gap_app_keyset_t{};
     }
 
-    // TODO: if this key is used in request_reply_key
-    // TODO: or event_key, remove them from the keys
-    // TODO: and unlock any keys
+#if NRF_SD_BLE_API_VERSION >= 6
+    for (auto &adv_set : gap_state->adv_sets)
+    {
+        adv_set = adv_set_t{};
+    }
 
-    return NRF_SUCCESS;
+    gap_state->scan_data    = {nullptr, 0};
+    gap_state->scan_data_id = 0;
+
+    for (auto &addr : gap_state->ble_gap_adv_buf_addr)
+    {
+        addr = nullptr;
+    }
+
+    for (auto &adv_set_data : gap_state->adv_set_data)
+    {
+        adv_set_data = {BLE_GAP_ADV_SET_HANDLE_NOT_SET, nullptr, nullptr};
+    }
+#endif // NRF_SD_BLE_API_VERSION >= 6
 }
 
-void app_ble_gap_set_current_adapter_id(void *adapter_id,
-                                        const app_ble_gap_adapter_codec_context_t key_type)
+void app_ble_gap_set_current_gap_state(adapter_ble_gap_state_t *gap_state,
+                                       const app_ble_gap_adapter_codec_context_t key_type)
 {
     if (key_type == EVENT_CODEC_CONTEXT)
     {
-        current_event_context.codec_mutex.lock();
-        current_event_context.adapter_id = adapter_id;
+        gap_state->event_codec_mutex.lock();
+        current_event_gap_state = gap_state;
     }
     else if (key_type == REQUEST_REPLY_CODEC_CONTEXT)
     {
-        current_request_reply_context.codec_mutex.lock();
-        current_request_reply_context.adapter_id = adapter_id;
+        gap_state->request_reply_codec_mutex.lock();
+        current_request_reply_gap_state = gap_state;
     }
 }
 
-void app_ble_gap_unset_current_adapter_id(const app_ble_gap_adapter_codec_context_t key_type)
+void app_ble_gap_unset_current_gap_state(const app_ble_gap_adapter_codec_context_t key_type)
 {
-    if (key_type == EVENT_CODEC_CONTEXT)
+    if (key_type == EVENT_CODEC_CONTEXT && current_event_gap_state != nullptr)
     {
-        current_event_context.codec_mutex.unlock();
-        current_event_context.adapter_id = nullptr;
+        current_event_gap_state->event_codec_mutex.unlock();
+        current_event_gap_state = nullptr;
     }
-    else if (key_type == REQUEST_REPLY_CODEC_CONTEXT)
+    else if (key_type == REQUEST_REPLY_CODEC_CONTEXT && current_request_reply_gap_state != nullptr)
     {
-        current_request_reply_context.codec_mutex.unlock();
-        current_request_reply_context.adapter_id = nullptr;
+        current_request_reply_gap_state->request_reply_codec_mutex.unlock();
+        current_request_reply_gap_state = nullptr;
+    }
+}
+
+void app_ble_gap_pause_current_gap_state(const app_ble_gap_adapter_codec_context_t key_type)
+{
+    if (key_type == EVENT_CODEC_CONTEXT && current_event_gap_state != nullptr)
+    {
+        current_event_gap_state->event_codec_mutex.unlock();
+    }
+    else if (key_type == REQUEST_REPLY_CODEC_CONTEXT && current_request_reply_gap_state != nullptr)
+    {
+        current_request_reply_gap_state->request_reply_codec_mutex.unlock();
+    }
+}
+
+void app_ble_gap_resume_current_gap_state(const app_ble_gap_adapter_codec_context_t key_type)
+{
+    if (key_type == EVENT_CODEC_CONTEXT && current_event_gap_state != nullptr)
+    {
+        current_event_gap_state->event_codec_mutex.lock();
+    }
+    else if (key_type == REQUEST_REPLY_CODEC_CONTEXT && current_request_reply_gap_state != nullptr)
+    {
+        current_request_reply_gap_state->request_reply_codec_mutex.lock();
     }
 }
 
@@ -170,11 +205,11 @@ app_ble_gap_check_current_adapter_set(const app_ble_gap_adapter_codec_context_t
 {
     if (codec_context == EVENT_CODEC_CONTEXT)
     {
-        return current_event_context.adapter_id != nullptr;
+        return current_event_gap_state != nullptr;
     }
     else if (codec_context == REQUEST_REPLY_CODEC_CONTEXT)
     {
-        return current_request_reply_context.adapter_id != nullptr;
+        return current_request_reply_gap_state != nullptr;
     }
 
     return false;
@@ -187,29 +222,27 @@ uint32_t app_ble_gap_sec_keys_storage_create(uint16_t conn_handle, uint32_t *p_i
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    try
+    const auto gap_state = request_reply_gap_state();
+
+    if (gap_state == nullptr)
     {
-        const auto gap_state = adapters_gap_state.at(current_request_reply_context.adapter_id);
+        return NRF_ERROR_SD_RPC_INVALID_STATE;
+    }
 
-        // Assumption: conn_handle is always starting from 0 and up to SER_MAX_CONNECTIONS (not
-        // including)
-        for (auto i = 0; i < SER_MAX_CONNECTIONS; i++)
-        {
-            auto &keys = gap_state->app_keys_table[i];
+    // Assumption: conn_handle is always starting from 0 and up to SER_MAX_CONNECTIONS (not
+    // including)
+    for (auto i = 0; i < SER_MAX_CONNECTIONS; i++)
+    {
+        auto &keys = gap_state->app_keys_table[i];
 
-            if (!keys.conn_active)
-            {
-                keys.conn_active = 1;
-                keys.conn_handle = conn_handle;
-                *p_index         = i;
-                return NRF_SUCCESS;
-            }
+        if (!keys.conn_active)
+        {
+            keys.conn_active = 1;
+            keys.conn_handle = conn_handle;
+            *p_index         = i;
+            return NRF_SUCCESS;
         }
     }
-    catch (const std::out_of_range &)
-    {
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
-    }
 
     return NRF_ERROR_NO_MEM;
 }
@@ -221,25 +254,23 @@ uint32_t app_ble_gap_sec_keys_storage_destroy(const uint16_t conn_handle)
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    try
+    const auto gap_state = event_gap_state();
+
+    if (gap_state == nullptr)
     {
-        const auto gap_state = adapters_gap_state.at(current_event_context.adapter_id);
+        return NRF_ERROR_SD_RPC_INVALID_STATE;
+    }
 
-        for (auto &keys : gap_state->app_keys_table)
+    for (auto &keys : gap_state->app_keys_table)
+    {
+        if (keys.conn_handle == conn_handle)
         {
-            if (keys.conn_handle == conn_handle)
-            {
-                keys.conn_active = 0;
-                return NRF_SUCCESS;
-            }
+            keys.conn_active = 0;
+            return NRF_SUCCESS;
         }
-
-        return NRF_ERROR_NO_MEM;
-    }
-    catch (const std::out_of_range &)
-    {
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
+
+    return NRF_ERROR_NO_MEM;
 }
 
 uint32_t app_ble_gap_sec_keys_find(const uint16_t conn_handle, uint32_t *p_index)
@@ -249,26 +280,24 @@ uint32_t app_ble_gap_sec_keys_find(const uint16_t conn_handle, uint32_t *p_index
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    try
+    const auto gap_state = event_gap_state();
+
+    if (gap_state == nullptr)
     {
-        const auto gap_state = adapters_gap_state.at(current_event_context.adapter_id);
+        return NRF_ERROR_SD_RPC_INVALID_STATE;
+    }
 
-        for (auto i = 0; i < SER_MAX_CONNECTIONS; i++)
+    for (auto i = 0; i < SER_MAX_CONNECTIONS; i++)
+    {
+        auto &keys = gap_state->app_keys_table[i];
+        if ((keys.conn_handle == conn_handle) && (keys.conn_active == 1))
         {
-            auto &keys = gap_state->app_keys_table[i];
-            if ((keys.conn_handle == conn_handle) && (keys.conn_active == 1))
-            {
-                *p_index = i;
-                return NRF_SUCCESS;
-            }
+            *p_index = i;
+            return NRF_SUCCESS;
         }
-
-        return NRF_ERROR_NOT_FOUND;
-    }
-    catch (const std::out_of_range &)
-    {
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
+
+    return NRF_ERROR_NOT_FOUND;
 }
 
 uint32_t app_ble_gap_sec_keys_get(const uint32_t index, ble_gap_sec_keyset_t **keyset)
@@ -278,16 +307,15 @@ uint32_t app_ble_gap_sec_keys_get(const uint32_t index, ble_gap_sec_keyset_t **k
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    try
-    {
-        const auto gap_state = adapters_gap_state.at(current_event_context.adapter_id);
-        *keyset              = &(gap_state->app_keys_table[index].keyset);
-        return NRF_SUCCESS;
-    }
-    catch (const std::out_of_range &)
+    const auto gap_state = event_gap_state();
+
+    if (gap_state == nullptr)
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
+
+    *keyset              = &(gap_state->app_keys_table[index].keyset);
+    return NRF_SUCCESS;
 }
 
 uint32_t app_ble_gap_sec_keys_update(const uint32_t index, const ble_gap_sec_keyset_t *keyset)
@@ -297,17 +325,16 @@ uint32_t app_ble_gap_sec_keys_update(const uint32_t index, const ble_gap_sec_key
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    try
-    {
-        const auto gap_state = adapters_gap_state.at(current_request_reply_context.adapter_id);
-        std::memcpy(&(gap_state->app_keys_table[index].keyset), keyset,
-                    sizeof(ble_gap_sec_keyset_t));
-        return NRF_SUCCESS;
-    }
-    catch (const std::out_of_range &)
+    const auto gap_state = request_reply_gap_state();
+
+    if (gap_state == nullptr)
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
+
+    std::memcpy(&(gap_state->app_keys_table[index].keyset), keyset,
+                sizeof(ble_gap_sec_keyset_t));
+    return NRF_SUCCESS;
 }
 
 uint32_t app_ble_gap_state_reset()
@@ -317,35 +344,31 @@ uint32_t app_ble_gap_state_reset()
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    try
+    const auto gap_state = request_reply_gap_state();
+
+    if (gap_state == nullptr)
     {
-        const auto gap_state = adapters_gap_state.at(current_request_reply_context.adapter_id);
+        return NRF_ERROR_SD_RPC_INVALID_STATE;
+    }
 
-        for (auto &keyset : gap_state->app_keys_table)
-        {
-            keyset.conn_active = false;
-        }
+    for (auto &keyset : gap_state->app_keys_table)
+    {
+        keyset.conn_active = false;
+    }
 
 #if NRF_SD_BLE_API_VERSION >= 6
-        for (auto &adv_set : gap_state->adv_sets)
-        {
-            adv_set.active = false;
-        }
-
-        gap_state->scan_data = {nullptr, 0};
-#endif // NRF_SD_BLE_API_VERSION >= 6
-    }
-    catch (const std::out_of_range &)
+    for (auto &adv_set : gap_state->adv_sets)
     {
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
+        adv_set.active = false;
     }
 
+    gap_state->scan_data = {nullptr, 0};
+#endif // NRF_SD_BLE_API_VERSION >= 6
+
     return NRF_SUCCESS;
 }
 
 #if NRF_SD_BLE_API_VERSION >= 6
-static adv_set_data_t adv_set_data[] = {{BLE_GAP_ADV_SET_HANDLE_NOT_SET, nullptr, nullptr}};
-
 uint32_t app_ble_gap_scan_data_set(ble_data_t const *p_data)
 {
     if (!app_ble_gap_check_current_adapter_set(REQUEST_REPLY_CODEC_CONTEXT))
@@ -353,22 +376,20 @@ uint32_t app_ble_gap_scan_data_set(ble_data_t const *p_data)
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    try
-    {
-        const auto gap_state = adapters_gap_state.at(current_request_reply_context.adapter_id);
-
-        if (gap_state->scan_data.p_data != nullptr)
-        {
-            return NRF_ERROR_BUSY;
-        }
+    const auto gap_state = request_reply_gap_state();
 
-        memcpy(&(gap_state->scan_data), p_data, sizeof(ble_data_t));
-        return NRF_SUCCESS;
-    }
-    catch (const std::out_of_range &)
+    if (gap_state == nullptr)
     {
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
+
+    if (gap_state->scan_data.p_data != nullptr)
+    {
+        return NRF_ERROR_BUSY;
+    }
+
+    memcpy(&(gap_state->scan_data), p_data, sizeof(ble_data_t));
+    return NRF_SUCCESS;
 }
 
 uint32_t app_ble_gap_scan_data_fetch_clear(ble_data_t *p_data)
@@ -378,23 +399,22 @@ uint32_t app_ble_gap_scan_data_fetch_clear(ble_data_t *p_data)
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    try
+    const auto gap_state = event_gap_state();
+
+    if (gap_state == nullptr)
     {
-        const auto gap_state = adapters_gap_state.at(current_event_context.adapter_id);
-        std::memcpy(p_data, &(gap_state->scan_data), sizeof(ble_data_t));
+        return NRF_ERROR_SD_RPC_INVALID_STATE;
+    }
 
-        if (gap_state->scan_data.p_data != nullptr)
-        {
-            gap_state->scan_data.p_data = nullptr;
-            return NRF_SUCCESS;
-        }
+    std::memcpy(p_data, &(gap_state->scan_data), sizeof(ble_data_t));
 
-        return NRF_ERROR_NOT_FOUND;
-    }
-    catch (const std::out_of_range &)
+    if (gap_state->scan_data.p_data != nullptr)
     {
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
+        gap_state->scan_data.p_data = nullptr;
+        return NRF_SUCCESS;
     }
+
+    return NRF_ERROR_NOT_FOUND;
 }
 
 uint32_t app_ble_gap_adv_set_register(uint8_t adv_handle, uint8_t *p_adv_data,
@@ -405,28 +425,26 @@ uint32_t app_ble_gap_adv_set_register(uint8_t adv_handle, uint8_t *p_adv_data,
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    try
+    const auto gap_state = request_reply_gap_state();
+
+    if (gap_state == nullptr)
     {
-        const auto gap_state = adapters_gap_state.at(current_request_reply_context.adapter_id);
+        return NRF_ERROR_SD_RPC_INVALID_STATE;
+    }
 
-        for (auto &m_adv_set : gap_state->adv_sets)
+    for (auto &m_adv_set : gap_state->adv_sets)
+    {
+        if (!m_adv_set.active)
         {
-            if (!m_adv_set.active)
-            {
-                m_adv_set.active          = true;
-                m_adv_set.adv_handle      = adv_handle;
-                m_adv_set.p_adv_data      = p_adv_data;
-                m_adv_set.p_scan_rsp_data = p_scan_rsp_data;
-                return NRF_SUCCESS;
-            }
+            m_adv_set.active          = true;
+            m_adv_set.adv_handle      = adv_handle;
+            m_adv_set.p_adv_data      = p_adv_data;
+            m_adv_set.p_scan_rsp_data = p_scan_rsp_data;
+            return NRF_SUCCESS;
         }
-
-        return NRF_ERROR_NOT_FOUND;
-    }
-    catch (const std::out_of_range &)
-    {
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
+
+    return NRF_ERROR_NOT_FOUND;
 }
 
 uint32_t app_ble_gap_adv_set_unregister(uint8_t adv_handle, uint8_t **pp_adv_data,
@@ -437,27 +455,25 @@ uint32_t app_ble_gap_adv_set_unregister(uint8_t adv_handle, uint8_t **pp_adv_dat
         return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
 
-    try
+    const auto gap_state = event_gap_state();
+
+    if (gap_state == nullptr)
     {
-        const auto gap_state = adapters_gap_state.at(current_event_context.adapter_id);
+        return NRF_ERROR_SD_RPC_INVALID_STATE;
+    }
 
-        for (auto &m_adv_set : gap_state->adv_sets)
+    for (auto &m_adv_set : gap_state->adv_sets)
+    {
+        if (m_adv_set.active && (m_adv_set.adv_handle == adv_handle))
         {
-            if (m_adv_set.active && (m_adv_set.adv_handle == adv_handle))
-            {
-                m_adv_set.active  = false;
-                *pp_adv_data      = m_adv_set.p_adv_data;
-                *pp_scan_rsp_data = m_adv_set.p_scan_rsp_data;
-                return NRF_SUCCESS;
-            }
+            m_adv_set.active  = false;
+            *pp_adv_data      = m_adv_set.p_adv_data;
+            *pp_scan_rsp_data = m_adv_set.p_scan_rsp_data;
+            return NRF_SUCCESS;
         }
-
-        return NRF_ERROR_NOT_FOUND;
-    }
-    catch (const std::out_of_range &)
-    {
-        return NRF_ERROR_SD_RPC_INVALID_STATE;
     }
+
+    return NRF_ERROR_NOT_FOUND;
 }
 
 int app_ble_gap_adv_buf_register(void *p_buf)
@@ -475,30 +491,28 @@ int app_ble_gap_adv_buf_register(void *p_buf)
         return 0;
     }
 
-    try
+    const auto gap_state = request_reply_gap_state();
+
+    if (gap_state == nullptr)
     {
-        const auto gap_state = adapters_gap_state.at(current_request_reply_context.adapter_id);
+        return -1;
+    }
 
-        auto id = 1;
+    auto id = 1;
 
-        // Find available location in ble_gap_adv_buf_addr for
-        // store this new buffer pointer.
-        for (auto &addr : gap_state->ble_gap_adv_buf_addr)
+    // Find available location in ble_gap_adv_buf_addr for
+    // store this new buffer pointer.
+    for (auto &addr : gap_state->ble_gap_adv_buf_addr)
+    {
+        if ((addr == nullptr) || (addr == p_buf))
         {
-            if ((addr == nullptr) || (addr == p_buf))
-            {
-                addr = p_buf;
-                return id;
-            }
-            id++;
+            addr = p_buf;
+            return id;
         }
-
-        return -1;
-    }
-    catch (const std::out_of_range &)
-    {
-        return -1;
+        id++;
     }
+
+    return -1;
 }
 
 int app_ble_gap_adv_buf_addr_unregister(void *p_buf)
@@ -516,29 +530,27 @@ int app_ble_gap_adv_buf_addr_unregister(void *p_buf)
         return 0;
     }
 
-    try
+    const auto gap_state = request_reply_gap_state();
+
+    if (gap_state == nullptr)
     {
-        const auto gap_state = adapters_gap_state.at(current_request_reply_context.adapter_id);
+        return -1;
+    }
 
-        auto id = 1;
+    auto id = 1;
 
-        // Find available location in ble_gap_adv_buf_addr for
-        // store this new buffer pointer.
-        for (auto &addr : gap_state->ble_gap_adv_buf_addr)
+    // Find available location in ble_gap_adv_buf_addr for
+    // store this new buffer pointer.
+    for (auto &addr : gap_state->ble_gap_adv_buf_addr)
+    {
+        if (addr == p_buf)
         {
-            if (addr == p_buf)
-            {
-                addr = nullptr;
-                return id;
-            }
+            addr = nullptr;
+            return id;
         }
-
-        return -1;
-    }
-    catch (const std::out_of_range &)
-    {
-        return -1;
     }
+
+    return -1;
 }
 
 void *app_ble_gap_adv_buf_unregister(const int id, const bool event_context)
@@ -554,9 +566,12 @@ void *app_ble_gap_adv_buf_unregister(const int id, const bool event_context)
         return nullptr;
     }
 
-    const auto gap_state =
-        adapters_gap_state.at(event_context ? current_event_context.adapter_id
-                                            : current_request_reply_context.adapter_id);
+    const auto gap_state = event_context ? event_gap_state() : request_reply_gap_state();
+
+    if (gap_state == nullptr)
+    {
+        return nullptr;
+    }
 
     auto ret                                = gap_state->ble_gap_adv_buf_addr[id - 1];
     gap_state->ble_gap_adv_buf_addr[id - 1] = nullptr;
@@ -571,6 +586,20 @@ void app_ble_gap_set_adv_data_set(uint8_t adv_handle, uint8_t *buf1, uint8_t *bu
         return;
     }
 
+    if (!app_ble_gap_check_current_adapter_set(REQUEST_REPLY_CODEC_CONTEXT))
+    {
+        return;
+    }
+
+    const auto gap_state = request_reply_gap_state();
+
+    if (gap_state == nullptr)
+    {
+        return;
+    }
+
+    const auto adv_set_data = gap_state->adv_set_data;
+
     for (int i = 0; i < BLE_GAP_ADV_SET_COUNT_MAX; i++)
     {
         if (adv_set_data[i].adv_handle == adv_handle)
@@ -614,7 +643,12 @@ void app_ble_gap_scan_data_set(const uint8_t *p_scan_data)
     }
 
     // Find location for scan_data
-    const auto gap_state = adapters_gap_state.at(current_request_reply_context.adapter_id);
+    const auto gap_state = request_reply_gap_state();
+
+    if (gap_state == nullptr)
+    {
+        return;
+    }
 
     auto id = 0;
 
@@ -639,7 +673,12 @@ void app_ble_gap_scan_data_unset(bool free)
         return;
     }
 
-    const auto gap_state = adapters_gap_state.at(current_request_reply_context.adapter_id);
+    const auto gap_state = request_reply_gap_state();
+
+    if (gap_state == nullptr)
+    {
+        return;
+    }
 
     if (gap_state->scan_data_id)
     {
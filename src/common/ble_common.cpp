@@ -47,24 +47,24 @@
 
 // AdapterRequestReplyCodecContext
 
-RequestReplyCodecContext::RequestReplyCodecContext(void *adapterId)
+RequestReplyCodecContext::RequestReplyCodecContext(adapter_ble_gap_state_t *gapState)
 {
-    app_ble_gap_set_current_adapter_id(adapterId, REQUEST_REPLY_CODEC_CONTEXT);
+    app_ble_gap_set_current_gap_state(gapState, REQUEST_REPLY_CODEC_CONTEXT);
 }
 
 RequestReplyCodecContext::~RequestReplyCodecContext()
 {
-    app_ble_gap_unset_current_adapter_id(REQUEST_REPLY_CODEC_CONTEXT);
+    app_ble_gap_unset_current_gap_state(REQUEST_REPLY_CODEC_CONTEXT);
 }
 
-EventCodecContext::EventCodecContext(void *adapterId)
+EventCodecContext::EventCodecContext(adapter_ble_gap_state_t *gapState)
 {
-    app_ble_gap_set_current_adapter_id(adapterId, EVENT_CODEC_CONTEXT);
+    app_ble_gap_set_current_gap_state(gapState, EVENT_CODEC_CONTEXT);
 }
 
 EventCodecContext::~EventCodecContext()
 {
-    app_ble_gap_unset_current_adapter_id(EVENT_CODEC_CONTEXT);
+    app_ble_gap_unset_current_gap_state(EVENT_CODEC_CONTEXT);
 }
 
 uint32_t encode_decode(adapter_t *adapter, const encode_function_t &encode_function,
@@ -74,18 +74,18 @@ uint32_t encode_decode(adapter_t *adapter, const encode_function_t &encode_funct
     auto _adapter = static_cast<AdapterInternal *>(adapter->internal);
 
     // Create rx_buffer
-    std::shared_ptr<std::vector<uint8_t>> rx_buffer;
-    
+    PooledBuffer rx_buffer;
+
     if (decode_function)
     {
-        rx_buffer = std::make_shared<std::vector<uint8_t>>(SER_HAL_TRANSPORT_MAX_PKT_SIZE);
+        rx_buffer = _adapter->bufferPool->acquire(SER_HAL_TRANSPORT_MAX_PKT_SIZE);
     }
 
-    // Create tx_buffer
+    // Create tx_buffer, the command is encoded after the space reserved for the packet type
     uint32_t tx_buffer_length = SER_HAL_TRANSPORT_MAX_PKT_SIZE;
-    std::vector<uint8_t> tx_buffer(tx_buffer_length);
-    auto err_code = encode_function(tx_buffer.data(), &tx_buffer_length);
-    tx_buffer.resize(tx_buffer_length);
+    const auto tx_buffer =
+        _adapter->bufferPool->acquire(SerializationHeadroom + SER_HAL_TRANSPORT_MAX_PKT_SIZE);
+    auto err_code = encode_function(tx_buffer.data() + SerializationHeadroom, &tx_buffer_length);
 
     if (AdapterInternal::isInternalError(err_code))
     {
@@ -94,7 +94,14 @@ uint32_t encode_decode(adapter_t *adapter, const encode_function_t &encode_funct
         return NRF_ERROR_SD_RPC_ENCODE;
     }
 
-    err_code = _adapter->transport->send(tx_buffer, rx_buffer);
+    // Other commands use the GAP state while this one waits for its response. The next queued
+    // command is started when the request is sent.
+    app_ble_gap_pause_current_gap_state(REQUEST_REPLY_CODEC_CONTEXT);
+    err_code = _adapter->transport->sendPacket(tx_buffer.data(),
+                                               SerializationHeadroom + tx_buffer_length, rx_buffer,
+                                               SERIALIZATION_COMMAND,
+                                               [] { CommandQueue::requestSent(); });
+    app_ble_gap_resume_current_gap_state(REQUEST_REPLY_CODEC_CONTEXT);
 
     if (AdapterInternal::isInternalError(err_code))
     {
@@ -116,7 +123,7 @@ uint32_t encode_decode(adapter_t *adapter, const encode_function_t &encode_funct
 
     if (decode_function)
     {
-        err_code = decode_function(rx_buffer->data(), static_cast<uint32_t>(rx_buffer->size()),
+        err_code = decode_function(rx_buffer.data(), static_cast<uint32_t>(rx_buffer.size()),
                                    &result_code);
     }
 
@@ -0,0 +1,210 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "command_queue.h"
+
+#include "nrf_error.h"
+
+#include <utility>
+
+namespace {
+// Queue the calling thread is a worker of, nullptr on other threads
+thread_local CommandQueue *workerQueue = nullptr;
+
+// Number of the command the calling worker thread runs
+thread_local uint64_t runningSequence = 0;
+} // namespace
+
+CommandQueue::CommandQueue(const size_t depth)
+    : pipelineDepth(depth)
+    , isRunning(false)
+    , idleWorkers(0)
+    , nextSequence(0)
+    , startTurn(0)
+    , completeTurn(0)
+{}
+
+CommandQueue::~CommandQueue()
+{
+    stop();
+}
+
+uint32_t CommandQueue::push(const command_t &command, const command_complete_t &complete)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (!isRunning)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    if (commands.size() >= CommandQueueCapacity)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    commands.push_back(Command{command, complete});
+
+    // Commands not taken by an idle worker get a new worker, up to the pipeline depth
+    if (idleWorkers < commands.size() && workers.size() < pipelineDepth)
+    {
+        workers.emplace_back([this] { runner(); });
+    }
+
+    queued.notify_one();
+    return NRF_SUCCESS;
+}
+
+void CommandQueue::start()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    isRunning = true;
+}
+
+uint32_t CommandQueue::stop()
+{
+    std::deque<Command> discarded;
+    std::vector<std::thread> stopped;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (workerQueue == this)
+        {
+            return NRF_ERROR_INVALID_STATE;
+        }
+
+        isRunning = false;
+        discarded.swap(commands);
+        stopped.swap(workers);
+        queued.notify_all();
+    }
+
+    // Commands taken by the workers are run and completed before the workers stop
+    for (auto &worker : stopped)
+    {
+        worker.join();
+    }
+
+    // Completed on the stopping thread, the workers are stopped
+    for (const auto &command : discarded)
+    {
+        if (command.complete)
+        {
+            command.complete(NRF_ERROR_INVALID_STATE);
+        }
+    }
+
+    return NRF_SUCCESS;
+}
+
+void CommandQueue::requestSent()
+{
+    if (workerQueue != nullptr)
+    {
+        workerQueue->passTurn(runningSequence);
+    }
+}
+
+void CommandQueue::passTurn(const uint64_t sequence)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    if (startTurn == sequence)
+    {
+        startTurn++;
+        turnTaken.notify_all();
+    }
+}
+
+void CommandQueue::runner()
+{
+    workerQueue = this;
+
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (true)
+    {
+        idleWorkers++;
+        queued.wait(lock, [this] { return !isRunning || !commands.empty(); });
+        idleWorkers--;
+
+        if (!isRunning)
+        {
+            return;
+        }
+
+        const auto command = std::move(commands.front());
+        commands.pop_front();
+        const auto sequence = nextSequence++;
+
+        // Started when the command before it has sent its request, or returned
+        turnTaken.wait(lock, [&] { return startTurn == sequence; });
+
+        // Commands still waiting for their turn when the queue is stopped are not run
+        auto result = static_cast<uint32_t>(NRF_ERROR_INVALID_STATE);
+
+        if (isRunning)
+        {
+            // Other threads queue commands while this one runs
+            lock.unlock();
+            runningSequence = sequence;
+            result          = command.command();
+            lock.lock();
+        }
+
+        // The next command is started if this one returned without sending a request
+        if (startTurn == sequence)
+        {
+            startTurn++;
+            turnTaken.notify_all();
+        }
+
+        // Completed after the commands queued before it
+        turnTaken.wait(lock, [&] { return completeTurn == sequence; });
+        lock.unlock();
+
+        if (command.complete)
+        {
+            command.complete(result);
+        }
+
+        lock.lock();
+        completeTurn++;
+        turnTaken.notify_all();
+    }
+}
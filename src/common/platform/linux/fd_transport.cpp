@@ -0,0 +1,565 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "fd_transport.h"
+#include "nrf_error.h"
+#include "runtime.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <system_error>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+// Max number of segments written with one writev, larger packets are queued for the I/O thread
+constexpr size_t MAX_WRITE_SEGMENTS = 8;
+// Max number of epoll events handled per wakeup
+constexpr int MAX_EPOLL_EVENTS = 4;
+
+struct FdTransport::RuntimeDescriptor : public asio::posix::stream_descriptor
+{
+    using asio::posix::stream_descriptor::stream_descriptor;
+};
+
+FdTransport::FdTransport(const std::string &name)
+    : Transport()
+    , name(name)
+    , fd(-1)
+    , epollFd(-1)
+    , wakeFd(-1)
+    , timerFd(-1)
+    , timerDeadline(std::chrono::steady_clock::time_point::max())
+    , readBuffer()
+    , writeInterest(false)
+    , runtimeWaiting(false)
+    , isOpen(false)
+{}
+
+FdTransport::~FdTransport() noexcept
+{
+    FdTransport::close();
+}
+
+uint32_t FdTransport::open(const status_cb_t &status_callback, const data_cb_t &data_callback,
+                         const log_cb_t &log_callback)
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (isOpen)
+    {
+        return NRF_ERROR_SD_RPC_SERIAL_PORT_ALREADY_OPEN;
+    }
+
+    Transport::open(status_callback, data_callback, log_callback);
+
+    try
+    {
+        fd = openDescriptor();
+
+        wakeFd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+        epollFd = epoll_create1(EPOLL_CLOEXEC);
+
+        if (wakeFd < 0 || timerFd < 0 || epollFd < 0)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()),
+                                    "Failed to create epoll instance");
+        }
+
+        epoll_event event = {};
+        event.events      = EPOLLIN;
+        event.data.fd     = wakeFd;
+
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event) < 0)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()),
+                                    "Failed to add eventfd to epoll");
+        }
+
+        event.data.fd = timerFd;
+
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, timerFd, &event) < 0)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()),
+                                    "Failed to add timerfd to epoll");
+        }
+
+        event.data.fd = fd;
+
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()),
+                                    "Failed to add descriptor to epoll");
+        }
+
+        if (runtime)
+        {
+            // The runtime waits on a duplicate, closed when the stream descriptor is destroyed
+            const auto runtimeFd = dup(epollFd);
+
+            if (runtimeFd < 0)
+            {
+                throw std::system_error(std::error_code(errno, std::system_category()),
+                                        "Failed to duplicate epoll instance");
+            }
+
+            runtimeDescriptor.reset(new RuntimeDescriptor(runtime->ioService(), runtimeFd));
+        }
+    }
+    catch (std::exception &ex)
+    {
+        std::stringstream message;
+        message << "Error opening " << name << ". " << ex.what();
+
+        for (auto descriptor : {fd, epollFd, wakeFd, timerFd})
+        {
+            if (descriptor >= 0)
+            {
+                ::close(descriptor);
+            }
+        }
+
+        fd      = -1;
+        epollFd = -1;
+        wakeFd  = -1;
+        timerFd = -1;
+
+        status(IO_RESOURCES_UNAVAILABLE, message.str());
+
+        return NRF_ERROR_SD_RPC_SERIAL_PORT;
+    }
+
+    pendingWrite.clear();
+    writeInterest = false;
+    timerDeadline = std::chrono::steady_clock::time_point::max();
+    isOpen        = true;
+
+    if (runtimeDescriptor)
+    {
+        runtimeWaiting = true;
+        waitForEvents();
+    }
+    else
+    {
+        ioThread = std::thread([this] { ioWorker(); });
+    }
+
+    std::stringstream message;
+    message << "Successfully opened " << name << ".";
+    log(SD_RPC_LOG_INFO, message.str());
+
+    return NRF_SUCCESS;
+}
+
+uint32_t FdTransport::close()
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (!isOpen)
+    {
+        return NRF_ERROR_SD_RPC_SERIAL_PORT_ALREADY_CLOSED;
+    }
+
+    isOpen = false;
+
+    const uint64_t stop = 1;
+
+    if (::write(wakeFd, &stop, sizeof(stop)) < 0)
+    {
+        log(SD_RPC_LOG_ERROR, "Failed to stop " + name + " I/O thread.");
+    }
+
+    if (ioThread.joinable())
+    {
+        ioThread.join();
+    }
+
+    if (runtimeDescriptor)
+    {
+        std::unique_lock<std::mutex> lock(runtimeMutex);
+        runtimeStopped.wait(lock, [this] { return !runtimeWaiting; });
+        runtimeDescriptor.reset();
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(timerMutex);
+        ::close(timerFd);
+        timerFd = -1;
+    }
+
+    ::close(epollFd);
+    ::close(wakeFd);
+    ::close(fd);
+
+    fd      = -1;
+    epollFd = -1;
+    wakeFd  = -1;
+
+    std::stringstream message;
+    message << name << " closed.";
+    log(SD_RPC_LOG_INFO, message.str());
+
+    return NRF_SUCCESS;
+}
+
+uint32_t FdTransport::send(const std::vector<uint8_t> &data)
+{
+    const transport_segment_t segment{data.data(), data.size()};
+    return send(&segment, 1);
+}
+
+uint32_t FdTransport::send(const transport_segment_t *segments, const size_t count)
+{
+    if (!isOpen)
+    {
+        log(SD_RPC_LOG_ERROR, "Trying to send packets to device when " + name +
+                                  " is closed is not supported.");
+        return NRF_ERROR_SD_RPC_SERIAL_PORT_STATE;
+    }
+
+    std::lock_guard<std::mutex> guard(writeMutex);
+
+    size_t written = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        writeStats.queued(segments[i].length);
+    }
+
+    // Write directly from the caller's buffers unless data is already waiting to be written
+    if (pendingWrite.empty() && count <= MAX_WRITE_SEGMENTS)
+    {
+        iovec iov[MAX_WRITE_SEGMENTS];
+
+        for (size_t i = 0; i < count; i++)
+        {
+            iov[i].iov_base = const_cast<uint8_t *>(segments[i].data);
+            iov[i].iov_len  = segments[i].length;
+        }
+
+        ssize_t result;
+
+        do
+        {
+            result = writeDescriptor(iov, static_cast<int>(count));
+        } while (result < 0 && errno == EINTR);
+
+        if (result < 0 && errno != EAGAIN)
+        {
+            std::stringstream message;
+            message << "write operation on " << name
+                    << " failed. Error: " << std::strerror(errno);
+            log(SD_RPC_LOG_ERROR, message.str());
+
+            return NRF_ERROR_SD_RPC_SERIAL_PORT;
+        }
+
+        written = result > 0 ? static_cast<size_t>(result) : 0;
+
+        if (written > 0)
+        {
+            writeStats.written(written);
+        }
+    }
+
+    // Queue what could not be written, the I/O thread writes it when the descriptor is writable
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto &segment = segments[i];
+
+        if (written >= segment.length)
+        {
+            written -= segment.length;
+            continue;
+        }
+
+        pendingWrite.insert(pendingWrite.end(), segment.data + written,
+                            segment.data + segment.length);
+        written = 0;
+    }
+
+    if (!pendingWrite.empty())
+    {
+        setWriteInterest(true);
+    }
+
+    return NRF_SUCCESS;
+}
+
+bool FdTransport::setTimerHandler(const timer_cb_t &handler)
+{
+    timerHandler = handler;
+    return true;
+}
+
+void FdTransport::scheduleTimer(const std::chrono::steady_clock::time_point deadline)
+{
+    // An earlier deadline is already scheduled
+    if (deadline >= timerDeadline.load())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(timerMutex);
+
+    if (timerFd < 0 || deadline >= timerDeadline.load())
+    {
+        return;
+    }
+
+    timerDeadline = deadline;
+
+    // steady_clock is CLOCK_MONOTONIC, an expiry of zero would disarm the timer
+    const auto expiry = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     deadline.time_since_epoch()),
+                                 std::chrono::nanoseconds(1));
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(expiry);
+
+    itimerspec timerSpec       = {};
+    timerSpec.it_value.tv_sec  = static_cast<time_t>(seconds.count());
+    timerSpec.it_value.tv_nsec = static_cast<long>((expiry - seconds).count());
+
+    if (timerfd_settime(timerFd, TFD_TIMER_ABSTIME, &timerSpec, nullptr) < 0)
+    {
+        std::stringstream message;
+        message << name << " timerfd_settime failed. Error: " << std::strerror(errno);
+        log(SD_RPC_LOG_ERROR, message.str());
+    }
+}
+
+uint32_t FdTransport::physicalLayerStats(sd_rpc_physical_layer_stats_t *stats)
+{
+    std::lock_guard<std::mutex> guard(writeMutex);
+    writeStats.stats(stats, pendingWrite.size());
+    return NRF_SUCCESS;
+}
+
+void FdTransport::ioWorker()
+{
+    while (handleEvents(-1))
+    {}
+}
+
+// I/O thread of the runtime. The epoll instance is readable when the descriptor or wakeFd is, the
+// events are then handled without blocking and the next wait is started.
+void FdTransport::waitForEvents()
+{
+    runtimeDescriptor->async_wait(asio::posix::stream_descriptor::wait_read,
+                                  [this](const asio::error_code &errorCode) {
+                                      if (!errorCode && handleEvents(0))
+                                      {
+                                          waitForEvents();
+                                          return;
+                                      }
+
+                                      std::lock_guard<std::mutex> lock(runtimeMutex);
+                                      runtimeWaiting = false;
+                                      runtimeStopped.notify_all();
+                                  });
+}
+
+// Waits at most timeout milliseconds for the descriptor, -1 waits until it is ready. Returns false
+// when the I/O is stopped.
+bool FdTransport::handleEvents(const int timeout)
+{
+    epoll_event events[MAX_EPOLL_EVENTS];
+
+    const auto count = epoll_wait(epollFd, events, MAX_EPOLL_EVENTS, timeout);
+
+    if (count < 0)
+    {
+        if (errno == EINTR)
+        {
+            return true;
+        }
+
+        std::stringstream message;
+        message << name << " epoll_wait failed. Error: " << std::strerror(errno);
+        log(SD_RPC_LOG_ERROR, message.str());
+        return false;
+    }
+
+    for (auto i = 0; i < count; i++)
+    {
+        const auto &event = events[i];
+
+        if (event.data.fd == wakeFd)
+        {
+            return false;
+        }
+
+        if (event.data.fd == timerFd)
+        {
+            timerExpired();
+            continue;
+        }
+
+        if (event.events & (EPOLLIN | EPOLLERR | EPOLLHUP))
+        {
+            readAvailable();
+        }
+
+        if (event.events & EPOLLOUT)
+        {
+            writePending();
+        }
+    }
+
+    return true;
+}
+
+void FdTransport::timerExpired()
+{
+    // Clears the expiration, fails with EAGAIN if the timer was set again since it expired
+    uint64_t expirations;
+    const auto result = ::read(timerFd, &expirations, sizeof(expirations));
+    static_cast<void>(result);
+
+    // Deadlines scheduled from now on set the timer again, the handler schedules the deadlines
+    // before now it still needs
+    timerDeadline = std::chrono::steady_clock::time_point::max();
+
+    if (timerHandler)
+    {
+        timerHandler();
+    }
+}
+
+void FdTransport::readAvailable()
+{
+    while (true)
+    {
+        const auto result = ::read(fd, readBuffer.data(), readBuffer.size());
+
+        if (result > 0)
+        {
+            if (upperDataCallback)
+            {
+                upperDataCallback(readBuffer.data(), static_cast<size_t>(result));
+            }
+
+            continue;
+        }
+
+        if (result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (result < 0 && (errno == EAGAIN))
+        {
+            return;
+        }
+
+        // The device is gone (unplugged, or the peer closed the socket or pseudo terminal).
+        // Stop waiting for it so the I/O thread does not spin.
+        std::stringstream message;
+        message << "read on " << name << " failed. Error: "
+                << (result == 0 ? "end of file" : std::strerror(errno)) << ".";
+
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        status(IO_RESOURCES_UNAVAILABLE, message.str());
+        return;
+    }
+}
+
+void FdTransport::writePending()
+{
+    std::lock_guard<std::mutex> guard(writeMutex);
+
+    while (!pendingWrite.empty())
+    {
+        const iovec iov = {pendingWrite.data(), pendingWrite.size()};
+        const auto result = writeDescriptor(&iov, 1);
+
+        if (result < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            if (errno != EAGAIN)
+            {
+                std::stringstream message;
+                message << "write operation on " << name
+                        << " failed. Error: " << std::strerror(errno);
+                log(SD_RPC_LOG_ERROR, message.str());
+                pendingWrite.clear();
+            }
+
+            break;
+        }
+
+        writeStats.written(static_cast<size_t>(result));
+        pendingWrite.erase(pendingWrite.begin(), pendingWrite.begin() + result);
+    }
+
+    if (pendingWrite.empty())
+    {
+        setWriteInterest(false);
+    }
+}
+
+void FdTransport::setWriteInterest(const bool enabled)
+{
+    if (writeInterest == enabled)
+    {
+        return;
+    }
+
+    const auto writeEvents = enabled ? static_cast<uint32_t>(EPOLLOUT) : 0u;
+
+    epoll_event event = {};
+    event.events      = static_cast<uint32_t>(EPOLLIN) | writeEvents;
+    event.data.fd     = fd;
+
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) == 0)
+    {
+        writeInterest = enabled;
+    }
+}
+
+ssize_t FdTransport::writeDescriptor(const iovec *iov, const int count)
+{
+    return ::writev(fd, iov, count);
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "uart_linux.h"
+
+#include <cerrno>
+#include <string>
+#include <system_error>
+
+// termios2 is used to set any baud rate. The kernel definitions of termios can not be combined
+// with <termios.h>, which is therefore not included.
+#include <asm/termbits.h>
+#include <fcntl.h>
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace {
+void throw_errno(const std::string &what)
+{
+    throw std::system_error(std::error_code(errno, std::system_category()), what);
+}
+} // namespace
+
+UartLinux::UartLinux(const UartCommunicationParameters &communicationParameters)
+    : FdTransport(communicationParameters.portName)
+    , baudRate(communicationParameters.baudRate)
+    , flowControl(communicationParameters.flowControl)
+    , parity(communicationParameters.parity)
+    , stopBits(communicationParameters.stopBits)
+    , dataBits(communicationParameters.dataBits)
+{}
+
+int UartLinux::openDescriptor()
+{
+    const auto portFd = ::open(name.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+
+    if (portFd < 0)
+    {
+        throw_errno("Failed to open port");
+    }
+
+    try
+    {
+        configurePort(portFd);
+    }
+    catch (std::exception &)
+    {
+        ::close(portFd);
+        throw;
+    }
+
+    return portFd;
+}
+
+void UartLinux::configurePort(const int portFd)
+{
+    termios2 tio;
+
+    if (ioctl(portFd, TCGETS2, &tio) < 0)
+    {
+        throw_errno("Failed to get port settings");
+    }
+
+    // Raw mode, no processing of the data in either direction
+    tio.c_iflag &= ~(IGNBRK | BRKINT | PARMRK | ISTRIP | INLCR | IGNCR | ICRNL | IXON | IXOFF);
+    tio.c_oflag &= ~OPOST;
+    tio.c_lflag &= ~(ECHO | ECHONL | ICANON | ISIG | IEXTEN);
+    tio.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS | CBAUD);
+    tio.c_cflag |= CLOCAL | CREAD;
+
+    switch (dataBits)
+    {
+        case UartDataBitsFive:
+            tio.c_cflag |= CS5;
+            break;
+        case UartDataBitsSix:
+            tio.c_cflag |= CS6;
+            break;
+        case UartDataBitsSeven:
+            tio.c_cflag |= CS7;
+            break;
+        default:
+            tio.c_cflag |= CS8;
+    }
+
+    if (parity == UartParityEven)
+    {
+        tio.c_cflag |= PARENB;
+    }
+    else if (parity == UartParityOdd)
+    {
+        tio.c_cflag |= PARENB | PARODD;
+    }
+
+    if (stopBits != UartStopBitsOne)
+    {
+        tio.c_cflag |= CSTOPB;
+    }
+
+    if (flowControl == UartFlowControlHardware)
+    {
+        tio.c_cflag |= CRTSCTS;
+    }
+    else if (flowControl == UartFlowControlSoftware)
+    {
+        tio.c_iflag |= IXON | IXOFF;
+    }
+
+    // Any baud rate is set directly, without mapping to a Bxxx constant
+    tio.c_cflag |= BOTHER;
+    tio.c_ispeed = baudRate;
+    tio.c_ospeed = baudRate;
+
+    // The port is non-blocking and the I/O thread waits for data with epoll. VMIN must be non-zero
+    // for reads of an empty port to fail with EAGAIN instead of returning end of file.
+    tio.c_cc[VMIN]  = 1;
+    tio.c_cc[VTIME] = 0;
+
+    if (ioctl(portFd, TCSETS2, &tio) < 0)
+    {
+        throw_errno("Failed to set port settings");
+    }
+
+    // Let the driver pass on received data immediately instead of on its timer. Not all drivers
+    // support this (pseudo terminals do not), the port works without it.
+    serial_struct serial;
+
+    if (ioctl(portFd, TIOCGSERIAL, &serial) == 0)
+    {
+        serial.flags |= ASYNC_LOW_LATENCY;
+
+        if (ioctl(portFd, TIOCSSERIAL, &serial) < 0)
+        {
+            log(SD_RPC_LOG_DEBUG, "Failed to enable low latency mode on " + name + ".");
+        }
+    }
+    else
+    {
+        log(SD_RPC_LOG_DEBUG, "Low latency mode is not supported by " + name + ".");
+    }
+
+    ioctl(portFd, TCFLSH, TCIOFLUSH);
+}
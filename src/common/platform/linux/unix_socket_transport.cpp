@@ -0,0 +1,95 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "unix_socket_transport.h"
+
+#include <cerrno>
+#include <cstring>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+UnixSocketTransport::UnixSocketTransport(const std::string &path)
+    : FdTransport(path)
+{}
+
+int UnixSocketTransport::openDescriptor()
+{
+    sockaddr_un address = {};
+    address.sun_family  = AF_UNIX;
+
+    if (name.size() >= sizeof(address.sun_path))
+    {
+        throw std::system_error(std::make_error_code(std::errc::filename_too_long),
+                                "Socket path too long");
+    }
+
+    std::memcpy(address.sun_path, name.c_str(), name.size());
+
+    const auto socketFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (socketFd < 0)
+    {
+        throw std::system_error(std::error_code(errno, std::system_category()),
+                                "Failed to create socket");
+    }
+
+    // Connect before making the socket non-blocking, a local connect completes immediately
+    if (connect(socketFd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 ||
+        fcntl(socketFd, F_SETFL, fcntl(socketFd, F_GETFL) | O_NONBLOCK) < 0)
+    {
+        const auto error = errno;
+        ::close(socketFd);
+        throw std::system_error(std::error_code(error, std::system_category()),
+                                "Failed to connect to socket");
+    }
+
+    return socketFd;
+}
+
+ssize_t UnixSocketTransport::writeDescriptor(const iovec *iov, const int count)
+{
+    msghdr message     = {};
+    message.msg_iov    = const_cast<iovec *>(iov);
+    message.msg_iovlen = static_cast<size_t>(count);
+
+    // A peer that has gone away is reported by the read side, not by SIGPIPE
+    return sendmsg(fd, &message, MSG_NOSIGNAL);
+}
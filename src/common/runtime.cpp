@@ -0,0 +1,138 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "runtime.h"
+
+#include <system_error>
+
+Runtime::Runtime(const uint32_t ioThreadCount, const uint32_t dispatchThreadCount)
+    : ioWork(new asio::io_service::work(io))
+    , dispatchWork(new asio::io_service::work(dispatchService))
+{
+    try
+    {
+        for (uint32_t i = 0; i < ioThreadCount; i++)
+        {
+            threads.emplace_back([this] { io.run(); });
+        }
+
+        for (uint32_t i = 0; i < dispatchThreadCount; i++)
+        {
+            threads.emplace_back([this] { dispatchService.run(); });
+        }
+    }
+    catch (const std::system_error &)
+    {
+        stop();
+        throw;
+    }
+}
+
+std::shared_ptr<Runtime> Runtime::create(const uint32_t ioThreadCount,
+                                         const uint32_t dispatchThreadCount)
+{
+    return std::shared_ptr<Runtime>(new Runtime(ioThreadCount, dispatchThreadCount),
+                                    &Runtime::destroy);
+}
+
+Runtime::~Runtime()
+{
+    stop();
+}
+
+// A thread of the runtime can not join itself. When the last owner releases the runtime on one of
+// them, for example by deleting an adapter from an event handler, it is destroyed by a new thread.
+void Runtime::destroy(Runtime *runtime)
+{
+    if (runtime->onRuntimeThread())
+    {
+        try
+        {
+            std::thread([runtime] { delete runtime; }).detach();
+            return;
+        }
+        catch (const std::system_error &)
+        {
+            // The threads are left running rather than joining the current one
+            return;
+        }
+    }
+
+    delete runtime;
+}
+
+bool Runtime::onRuntimeThread() const
+{
+    const auto current = std::this_thread::get_id();
+
+    for (const auto &thread : threads)
+    {
+        if (thread.get_id() == current)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+asio::io_service &Runtime::ioService()
+{
+    return io;
+}
+
+void Runtime::dispatch(const std::function<void()> &task)
+{
+    dispatchService.post(task);
+}
+
+void Runtime::stop()
+{
+    // Handlers already queued run before the threads return
+    ioWork.reset();
+    dispatchWork.reset();
+
+    for (auto &thread : threads)
+    {
+        if (thread.joinable())
+        {
+            thread.join();
+        }
+    }
+
+    threads.clear();
+}
@@ -40,13 +40,25 @@
 #include "adapter_internal.h"
 #include "ble_common.h"
 #include "h5_transport.h"
+#include "recording_transport.h"
+#include "replay_transport.h"
+#include "runtime.h"
 #include "serial_port_enum.h"
 #include "serialization_transport.h"
 #include "uart_boost.h"
 #include "uart_settings_boost.h"
 #include "app_ble_gap.h"
 
+#if defined(__linux__)
+#include "uart_linux.h"
+#include "unix_socket_transport.h"
+
+#include <sys/stat.h>
+#endif
+
 #include <cstdlib>
+#include <functional>
+#include <system_error>
 
 uint32_t sd_rpc_serial_port_enum(sd_rpc_serial_port_desc_t serial_port_descs[], uint32_t *size)
 {
@@ -80,12 +92,11 @@ uint32_t sd_rpc_serial_port_enum(sd_rpc_serial_port_desc_t serial_port_descs[],
     return NRF_SUCCESS;
 }
 
-physical_layer_t *sd_rpc_physical_layer_create_uart(const char *port_name, uint32_t baud_rate,
-                                                    sd_rpc_flow_control_t flow_control,
-                                                    sd_rpc_parity_t parity)
+namespace {
+UartCommunicationParameters uart_settings(const char *port_name, uint32_t baud_rate,
+                                          sd_rpc_flow_control_t flow_control,
+                                          sd_rpc_parity_t parity)
 {
-    const auto physicalLayer = static_cast<physical_layer_t *>(malloc(sizeof(physical_layer_t)));
-
     UartCommunicationParameters uartSettings = {};
     uartSettings.portName                    = port_name;
     uartSettings.baudRate                    = baud_rate;
@@ -111,11 +122,111 @@ physical_layer_t *sd_rpc_physical_layer_create_uart(const char *port_name, uint3
     uartSettings.stopBits = UartStopBitsOne;
     uartSettings.dataBits = UartDataBitsEight;
 
-    const auto uart         = new UartBoost(uartSettings);
-    physicalLayer->internal = static_cast<void *>(uart);
+    return uartSettings;
+}
+} // namespace
+
+physical_layer_t *sd_rpc_physical_layer_create_uart(const char *port_name, uint32_t baud_rate,
+                                                    sd_rpc_flow_control_t flow_control,
+                                                    sd_rpc_parity_t parity)
+{
+    const auto physicalLayer = static_cast<physical_layer_t *>(malloc(sizeof(physical_layer_t)));
+    const auto uart = new UartBoost(uart_settings(port_name, baud_rate, flow_control, parity));
+    physicalLayer->internal = static_cast<void *>(static_cast<Transport *>(uart));
     return physicalLayer;
 }
 
+physical_layer_t *sd_rpc_physical_layer_create_uart_native(const char *port_name,
+                                                           uint32_t baud_rate,
+                                                           sd_rpc_flow_control_t flow_control,
+                                                           sd_rpc_parity_t parity)
+{
+#if defined(__linux__)
+    const auto physicalLayer = static_cast<physical_layer_t *>(malloc(sizeof(physical_layer_t)));
+    const auto uart = new UartLinux(uart_settings(port_name, baud_rate, flow_control, parity));
+    physicalLayer->internal = static_cast<void *>(static_cast<Transport *>(uart));
+    return physicalLayer;
+#else
+    (void)port_name;
+    (void)baud_rate;
+    (void)flow_control;
+    (void)parity;
+    return nullptr;
+#endif
+}
+
+physical_layer_t *sd_rpc_physical_layer_create_local(const char *path)
+{
+#if defined(__linux__)
+    if (path == nullptr)
+    {
+        return nullptr;
+    }
+
+    Transport *transport;
+    struct stat status;
+
+    if (stat(path, &status) == 0 && S_ISSOCK(status.st_mode))
+    {
+        transport = new UnixSocketTransport(path);
+    }
+    else
+    {
+        // A pseudo terminal ignores the serial port settings
+        transport = new UartLinux(uart_settings(path, 1000000, SD_RPC_FLOW_CONTROL_NONE,
+                                                SD_RPC_PARITY_NONE));
+    }
+
+    const auto physicalLayer = static_cast<physical_layer_t *>(malloc(sizeof(physical_layer_t)));
+    physicalLayer->internal  = static_cast<void *>(transport);
+    return physicalLayer;
+#else
+    (void)path;
+    return nullptr;
+#endif
+}
+
+physical_layer_t *sd_rpc_physical_layer_create_recording(physical_layer_t *physical_layer,
+                                                         const char *file_path)
+{
+    if (physical_layer == nullptr || physical_layer->internal == nullptr || file_path == nullptr)
+    {
+        return nullptr;
+    }
+
+    const auto physicalLayer = static_cast<physical_layer_t *>(malloc(sizeof(physical_layer_t)));
+    const auto recording =
+        new RecordingTransport(static_cast<Transport *>(physical_layer->internal), file_path);
+    physicalLayer->internal = static_cast<void *>(static_cast<Transport *>(recording));
+    return physicalLayer;
+}
+
+physical_layer_t *sd_rpc_physical_layer_create_replay(const char *file_path,
+                                                      sd_rpc_replay_timing_t timing)
+{
+    if (file_path == nullptr)
+    {
+        return nullptr;
+    }
+
+    const auto physicalLayer = static_cast<physical_layer_t *>(malloc(sizeof(physical_layer_t)));
+    const auto replay =
+        new ReplayTransport(file_path, timing == SD_RPC_REPLAY_TIMING_ORIGINAL);
+    physicalLayer->internal = static_cast<void *>(static_cast<Transport *>(replay));
+    return physicalLayer;
+}
+
+uint32_t sd_rpc_physical_layer_stats_get(physical_layer_t *physical_layer,
+                                         sd_rpc_physical_layer_stats_t *stats)
+{
+    if (physical_layer == nullptr || physical_layer->internal == nullptr || stats == nullptr)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    return static_cast<Transport *>(physical_layer->internal)->physicalLayerStats(stats);
+}
+
 data_link_layer_t *sd_rpc_data_link_layer_create_bt_three_wire(physical_layer_t *physical_layer,
                                                                uint32_t retransmission_interval)
 {
@@ -126,6 +237,33 @@ data_link_layer_t *sd_rpc_data_link_layer_create_bt_three_wire(physical_layer_t
     return dataLinkLayer;
 }
 
+data_link_layer_t *
+sd_rpc_data_link_layer_create_bt_three_wire_delayed_ack(physical_layer_t *physical_layer,
+                                                        uint32_t retransmission_interval,
+                                                        uint32_t ack_delay)
+{
+    const auto dataLinkLayer = static_cast<data_link_layer_t *>(malloc(sizeof(data_link_layer_t)));
+    const auto physicalLayer = static_cast<Transport *>(physical_layer->internal);
+    const auto h5 = new H5Transport(physicalLayer, retransmission_interval, SlidingWindowSizeMax,
+                                    ack_delay);
+    dataLinkLayer->internal = static_cast<void *>(h5);
+    return dataLinkLayer;
+}
+
+uint32_t sd_rpc_data_link_layer_rtt_estimate_get(data_link_layer_t *data_link_layer,
+                                                 sd_rpc_rtt_estimate_t *rtt_estimate)
+{
+    if (data_link_layer == nullptr || data_link_layer->internal == nullptr ||
+        rtt_estimate == nullptr)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    const auto h5 = static_cast<H5Transport *>(data_link_layer->internal);
+    *rtt_estimate = h5->rttEstimate();
+    return NRF_SUCCESS;
+}
+
 transport_layer_t *sd_rpc_transport_layer_create(data_link_layer_t *data_link_layer,
                                                  uint32_t response_timeout)
 {
@@ -145,6 +283,124 @@ adapter_t *sd_rpc_adapter_create(transport_layer_t *transport_layer)
     return adapterLayer;
 }
 
+adapter_t *sd_rpc_adapter_create_with_buffer_pool(
+    transport_layer_t *transport_layer, const sd_rpc_buffer_pool_config_t *buffer_pool_config)
+{
+    if (buffer_pool_config == nullptr)
+    {
+        return nullptr;
+    }
+
+    const auto adapterLayer   = static_cast<adapter_t *>(malloc(sizeof(adapter_t)));
+    const auto transportLayer = static_cast<SerializationTransport *>(transport_layer->internal);
+    const auto adapter        = new AdapterInternal(transportLayer, *buffer_pool_config);
+    adapterLayer->internal    = static_cast<void *>(adapter);
+    return adapterLayer;
+}
+
+sd_rpc_runtime_t *sd_rpc_runtime_create(const sd_rpc_runtime_config_t *runtime_config)
+{
+    if (runtime_config == nullptr)
+    {
+        return nullptr;
+    }
+
+    const auto ioThreads       = runtime_config->io_threads;
+    const auto dispatchThreads = runtime_config->dispatch_threads;
+
+    if (ioThreads == 0 || ioThreads > SD_RPC_RUNTIME_THREADS_MAX || dispatchThreads == 0 ||
+        dispatchThreads > SD_RPC_RUNTIME_THREADS_MAX)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<Runtime> runtime;
+
+    try
+    {
+        runtime = Runtime::create(ioThreads, dispatchThreads);
+    }
+    catch (const std::system_error &)
+    {
+        return nullptr;
+    }
+
+    const auto runtimeLayer = static_cast<sd_rpc_runtime_t *>(malloc(sizeof(sd_rpc_runtime_t)));
+    runtimeLayer->internal  = static_cast<void *>(new std::shared_ptr<Runtime>(runtime));
+    return runtimeLayer;
+}
+
+uint32_t sd_rpc_runtime_delete(sd_rpc_runtime_t *runtime)
+{
+    if (runtime == nullptr)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    const auto runtimeLayer = static_cast<std::shared_ptr<Runtime> *>(runtime->internal);
+
+    if (runtimeLayer == nullptr)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+
+    delete runtimeLayer;
+    runtime->internal = nullptr;
+    return NRF_SUCCESS;
+}
+
+adapter_t *sd_rpc_adapter_create_with_runtime(transport_layer_t *transport_layer,
+                                              sd_rpc_runtime_t *runtime)
+{
+    if (runtime == nullptr || runtime->internal == nullptr)
+    {
+        return nullptr;
+    }
+
+    const auto adapterLayer   = static_cast<adapter_t *>(malloc(sizeof(adapter_t)));
+    const auto transportLayer = static_cast<SerializationTransport *>(transport_layer->internal);
+    const auto sharedRuntime  = *static_cast<std::shared_ptr<Runtime> *>(runtime->internal);
+    const auto adapter        = new AdapterInternal(transportLayer, sharedRuntime);
+    adapterLayer->internal    = static_cast<void *>(adapter);
+    return adapterLayer;
+}
+
+uint32_t sd_rpc_buffer_pool_stats_get(adapter_t *adapter, sd_rpc_buffer_pool_stats_t *stats)
+{
+    if (adapter == nullptr || stats == nullptr)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    const auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    *stats = adapterLayer->bufferPool->stats();
+    return NRF_SUCCESS;
+}
+
+uint32_t sd_rpc_stats_get(adapter_t *adapter, sd_rpc_stats_t *stats)
+{
+    if (adapter == nullptr || stats == nullptr)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    const auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    adapterLayer->stats->stats(stats);
+    return NRF_SUCCESS;
+}
+
 void sd_rpc_adapter_delete(adapter_t *adapter)
 {
     const auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
@@ -158,25 +414,102 @@ void sd_rpc_adapter_delete(adapter_t *adapter)
     adapter->internal = nullptr;
 }
 
+namespace {
+// Opens the adapter with open, after the checks shared by the open functions
+uint32_t open_adapter(adapter_t *adapter,
+                      const std::function<uint32_t(AdapterInternal *adapterLayer)> &open)
+{
+    if (adapter == nullptr)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    const auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return open(adapterLayer);
+}
+} // namespace
+
 uint32_t sd_rpc_open(adapter_t *adapter, sd_rpc_status_handler_t status_handler,
                      sd_rpc_evt_handler_t event_handler, sd_rpc_log_handler_t log_handler)
 {
-    auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+    return open_adapter(adapter, [&](AdapterInternal *adapterLayer) {
+        return adapterLayer->open(status_handler, event_handler, log_handler);
+    });
+}
+
+uint32_t sd_rpc_open_batch(adapter_t *adapter, sd_rpc_status_handler_t status_handler,
+                           sd_rpc_evt_batch_handler_t evt_batch_handler,
+                           sd_rpc_log_handler_t log_handler,
+                           const sd_rpc_evt_batch_config_t *config)
+{
+    if (adapter == nullptr || config == nullptr)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    if (config->max_batch_size == 0 || config->max_batch_size > SD_RPC_EVT_BATCH_SIZE_MAX)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return open_adapter(adapter, [&](AdapterInternal *adapterLayer) {
+        return adapterLayer->open(status_handler, evt_batch_handler, log_handler, *config);
+    });
+}
+
+uint32_t sd_rpc_open_pull(adapter_t *adapter, sd_rpc_status_handler_t status_handler,
+                          sd_rpc_log_handler_t log_handler)
+{
+    return open_adapter(adapter, [&](AdapterInternal *adapterLayer) {
+        return adapterLayer->open(status_handler, log_handler);
+    });
+}
+
+uint32_t sd_rpc_evt_get(adapter_t *adapter, uint8_t *p_dest, uint16_t *p_len)
+{
+    if (adapter == nullptr || p_len == nullptr)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    const auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
 
     if (adapterLayer == nullptr)
     {
         return NRF_ERROR_INVALID_PARAM;
     }
 
-    const auto err_code = adapterLayer->open(status_handler, event_handler, log_handler);
+    const auto err_code = adapterLayer->transport->getEvent(p_dest, p_len);
 
-    if (err_code != NRF_SUCCESS)
+    if (err_code == NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_INVALID_STATE)
     {
-        return err_code;
+        return NRF_ERROR_INVALID_STATE;
     }
 
-    // Create a BLE GAP state object
-    return app_ble_gap_state_create(adapterLayer->transport);
+    return err_code;
+}
+
+int sd_rpc_evt_fd(adapter_t *adapter)
+{
+    if (adapter == nullptr)
+    {
+        return -1;
+    }
+
+    const auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr)
+    {
+        return -1;
+    }
+
+    return adapterLayer->transport->eventFd();
 }
 
 uint32_t sd_rpc_close(adapter_t *adapter)
@@ -188,12 +521,27 @@ uint32_t sd_rpc_close(adapter_t *adapter)
         return NRF_ERROR_INVALID_PARAM;
     }
 
-    // Delete BLE GAP state object
-    app_ble_gap_state_delete(adapterLayer->transport);
-
     return adapterLayer->close();
 }
 
+uint32_t sd_rpc_command_async(adapter_t *adapter, sd_rpc_command_handler_t command,
+                              sd_rpc_command_complete_handler_t complete_handler, void *p_context)
+{
+    if (adapter == nullptr || command == nullptr)
+    {
+        return NRF_ERROR_NULL;
+    }
+
+    const auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
+
+    if (adapterLayer == nullptr)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    return adapterLayer->commandAsync(adapter, command, complete_handler, p_context);
+}
+
 uint32_t sd_rpc_log_handler_severity_filter_set(adapter_t *adapter,
                                                 sd_rpc_log_severity_t severity_filter)
 {
@@ -220,5 +568,5 @@ uint32_t sd_rpc_conn_reset(adapter_t *adapter, sd_rpc_reset_t reset_mode)
     std::vector<uint8_t> tx_buffer(tx_buffer_length);
     tx_buffer[0] = static_cast<uint8_t>(reset_mode);
 
-    return adapterLayer->transport->send(tx_buffer, nullptr, SERIALIZATION_RESET_CMD);
+    return adapterLayer->transport->send(tx_buffer, PooledBuffer(), SERIALIZATION_RESET_CMD);
 }
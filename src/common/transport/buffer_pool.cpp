@@ -0,0 +1,263 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "buffer_pool.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+
+namespace {
+const uint32_t FREE_LIST_EMPTY = 0xFFFFFFFF;
+
+// Buffers are aligned so that structs can be decoded into them
+size_t align_size(const size_t size)
+{
+    const auto alignment = alignof(std::max_align_t);
+    return (size + alignment - 1) / alignment * alignment;
+}
+
+uint64_t free_list_head(const uint64_t previous, const uint32_t index)
+{
+    const auto tag = (previous >> 32) + 1;
+    return (tag << 32) | index;
+}
+} // namespace
+
+PooledBuffer::PooledBuffer() noexcept
+    : header(nullptr)
+{}
+
+PooledBuffer::PooledBuffer(Header *header_) noexcept
+    : header(header_)
+{}
+
+PooledBuffer::PooledBuffer(const PooledBuffer &other) noexcept
+    : header(other.header)
+{
+    if (header != nullptr)
+    {
+        header->references.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+PooledBuffer::PooledBuffer(PooledBuffer &&other) noexcept
+    : header(other.header)
+{
+    other.header = nullptr;
+}
+
+PooledBuffer &PooledBuffer::operator=(PooledBuffer other) noexcept
+{
+    std::swap(header, other.header);
+    return *this;
+}
+
+PooledBuffer::~PooledBuffer() noexcept
+{
+    release();
+}
+
+uint8_t *PooledBuffer::data() const noexcept
+{
+    return header != nullptr ? header->data : nullptr;
+}
+
+size_t PooledBuffer::size() const noexcept
+{
+    return header != nullptr ? header->size : 0;
+}
+
+size_t PooledBuffer::capacity() const noexcept
+{
+    return header != nullptr ? header->capacity : 0;
+}
+
+void PooledBuffer::resize(const size_t size) noexcept
+{
+    if (header != nullptr)
+    {
+        header->size = std::min(size, header->capacity);
+    }
+}
+
+PooledBuffer::operator bool() const noexcept
+{
+    return header != nullptr;
+}
+
+void PooledBuffer::release() noexcept
+{
+    if (header == nullptr)
+    {
+        return;
+    }
+
+    if (header->references.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        if (header->pool != nullptr)
+        {
+            header->pool->release(header);
+        }
+        else
+        {
+            header->~Header();
+            delete[] reinterpret_cast<uint8_t *>(header);
+        }
+    }
+
+    header = nullptr;
+}
+
+BufferPool::BufferPool(const size_t buffer_size, const size_t buffer_count)
+    : bufferSize(align_size(buffer_size))
+    , bufferCount(std::min(buffer_count, static_cast<size_t>(FREE_LIST_EMPTY)))
+    , memory(new uint8_t[bufferSize * bufferCount])
+    , headers(new PooledBuffer::Header[bufferCount])
+    , next(new std::atomic<uint32_t>[bufferCount])
+    , freeList(FREE_LIST_EMPTY)
+    , inUse(0)
+    , highWaterMark(0)
+    , exhaustedCount(0)
+    , heapFallbackCount(0)
+{
+    for (size_t i = 0; i < bufferCount; i++)
+    {
+        auto &header = headers[i];
+        header.references.store(0, std::memory_order_relaxed);
+        header.pool     = this;
+        header.index    = static_cast<uint32_t>(i);
+        header.capacity = bufferSize;
+        header.size     = 0;
+        header.data     = memory.get() + i * bufferSize;
+
+        // Buffers are initially linked in order
+        next[i].store(i + 1 < bufferCount ? static_cast<uint32_t>(i + 1) : FREE_LIST_EMPTY,
+                      std::memory_order_relaxed);
+    }
+
+    if (bufferCount > 0)
+    {
+        freeList.store(0, std::memory_order_release);
+    }
+}
+
+BufferPool::~BufferPool() noexcept = default;
+
+PooledBuffer BufferPool::acquire(const size_t size)
+{
+    if (size <= bufferSize)
+    {
+        auto head = freeList.load(std::memory_order_acquire);
+
+        while (static_cast<uint32_t>(head) != FREE_LIST_EMPTY)
+        {
+            const auto index = static_cast<uint32_t>(head);
+
+            // The link may be changed by another thread, the compare exchange then fails since
+            // the tag has changed
+            const auto nextIndex = next[index].load(std::memory_order_relaxed);
+
+            if (freeList.compare_exchange_weak(head, free_list_head(head, nextIndex),
+                                               std::memory_order_acq_rel,
+                                               std::memory_order_acquire))
+            {
+                auto &header = headers[index];
+                header.references.store(1, std::memory_order_relaxed);
+                header.size = size;
+
+                const auto used = inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+                auto highest    = highWaterMark.load(std::memory_order_relaxed);
+
+                while (used > highest &&
+                       !highWaterMark.compare_exchange_weak(highest, used,
+                                                            std::memory_order_relaxed))
+                {
+                }
+
+                return PooledBuffer(&header);
+            }
+        }
+
+        exhaustedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    heapFallbackCount.fetch_add(1, std::memory_order_relaxed);
+    return allocate(size);
+}
+
+PooledBuffer BufferPool::allocate(const size_t size)
+{
+    const auto headerSize = align_size(sizeof(PooledBuffer::Header));
+    const auto memory     = new uint8_t[headerSize + size];
+    const auto header = new (memory) PooledBuffer::Header();
+
+    header->references.store(1, std::memory_order_relaxed);
+    header->pool     = nullptr;
+    header->index    = 0;
+    header->capacity = size;
+    header->size     = size;
+    header->data     = memory + headerSize;
+
+    return PooledBuffer(header);
+}
+
+void BufferPool::release(PooledBuffer::Header *header) noexcept
+{
+    inUse.fetch_sub(1, std::memory_order_relaxed);
+
+    auto head = freeList.load(std::memory_order_relaxed);
+
+    do
+    {
+        next[header->index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+    } while (!freeList.compare_exchange_weak(head, free_list_head(head, header->index),
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+}
+
+sd_rpc_buffer_pool_stats_t BufferPool::stats() const
+{
+    sd_rpc_buffer_pool_stats_t stats;
+    stats.buffer_size         = static_cast<uint32_t>(bufferSize);
+    stats.buffer_count        = static_cast<uint32_t>(bufferCount);
+    stats.in_use              = inUse.load(std::memory_order_relaxed);
+    stats.high_water_mark     = highWaterMark.load(std::memory_order_relaxed);
+    stats.exhausted_count     = exhaustedCount.load(std::memory_order_relaxed);
+    stats.heap_fallback_count = heapFallbackCount.load(std::memory_order_relaxed);
+    return stats;
+}
@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "crc16.h"
+
+#include <cstddef>
+#include <vector>
+
+#if H5_CRC16_SLICES != 0 && H5_CRC16_SLICES != 1 && H5_CRC16_SLICES != 4 &&                     \
+    H5_CRC16_SLICES != 8
+#error "H5_CRC16_SLICES must be 0, 1, 4 or 8"
+#endif
+
+namespace {
+
+const uint16_t CRC16_POLYNOMIAL = 0x1021;
+
+#if H5_CRC16_SLICES > 0
+// table[0] is the CRC of each byte value, table[n] is the CRC of each byte value followed by n
+// zero bytes. Processing several bytes per step needs one table per byte.
+struct Crc16Tables
+{
+    uint16_t table[H5_CRC16_SLICES][256];
+};
+
+constexpr Crc16Tables crc16_generate_tables()
+{
+    Crc16Tables tables{};
+
+    for (uint16_t value = 0; value < 256; value++)
+    {
+        uint16_t crc = static_cast<uint16_t>(value << 8);
+
+        for (auto bit = 0; bit < 8; bit++)
+        {
+            crc = static_cast<uint16_t>((crc & 0x8000) ? (crc << 1) ^ CRC16_POLYNOMIAL : crc << 1);
+        }
+
+        tables.table[0][value] = crc;
+    }
+
+    for (auto slice = 1; slice < H5_CRC16_SLICES; slice++)
+    {
+        for (uint16_t value = 0; value < 256; value++)
+        {
+            const auto previous         = tables.table[slice - 1][value];
+            tables.table[slice][value] = static_cast<uint16_t>((previous << 8) ^
+                                                               tables.table[0][previous >> 8]);
+        }
+    }
+
+    return tables;
+}
+
+constexpr Crc16Tables crc16Tables = crc16_generate_tables();
+
+inline uint16_t crc16_table_step(const uint16_t crc, const uint8_t data)
+{
+    return static_cast<uint16_t>((crc << 8) ^ crc16Tables.table[0][(crc >> 8) ^ data]);
+}
+#endif
+
+} // namespace
+
+uint16_t crc16_calculate_reference(const uint8_t *start, const uint8_t *end, const uint16_t crc)
+{
+    uint16_t result = crc;
+
+    for (auto data = start; data != end; data++)
+    {
+        result = (result >> 8) | (result << 8);
+        result ^= *data;
+        result ^= (result & 0xFF) >> 4;
+        result ^= result << 12;
+        result ^= (result & 0xFF) << 5;
+    }
+
+    return result;
+}
+
+uint16_t crc16_calculate(const uint8_t *start, const uint8_t *end, const uint16_t crc)
+{
+#if H5_CRC16_SLICES == 0
+    return crc16_calculate_reference(start, end, crc);
+#else
+    uint16_t result = crc;
+    auto data       = start;
+
+#if H5_CRC16_SLICES > 1
+    const auto &t = crc16Tables.table;
+
+    // The CRC is combined with the first two bytes of each slice, the remaining bytes are
+    // looked up directly
+    while (end - data >= H5_CRC16_SLICES)
+    {
+        result = static_cast<uint16_t>(t[H5_CRC16_SLICES - 1][(result >> 8) ^ data[0]] ^
+                                       t[H5_CRC16_SLICES - 2][(result & 0xFF) ^ data[1]] ^
+                                       t[H5_CRC16_SLICES - 3][data[2]] ^
+                                       t[H5_CRC16_SLICES - 4][data[3]]
+#if H5_CRC16_SLICES == 8
+                                       ^ t[3][data[4]] ^ t[2][data[5]] ^ t[1][data[6]] ^
+                                       t[0][data[7]]
+#endif
+        );
+
+        data += H5_CRC16_SLICES;
+    }
+#endif
+
+    for (; data != end; data++)
+    {
+        result = crc16_table_step(result, *data);
+    }
+
+    return result;
+#endif
+}
+
+bool crc16_self_test()
+{
+    static const bool passed = [] {
+        // CRC-CCITT check value
+        const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+
+        if (crc16_calculate(check, check + sizeof(check)) != 0x29B1 ||
+            crc16_calculate_reference(check, check + sizeof(check)) != 0x29B1)
+        {
+            return false;
+        }
+
+        // Cover all lengths up to a few slices and every start offset within a slice
+        std::vector<uint8_t> data(64);
+        uint32_t seed = 0x12345678;
+
+        for (auto &byte : data)
+        {
+            seed = seed * 1103515245 + 12345;
+            byte = static_cast<uint8_t>(seed >> 16);
+        }
+
+        for (size_t offset = 0; offset < 8; offset++)
+        {
+            for (size_t length = 0; offset + length <= data.size(); length++)
+            {
+                const auto start = data.data() + offset;
+
+                if (crc16_calculate(start, start + length) !=
+                    crc16_calculate_reference(start, start + length))
+                {
+                    return false;
+                }
+            }
+        }
+
+        return true;
+    }();
+
+    return passed;
+}
@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "event_notifier.h"
+
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#include <unistd.h>
+#elif !defined(_WIN32)
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include <stdint.h>
+
+#if defined(__linux__)
+
+EventNotifier::EventNotifier()
+    : readFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))
+    , writeFd(readFd)
+{}
+
+EventNotifier::~EventNotifier() noexcept
+{
+    if (readFd >= 0)
+    {
+        ::close(readFd);
+    }
+}
+
+void EventNotifier::signal()
+{
+    const uint64_t value = 1;
+
+    // Fails only if the counter would overflow, the descriptor is readable then
+    (void)::write(writeFd, &value, sizeof(value));
+}
+
+void EventNotifier::clear()
+{
+    uint64_t value;
+
+    // Reading resets the counter, fails if it is already zero
+    (void)::read(readFd, &value, sizeof(value));
+}
+
+#elif !defined(_WIN32)
+
+EventNotifier::EventNotifier()
+    : readFd(-1)
+    , writeFd(-1)
+{
+    int fds[2];
+
+    if (::pipe(fds) != 0)
+    {
+        return;
+    }
+
+    for (const auto fd : fds)
+    {
+        ::fcntl(fd, F_SETFL, ::fcntl(fd, F_GETFL) | O_NONBLOCK);
+        ::fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+
+    readFd  = fds[0];
+    writeFd = fds[1];
+}
+
+EventNotifier::~EventNotifier() noexcept
+{
+    if (readFd >= 0)
+    {
+        ::close(readFd);
+        ::close(writeFd);
+    }
+}
+
+void EventNotifier::signal()
+{
+    const uint8_t value = 1;
+
+    // Fails if the pipe is full, the descriptor is readable then
+    (void)::write(writeFd, &value, sizeof(value));
+}
+
+void EventNotifier::clear()
+{
+    uint8_t values[64];
+
+    while (::read(readFd, values, sizeof(values)) > 0)
+    {
+    }
+}
+
+#else
+
+EventNotifier::EventNotifier()
+    : readFd(-1)
+    , writeFd(-1)
+{}
+
+EventNotifier::~EventNotifier() noexcept = default;
+
+void EventNotifier::signal() {}
+
+void EventNotifier::clear() {}
+
+#endif
+
+int EventNotifier::fd() const
+{
+    return readFd;
+}
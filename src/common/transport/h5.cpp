@@ -36,9 +36,12 @@
  */
 
 #include "h5.h"
+#include "crc16.h"
 #include "nrf_error.h"
 #include "sd_rpc_types.h"
+#include "slip.h"
 #include <algorithm>
+#include <cstring>
 #include <vector>
 
 const uint8_t seqNumMask         = 0x07;
@@ -54,7 +57,7 @@ const uint16_t payloadLengthFirstNibbleMask  = 0x000F;
 const uint16_t payloadLengthSecondNibbleMask = 0x0FF0;
 const uint8_t payloadLengthOffset            = 4;
 
-uint8_t calculate_header_checksum(const std::vector<uint8_t> &header)
+uint8_t calculate_header_checksum(const uint8_t *header)
 {
     uint16_t checksum = header[0];
     checksum += header[1];
@@ -65,40 +68,35 @@ uint8_t calculate_header_checksum(const std::vector<uint8_t> &header)
     return static_cast<uint8_t>(checksum);
 }
 
-uint16_t calculate_crc16_checksum(const std::vector<uint8_t>::const_iterator &start,
-                                  const std::vector<uint8_t>::const_iterator &end)
+void write_h5_header(uint8_t *header, const uint8_t seq_num, const uint8_t ack_num,
+                     const bool crc_present, const bool reliable_packet, const uint8_t packet_type,
+                     const uint16_t payload_length)
 {
-    uint16_t crc = 0xFFFF;
+    header[0] = (seq_num & seqNumMask) | ((ack_num & ackNumMask) << ackNumPos) |
+                ((crc_present & crcPresentMask) << crcPresentPos) |
+                ((reliable_packet & reliablePacketMask) << reliablePacketPos);
 
-    std::for_each(start, end, [&crc](const uint8_t data) {
-        crc = (crc >> 8) | (crc << 8);
-        crc ^= data;
-        crc ^= (crc & 0xFF) >> 4;
-        crc ^= crc << 12;
-        crc ^= (crc & 0xFF) << 5;
-    });
+    header[1] = (packet_type & packetTypeMask) |
+                ((payload_length & payloadLengthFirstNibbleMask) << payloadLengthOffset);
 
-    return crc;
+    header[2] = (payload_length & payloadLengthSecondNibbleMask) >> payloadLengthOffset;
+    header[3] = calculate_header_checksum(header);
 }
 
 void add_h5_header(std::vector<uint8_t> &out_packet, const uint8_t seq_num, const uint8_t ack_num,
                    const bool crc_present, const bool reliable_packet, const uint8_t packet_type,
                    const uint16_t payload_length)
 {
-    out_packet.push_back((seq_num & seqNumMask) | ((ack_num & ackNumMask) << ackNumPos) |
-                         ((crc_present & crcPresentMask) << crcPresentPos) |
-                         ((reliable_packet & reliablePacketMask) << reliablePacketPos));
-
-    out_packet.push_back((packet_type & packetTypeMask) |
-                         ((payload_length & payloadLengthFirstNibbleMask) << payloadLengthOffset));
-
-    out_packet.push_back((payload_length & payloadLengthSecondNibbleMask) >> payloadLengthOffset);
-    out_packet.push_back(calculate_header_checksum(out_packet));
+    uint8_t header[H5_HEADER_LENGTH];
+    write_h5_header(header, seq_num, ack_num, crc_present, reliable_packet, packet_type,
+                    payload_length);
+    out_packet.insert(out_packet.end(), header, header + H5_HEADER_LENGTH);
 }
 
 void add_crc16(std::vector<uint8_t> &out_packet)
 {
-    const auto crc16 = calculate_crc16_checksum(out_packet.begin(), out_packet.end());
+    const auto crc16 =
+        crc16_calculate(out_packet.data(), out_packet.data() + out_packet.size());
     out_packet.push_back(crc16 & 0xFF);
     out_packet.push_back((crc16 >> 8) & 0xFF);
 }
@@ -119,32 +117,176 @@ void h5_encode(const std::vector<uint8_t> &in_packet, std::vector<uint8_t> &out_
     }
 }
 
+void h5_encode(const transport_segment_t *segments, const size_t count,
+               std::vector<uint8_t> &out_packet, const uint8_t seq_num, const uint8_t ack_num,
+               const bool crc_present, const bool reliable_packet,
+               const h5_pkt_type_t packet_type)
+{
+    size_t payload_length = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        payload_length += segments[i].length;
+    }
+
+    out_packet.resize(H5_HEADER_LENGTH + payload_length + (crc_present ? 2 : 0));
+    auto out = out_packet.data();
+
+    write_h5_header(out, seq_num, ack_num, crc_present, reliable_packet, packet_type,
+                    static_cast<uint16_t>(payload_length));
+    out += H5_HEADER_LENGTH;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        std::memcpy(out, segments[i].data, segments[i].length);
+        out += segments[i].length;
+    }
+
+    if (crc_present)
+    {
+        const auto crc16 = crc16_calculate(out_packet.data(), out);
+        out[0]           = static_cast<uint8_t>(crc16 & 0xFF);
+        out[1]           = static_cast<uint8_t>((crc16 >> 8) & 0xFF);
+    }
+}
+
+bool h5_set_ack_num(std::vector<uint8_t> &h5_packet, const uint8_t ack_num)
+{
+    auto header = h5_packet.data();
+
+    if (((header[0] >> ackNumPos) & ackNumMask) == ack_num)
+    {
+        return false;
+    }
+
+    header[0] = static_cast<uint8_t>((header[0] & ~(ackNumMask << ackNumPos)) |
+                                     ((ack_num & ackNumMask) << ackNumPos));
+    header[3] = calculate_header_checksum(header);
+
+    if (((header[0] >> crcPresentPos) & crcPresentMask) != 0)
+    {
+        const auto crc   = h5_packet.data() + h5_packet.size() - 2;
+        const auto crc16 = crc16_calculate(h5_packet.data(), crc);
+        crc[0]           = static_cast<uint8_t>(crc16 & 0xFF);
+        crc[1]           = static_cast<uint8_t>((crc16 >> 8) & 0xFF);
+    }
+
+    return true;
+}
+
+void h5_slip_encode(const uint8_t *payload, const size_t payload_length,
+                    std::vector<uint8_t> &out_packet, const uint8_t seq_num, const uint8_t ack_num,
+                    const bool crc_present, const bool reliable_packet,
+                    const h5_pkt_type_t packet_type)
+{
+    const transport_segment_t segment{payload, payload_length};
+    h5_slip_encode(&segment, 1, out_packet, seq_num, ack_num, crc_present, reliable_packet,
+                   packet_type);
+}
+
+void h5_slip_encode(const transport_segment_t *segments, const size_t count,
+                    std::vector<uint8_t> &out_packet, const uint8_t seq_num, const uint8_t ack_num,
+                    const bool crc_present, const bool reliable_packet,
+                    const h5_pkt_type_t packet_type)
+{
+    size_t payload_length = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        payload_length += segments[i].length;
+    }
+
+    uint8_t header[H5_HEADER_LENGTH];
+    write_h5_header(header, seq_num, ack_num, crc_present, reliable_packet, packet_type,
+                    static_cast<uint16_t>(payload_length));
+
+    // Size the output for the worst case where every byte is escaped, and shrink it afterwards.
+    // Shrinking keeps the capacity, a buffer reused for the next packet is not reallocated.
+    out_packet.resize((H5_HEADER_LENGTH + payload_length + 2) * 2 + 2);
+    auto out = out_packet.data();
+
+    *out++ = SLIP_END;
+    out    = slip_escape(header, H5_HEADER_LENGTH, out);
+
+    auto crc16 = crc16_calculate(header, header + H5_HEADER_LENGTH);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto segment = segments[i];
+        out                = slip_escape(segment.data, segment.length, out);
+
+        if (crc_present)
+        {
+            crc16 = crc16_calculate(segment.data, segment.data + segment.length, crc16);
+        }
+    }
+
+    if (crc_present)
+    {
+        const uint8_t crc[] = {static_cast<uint8_t>(crc16 & 0xFF),
+                               static_cast<uint8_t>((crc16 >> 8) & 0xFF)};
+        out = slip_escape(crc, sizeof(crc), out);
+    }
+
+    *out++ = SLIP_END;
+
+    out_packet.resize(static_cast<size_t>(out - out_packet.data()));
+}
+
 uint32_t h5_decode(const std::vector<uint8_t> &slipPayload, std::vector<uint8_t> &h5Payload,
                    uint8_t *seq_num, uint8_t *ack_num, bool *_data_integrity,
                    uint16_t *_payload_length, uint8_t *_header_checksum, bool *reliable_packet,
                    h5_pkt_type_t *packet_type)
 {
-    if (slipPayload.size() < 4)
+    const uint8_t *payload = nullptr;
+    uint16_t payload_length = 0;
+
+    const auto err_code =
+        h5_decode(slipPayload.data(), slipPayload.size(), &payload, seq_num, ack_num,
+                  _data_integrity, &payload_length, _header_checksum, reliable_packet, packet_type);
+
+    if (_payload_length != nullptr)
+        *_payload_length = payload_length;
+
+    if (err_code != NRF_SUCCESS)
+    {
+        return err_code;
+    }
+
+    if (payload_length > 0)
+    {
+        h5Payload.insert(h5Payload.begin(), payload, payload + payload_length);
+    }
+
+    return NRF_SUCCESS;
+}
+
+uint32_t h5_decode(const uint8_t *packet, const size_t length, const uint8_t **payload,
+                   uint8_t *seq_num, uint8_t *ack_num, bool *_data_integrity,
+                   uint16_t *_payload_length, uint8_t *_header_checksum, bool *reliable_packet,
+                   h5_pkt_type_t *packet_type)
+{
+    if (length < H5_HEADER_LENGTH)
     {
         return NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_PAYLOAD_SIZE;
     }
 
-    *seq_num = slipPayload[0] & seqNumMask;
-    *ack_num = (slipPayload[0] >> ackNumPos) & ackNumMask;
+    *seq_num = packet[0] & seqNumMask;
+    *ack_num = (packet[0] >> ackNumPos) & ackNumMask;
     const auto crc_present =
-        static_cast<bool>(((slipPayload[0] >> crcPresentPos) & crcPresentMask) != 0);
+        static_cast<bool>(((packet[0] >> crcPresentPos) & crcPresentMask) != 0);
     *reliable_packet =
-        static_cast<bool>(((slipPayload[0] >> reliablePacketPos) & reliablePacketMask) != 0);
-    *packet_type = static_cast<h5_pkt_type_t>(slipPayload[1] & packetTypeMask);
+        static_cast<bool>(((packet[0] >> reliablePacketPos) & reliablePacketMask) != 0);
+    *packet_type = static_cast<h5_pkt_type_t>(packet[1] & packetTypeMask);
     const uint16_t payload_length =
-        ((slipPayload[1] >> payloadLengthOffset) & payloadLengthFirstNibbleMask) +
-        (static_cast<uint16_t>(slipPayload[2]) << payloadLengthOffset);
-    const auto header_checksum = slipPayload[3];
+        ((packet[1] >> payloadLengthOffset) & payloadLengthFirstNibbleMask) +
+        (static_cast<uint16_t>(packet[2]) << payloadLengthOffset);
+    const auto header_checksum = packet[3];
 
     // Check if received packet size matches the packet size stated in header
     const auto calculatedPayloadSize = payload_length + H5_HEADER_LENGTH + (crc_present ? 2 : 0);
 
-    if (slipPayload.size() != calculatedPayloadSize)
+    if (length != calculatedPayloadSize)
     {
         return NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_CALCULATED_PAYLOAD_SIZE;
     }
@@ -156,7 +298,7 @@ uint32_t h5_decode(const std::vector<uint8_t> &slipPayload, std::vector<uint8_t>
     if (_header_checksum != nullptr)
         *_header_checksum = header_checksum;
 
-    const auto calculated_header_checksum = calculate_header_checksum(slipPayload);
+    const auto calculated_header_checksum = calculate_header_checksum(packet);
 
     if (header_checksum != calculated_header_checksum)
     {
@@ -165,10 +307,10 @@ uint32_t h5_decode(const std::vector<uint8_t> &slipPayload, std::vector<uint8_t>
 
     if (crc_present)
     {
-        const uint16_t packet_checksum = slipPayload[payload_length + H5_HEADER_LENGTH] +
-                                         (slipPayload[payload_length + H5_HEADER_LENGTH + 1] << 8);
-        const auto calculated_packet_checksum = calculate_crc16_checksum(
-            slipPayload.begin(), slipPayload.begin() + payload_length + H5_HEADER_LENGTH);
+        const uint16_t packet_checksum = packet[payload_length + H5_HEADER_LENGTH] +
+                                         (packet[payload_length + H5_HEADER_LENGTH + 1] << 8);
+        const auto calculated_packet_checksum =
+            crc16_calculate(packet, packet + payload_length + H5_HEADER_LENGTH);
 
         if (packet_checksum != calculated_packet_checksum)
         {
@@ -176,11 +318,7 @@ uint32_t h5_decode(const std::vector<uint8_t> &slipPayload, std::vector<uint8_t>
         }
     }
 
-    if (payload_length > 0)
-    {
-        const auto payloadIterator = slipPayload.begin() + 4;
-        h5Payload.insert(h5Payload.begin(), payloadIterator, payloadIterator + payload_length);
-    }
+    *payload = packet + H5_HEADER_LENGTH;
 
     return NRF_SUCCESS;
 }
@@ -53,6 +53,7 @@
 #include <iostream>
 
 #include "h5_transport.h"
+#include "crc16.h"
 #include "nrf_error.h"
 #include "sd_rpc_types.h"
 
@@ -63,7 +64,6 @@
 #include <chrono>
 #include <iomanip>
 #include <iostream>
-#include <map>
 #include <sstream>
 #include <stdint.h>
 #include <thread>
@@ -77,25 +77,62 @@ const uint8_t PACKET_RETRANSMISSIONS =
 const auto OPEN_WAIT_TIMEOUT = std::chrono::milliseconds(2000);
 // Duration to wait before continuing UART communication after reset is sent to target
 const auto RESET_WAIT_DURATION = std::chrono::milliseconds(300);
+// Lower bound of the retransmission timeout derived from measured round-trip times
+const auto RETRANSMISSION_TIMEOUT_MIN = std::chrono::milliseconds(20);
+// Upper bound of the retransmission timeout, relative to the retransmission interval
+const uint8_t RETRANSMISSION_TIMEOUT_MAX_FACTOR = 4;
+// Clock granularity used when calculating the retransmission timeout
+const auto RTT_CLOCK_GRANULARITY = std::chrono::microseconds(1000);
 
 #pragma region Public methods
-H5Transport::H5Transport(Transport *_nextTransportLayer, const uint32_t retransmission_interval)
+H5Transport::H5Transport(Transport *_nextTransportLayer, const uint32_t retransmission_interval,
+                         const uint8_t sliding_window_size, const uint32_t ack_delay)
     : nextTransportLayer(_nextTransportLayer)
     , seqNum(0)
     , ackNum(0)
-    , c0Found(false)
+    , unackedSeqNum(0)
+    , outstandingPackets()
+    , localSlidingWindowSize(
+          std::min(std::max(sliding_window_size, static_cast<uint8_t>(1)), SlidingWindowSizeMax))
+    , negotiatedSlidingWindowSize(1)
+    , slidingWindowResets(0)
+    , smoothedRtt(0)
+    , rttVariation(0)
+    , retransmissionTimeout(std::chrono::milliseconds(retransmission_interval))
+    , retransmissionTimeoutMin(
+          std::min(RETRANSMISSION_TIMEOUT_MIN, std::chrono::milliseconds(retransmission_interval)))
+    , retransmissionTimeoutMax(
+          std::chrono::milliseconds(retransmission_interval * RETRANSMISSION_TIMEOUT_MAX_FACTOR))
+    , rttSampleCount(0)
+    // Peer must receive the acknowledgement before it retransmits the packet
+    , ackDelay(std::chrono::milliseconds(std::min(ack_delay, retransmission_interval / 2)))
+    , pendingAcks(0)
+    , ackSendRequested(false)
+    , retransmitRequested(false)
+    , slipDecoder(
+          [this](const uint8_t *packet, const size_t length, const uint32_t err_code) {
+              processPacket(packet, length, err_code);
+          },
+          H5_MAX_PACKET_LENGTH)
     , retransmissionInterval(std::chrono::milliseconds(retransmission_interval))
+    , windowWaiters(0)
     , incomingPacketCount(0)
     , outgoingPacketCount(0)
     , errorPacketCount(0)
     , currentState(STATE_START)
-    , stateMachineReady(false)
+    , stateDeadline(std::chrono::steady_clock::time_point::max())
+    , syncRetransmissions(0)
+    , ownTimer(false)
+    , timerDeadline(std::chrono::steady_clock::time_point::max())
+    , timerStopped(true)
     , isOpen(false)
 {
+    encodeControlPackets();
 }
 
 H5Transport::~H5Transport() noexcept
 {
+    stopTimerThread();
     delete nextTransportLayer;
 }
 
@@ -109,6 +146,12 @@ uint32_t H5Transport::open(const status_cb_t &status_callback, const data_cb_t &
         return NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE;
     }
 
+    if (!crc16_self_test())
+    {
+        log(SD_RPC_LOG_FATAL, "CRC16 implementation does not match the reference implementation.");
+        return NRF_ERROR_SD_RPC_H5_TRANSPORT;
+    }
+
     isOpen = true;
 
     auto errorCode = Transport::open(status_callback, data_callback, log_callback);
@@ -126,51 +169,36 @@ uint32_t H5Transport::open(const status_cb_t &status_callback, const data_cb_t &
         return NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE;
     }
 
-    // State machine starts in a separate thread.
-    // Wait for the state machine to be ready
-    setupStateMachine();
-    startStateMachine();
+    // Discard partial packets from a previous session
+    slipDecoder.reset();
 
-    lastPacket.clear();
+    {
+        std::lock_guard<std::mutex> stateMachineLock(stateMachineMutex);
+        currentState  = STATE_START;
+        stateDeadline = std::chrono::steady_clock::time_point::max();
+    }
 
     statusCallback =
         std::bind(&H5Transport::statusHandler, this, std::placeholders::_1, std::placeholders::_2);
     dataCallback =
         std::bind(&H5Transport::dataHandler, this, std::placeholders::_1, std::placeholders::_2);
 
-    errorCode = nextTransportLayer->open(statusCallback, dataCallback, upperLogCallback);
+    // Timeouts are handled on the I/O thread of the layer below. Layers without an I/O thread
+    // get a timer thread of their own.
+    ownTimer = !nextTransportLayer->setTimerHandler([this] { timerExpired(); });
 
-    try
+    if (ownTimer)
     {
-        std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-
-        const auto currentExitCriteria = exitCriterias.at(currentState);
-        const auto exitCriteria = dynamic_cast<StartExitCriterias *>(currentExitCriteria.get());
-
-        if (exitCriteria == nullptr)
-        {
-            std::stringstream ss;
-            ss << "h5_transport is in state " << stateToString(currentState)
-               << " but should be in STATE_START. This state is not valid.";
-            log(SD_RPC_LOG_WARNING, ss.str());
-            return NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE;
-        }
+        timerDeadline = std::chrono::steady_clock::time_point::max();
+        timerStopped  = false;
+        timerThread   = std::thread([this] { timerWorker(); });
+    }
 
-        if (errorCode != NRF_SUCCESS)
-        {
-            exitCriteria->ioResourceError = true;
-        }
-        else
-        {
-            exitCriteria->isOpened = true;
-        }
+    errorCode = nextTransportLayer->open(statusCallback, dataCallback, upperLogCallback);
 
-        stateMachineLock.unlock();
-        stateMachineChange.notify_all();
-    }
-    catch (std::out_of_range &)
     {
-        return NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE;
+        std::lock_guard<std::mutex> stateMachineLock(stateMachineMutex);
+        handleEvent(errorCode == NRF_SUCCESS ? EVENT_OPENED : EVENT_IO_ERROR);
     }
 
     if (waitForState(STATE_ACTIVE, OPEN_WAIT_TIMEOUT))
@@ -213,86 +241,127 @@ uint32_t H5Transport::close()
 
     isOpen = false;
 
-    try
+    // Senders waiting for room in the sliding window return. A sender past the wait has its packet
+    // sent before the layer below is closed.
     {
-        std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-        const auto currentExitCriteria = exitCriterias.at(currentState);
-        const auto exitCriteria        = currentExitCriteria.get();
+        std::lock_guard<std::mutex> ackGuard(ackMutex);
+        ackWaitCondition.notify_all();
+    }
 
-        if (exitCriteria != nullptr)
-        {
-            exitCriteria->close = true;
-        }
+    ackSendMutex.lock();
+    unlockAckSend();
 
-        // Notify about the change in the state machine
-        stateMachineLock.unlock();
-        stateMachineChange.notify_all();
-    }
-    catch (std::out_of_range &)
     {
-        std::stringstream ss;
-        ss << "State " << stateToString(currentState)
-           << " does not have exit criteria associated with it. Will continue to close the "
-              "H5Transport.";
-        log(SD_RPC_LOG_WARNING, ss.str());
+        std::lock_guard<std::mutex> stateMachineLock(stateMachineMutex);
+        handleEvent(EVENT_CLOSE);
     }
 
-    stopStateMachine();
+    stopTimerThread();
 
     return nextTransportLayer->close();
 }
 
 uint32_t H5Transport::send(const std::vector<uint8_t> &data)
 {
-    std::lock_guard<std::mutex> lck(publicMethodMutex);
+    const transport_segment_t segment{data.data(), data.size()};
+    return send(&segment, 1);
+}
 
+uint32_t H5Transport::send(const transport_segment_t *segments, const size_t count)
+{
     if (currentState != STATE_ACTIVE || !isOpen)
     {
         return NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE;
     }
 
-    // max theoretical length of encoded packet, aditional 6 bytes h5 encoding and all bytes escaped
-    // + 2 packet encapsuling
-    payload_t h5EncodedPacket;
-
-    h5_encode(data, h5EncodedPacket, seqNum, ackNum, true, true, VENDOR_SPECIFIC_PACKET);
-
-    payload_t encodedPacket;
-    slip_encode(h5EncodedPacket, encodedPacket);
-
-    auto remainingRetransmissions = PACKET_RETRANSMISSIONS;
-
-    lastPacket.clear();
-    lastPacket = encodedPacket;
-
     std::unique_lock<std::mutex> ackGuard(ackMutex);
+    const auto windowResetsBefore = slidingWindowResets;
 
-    while (remainingRetransmissions--)
+    while (true)
     {
-        logPacket(true, h5EncodedPacket);
-        const auto err_code = nextTransportLayer->send(lastPacket);
+        // Only block if the sliding window is full. Room is made when peer acknowledges packets,
+        // or when the window is dropped because a packet was retransmitted too many times. close
+        // wakes the waiting senders. The upper bound of the wait covers the case where the state
+        // machine is not running.
+        windowWaiters++;
+        const auto windowAvailable = ackWaitCondition.wait_for(
+            ackGuard, retransmissionTimeoutMax * (PACKET_RETRANSMISSIONS + 1), [&] {
+                return packetsInFlight() < negotiatedSlidingWindowSize ||
+                       slidingWindowResets != windowResetsBefore || !isOpen;
+            });
+        windowWaiters--;
+
+        if (!isOpen)
+        {
+            return NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE;
+        }
 
-        if (err_code != NRF_SUCCESS)
-            return err_code;
+        if (!windowAvailable || slidingWindowResets != windowResetsBefore)
+        {
+            return NRF_ERROR_SD_RPC_H5_TRANSPORT_NO_RESPONSE;
+        }
 
-        const uint8_t seqNumBefore = seqNum;
+        // An ACK packet sent after the packet is encoded would otherwise overtake its
+        // acknowledgement number. ackSendMutex is taken before ackMutex.
+        ackGuard.unlock();
+        ackSendMutex.lock();
+        ackGuard.lock();
 
-        // Checking for timeout. Also checking against spurios wakeup by making sure the sequence
-        // number has actually increased. If the sequence number has not increased, we have not
-        // received an ACK packet, and should not exit the loop (unless timeout).
-        // Ref. spurious wakeup:
-        // http://en.cppreference.com/w/cpp/thread/condition_variable
-        // https://en.wikipedia.org/wiki/Spurious_wakeup
-        if (ackWaitCondition.wait_for(ackGuard, std::chrono::milliseconds(retransmissionInterval),
-                                      [&] { return seqNum != seqNumBefore; }))
+        // close, a reset of the window or another sender may have come first
+        if (isOpen && slidingWindowResets == windowResetsBefore &&
+            packetsInFlight() < negotiatedSlidingWindowSize)
         {
-            lastPacket.clear();
-            return NRF_SUCCESS;
+            break;
         }
+
+        ackGuard.unlock();
+        unlockAckSend();
+        ackGuard.lock();
     }
 
-    lastPacket.clear();
-    return NRF_ERROR_SD_RPC_H5_TRANSPORT_NO_RESPONSE;
+    auto &outstanding = outstandingPackets[seqNum];
+
+    // The packet acknowledges all packets received so far, no need to send them separately.
+    // The packet is encoded directly into the buffers kept for retransmission.
+    h5_encode(segments, count, outstanding.h5Packet, seqNum, ackNum, true, true,
+              VENDOR_SPECIFIC_PACKET);
+    outstanding.slipPacket.clear();
+    slip_encode(outstanding.h5Packet, outstanding.slipPacket);
+    pendingAcks      = 0;
+    ackSendRequested = false;
+
+    outstanding.sentAt          = std::chrono::steady_clock::now();
+    outstanding.retransmissions = 0;
+
+    incrementSeqNum();
+    scheduleTimer(outstanding.sentAt + retransmissionTimeout);
+
+    // The I/O thread takes ackMutex for every packet received, it is not held while the layer
+    // below may wait for room to queue the packet. The packet is only replaced by this method
+    // after peer has acknowledged it.
+    ackGuard.unlock();
+
+    const auto errorCode = sendSlipPacket(outstanding.slipPacket);
+    unlockAckSend();
+    return errorCode;
+}
+
+void H5Transport::setBufferPool(const std::shared_ptr<BufferPool> &pool)
+{
+    Transport::setBufferPool(pool);
+    nextTransportLayer->setBufferPool(pool);
+}
+
+void H5Transport::setRuntime(const std::shared_ptr<Runtime> &sharedRuntime)
+{
+    Transport::setRuntime(sharedRuntime);
+    nextTransportLayer->setRuntime(sharedRuntime);
+}
+
+void H5Transport::setLogSeverityFilter(const sd_rpc_log_severity_t severity)
+{
+    Transport::setLogSeverityFilter(severity);
+    nextTransportLayer->setLogSeverityFilter(severity);
 }
 
 h5_state_t H5Transport::state() const
@@ -300,157 +369,198 @@ h5_state_t H5Transport::state() const
     return currentState;
 }
 
+uint8_t H5Transport::slidingWindowSize() const
+{
+    return negotiatedSlidingWindowSize;
+}
+
+sd_rpc_rtt_estimate_t H5Transport::rttEstimate()
+{
+    std::lock_guard<std::mutex> ackGuard(ackMutex);
+
+    sd_rpc_rtt_estimate_t estimate;
+    estimate.srtt         = static_cast<uint32_t>(smoothedRtt.count());
+    estimate.rttvar       = static_cast<uint32_t>(rttVariation.count());
+    estimate.rto          = static_cast<uint32_t>(retransmissionTimeout.count());
+    estimate.sample_count = rttSampleCount;
+    return estimate;
+}
+
 #pragma endregion Public methods
 
 #pragma region Processing incoming data from UART
-void H5Transport::processPacket(const payload_t &packet)
+void H5Transport::processPacket(const uint8_t *packet, const size_t length,
+                                const uint32_t slip_err_code)
 {
     uint8_t seq_num;
     uint8_t ack_num;
     bool reliable_packet;
     h5_pkt_type_t packet_type;
 
-    payload_t slipPayload;
-    auto err_code = slip_decode(packet, slipPayload);
-
-    if (err_code != NRF_SUCCESS)
+    if (slip_err_code != NRF_SUCCESS)
     {
         errorPacketCount++;
 
+        if (transportStats)
+        {
+            transportStats->decodeError();
+        }
+
         std::stringstream ss;
-        ss << "slip_decode error, code: 0x" << std::hex << static_cast<uint32_t>(err_code);
+        ss << "slip_decode error, code: 0x" << std::hex << static_cast<uint32_t>(slip_err_code);
         ss << ", H5 error count: " << static_cast<uint32_t>(errorPacketCount)
-           << ". raw packet: " << asHex(packet);
+           << ". decoded packet: " << asHex(payload_t(packet, packet + length));
         log(SD_RPC_LOG_ERROR, ss.str());
 
         return;
     }
 
-    logPacket(false, slipPayload);
+    logPacket(false, packet, length);
 
-    payload_t h5Payload;
+    // Payload points into the packet, no copy is made
+    const uint8_t *payload  = nullptr;
+    uint16_t payload_length = 0;
 
-    err_code = h5_decode(slipPayload, h5Payload, &seq_num, &ack_num, nullptr, nullptr, nullptr,
-                         &reliable_packet, &packet_type);
+    const auto err_code = h5_decode(packet, length, &payload, &seq_num, &ack_num, nullptr,
+                                    &payload_length, nullptr, &reliable_packet, &packet_type);
 
     if (err_code != NRF_SUCCESS)
     {
         errorPacketCount++;
 
+        if (transportStats)
+        {
+            transportStats->decodeError();
+        }
+
         std::stringstream ss;
         ss << "h5_decode error, code: 0x" << std::hex << static_cast<uint32_t>(err_code);
         ss << ", H5 error count: " << static_cast<uint32_t>(errorPacketCount)
-           << ". raw packet: " << asHex(packet);
+           << ". decoded packet: " << asHex(payload_t(packet, packet + length));
         log(SD_RPC_LOG_ERROR, ss.str());
 
         return;
     }
 
+    if (transportStats)
+    {
+        transportStats->packetReceived();
+    }
+
     if (currentState == STATE_RESET)
     {
         // Ignore packets packets received in this state.
-        stateMachineChange.notify_all();
         return;
     }
 
-    std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-
     if (packet_type == LINK_CONTROL_PACKET)
     {
+        // Link control packets are rare, a copy is fine
+        const payload_t h5Payload(payload, payload + payload_length);
+        std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
+
+        // Responses are sent after the state machine is released
+        auto response = CONTROL_PKT_LAST;
+
         if (currentState == STATE_UNINITIALIZED)
         {
             if (H5Transport::isSyncResponsePacket(h5Payload))
             {
-                const auto stateCriteria =
-                    dynamic_cast<UninitializedExitCriterias *>(exitCriterias[currentState].get());
-
-                if (stateCriteria != nullptr)
-                {
-                    stateCriteria->syncRspReceived = true;
-                }
+                handleEvent(EVENT_SYNC_RESPONSE);
             }
             else if (H5Transport::isSyncPacket(h5Payload))
             {
-                sendControlPacket(CONTROL_PKT_SYNC_RESPONSE);
+                response = CONTROL_PKT_SYNC_RESPONSE;
             }
         }
         else if (currentState == STATE_INITIALIZED)
         {
-            const auto exit =
-                dynamic_cast<InitializedExitCriterias *>(exitCriterias[currentState].get());
-
             if (H5Transport::isSyncConfigResponsePacket(h5Payload))
             {
-                exit->syncConfigRspReceived = true;
+                negotiateSlidingWindowSize(h5Payload);
+                handleEvent(EVENT_SYNC_CONFIG_RESPONSE);
             }
             else if (H5Transport::isSyncConfigPacket(h5Payload))
             {
-                sendControlPacket(CONTROL_PKT_SYNC_CONFIG_RESPONSE);
+                negotiateSlidingWindowSize(h5Payload);
+                response = CONTROL_PKT_SYNC_CONFIG_RESPONSE;
             }
             else if (H5Transport::isSyncPacket(h5Payload))
             {
-                sendControlPacket(CONTROL_PKT_SYNC_RESPONSE);
+                response = CONTROL_PKT_SYNC_RESPONSE;
             }
         }
         else if (currentState == STATE_ACTIVE)
         {
-            const auto exit =
-                dynamic_cast<ActiveExitCriterias *>(exitCriterias[currentState].get());
-
             if (H5Transport::isSyncPacket(h5Payload))
             {
-                exit->syncReceived = true;
+                handleEvent(EVENT_SYNC);
             }
             else if (H5Transport::isSyncConfigPacket(h5Payload))
             {
-                sendControlPacket(CONTROL_PKT_SYNC_CONFIG_RESPONSE);
+                response = CONTROL_PKT_SYNC_CONFIG_RESPONSE;
             }
         }
+
+        stateMachineLock.unlock();
+
+        if (response != CONTROL_PKT_LAST)
+        {
+            sendControlPacket(response);
+        }
     }
     else if (packet_type == VENDOR_SPECIFIC_PACKET)
     {
         if (currentState == STATE_ACTIVE)
         {
+            // Peer may acknowledge our packets in its data packets. An ack_num that does not
+            // match the window is ignored, the ACK packets from peer takes care of resyncing.
+            processAck(ack_num);
+
             if (reliable_packet)
             {
-                if (seq_num == ackNum)
+                std::unique_lock<std::mutex> ackGuard(ackMutex);
+                const auto expectedPacket = seq_num == ackNum;
+
+                if (expectedPacket)
                 {
                     incrementAckNum();
-                    sendControlPacket(CONTROL_PKT_ACK);
-                    upperDataCallback(h5Payload.data(), h5Payload.size());
                 }
                 else
+                {
+                    // Peer is retransmitting, tell it right away which packet we expect
+                    pendingAcks = 0;
+                }
+
+                const auto sendAck = !expectedPacket || !delayAck();
+                ackGuard.unlock();
+
+                if (sendAck)
                 {
                     sendControlPacket(CONTROL_PKT_ACK);
                 }
+
+                if (expectedPacket)
+                {
+                    upperDataCallback(payload, payload_length);
+                }
             }
         }
     }
     else if (packet_type == ACK_PACKET)
     {
-        if (ack_num == ((seqNum + 1) & 0x07))
-        {
-            // Received a packet with valid ack_num, inform threads that wait the command is
-            // received on the other end
-            std::lock_guard<std::mutex> ackGuard(ackMutex);
-            incrementSeqNum();
-            ackWaitCondition.notify_all();
-        }
-        else if (ack_num == seqNum)
+        if (processAck(ack_num))
         {
-            // Discard packet, we assume that we have received a reply from a previous packet
+            // ack_num acknowledged zero or more packets in the sliding window, threads waiting
+            // for room in the window are notified by processAck
         }
         else
         {
+            std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
+
             if (currentState == STATE_ACTIVE)
             {
-                const auto exit =
-                    dynamic_cast<ActiveExitCriterias *>(exitCriterias[currentState].get());
-
-                if (exit != nullptr)
-                {
-                    exit->irrecoverableSyncError = true;
-                }
+                handleEvent(EVENT_SYNC_ERROR);
             }
             else
             {
@@ -462,36 +572,14 @@ void H5Transport::processPacket(const payload_t &packet)
             }
         }
     }
-
-    stateMachineLock.unlock();
-    stateMachineChange.notify_all();
 }
 
 void H5Transport::statusHandler(const sd_rpc_app_status_t code, const std::string &message)
 {
     if (code == IO_RESOURCES_UNAVAILABLE)
     {
-        try
-        {
-            std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-            const auto currentExitCriteria = exitCriterias.at(currentState);
-            const auto exitCriteria        = currentExitCriteria.get();
-
-            if (exitCriteria != nullptr)
-            {
-                exitCriteria->ioResourceError = true;
-            }
-
-            stateMachineLock.unlock();
-            stateMachineChange.notify_all();
-        }
-        catch (std::out_of_range &)
-        {
-            std::stringstream ss;
-            ss << "State " << stateToString(currentState)
-               << " does not have criteria associated with it.";
-            log(SD_RPC_LOG_WARNING, ss.str());
-        }
+        std::lock_guard<std::mutex> stateMachineLock(stateMachineMutex);
+        handleEvent(EVENT_IO_ERROR);
     }
 
     status(code, message);
@@ -499,58 +587,13 @@ void H5Transport::statusHandler(const sd_rpc_app_status_t code, const std::strin
 
 void H5Transport::dataHandler(const uint8_t *data, const size_t length)
 {
-    payload_t packet;
-
-    // Check if we have any data from before that has not been processed.
-    // If so add the remaining data from previous callback(s) to this packet
-    if (!unprocessedData.empty())
-    {
-        packet.insert(packet.begin(), unprocessedData.begin(), unprocessedData.end());
-    }
-
-    for (size_t i = 0; i < length; i++)
+    if (transportStats)
     {
-        packet.push_back(data[i]);
-
-        if (data[i] == 0xC0)
-        {
-            if (c0Found)
-            {
-                // End of packet found
-
-                // If we have two 0xC0 after another we assume it is the beginning of a new packet,
-                // and not the end
-                if (packet.size() == 2)
-                {
-                    packet.clear();
-                    packet.push_back(0xc0);
-                    continue;
-                }
-
-                processPacket(packet);
-
-                packet.clear();
-                unprocessedData.clear();
-                c0Found = false;
-            }
-            else
-            {
-                // Start of packet found
-                c0Found = true;
-
-                // Clear previous data from packet since data before the start of packet is
-                // irrelevant.
-                packet.clear();
-                packet.push_back(0xC0);
-            }
-        }
+        transportStats->dataReceived(length);
     }
 
-    if (!packet.empty())
-    {
-        unprocessedData.clear();
-        unprocessedData.insert(unprocessedData.begin(), packet.begin(), packet.end());
-    }
+    // Complete packets are passed on to processPacket
+    slipDecoder.decode(data, length);
 }
 
 void H5Transport::incrementSeqNum()
@@ -565,390 +608,678 @@ void H5Transport::incrementAckNum()
     ackNum = ackNum & 0x07;
 }
 
-#pragma endregion Processing of incoming packets from UART
-
-#pragma region State machine
+uint8_t H5Transport::packetsInFlight() const
+{
+    return (seqNum - unackedSeqNum) & 0x07;
+}
 
-h5_state_t H5Transport::stateActionStart()
+bool H5Transport::processAck(const uint8_t ack_num)
 {
-    std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-    auto exit = dynamic_cast<StartExitCriterias *>(exitCriterias[STATE_START].get());
+    std::lock_guard<std::mutex> ackGuard(ackMutex);
 
-    stateMachineReady = true;
+    // ack_num is the sequence number peer expects next, it acknowledges all packets before it
+    const uint8_t acknowledged = (ack_num - unackedSeqNum) & 0x07;
 
-    // Notify other threads that the state machine is ready
-    stateMachineLock.unlock();
-    stateMachineChange.notify_all();
-    stateMachineLock.lock();
+    if (acknowledged > packetsInFlight())
+    {
+        return false;
+    }
 
-    // Wait for notification of a stateMachineChange that exists the state
-    stateMachineChange.wait(stateMachineLock, [&exit] { return exit->isFullfilled(); });
+    if (acknowledged == 0)
+    {
+        // Discard packet, we assume that we have received a reply from a previous packet
+        return true;
+    }
+
+    // Only packets sent once give a round-trip time sample, it is not known which transmission
+    // of a retransmitted packet is acknowledged (Karn's algorithm)
+    const auto &lastAcknowledged = outstandingPackets[(ack_num - 1) & 0x07];
 
-    // Order is of importance when returning state
-    if (exit->ioResourceError)
+    if (lastAcknowledged.retransmissions == 0)
     {
-        return STATE_FAILED;
+        updateRttEstimate(std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - lastAcknowledged.sentAt));
     }
 
-    if (exit->close)
+    while (unackedSeqNum != ack_num)
     {
-        return STATE_CLOSED;
+        outstandingPackets[unackedSeqNum].retransmissions = 0;
+        unackedSeqNum = (unackedSeqNum + 1) & 0x07;
     }
 
-    if (exit->isOpened)
+    // Inform threads that wait for room in the sliding window
+    if (windowWaiters > 0)
     {
-        return STATE_RESET;
+        ackWaitCondition.notify_all();
     }
 
-    return STATE_FAILED;
+    return true;
 }
 
-h5_state_t H5Transport::stateActionReset()
+void H5Transport::negotiateSlidingWindowSize(const payload_t &configPacket)
 {
-    std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-    auto exit = dynamic_cast<ResetExitCriterias *>(exitCriterias[STATE_RESET].get());
-
-    // Send the reset packet, and wait for the device to reboot and ready for receiving commands
-    sendControlPacket(CONTROL_PKT_RESET);
+    // The configuration field is the third byte of CONFIG and CONFIG RESPONSE
+    uint8_t peerSlidingWindowSize = 1;
 
-    if (statusCallback)
+    if (configPacket.size() > 2)
     {
-        statusCallback(RESET_PERFORMED, "Target Reset performed");
+        peerSlidingWindowSize = configPacket[2] & SyncConfigSlidingWindowMask;
     }
 
-    exit->resetSent = true;
-    stateMachineChange.wait_for(stateMachineLock, RESET_WAIT_DURATION,
-                                [&exit] { return exit->isFullfilled(); });
-    exit->resetWait = true;
+    std::lock_guard<std::mutex> ackGuard(ackMutex);
+    negotiatedSlidingWindowSize = std::min(localSlidingWindowSize, peerSlidingWindowSize);
 
-    // Order is of importance when returning state
-    if (exit->ioResourceError)
+    if (negotiatedSlidingWindowSize == 0)
     {
-        return STATE_FAILED;
+        negotiatedSlidingWindowSize = 1;
     }
+}
 
-    if (exit->close)
-    {
-        return STATE_CLOSED;
-    }
+void H5Transport::resetSlidingWindow()
+{
+    std::lock_guard<std::mutex> ackGuard(ackMutex);
 
-    if (exit->resetSent && exit->resetWait)
+    // Packets not acknowledged are dropped. Their sequence numbers are reused by the next
+    // packets sent since peer has not received them.
+    seqNum        = unackedSeqNum;
+    slidingWindowResets++;
+
+    ackWaitCondition.notify_all();
+}
+
+std::chrono::steady_clock::time_point H5Transport::nextRetransmission() const
+{
+    auto next = std::chrono::steady_clock::time_point::max();
+
+    for (auto seq = unackedSeqNum; seq != seqNum; seq = (seq + 1) & 0x07)
     {
-        return STATE_UNINITIALIZED;
+        next = std::min(next, outstandingPackets[seq].sentAt + retransmissionTimeout);
     }
 
-    return STATE_FAILED;
-};
+    return next;
+}
 
-h5_state_t H5Transport::stateActionUninitialized()
+bool H5Transport::delayAck()
 {
-    std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-    auto exit =
-        dynamic_cast<UninitializedExitCriterias *>(exitCriterias[STATE_UNINITIALIZED].get());
-    auto syncRetransmission = PACKET_RETRANSMISSIONS;
+    // Acknowledge at least every half window so that peer does not run out of room in its window.
+    // With a window of one or two packets a single acknowledgement is delayed, peer then waits at
+    // most ackDelay for room in its window unless a packet is sent to it first.
+    const auto maxPendingAcks =
+        std::max(static_cast<uint8_t>((negotiatedSlidingWindowSize + 1) / 2), uint8_t{2});
 
-    while (!exit->isFullfilled() && syncRetransmission > 0)
+    if (ackDelay.count() == 0 || pendingAcks + 1 >= maxPendingAcks)
     {
-        sendControlPacket(CONTROL_PKT_SYNC);
-        exit->syncSent = true;
-        stateMachineChange.wait_for(stateMachineLock, retransmissionInterval,
-                                    [&exit] { return exit->isFullfilled(); });
-        syncRetransmission--;
+        pendingAcks = 0;
+        return false;
     }
 
-    // Order is of importance when returning state
-    if (exit->ioResourceError)
+    if (pendingAcks == 0)
     {
-        return STATE_FAILED;
+        ackDeadline = std::chrono::steady_clock::now() + ackDelay;
+        scheduleTimer(ackDeadline);
     }
 
-    if (exit->close)
+    pendingAcks++;
+    return true;
+}
+
+std::chrono::steady_clock::time_point H5Transport::nextAckFlush() const
+{
+    if (pendingAcks == 0)
     {
-        return STATE_CLOSED;
+        return std::chrono::steady_clock::time_point::max();
     }
 
-    if (exit->syncSent && exit->syncRspReceived)
+    return ackDeadline;
+}
+
+void H5Transport::flushDelayedAck()
+{
+    std::unique_lock<std::mutex> ackGuard(ackMutex);
+
+    if (pendingAcks == 0 || std::chrono::steady_clock::now() < ackDeadline)
     {
-        return STATE_INITIALIZED;
+        return;
     }
 
-    if (syncRetransmission == 0)
+    pendingAcks = 0;
+    ackGuard.unlock();
+
+    sendControlPacket(CONTROL_PKT_ACK);
+}
+
+// Returns false if the packets are left to the thread holding ackSendMutex
+bool H5Transport::retransmitExpiredPackets()
+{
+    retransmitRequested = true;
+
+    if (!ackSendMutex.try_lock())
     {
-        std::stringstream status;
-        status << "No response from device. Tried to send packet "
-               << std::to_string(PACKET_RETRANSMISSIONS) << " times.";
-        statusHandler(PKT_SEND_MAX_RETRIES_REACHED, status.str().c_str());
-        return STATE_NO_RESPONSE;
+        return false;
     }
 
-    return STATE_FAILED;
-};
+    retransmitRequested = false;
+    std::unique_lock<std::mutex> ackGuard(ackMutex);
 
-h5_state_t H5Transport::stateActionInitialized()
-{
-    std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-    auto exit = dynamic_cast<InitializedExitCriterias *>(exitCriterias[STATE_INITIALIZED].get());
-    auto syncRetransmission = PACKET_RETRANSMISSIONS;
+    const auto now     = std::chrono::steady_clock::now();
+    auto retransmitted = false;
 
-    // Send a package immediately
-    while (!exit->isFullfilled() && syncRetransmission > 0)
+    for (auto seq = unackedSeqNum; seq != seqNum; seq = (seq + 1) & 0x07)
     {
-        sendControlPacket(CONTROL_PKT_SYNC_CONFIG);
-        exit->syncConfigSent = true;
+        auto &outstanding = outstandingPackets[seq];
+
+        if (now < outstanding.sentAt + retransmissionTimeout)
+        {
+            continue;
+        }
 
-        stateMachineChange.wait_for(stateMachineLock, retransmissionInterval,
-                                    [&exit] { return exit->isFullfilled(); });
+        if (outstanding.retransmissions + 1 >= PACKET_RETRANSMISSIONS)
+        {
+            ackGuard.unlock();
+            unlockAckSend();
+            resetSlidingWindow();
+
+            std::stringstream status;
+            status << "No response from device. Tried to send packet with seq#:" << +seq << " "
+                   << std::to_string(PACKET_RETRANSMISSIONS) << " times.";
+            statusHandler(PKT_SEND_MAX_RETRIES_REACHED, status.str());
+            return true;
+        }
+
+        outstanding.retransmissions++;
+        outstanding.sentAt = now;
+
+        // Peer may have sent packets since the packet was encoded, the acknowledgement number
+        // carried by the packet is updated. An outdated one looks like a sync error to peer.
+        if (h5_set_ack_num(outstanding.h5Packet, ackNum))
+        {
+            outstanding.slipPacket.clear();
+            slip_encode(outstanding.h5Packet, outstanding.slipPacket);
+        }
+
+        pendingAcks = 0;
+        sendSlipPacket(outstanding.slipPacket);
+        retransmitted = true;
 
-        syncRetransmission--;
+        if (transportStats)
+        {
+            transportStats->retransmission();
+        }
+    }
+
+    if (retransmitted)
+    {
+        backOffRetransmissionTimeout();
     }
 
-    // Order is of importance when returning state
-    if (exit->ioResourceError)
+    ackGuard.unlock();
+    unlockAckSend();
+    return true;
+}
+
+void H5Transport::updateRttEstimate(const std::chrono::microseconds rtt)
+{
+    if (rttSampleCount == 0)
     {
-        return STATE_FAILED;
+        smoothedRtt  = rtt;
+        rttVariation = rtt / 2;
     }
+    else
+    {
+        const auto deviation = smoothedRtt > rtt ? smoothedRtt - rtt : rtt - smoothedRtt;
+        rttVariation         = (rttVariation * 3 + deviation) / 4;
+        smoothedRtt          = (smoothedRtt * 7 + rtt) / 8;
+    }
+
+    rttSampleCount++;
+
+    const auto timeout = smoothedRtt + std::max(RTT_CLOCK_GRANULARITY, rttVariation * 4);
+
+    // Round up to whole milliseconds
+    retransmissionTimeout = std::chrono::duration_cast<std::chrono::milliseconds>(
+        timeout + std::chrono::microseconds(999));
+    retransmissionTimeout = std::min(std::max(retransmissionTimeout, retransmissionTimeoutMin),
+                                     retransmissionTimeoutMax);
+}
+
+void H5Transport::backOffRetransmissionTimeout()
+{
+    // Peer or the host is slower than estimated, the estimate is corrected by the next sample
+    retransmissionTimeout = std::min(retransmissionTimeout * 2, retransmissionTimeoutMax);
+}
 
-    if (exit->close)
+#pragma endregion Processing of incoming packets from UART
+
+#pragma region State machine
+
+namespace {
+constexpr auto NONE = STATE_UNKNOWN;
+
+// Next state for each state and event, indexed by h5_state_t and h5_event_t. Events that do not
+// change the state are NONE. The columns are EVENT_OPENED, EVENT_IO_ERROR, EVENT_CLOSE,
+// EVENT_TIMEOUT, EVENT_SYNC_RESPONSE, EVENT_SYNC_CONFIG_RESPONSE, EVENT_SYNC and EVENT_SYNC_ERROR.
+const h5_state_t stateTransitions[STATE_UNKNOWN][EVENT_COUNT] = {
+    // STATE_START
+    {STATE_RESET, STATE_FAILED, STATE_CLOSED, NONE, NONE, NONE, NONE, NONE},
+    // STATE_RESET
+    {NONE, STATE_FAILED, STATE_CLOSED, STATE_UNINITIALIZED, NONE, NONE, NONE, NONE},
+    // STATE_UNINITIALIZED
+    {NONE, STATE_FAILED, STATE_CLOSED, STATE_NO_RESPONSE, STATE_INITIALIZED, NONE, NONE, NONE},
+    // STATE_INITIALIZED
+    {NONE, STATE_FAILED, STATE_CLOSED, STATE_NO_RESPONSE, NONE, STATE_ACTIVE, NONE, NONE},
+    // STATE_ACTIVE
+    {NONE, STATE_FAILED, STATE_CLOSED, NONE, NONE, NONE, STATE_RESET, STATE_RESET},
+    // STATE_FAILED, STATE_CLOSED and STATE_NO_RESPONSE are terminal
+    {NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE},
+    {NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE},
+    {NONE, NONE, NONE, NONE, NONE, NONE, NONE, NONE},
+};
+} // namespace
+
+const std::array<H5Transport::StateActions, STATE_UNKNOWN> H5Transport::stateActions = {{
+    {nullptr, nullptr},                                                      // STATE_START
+    {&H5Transport::enterReset, &H5Transport::timeoutReset},                  // STATE_RESET
+    {&H5Transport::enterUninitialized, &H5Transport::timeoutUninitialized}, // STATE_UNINITIALIZED
+    {&H5Transport::enterInitialized, &H5Transport::timeoutInitialized},     // STATE_INITIALIZED
+    {&H5Transport::enterActive, &H5Transport::timeoutActive},               // STATE_ACTIVE
+    {&H5Transport::enterFailed, nullptr},                                   // STATE_FAILED
+    {&H5Transport::enterClosed, nullptr},                                   // STATE_CLOSED
+    {&H5Transport::enterNoResponse, nullptr},                               // STATE_NO_RESPONSE
+}};
+
+void H5Transport::handleEvent(const h5_event_t event)
+{
+    const auto nextState = stateTransitions[currentState][event];
+
+    if (nextState != STATE_UNKNOWN)
     {
-        return STATE_CLOSED;
+        changeState(nextState);
     }
+}
+
+void H5Transport::changeState(const h5_state_t nextState)
+{
+    logStateTransition(currentState, nextState);
 
-    if (exit->syncConfigSent && exit->syncConfigRspReceived)
+    if (currentState == STATE_ACTIVE)
     {
-        return STATE_ACTIVE;
+        // Release senders waiting for room in the sliding window
+        resetSlidingWindow();
     }
 
-    if (syncRetransmission == 0)
+    currentState  = nextState;
+    stateDeadline = std::chrono::steady_clock::time_point::max();
+
+    const auto enter = stateActions[nextState].enter;
+
+    if (enter != nullptr)
     {
-        std::stringstream status;
-        status << "No response from device. Tried to send packet "
-               << std::to_string(PACKET_RETRANSMISSIONS) << " times.";
-        statusHandler(PKT_SEND_MAX_RETRIES_REACHED, status.str().c_str());
-        return STATE_NO_RESPONSE;
+        (this->*enter)();
     }
 
-    return STATE_FAILED;
-};
-h5_state_t H5Transport::stateActionActive()
+    stateChanged.notify_all();
+}
+
+bool H5Transport::waitForState(h5_state_t state, std::chrono::milliseconds timeout)
 {
     std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-    auto exit = dynamic_cast<ActiveExitCriterias *>(exitCriterias[STATE_ACTIVE].get());
 
-    seqNum = 0;
-    ackNum = 0;
+    // Stop waiting when the state machine stops in a terminal state
+    stateChanged.wait_for(stateMachineLock, timeout, [&state, this] {
+        return currentState == state || currentState == STATE_FAILED ||
+               currentState == STATE_CLOSED || currentState == STATE_NO_RESPONSE;
+    });
 
-    statusHandler(CONNECTION_ACTIVE, "Connection active");
-    stateMachineChange.wait(stateMachineLock, [&exit] { return exit->isFullfilled(); }); // T#2
+    return currentState == state;
+}
 
-    if (exit->ioResourceError)
+// I/O thread of the layer below, or the timer thread
+void H5Transport::timerExpired()
+{
+    std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
+
+    if (currentState == STATE_ACTIVE)
     {
-        return STATE_FAILED;
+        // The sliding window is protected by ackMutex, packets are retransmitted and delayed
+        // acknowledgements sent without holding the state machine
+        stateMachineLock.unlock();
+        timeoutActive();
+        return;
     }
 
-    if (exit->close)
+    const auto timeout = stateActions[currentState].timeout;
+
+    if (timeout != nullptr)
     {
-        return STATE_CLOSED;
+        (this->*timeout)();
     }
+}
 
-    if (exit->syncReceived || exit->irrecoverableSyncError)
+void H5Transport::scheduleTimer(const std::chrono::steady_clock::time_point deadline)
+{
+    if (!ownTimer)
     {
-        return STATE_RESET;
+        nextTransportLayer->scheduleTimer(deadline);
+        return;
     }
 
-    return STATE_FAILED;
-};
+    std::lock_guard<std::mutex> timerGuard(timerMutex);
+
+    if (deadline < timerDeadline)
+    {
+        timerDeadline = deadline;
+        timerChanged.notify_one();
+    }
+}
 
-h5_state_t H5Transport::stateActionFailed()
+void H5Transport::startStateTimer(const std::chrono::milliseconds duration)
 {
-    std::lock_guard<std::mutex> stateMachineLock(stateMachineMutex);
-    log(SD_RPC_LOG_FATAL, "Entered state failed. No exit exists from this state.");
-    return STATE_FAILED;
-};
+    stateDeadline = std::chrono::steady_clock::now() + duration;
+    scheduleTimer(stateDeadline);
+}
 
-h5_state_t H5Transport::stateActionClosed()
+// Returns true once when the timer of the state is due. The timer is scheduled again if it
+// expired early, it is shared with the sliding window.
+bool H5Transport::stateTimerExpired()
 {
-    std::lock_guard<std::mutex> stateMachineLock(stateMachineMutex);
-    log(SD_RPC_LOG_DEBUG, "Entered state closed.");
-    return STATE_CLOSED;
-};
-h5_state_t H5Transport::stateActionNoResponse()
+    if (stateDeadline == std::chrono::steady_clock::time_point::max())
+    {
+        return false;
+    }
+
+    if (std::chrono::steady_clock::now() < stateDeadline)
+    {
+        scheduleTimer(stateDeadline);
+        return false;
+    }
+
+    stateDeadline = std::chrono::steady_clock::time_point::max();
+    return true;
+}
+
+// Timer thread, used when the layer below has no I/O thread
+void H5Transport::timerWorker()
 {
-    std::lock_guard<std::mutex> stateMachineLock(stateMachineMutex);
-    log(SD_RPC_LOG_DEBUG, "No response to data sent to device.");
-    return STATE_NO_RESPONSE;
-};
+    std::unique_lock<std::mutex> timerGuard(timerMutex);
+
+    while (!timerStopped)
+    {
+        if (timerDeadline == std::chrono::steady_clock::time_point::max())
+        {
+            timerChanged.wait(timerGuard);
+            continue;
+        }
+
+        if (std::chrono::steady_clock::now() < timerDeadline)
+        {
+            timerChanged.wait_until(timerGuard, timerDeadline);
+            continue;
+        }
+
+        timerDeadline = std::chrono::steady_clock::time_point::max();
 
-void H5Transport::setupStateMachine()
+        timerGuard.unlock();
+        timerExpired();
+        timerGuard.lock();
+    }
+}
+
+void H5Transport::stopTimerThread()
 {
-    // Setup state actions
-    //
-    // The reason for using lambdas calling data member functions is to be able to easier debug when
-    // compiling the project as a release build Doing it this way allows us to see the symbol name
-    // when debugging
-    stateActions[STATE_START]         = [this] { return stateActionStart(); };
-    stateActions[STATE_RESET]         = [this] { return stateActionReset(); };
-    stateActions[STATE_UNINITIALIZED] = [this] { return stateActionUninitialized(); };
-    stateActions[STATE_INITIALIZED]   = [this] { return stateActionInitialized(); };
-    stateActions[STATE_ACTIVE]        = [this] { return stateActionActive(); };
-    stateActions[STATE_FAILED]        = [this] { return stateActionFailed(); };
-    stateActions[STATE_CLOSED]        = [this] { return stateActionClosed(); };
-    stateActions[STATE_NO_RESPONSE]   = [this] { return stateActionNoResponse(); };
+    if (!timerThread.joinable())
+    {
+        return;
+    }
 
-    // Setup exit criteria
-    exitCriterias[STATE_START] = std::shared_ptr<ExitCriterias>(new StartExitCriterias());
-    exitCriterias[STATE_RESET] = std::shared_ptr<ExitCriterias>(new ResetExitCriterias());
-    exitCriterias[STATE_UNINITIALIZED] =
-        std::shared_ptr<ExitCriterias>(new UninitializedExitCriterias());
-    exitCriterias[STATE_INITIALIZED] =
-        std::shared_ptr<ExitCriterias>(new InitializedExitCriterias());
-    exitCriterias[STATE_ACTIVE] = std::shared_ptr<ExitCriterias>(new ActiveExitCriterias());
+    {
+        std::lock_guard<std::mutex> timerGuard(timerMutex);
+        timerStopped = true;
+    }
+
+    timerChanged.notify_one();
+    timerThread.join();
 }
 
-void H5Transport::startStateMachine()
+void H5Transport::enterReset()
 {
-    currentState = STATE_START;
+    // Send the reset packet, and wait for the device to reboot and ready for receiving commands
+    sendControlPacket(CONTROL_PKT_RESET);
 
-    if (!stateMachineThread.joinable())
+    if (statusCallback)
     {
-        // Lock the stateMachineMutex and let stateMachineThread notify
-        // when the state machine is ready to process states
-        std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-        stateMachineThread = std::thread([this] { stateMachineWorker(); });
+        statusCallback(RESET_PERFORMED, "Target Reset performed");
+    }
+
+    startStateTimer(RESET_WAIT_DURATION);
+}
 
-        // Wait for the state machine to be ready
-        stateMachineChange.wait(stateMachineLock, [this] { return stateMachineReady; });
+void H5Transport::timeoutReset()
+{
+    if (stateTimerExpired())
+    {
+        handleEvent(EVENT_TIMEOUT);
     }
-    else
+}
+
+void H5Transport::enterUninitialized()
+{
+    syncRetransmissions = PACKET_RETRANSMISSIONS;
+    resendSyncPacket(CONTROL_PKT_SYNC);
+}
+
+void H5Transport::timeoutUninitialized()
+{
+    if (stateTimerExpired())
     {
-        // Terminate if the state machine thread is joinable (already runs), this should not happen.
-        std::cerr << __FILE__ << ":" << __LINE__
-                  << " stateMachineThread exists, this should not happen. Terminating."
-                  << std::endl;
-        std::terminate();
+        resendSyncPacket(CONTROL_PKT_SYNC);
     }
 }
 
-void H5Transport::stopStateMachine()
+void H5Transport::enterInitialized()
 {
-    if (stateMachineThread.joinable())
+    // Reset the sequence numbers before entering STATE_ACTIVE, packets may be sent and received
+    // as soon as the state is changed.
     {
-        stateMachineThread.join();
+        std::lock_guard<std::mutex> ackGuard(ackMutex);
+        seqNum        = 0;
+        ackNum        = 0;
+        unackedSeqNum = 0;
+        pendingAcks   = 0;
     }
+
+    syncRetransmissions = PACKET_RETRANSMISSIONS;
+    resendSyncPacket(CONTROL_PKT_SYNC_CONFIG);
 }
 
-// State machine thread
-void H5Transport::stateMachineWorker()
+void H5Transport::timeoutInitialized()
 {
-    while (currentState != STATE_FAILED && currentState != STATE_CLOSED &&
-           currentState != STATE_NO_RESPONSE)
+    if (stateTimerExpired())
     {
-        const auto nextState = stateActions[currentState]();
+        resendSyncPacket(CONTROL_PKT_SYNC_CONFIG);
+    }
+}
 
-        // Make sure that state is not changed when assigning a new current state
-        {
-            std::unique_lock<std::mutex> stateMachineLock(stateMachineMutex);
-            logStateTransition(currentState, nextState);
+// Sends the SYNC or CONFIG packet of the state, the state times out when all retransmissions are
+// sent without a response
+void H5Transport::resendSyncPacket(const control_pkt_type type)
+{
+    if (syncRetransmissions > 0)
+    {
+        syncRetransmissions--;
+        sendControlPacket(type);
+        startStateTimer(retransmissionInterval);
+        return;
+    }
 
-            // Reset the next states variables before starting to use them.
-            switch (nextState)
-            {
-                case STATE_START:
-                    dynamic_cast<StartExitCriterias *>(exitCriterias[STATE_START].get())->reset();
-                    break;
-                case STATE_RESET:
-                    dynamic_cast<ResetExitCriterias *>(exitCriterias[STATE_RESET].get())->reset();
-                    break;
-                case STATE_UNINITIALIZED:
-                    dynamic_cast<UninitializedExitCriterias *>(
-                        exitCriterias[STATE_UNINITIALIZED].get())
-                        ->reset();
-                    break;
-                case STATE_INITIALIZED:
-                    dynamic_cast<InitializedExitCriterias *>(exitCriterias[STATE_INITIALIZED].get())
-                        ->reset();
-                    break;
-                case STATE_ACTIVE:
-                    dynamic_cast<ActiveExitCriterias *>(exitCriterias[STATE_ACTIVE].get())->reset();
-                    break;
-                case STATE_FAILED:
-                case STATE_CLOSED:
-                case STATE_NO_RESPONSE:
-                    // These are terminal states that do not have exit criteria associated with
-                    // them
-                    break;
-                case STATE_UNKNOWN:
-                    // Not used
-                    break;
-            }
+    std::stringstream status;
+    status << "No response from device. Tried to send packet "
+           << std::to_string(PACKET_RETRANSMISSIONS) << " times.";
+    statusHandler(PKT_SEND_MAX_RETRIES_REACHED, status.str());
 
-            currentState = nextState;
-        }
+    handleEvent(EVENT_TIMEOUT);
+}
+
+void H5Transport::enterActive()
+{
+    statusHandler(CONNECTION_ACTIVE, "Connection active");
+}
+
+// Called when a packet in the sliding window is due for retransmission or when a delayed
+// acknowledgement is due
+void H5Transport::timeoutActive()
+{
+    const auto retransmissionsDone = retransmitExpiredPackets();
+    flushDelayedAck();
+
+    // Retransmissions left to the thread holding ackSendMutex are rescheduled by it
+    std::unique_lock<std::mutex> ackGuard(ackMutex);
+    const auto next = retransmissionsDone ? std::min(nextRetransmission(), nextAckFlush())
+                                          : nextAckFlush();
+    ackGuard.unlock();
 
-        // Inform interested parties that new current state is set and ready
-        stateWaitCondition.notify_all();
+    if (next != std::chrono::steady_clock::time_point::max())
+    {
+        scheduleTimer(next);
     }
+}
 
-    stateMachineReady = false;
+void H5Transport::enterFailed()
+{
+    log(SD_RPC_LOG_FATAL, "Entered state failed. No exit exists from this state.");
 }
 
-bool H5Transport::waitForState(h5_state_t state, std::chrono::milliseconds timeout)
+void H5Transport::enterClosed()
+{
+    log(SD_RPC_LOG_DEBUG, "Entered state closed.");
+}
+
+void H5Transport::enterNoResponse()
 {
-    std::unique_lock<std::mutex> lock(stateMutex);
-    return stateWaitCondition.wait_for(lock, timeout,
-                                       [&state, this] { return currentState == state; });
+    log(SD_RPC_LOG_DEBUG, "No response to data sent to device.");
 }
 
 #pragma endregion State machine related methods
 
 #pragma region Sending packet types
 
-void H5Transport::sendControlPacket(const control_pkt_type type)
+void H5Transport::encodeControlPackets()
 {
-    h5_pkt_type_t h5_packet;
-
-    switch (type)
+    for (size_t index = 0; index < controlPackets.size(); index++)
     {
-        case CONTROL_PKT_RESET:
-            h5_packet = RESET_PACKET;
-            break;
-        case CONTROL_PKT_SYNC:
-        case CONTROL_PKT_SYNC_RESPONSE:
-        case CONTROL_PKT_SYNC_CONFIG:
-        case CONTROL_PKT_SYNC_CONFIG_RESPONSE:
-            h5_packet = LINK_CONTROL_PACKET;
-            break;
-        case CONTROL_PKT_ACK:
-            h5_packet = ACK_PACKET;
-            break;
-        default:
-            h5_packet = LINK_CONTROL_PACKET;
-    }
+        const auto type = static_cast<control_pkt_type>(index);
+        auto payload    = getPktPattern(type);
+        h5_pkt_type_t h5_packet;
 
-    payload_t h5Packet;
+        switch (type)
+        {
+            case CONTROL_PKT_RESET:
+                h5_packet = RESET_PACKET;
+                break;
+            case CONTROL_PKT_ACK:
+                // ACK packets depend on the acknowledgement number, see ackPackets
+                continue;
+            case CONTROL_PKT_SYNC_CONFIG:
+            case CONTROL_PKT_SYNC_CONFIG_RESPONSE:
+                payload[2] = syncConfigField();
+                h5_packet  = LINK_CONTROL_PACKET;
+                break;
+            default:
+                h5_packet = LINK_CONTROL_PACKET;
+        }
 
-    try
-    {
-        const auto payload = getPktPattern(type);
+        h5_slip_encode(payload.data(), payload.size(), controlPackets[index], 0, 0, false, false,
+                       h5_packet);
+    }
 
-        h5_encode(payload, h5Packet, 0, type == CONTROL_PKT_ACK ? ackNum : 0, false, false,
-                  h5_packet);
+    for (uint8_t ack_num = 0; ack_num < ackPackets.size(); ack_num++)
+    {
+        h5_slip_encode(static_cast<const transport_segment_t *>(nullptr), 0, ackPackets[ack_num], 0,
+                       ack_num, false, false, ACK_PACKET);
     }
-    catch (const std::out_of_range &e)
+}
+
+void H5Transport::sendControlPacket(const control_pkt_type type)
+{
+    if (static_cast<size_t>(type) >= controlPackets.size())
     {
         std::stringstream logLine;
 
-        logLine << "Trying to send unknown control packet to device. " << e.what() << ". Aborting.";
+        logLine << "Trying to send unknown control packet to device. unknown CONTROL packet type 0x"
+                << std::hex << static_cast<uint32_t>(type) << ". Aborting.";
         log(SD_RPC_LOG_INFO, logLine.str());
 
         std::terminate();
     }
 
-    payload_t slipPacket;
-    slip_encode(h5Packet, slipPacket);
+    if (type == CONTROL_PKT_ACK)
+    {
+        sendAck();
+        return;
+    }
+
+    // Control packets are encoded when the transport is created
+    sendSlipPacket(controlPackets[type]);
+}
+
+void H5Transport::sendAck()
+{
+    // Peer treats an ACK packet arriving after one with a later acknowledgement number as a sync
+    // error. The ACK is sent when ackSendMutex is released, by this thread if it is free.
+    ackSendRequested = true;
+
+    if (ackSendMutex.try_lock())
+    {
+        unlockAckSend();
+    }
+}
+
+// Releases ackSendMutex and does the work requested by the threads that found it taken
+void H5Transport::unlockAckSend()
+{
+    ackSendMutex.unlock();
+
+    while (true)
+    {
+        if (retransmitRequested.exchange(false))
+        {
+            scheduleTimer(std::chrono::steady_clock::now());
+        }
+
+        if (!ackSendRequested || !ackSendMutex.try_lock())
+        {
+            return;
+        }
+
+        ackSendRequested = false;
+
+        uint8_t acknowledgement;
+
+        {
+            std::lock_guard<std::mutex> ackGuard(ackMutex);
+            acknowledgement = ackNum;
+        }
+
+        sendSlipPacket(ackPackets[acknowledgement]);
+        ackSendMutex.unlock();
+    }
+}
+
+uint32_t H5Transport::sendSlipPacket(const payload_t &slipPacket)
+{
+    logOutgoingPacket(slipPacket);
 
-    logPacket(true, h5Packet);
+    if (transportStats)
+    {
+        transportStats->packetSent(slipPacket.size());
+    }
 
-    nextTransportLayer->send(slipPacket);
+    return nextTransportLayer->send(slipPacket);
+}
+
+uint8_t H5Transport::syncConfigField() const
+{
+    return (SyncConfigField & ~SyncConfigSlidingWindowMask) |
+           (localSlidingWindowSize & SyncConfigSlidingWindowMask);
 }
 
 #pragma endregion Methods related to sending packet types defined in the Three Wire Standard
@@ -1083,9 +1414,10 @@ std::string H5Transport::hciPacketLinkControlToString(const payload_t &payload)
     return retval.str();
 }
 
-std::string H5Transport::h5PktToString(const bool out, const payload_t &h5Packet) const
+std::string H5Transport::h5PktToString(const bool out, const uint8_t *h5Packet,
+                                       const size_t length) const
 {
-    payload_t payload;
+    const uint8_t *payloadStart = nullptr;
 
     uint8_t seq_num;
     uint8_t ack_num;
@@ -1096,8 +1428,15 @@ std::string H5Transport::h5PktToString(const bool out, const payload_t &h5Packet
     uint8_t header_checksum;
 
     const auto err_code =
-        h5_decode(h5Packet, payload, &seq_num, &ack_num, &data_integrity, &payload_length,
-                  &header_checksum, &reliable_packet, &packet_type);
+        h5_decode(h5Packet, length, &payloadStart, &seq_num, &ack_num, &data_integrity,
+                  &payload_length, &header_checksum, &reliable_packet, &packet_type);
+
+    payload_t payload;
+
+    if (err_code == NRF_SUCCESS)
+    {
+        payload.assign(payloadStart, payloadStart + payload_length);
+    }
 
     std::stringstream count;
 
@@ -1133,7 +1472,7 @@ std::string H5Transport::h5PktToString(const bool out, const payload_t &h5Packet
     return retval.str();
 }
 
-void H5Transport::logPacket(const bool outgoing, const payload_t &packet)
+void H5Transport::logPacket(const bool outgoing, const uint8_t *packet, const size_t length)
 {
     if (outgoing)
     {
@@ -1144,10 +1483,30 @@ void H5Transport::logPacket(const bool outgoing, const payload_t &packet)
         incomingPacketCount++;
     }
 
-    const std::string logLine = h5PktToString(outgoing, packet);
+    if (!logEnabled(SD_RPC_LOG_DEBUG))
+    {
+        return;
+    }
+
+    const std::string logLine = h5PktToString(outgoing, packet, length);
     log(SD_RPC_LOG_DEBUG, logLine);
 }
 
+void H5Transport::logOutgoingPacket(const payload_t &slipPacket)
+{
+    if (!logEnabled(SD_RPC_LOG_DEBUG))
+    {
+        outgoingPacketCount++;
+        return;
+    }
+
+    // Outgoing packets are passed on SLIP encoded. The buffer is reused by the thread.
+    static thread_local payload_t h5Packet;
+    h5Packet.clear();
+    slip_decode(slipPacket, h5Packet);
+    logPacket(true, h5Packet.data(), h5Packet.size());
+}
+
 void H5Transport::logStateTransition(h5_state_t from, h5_state_t to) const
 {
     std::stringstream logLine;
@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "recording_transport.h"
+
+#include "nrf_error.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+
+RecordingTransport::RecordingTransport(Transport *nextTransportLayer, const std::string &path)
+    : Transport()
+    , nextTransportLayer(nextTransportLayer)
+    , path(path)
+    , isOpen(false)
+{}
+
+RecordingTransport::~RecordingTransport() noexcept
+{
+    RecordingTransport::close();
+    delete nextTransportLayer;
+}
+
+uint32_t RecordingTransport::open(const status_cb_t &status_callback,
+                                  const data_cb_t &data_callback, const log_cb_t &log_callback)
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (isOpen)
+    {
+        return NRF_ERROR_SD_RPC_SERIAL_PORT_ALREADY_OPEN;
+    }
+
+    Transport::open(status_callback, data_callback, log_callback);
+
+    {
+        std::lock_guard<std::mutex> guard(fileMutex);
+
+        file.open(path, std::ios::binary | std::ios::trunc);
+
+        if (!file)
+        {
+            status(IO_RESOURCES_UNAVAILABLE, "Error creating recording file " + path + ".");
+            return NRF_ERROR_SD_RPC_SERIAL_PORT;
+        }
+
+        file.write(RecordingMagic, sizeof(RecordingMagic));
+        file.put(static_cast<char>(RecordingVersion));
+        lastRecordTime = std::chrono::steady_clock::now();
+    }
+
+    // Data is recorded before it is passed to the upper layer, the recording then has the reads
+    // in the order the upper layer sees them
+    const auto errorCode = nextTransportLayer->open(
+        upperStatusCallback,
+        [this](const uint8_t *data, const size_t length) { dataHandler(data, length); },
+        upperLogCallback);
+
+    if (errorCode != NRF_SUCCESS)
+    {
+        std::lock_guard<std::mutex> guard(fileMutex);
+        file.close();
+        return errorCode;
+    }
+
+    isOpen = true;
+
+    log(SD_RPC_LOG_INFO, "Recording physical layer traffic to " + path + ".");
+
+    return NRF_SUCCESS;
+}
+
+uint32_t RecordingTransport::close()
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (!isOpen)
+    {
+        return NRF_ERROR_SD_RPC_SERIAL_PORT_ALREADY_CLOSED;
+    }
+
+    isOpen = false;
+
+    // No data is received once the physical layer is closed
+    const auto errorCode = nextTransportLayer->close();
+
+    std::lock_guard<std::mutex> guard(fileMutex);
+    file.close();
+
+    if (file.fail())
+    {
+        log(SD_RPC_LOG_ERROR, "Error writing recording file " + path + ".");
+    }
+
+    return errorCode;
+}
+
+uint32_t RecordingTransport::send(const std::vector<uint8_t> &data)
+{
+    const transport_segment_t segment{data.data(), data.size()};
+    return send(&segment, 1);
+}
+
+uint32_t RecordingTransport::send(const transport_segment_t *segments, const size_t count)
+{
+    // Recorded before it is sent, a response can not be recorded before the data it answers
+    record(RECORDING_DIRECTION_WRITE, segments, count);
+    return nextTransportLayer->send(segments, count);
+}
+
+void RecordingTransport::setBufferPool(const std::shared_ptr<BufferPool> &pool)
+{
+    Transport::setBufferPool(pool);
+    nextTransportLayer->setBufferPool(pool);
+}
+
+void RecordingTransport::setRuntime(const std::shared_ptr<Runtime> &sharedRuntime)
+{
+    Transport::setRuntime(sharedRuntime);
+    nextTransportLayer->setRuntime(sharedRuntime);
+}
+
+void RecordingTransport::setLogSeverityFilter(const sd_rpc_log_severity_t severity)
+{
+    Transport::setLogSeverityFilter(severity);
+    nextTransportLayer->setLogSeverityFilter(severity);
+}
+
+bool RecordingTransport::setTimerHandler(const timer_cb_t &handler)
+{
+    return nextTransportLayer->setTimerHandler(handler);
+}
+
+void RecordingTransport::scheduleTimer(const std::chrono::steady_clock::time_point deadline)
+{
+    nextTransportLayer->scheduleTimer(deadline);
+}
+
+uint32_t RecordingTransport::physicalLayerStats(sd_rpc_physical_layer_stats_t *stats)
+{
+    return nextTransportLayer->physicalLayerStats(stats);
+}
+
+void RecordingTransport::dataHandler(const uint8_t *data, const size_t length)
+{
+    const transport_segment_t segment{data, length};
+    record(RECORDING_DIRECTION_READ, &segment, 1);
+
+    if (upperDataCallback)
+    {
+        upperDataCallback(data, length);
+    }
+}
+
+void RecordingTransport::record(const recording_direction_t direction,
+                                const transport_segment_t *segments, const size_t count)
+{
+    std::lock_guard<std::mutex> guard(fileMutex);
+
+    if (!file.is_open())
+    {
+        return;
+    }
+
+    if (count == 1)
+    {
+        writeRecord(direction, segments[0].data, segments[0].length);
+        return;
+    }
+
+    recordBuffer.clear();
+
+    for (size_t i = 0; i < count; i++)
+    {
+        recordBuffer.insert(recordBuffer.end(), segments[i].data,
+                            segments[i].data + segments[i].length);
+    }
+
+    writeRecord(direction, recordBuffer.data(), recordBuffer.size());
+}
+
+void RecordingTransport::writeRecord(const recording_direction_t direction, const uint8_t *data,
+                                     const size_t length)
+{
+    size_t offset = 0;
+
+    do
+    {
+        const auto now = std::chrono::steady_clock::now();
+        const auto elapsed =
+            std::chrono::duration_cast<std::chrono::microseconds>(now - lastRecordTime).count();
+        const auto delta = static_cast<uint32_t>(
+            std::min<int64_t>(elapsed, std::numeric_limits<uint32_t>::max()));
+        const auto chunk = static_cast<uint16_t>(std::min(length - offset, RecordingMaxDataLength));
+
+        // Only advance by the recorded delta, the rounding error does not accumulate
+        lastRecordTime += std::chrono::microseconds(delta);
+
+        const char header[RecordingRecordHeaderLength] = {
+            static_cast<char>(direction),
+            static_cast<char>(delta & 0xFF),
+            static_cast<char>((delta >> 8) & 0xFF),
+            static_cast<char>((delta >> 16) & 0xFF),
+            static_cast<char>((delta >> 24) & 0xFF),
+            static_cast<char>(chunk & 0xFF),
+            static_cast<char>((chunk >> 8) & 0xFF)};
+
+        file.write(header, sizeof(header));
+        file.write(reinterpret_cast<const char *>(data + offset), chunk);
+
+        offset += chunk;
+    } while (offset < length);
+}
@@ -0,0 +1,395 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "replay_transport.h"
+
+#include "h5.h"
+#include "h5_transport.h"
+#include "nrf_error.h"
+#include "slip.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+constexpr std::chrono::milliseconds ReplayTransport::WaitForSendTimeout;
+
+ReplayTransport::LinkPacketCounter::LinkPacketCounter()
+    : syncCount(0)
+    , syncConfigCount(0)
+    , reliableCount(0)
+    , lastPacket(LINK_PACKET_OTHER)
+    , lastReliableSeqNum(7)
+{}
+
+ReplayTransport::link_packet_t
+ReplayTransport::LinkPacketCounter::count(const uint8_t *data, const size_t length)
+{
+    payload_t packet;
+
+    if (slip_decode(payload_t(data, data + length), packet) != NRF_SUCCESS)
+    {
+        return LINK_PACKET_OTHER;
+    }
+
+    const uint8_t *payload;
+    uint8_t seqNum;
+    uint8_t ackNum;
+    bool dataIntegrity;
+    uint16_t payloadLength;
+    uint8_t headerChecksum;
+    bool reliable;
+    h5_pkt_type_t packetType;
+
+    if (h5_decode(packet.data(), packet.size(), &payload, &seqNum, &ackNum, &dataIntegrity,
+                  &payloadLength, &headerChecksum, &reliable, &packetType) != NRF_SUCCESS)
+    {
+        return LINK_PACKET_OTHER;
+    }
+
+    const payload_t h5Payload(payload, payload + payloadLength);
+    link_packet_t result;
+
+    if (packetType == LINK_CONTROL_PACKET && H5Transport::isSyncPacket(h5Payload))
+    {
+        result = LINK_PACKET_SYNC;
+    }
+    else if (packetType == LINK_CONTROL_PACKET && H5Transport::isSyncConfigPacket(h5Payload))
+    {
+        result = LINK_PACKET_SYNC_CONFIG;
+    }
+    else if (reliable && seqNum == ((lastReliableSeqNum + 1) & 0x07))
+    {
+        result = LINK_PACKET_RELIABLE;
+    }
+    else
+    {
+        return LINK_PACKET_OTHER;
+    }
+
+    if (result == lastPacket && result != LINK_PACKET_RELIABLE)
+    {
+        return LINK_PACKET_OTHER;
+    }
+
+    lastPacket = result;
+
+    switch (result)
+    {
+        case LINK_PACKET_SYNC:
+            // The link is established again, sequence numbers start from 0
+            lastReliableSeqNum = 7;
+            syncCount++;
+            break;
+        case LINK_PACKET_SYNC_CONFIG:
+            syncConfigCount++;
+            break;
+        default:
+            lastReliableSeqNum = seqNum;
+            reliableCount++;
+            break;
+    }
+
+    return result;
+}
+
+uint32_t ReplayTransport::LinkPacketCounter::countOf(const link_packet_t packet) const
+{
+    switch (packet)
+    {
+        case LINK_PACKET_SYNC:
+            return syncCount;
+        case LINK_PACKET_SYNC_CONFIG:
+            return syncConfigCount;
+        case LINK_PACKET_RELIABLE:
+            return reliableCount;
+        default:
+            return 0;
+    }
+}
+
+ReplayTransport::ReplayTransport(const std::string &path, const bool originalTiming)
+    : Transport()
+    , path(path)
+    , originalTiming(originalTiming)
+    , isOpen(false)
+    , stopping(false)
+    , completed(false)
+{}
+
+ReplayTransport::~ReplayTransport() noexcept
+{
+    ReplayTransport::close();
+}
+
+uint32_t ReplayTransport::open(const status_cb_t &status_callback, const data_cb_t &data_callback,
+                               const log_cb_t &log_callback)
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (isOpen)
+    {
+        return NRF_ERROR_SD_RPC_SERIAL_PORT_ALREADY_OPEN;
+    }
+
+    Transport::open(status_callback, data_callback, log_callback);
+
+    file.open(path, std::ios::binary);
+
+    char header[RecordingHeaderLength];
+    file.read(header, sizeof(header));
+
+    if (!file || std::memcmp(header, RecordingMagic, sizeof(RecordingMagic)) != 0 ||
+        static_cast<uint8_t>(header[sizeof(RecordingMagic)]) != RecordingVersion)
+    {
+        file.close();
+        status(IO_RESOURCES_UNAVAILABLE, "Error opening recording " + path +
+                                             ". The file is missing or not a recording.");
+        return NRF_ERROR_SD_RPC_SERIAL_PORT;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        sent      = LinkPacketCounter();
+        stopping  = false;
+        completed = false;
+    }
+
+    recorded = LinkPacketCounter();
+    isOpen   = true;
+
+    replayThread = std::thread([this] { replayWorker(); });
+
+    std::stringstream message;
+    message << "Replaying " << path << (originalTiming ? " with original timing." : ".");
+    log(SD_RPC_LOG_INFO, message.str());
+
+    return NRF_SUCCESS;
+}
+
+uint32_t ReplayTransport::close()
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (!isOpen)
+    {
+        return NRF_ERROR_SD_RPC_SERIAL_PORT_ALREADY_CLOSED;
+    }
+
+    isOpen = false;
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+
+    stateChanged.notify_all();
+
+    if (replayThread.joinable())
+    {
+        replayThread.join();
+    }
+
+    file.close();
+
+    log(SD_RPC_LOG_INFO, "Replay of " + path + " closed.");
+
+    return NRF_SUCCESS;
+}
+
+uint32_t ReplayTransport::send(const std::vector<uint8_t> &data)
+{
+    const transport_segment_t segment{data.data(), data.size()};
+    return send(&segment, 1);
+}
+
+uint32_t ReplayTransport::send(const transport_segment_t *segments, const size_t count)
+{
+    if (!isOpen)
+    {
+        log(SD_RPC_LOG_ERROR,
+            "Trying to send packets to device when replay of " + path + " is closed.");
+        return NRF_ERROR_SD_RPC_SERIAL_PORT_STATE;
+    }
+
+    std::vector<uint8_t> data;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        data.insert(data.end(), segments[i].data, segments[i].data + segments[i].length);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+
+        if (sent.count(data.data(), data.size()) == LINK_PACKET_OTHER)
+        {
+            return NRF_SUCCESS;
+        }
+    }
+
+    stateChanged.notify_all();
+
+    return NRF_SUCCESS;
+}
+
+bool ReplayTransport::waitForCompletion(const std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+    return stateChanged.wait_for(lock, timeout, [this] { return completed; });
+}
+
+void ReplayTransport::replayWorker()
+{
+    recording_direction_t direction;
+    uint32_t delta;
+    std::vector<uint8_t> data;
+
+    // Time the current record is due when replaying with original timing
+    auto due = std::chrono::steady_clock::now();
+
+    while (readRecord(direction, delta, data))
+    {
+        if (originalTiming)
+        {
+            due += std::chrono::microseconds(delta);
+
+            std::unique_lock<std::mutex> lock(stateMutex);
+
+            if (stateChanged.wait_until(lock, due, [this] { return stopping; }))
+            {
+                return;
+            }
+        }
+
+        if (direction == RECORDING_DIRECTION_WRITE)
+        {
+            const auto packet = recorded.count(data.data(), data.size());
+
+            if (packet != LINK_PACKET_OTHER)
+            {
+                waitForSend(packet, recorded.countOf(packet));
+
+                // The upper layer may be slower than when recording, later records are due
+                // relative to when it caught up
+                due = std::max(due, std::chrono::steady_clock::now());
+            }
+        }
+        else if (upperDataCallback)
+        {
+            upperDataCallback(data.data(), data.size());
+        }
+
+        std::lock_guard<std::mutex> lock(stateMutex);
+
+        if (stopping)
+        {
+            return;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        completed = true;
+    }
+
+    stateChanged.notify_all();
+
+    log(SD_RPC_LOG_INFO, "Replay of " + path + " completed.");
+}
+
+bool ReplayTransport::readRecord(recording_direction_t &direction, uint32_t &delta,
+                                 std::vector<uint8_t> &data)
+{
+    uint8_t header[RecordingRecordHeaderLength];
+
+    if (!file.read(reinterpret_cast<char *>(header), sizeof(header)))
+    {
+        return false;
+    }
+
+    delta = static_cast<uint32_t>(header[1]) | (static_cast<uint32_t>(header[2]) << 8) |
+            (static_cast<uint32_t>(header[3]) << 16) | (static_cast<uint32_t>(header[4]) << 24);
+    const auto length = static_cast<size_t>(header[5] | (header[6] << 8));
+
+    data.resize(length);
+
+    if (header[0] > RECORDING_DIRECTION_WRITE ||
+        !file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(length)))
+    {
+        log(SD_RPC_LOG_ERROR, "Recording " + path + " is truncated or corrupt, replay stopped.");
+        return false;
+    }
+
+    direction = static_cast<recording_direction_t>(header[0]);
+    return true;
+}
+
+void ReplayTransport::waitForSend(const link_packet_t packet, const uint32_t count)
+{
+    std::unique_lock<std::mutex> lock(stateMutex);
+
+    const auto caughtUp = stateChanged.wait_for(lock, WaitForSendTimeout, [&] {
+        return stopping || sent.countOf(packet) >= count;
+    });
+
+    if (caughtUp)
+    {
+        return;
+    }
+
+    // Continue as if the packet was sent, replay would otherwise wait at every following packet
+    switch (packet)
+    {
+        case LINK_PACKET_SYNC:
+            sent.syncCount = count;
+            break;
+        case LINK_PACKET_SYNC_CONFIG:
+            sent.syncConfigCount = count;
+            break;
+        default:
+            sent.reliableCount = count;
+            break;
+    }
+
+    lock.unlock();
+
+    std::stringstream message;
+    message << "Replay of " << path << " continues without the upper layer sending the packet "
+            << "recorded as number " << count << " of its kind.";
+    log(SD_RPC_LOG_WARNING, message.str());
+}
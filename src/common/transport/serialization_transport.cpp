@@ -42,17 +42,75 @@
 #include "nrf_error.h"
 
 #include "ble_common.h"
+#include "runtime.h"
 
+#if NRF_SD_BLE_API_VERSION == 3
+#include "nordic_common.h" // MAX used by BLE_EVTS_LEN_MAX
+#endif
+
+#include <chrono>
+#include <cstring>
 #include <iterator>
 #include <memory>
 #include <sstream>
 
+#if NRF_SD_BLE_API_VERSION >= 3
+// Largest ATT MTU the connectivity firmware can be configured with
+constexpr uint16_t MaxAttMtu = 247;
+#endif
+
+// Advertising report data of SD API v6 is decoded into the scan buffer provided by the application,
+// the decoded event only refers to it.
+#if NRF_SD_BLE_API_VERSION >= 5
+const uint32_t MaxEventLength =
+    static_cast<uint32_t>(BLE_MAX(sizeof(ble_evt_t), BLE_EVT_LEN_MAX(MaxAttMtu)));
+#elif NRF_SD_BLE_API_VERSION == 3
+const uint32_t MaxEventLength = static_cast<uint32_t>(BLE_EVTS_LEN_MAX(MaxAttMtu));
+#else
+// SD API v2 does not define the maximum event length
+const uint32_t MaxEventLength = 700;
+#endif
+
+namespace {
+// Length of a slot in the event decode arena, in units of std::max_align_t
+constexpr size_t EventSlotLength =
+    (MaxEventLength + sizeof(std::max_align_t) - 1) / sizeof(std::max_align_t);
+
+// Transport whose events the current dispatch thread of a runtime is handling
+thread_local const SerializationTransport *dispatchingTransport = nullptr;
+
+// Returns the opcode of a command, the byte after the packet type
+uint8_t commandOpcode(const transport_segment_t *segments, const size_t count)
+{
+    size_t offset = SerializationHeadroom;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (offset < segments[i].length)
+        {
+            return segments[i].data[offset];
+        }
+
+        offset -= segments[i].length;
+    }
+
+    return 0;
+}
+} // namespace
+
 SerializationTransport::SerializationTransport(Transport *dataLinkLayer, uint32_t response_timeout)
     : statusCallback(nullptr)
     , eventCallback(nullptr)
+    , eventBatchCallback(nullptr)
     , logCallback(nullptr)
-    , responseReceived(false)
-    , responseBuffer(nullptr)
+    , eventQueue(EventQueueCapacity)
+    , eventDecodeArena(new std::max_align_t[EventSlotLength])
+    , eventDecodeArenaSlots(1)
+    , eventBatchSize(1)
+    , eventBatchLatency(0)
+    , eventDispatchScheduled(false)
+    , eventPullMode(false)
+    , pendingEventLength(0)
     , isOpen(false)
 {
     // SerializationTransport takes ownership of dataLinkLayer provided object
@@ -70,10 +128,78 @@ uint32_t SerializationTransport::open(const status_cb_t &status_callback,
         return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_ALREADY_OPEN;
     }
 
+    eventCallback      = event_callback;
+    eventBatchCallback = nullptr;
+    eventPullMode      = false;
+
+    return openTransport(status_callback, log_callback);
+}
+
+uint32_t SerializationTransport::open(const status_cb_t &status_callback,
+                                      const evt_batch_cb_t &event_batch_callback,
+                                      const log_cb_t &log_callback, const uint32_t batchSize,
+                                      const std::chrono::milliseconds maxLatency)
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (isOpen)
+    {
+        return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_ALREADY_OPEN;
+    }
+
+    if (batchSize == 0)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    eventCallback      = nullptr;
+    eventBatchCallback = event_batch_callback;
+    eventBatchSize     = batchSize;
+    eventBatchLatency  = maxLatency;
+    eventPullMode      = false;
+
+    // The arena is only replaced while the event thread is stopped
+    if (eventDecodeArenaSlots < batchSize)
+    {
+        eventDecodeArena.reset(new std::max_align_t[EventSlotLength * batchSize]);
+        eventDecodeArenaSlots = batchSize;
+    }
+
+    eventBatch.reset(new ble_evt_t *[batchSize]);
+
+    return openTransport(status_callback, log_callback);
+}
+
+uint32_t SerializationTransport::open(const status_cb_t &status_callback,
+                                      const log_cb_t &log_callback)
+{
+    std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+    if (isOpen)
+    {
+        return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_ALREADY_OPEN;
+    }
+
+    eventCallback      = nullptr;
+    eventBatchCallback = nullptr;
+    eventPullMode      = true;
+
+    // Created once, the descriptor stays the same when the transport is opened again
+    if (!eventNotifier)
+    {
+        eventNotifier.reset(new EventNotifier());
+    }
+
+    return openTransport(status_callback, log_callback);
+}
+
+// Called with publicMethodMutex locked
+uint32_t SerializationTransport::openTransport(const status_cb_t &status_callback,
+                                                 const log_cb_t &log_callback)
+{
     isOpen = true;
 
     statusCallback = status_callback;
-    eventCallback  = event_callback;
     logCallback    = log_callback;
 
     const auto dataCallback = std::bind(&SerializationTransport::readHandler, this,
@@ -87,26 +213,19 @@ uint32_t SerializationTransport::open(const status_cb_t &status_callback,
     }
 
     // Thread should not be running from before when calling this
-    if (!eventThread.joinable())
-    {
-        // If ::close is called when this method (::open) returns 
-        // and eventThread is executing somewhere between while (isOpen) 
-        // and eventWaitCondition notification we could get a deadlock.
-        //
-        // To prevent this, lock eventMutex in this thread, let eventThread
-        // wait until eventMutex is unlocked (.wait in this thread).
-        // When eventThread is started and outside critical region, 
-        // let eventThread notify eventWaitCondition, making .wait 
-        // return
-        std::unique_lock<std::mutex> eventLock(eventMutex);
-        eventThread = std::thread([this] { eventHandlingRunner(); });
-        eventWaitCondition.wait(eventLock);
-    }
-    else
+    if (eventThread.joinable())
     {
         return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT;
     }
 
+    // Events are pulled by the application or handled on the dispatch threads of the runtime
+    if (eventPullMode || runtime)
+    {
+        return NRF_SUCCESS;
+    }
+
+    eventThread = std::thread([this] { eventHandlingRunner(); });
+
     return NRF_SUCCESS;
 }
 
@@ -119,8 +238,14 @@ uint32_t SerializationTransport::close()
         return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_ALREADY_CLOSED;
     }
 
+    if (dispatchingTransport == this)
+    {
+        // Closed from an event callback, the dispatch task can not wait for itself
+        return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT;
+    }
+
     isOpen = false;
-    eventWaitCondition.notify_all();
+    eventQueue.wakeAll();
 
     if (eventThread.joinable())
     {
@@ -134,34 +259,234 @@ uint32_t SerializationTransport::close()
         eventThread.join();
     }
 
-    return nextTransportLayer->close();
+    // Commands sent before closing get their responses, or time out, before the layer below is
+    // closed
+    {
+        std::unique_lock<std::mutex> responseGuard(responseMutex);
+        responseWaitCondition.wait(responseGuard, [this] { return !commandsAwaitingResponse(); });
+        sentCommands.clear();
+    }
+
+    const auto errorCode = nextTransportLayer->close();
+
+    // The layer below no longer queues events, wait for the dispatch task it scheduled last
+    if (runtime)
+    {
+        std::unique_lock<std::mutex> lock(eventDispatchMutex);
+        eventDispatchIdle.wait(lock, [this] { return !eventDispatchScheduled; });
+    }
+
+    // Events not handled before closing are not passed on when the transport is opened again.
+    // They belong to connections and scans of the closed session, and the GAP state they are
+    // decoded with is deleted at close. The event thread and the layer below are stopped, getEvent
+    // is the only other user.
+    std::lock_guard<std::mutex> eventGetGuard(eventGetMutex);
+    PooledBuffer event;
+    uint32_t dropped = pendingEventLength > 0 ? 1 : 0;
+
+    while (eventQueue.pop(event))
+    {
+        dropped++;
+
+        if (transportStats)
+        {
+            transportStats->eventDequeued();
+        }
+    }
+
+    pendingEventLength = 0;
+
+    if (eventNotifier)
+    {
+        eventNotifier->clear();
+    }
+
+    if (transportStats && dropped > 0)
+    {
+        transportStats->eventsDropped(dropped);
+    }
+
+    return errorCode;
 }
 
-uint32_t SerializationTransport::send(const std::vector<uint8_t> &cmdBuffer,
-                                      std::shared_ptr<std::vector<uint8_t>> rspBuffer,
-                                      serialization_pkt_type_t pktType)
+uint32_t SerializationTransport::getEvent(uint8_t *dest, uint16_t *length)
 {
-    std::lock_guard<std::mutex> lck(publicMethodMutex);
+    std::lock_guard<std::mutex> eventGetGuard(eventGetMutex);
 
-    if (!isOpen)
+    if (!isOpen || !eventPullMode)
     {
         return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_INVALID_STATE;
     }
 
-    // Mutex to avoid multiple threads sending commands at the same time.
-    std::lock_guard<std::mutex> sendGuard(sendMutex);
-    responseReceived = false;
-    responseBuffer   = rspBuffer;
+    // The next event is decoded into the arena and kept there until it fits into dest
+    const auto event = eventSlot(0);
+    PooledBuffer eventData;
 
-    std::vector<uint8_t> commandBuffer(cmdBuffer.size() + 1);
-    commandBuffer[0] = pktType;
-    std::copy(cmdBuffer.begin(), cmdBuffer.end(), commandBuffer.begin() + 1);
+    while (pendingEventLength == 0)
+    {
+        if (!eventQueue.pop(eventData))
+        {
+            // An event queued after the queue was found empty signals again, as the queue was
+            // empty. An event queued before the descriptor was cleared is found here.
+            eventNotifier->clear();
 
-    const auto errCode = nextTransportLayer->send(commandBuffer);
+            if (eventQueue.empty())
+            {
+                return NRF_ERROR_NOT_FOUND;
+            }
+
+            eventNotifier->signal();
+            continue;
+        }
+
+        if (decodeEvent(eventData, event))
+        {
+            pendingEventLength = event->header.evt_len;
+        }
+
+        eventData = PooledBuffer();
+    }
+
+    if (dest != nullptr)
+    {
+        if (*length < pendingEventLength)
+        {
+            *length = pendingEventLength;
+            return NRF_ERROR_DATA_SIZE;
+        }
+
+        std::memcpy(dest, event, pendingEventLength);
+        *length            = pendingEventLength;
+        pendingEventLength = 0;
+        return NRF_SUCCESS;
+    }
+
+    *length = pendingEventLength;
+    return NRF_SUCCESS;
+}
+
+int SerializationTransport::eventFd()
+{
+    // Not locked, publicMethodMutex is held while a command waits for its response
+    if (!isOpen || !eventPullMode)
+    {
+        return -1;
+    }
+
+    return eventNotifier->fd();
+}
+
+void SerializationTransport::setBufferPool(const std::shared_ptr<BufferPool> &pool)
+{
+    bufferPool = pool;
+    nextTransportLayer->setBufferPool(pool);
+}
+
+void SerializationTransport::setTransportStats(const std::shared_ptr<TransportStats> &stats)
+{
+    transportStats = stats;
+    nextTransportLayer->setTransportStats(stats);
+}
+
+void SerializationTransport::setGapState(const std::shared_ptr<adapter_ble_gap_state_t> &state)
+{
+    gapState = state;
+}
+
+void SerializationTransport::setRuntime(const std::shared_ptr<Runtime> &sharedRuntime)
+{
+    runtime = sharedRuntime;
+    nextTransportLayer->setRuntime(sharedRuntime);
+}
+
+void SerializationTransport::setLogSeverityFilter(const sd_rpc_log_severity_t severity)
+{
+    nextTransportLayer->setLogSeverityFilter(severity);
+}
+
+PooledBuffer SerializationTransport::acquireBuffer(const size_t size) const
+{
+    return bufferPool ? bufferPool->acquire(size) : BufferPool::allocate(size);
+}
+
+uint32_t SerializationTransport::send(const std::vector<uint8_t> &cmdBuffer,
+                                      PooledBuffer rspBuffer,
+                                      serialization_pkt_type_t pktType)
+{
+    // The packet type is sent as a separate segment in front of the command
+    const uint8_t packetType             = pktType;
+    const transport_segment_t segments[] = {{&packetType, 1}, {cmdBuffer.data(), cmdBuffer.size()}};
+
+    return sendSegments(segments, 2, rspBuffer, nullptr);
+}
+
+uint32_t SerializationTransport::sendPacket(uint8_t *packet, const size_t length,
+                                            PooledBuffer rspBuffer,
+                                            serialization_pkt_type_t pktType,
+                                            const std::function<void()> &sent)
+{
+    packet[0] = pktType;
+
+    const transport_segment_t segment{packet, length};
+    return sendSegments(&segment, 1, rspBuffer, sent);
+}
+
+uint32_t SerializationTransport::sendSegments(const transport_segment_t *segments,
+                                              const size_t count,
+                                              PooledBuffer rspBuffer,
+                                              const std::function<void()> &sent)
+{
+    const auto opcode = commandOpcode(segments, count);
+    ResponseWaiter waiter{rspBuffer, false};
+    std::chrono::steady_clock::time_point sentAt;
 
-    if (errCode != NRF_SUCCESS)
     {
-        return errCode;
+        std::lock_guard<std::mutex> lck(publicMethodMutex);
+
+        if (!isOpen)
+        {
+            return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_INVALID_STATE;
+        }
+
+        // Mutex to avoid multiple threads sending commands at the same time. The command waits
+        // for its response after the commands sent before it.
+        std::lock_guard<std::mutex> sendGuard(sendMutex);
+
+        if (rspBuffer)
+        {
+            std::lock_guard<std::mutex> responseGuard(responseMutex);
+            sentCommands.push_back(SentCommand{opcode, &waiter});
+        }
+
+        sentAt             = std::chrono::steady_clock::now();
+        const auto errCode = nextTransportLayer->send(segments, count);
+
+        if (errCode != NRF_SUCCESS)
+        {
+            if (rspBuffer)
+            {
+                // The packet may have reached the connectivity firmware, a response to it is
+                // discarded
+                std::lock_guard<std::mutex> responseGuard(responseMutex);
+
+                for (auto &command : sentCommands)
+                {
+                    if (command.waiter == &waiter)
+                    {
+                        command.waiter = nullptr;
+                    }
+                }
+
+                responseWaitCondition.notify_all();
+            }
+
+            return errCode;
+        }
+    }
+
+    if (sent)
+    {
+        sent();
     }
 
     if (!rspBuffer)
@@ -169,81 +494,234 @@ uint32_t SerializationTransport::send(const std::vector<uint8_t> &cmdBuffer,
         return NRF_SUCCESS;
     }
 
+    // Other commands are sent while this one waits for its response
     std::unique_lock<std::mutex> responseGuard(responseMutex);
 
     const std::chrono::milliseconds timeout(responseTimeout);
-    const auto wakeupTime = std::chrono::system_clock::now() + timeout;
+    const auto wakeupTime = std::chrono::steady_clock::now() + timeout;
 
-    responseWaitCondition.wait_until(responseGuard, wakeupTime, [&] { return responseReceived; });
+    responseWaitCondition.wait_until(responseGuard, wakeupTime, [&] { return waiter.received; });
 
-    if (!responseReceived)
+    if (!waiter.received)
     {
+        // A late response is not stored
+        for (auto &command : sentCommands)
+        {
+            if (command.waiter == &waiter)
+            {
+                command.waiter = nullptr;
+            }
+        }
+
+        responseWaitCondition.notify_all();
+        responseGuard.unlock();
+
+        if (transportStats)
+        {
+            transportStats->commandTimedOut();
+        }
+
         logCallback(SD_RPC_LOG_WARNING, "Failed to receive response for command");
         return NRF_ERROR_SD_RPC_SERIALIZATION_TRANSPORT_NO_RESPONSE;
     }
 
+    responseGuard.unlock();
+
+    if (transportStats)
+    {
+        transportStats->commandCompleted(opcode, std::chrono::steady_clock::now() - sentAt);
+    }
+
     return NRF_SUCCESS;
 }
 
+// Called with responseMutex locked
+bool SerializationTransport::commandsAwaitingResponse() const
+{
+    for (const auto &command : sentCommands)
+    {
+        if (command.waiter != nullptr)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 // Event Thread
 void SerializationTransport::eventHandlingRunner()
 {
-    std::unique_lock<std::mutex> eventLock(eventMutex);
+    PooledBuffer eventData;
+    const auto event = eventSlot(0);
 
     while (isOpen)
     {
-        // Suspend this thread until event wait condition
-        // is notified. This can happen from ::close and
-        // ::readHandler (thread in H5Transport)
-        eventWaitCondition.notify_all();
-        eventWaitCondition.wait(eventLock);
+        // Sleep until readHandler (thread in H5Transport) queues an event or ::close is called
+        eventQueue.waitWhileEmpty([this] { return !isOpen; });
 
-        while (!eventQueue.empty() && isOpen)
+        if (eventBatchCallback)
         {
-            // Get oldest event received from UART thread
-            const auto eventData     = eventQueue.front();
-            const auto eventDataSize = static_cast<uint32_t>(eventData.size());
+            handleEventBatch(eventBatchLatency);
+            continue;
+        }
 
-            // Remove oldest event received from H5Transport thread
-            eventQueue.pop();
+        // Get oldest event received from H5Transport thread
+        while (isOpen && eventQueue.pop(eventData))
+        {
+            if (decodeEvent(eventData, event) && eventCallback)
+            {
+                eventCallback(event);
+            }
 
-            // Let UART thread add events to eventQueue
-            // while popped event is processed
-            eventLock.unlock();
+            // Return the buffer to the pool before waiting for the next event
+            eventData = PooledBuffer();
+        }
+    }
+}
 
-            // Set codec context
-            EventCodecContext context(this);
+// Schedules the dispatch task unless it is already scheduled. The task handles the events queued
+// before it runs.
+void SerializationTransport::scheduleEventDispatch()
+{
+    if (!eventDispatchScheduled.exchange(true))
+    {
+        runtime->dispatch([this] { dispatchEvents(); });
+    }
+}
 
-            // Allocate memory to store decoded event including an unknown quantity of padding
-            auto possibleEventLength = MaxPossibleEventLength;
-            std::vector<uint8_t> eventDecodeBuffer;
-            eventDecodeBuffer.reserve(MaxPossibleEventLength);
-            const auto event = reinterpret_cast<ble_evt_t *>(eventDecodeBuffer.data());
+// Dispatch thread of the runtime. Handles up to EventDispatchBudget events, the task is scheduled
+// again while events remain so adapters sharing the dispatch threads take turns.
+void SerializationTransport::dispatchEvents()
+{
+    dispatchingTransport = this;
 
-            // Decode event
-            const auto errCode =
-                ble_event_dec(eventData.data(), eventDataSize, event, &possibleEventLength);
+    if (eventBatchCallback)
+    {
+        // The dispatch thread is not held waiting for more events, a batch is the events queued
+        for (uint32_t handled = 0; isOpen && !eventQueue.empty() && handled < EventDispatchBudget;
+             handled += eventBatchSize)
+        {
+            handleEventBatch(std::chrono::milliseconds::zero());
+        }
+    }
+    else
+    {
+        PooledBuffer eventData;
+        const auto event = eventSlot(0);
 
-            if (eventCallback && errCode == NRF_SUCCESS)
+        for (uint32_t handled = 0; isOpen && handled < EventDispatchBudget; handled++)
+        {
+            if (!eventQueue.pop(eventData))
+            {
+                break;
+            }
+
+            if (decodeEvent(eventData, event) && eventCallback)
             {
                 eventCallback(event);
             }
 
-            if (errCode != NRF_SUCCESS)
+            eventData = PooledBuffer();
+        }
+    }
+
+    dispatchingTransport = nullptr;
+
+    std::lock_guard<std::mutex> lock(eventDispatchMutex);
+    eventDispatchScheduled.exchange(false); // Acquires the events pushed by readHandler
+
+    // Events queued while the task was scheduled did not schedule it again
+    if (isOpen && !eventQueue.empty())
+    {
+        scheduleEventDispatch();
+        return;
+    }
+
+    eventDispatchIdle.notify_all();
+}
+
+// Event Thread. Decodes the queued events into a batch, waiting for more events until the batch is
+// full or the first event has waited maxLatency.
+void SerializationTransport::handleEventBatch(const std::chrono::milliseconds maxLatency)
+{
+    PooledBuffer eventData;
+    uint32_t count      = 0;
+    const auto deadline = std::chrono::steady_clock::now() + maxLatency;
+
+    while (isOpen && count < eventBatchSize)
+    {
+        if (!eventQueue.pop(eventData))
+        {
+            const auto remaining = deadline - std::chrono::steady_clock::now();
+
+            if (remaining <= std::chrono::steady_clock::duration::zero())
             {
-                std::stringstream logMessage;
-                logMessage << "Failed to decode event, error code is " << std::dec << errCode
-                           << "/0x" << std::hex << errCode << ".";
-                logCallback(SD_RPC_LOG_ERROR, logMessage.str());
-                statusCallback(PKT_DECODE_ERROR, logMessage.str());
+                break;
             }
 
-            // Prevent UART from adding events to eventQueue
-            eventLock.lock();
+            eventQueue.waitWhileEmptyFor([this] { return !isOpen; }, remaining);
+            continue;
+        }
+
+        const auto event = eventSlot(count);
+
+        if (decodeEvent(eventData, event))
+        {
+            eventBatch[count++] = event;
         }
+
+        eventData = PooledBuffer();
+    }
+
+    if (count > 0)
+    {
+        eventBatchCallback(eventBatch.get(), count);
     }
 }
 
+// Event Thread. Decodes eventData into event, returns false if the event could not be decoded.
+bool SerializationTransport::decodeEvent(const PooledBuffer &eventData, ble_evt_t *event)
+{
+    const auto eventDataSize = static_cast<uint32_t>(eventData.size());
+
+    if (transportStats)
+    {
+        transportStats->eventDequeued();
+    }
+
+    // Set codec context
+    EventCodecContext context(gapState.get());
+
+    // Decode event in place, the arena slot is reused for every event
+    auto possibleEventLength = MaxEventLength;
+    const auto errCode =
+        ble_event_dec(eventData.data(), eventDataSize, event, &possibleEventLength);
+
+    if (errCode != NRF_SUCCESS)
+    {
+        std::stringstream logMessage;
+        logMessage << "Failed to decode event, error code is " << std::dec << errCode << "/0x"
+                   << std::hex << errCode << ".";
+        logCallback(SD_RPC_LOG_ERROR, logMessage.str());
+        statusCallback(PKT_DECODE_ERROR, logMessage.str());
+
+        if (transportStats)
+        {
+            transportStats->eventsDropped(1);
+        }
+
+        return false;
+    }
+
+    return true;
+}
+
+ble_evt_t *SerializationTransport::eventSlot(const uint32_t index) const
+{
+    return reinterpret_cast<ble_evt_t *>(eventDecodeArena.get() + index * EventSlotLength);
+}
+
 void SerializationTransport::readHandler(const uint8_t *data, const size_t length)
 {
     const auto eventType = static_cast<serialization_pkt_type_t>(data[0]);
@@ -253,37 +731,83 @@ void SerializationTransport::readHandler(const uint8_t *data, const size_t lengt
 
     if (eventType == SERIALIZATION_RESPONSE)
     {
-        if (responseBuffer && !responseBuffer->empty())
+        const auto opcode = dataLength > 0 ? startOfData[0] : 0;
+
+        std::lock_guard<std::mutex> responseGuard(responseMutex);
+
+        // Commands no longer waited for, and not answered by this response, lost their responses
+        while (!sentCommands.empty() && sentCommands.front().waiter == nullptr &&
+               sentCommands.front().opcode != opcode)
         {
-            if (responseBuffer->size() >= dataLength)
-            {
-                std::copy(startOfData, startOfData + dataLength, responseBuffer->begin());
-                responseBuffer->resize(dataLength);
-            }
-            else
-            {
-                logCallback(SD_RPC_LOG_ERROR, "Received SERIALIZATION_RESPONSE with a packet that "
-                                              "is larger than the allocated buffer.");
-            }
+            sentCommands.pop_front();
+        }
+
+        if (sentCommands.empty() || sentCommands.front().opcode != opcode)
+        {
+            logCallback(SD_RPC_LOG_ERROR, "Received SERIALIZATION_RESPONSE but no command is "
+                                          "waiting for it.");
+            return;
+        }
+
+        const auto waiter = sentCommands.front().waiter;
+        sentCommands.pop_front();
+
+        // A response to a command no longer waited for is discarded
+        if (waiter == nullptr)
+        {
+            return;
+        }
+
+        if (waiter->buffer.size() >= dataLength)
+        {
+            std::copy(startOfData, startOfData + dataLength, waiter->buffer.data());
+            waiter->buffer.resize(dataLength);
         }
         else
         {
-            logCallback(SD_RPC_LOG_ERROR, "Received SERIALIZATION_RESPONSE but command did not "
-                                          "provide a buffer for the reply.");
+            logCallback(SD_RPC_LOG_ERROR, "Received SERIALIZATION_RESPONSE with a packet that "
+                                          "is larger than the allocated buffer.");
         }
 
-        std::lock_guard<std::mutex> responseGuard(responseMutex);
-        responseReceived = true;
-        responseWaitCondition.notify_one();
+        waiter->received = true;
+        responseWaitCondition.notify_all();
     }
     else if (eventType == SERIALIZATION_EVENT)
     {
-        std::vector<uint8_t> event;
-        event.reserve(dataLength);
-        std::copy(startOfData, startOfData + dataLength, std::back_inserter(event));
-        std::lock_guard<std::mutex> eventLock(eventMutex);
-        eventQueue.push(std::move(event));
-        eventWaitCondition.notify_one();
+        auto event = acquireBuffer(dataLength);
+        std::copy(startOfData, startOfData + dataLength, event.data());
+
+        // Counted before it is queued, the event thread may dequeue it right away
+        if (transportStats)
+        {
+            transportStats->eventQueued();
+        }
+
+        // The queue is full when the application handles events slower than they arrive. This
+        // thread does not wait for room, it also passes on responses and runs the data link
+        // layer. Events that do not fit in the queue are dropped.
+        if (!eventQueue.push(std::move(event)))
+        {
+            if (transportStats)
+            {
+                transportStats->eventDequeued();
+                transportStats->eventsDropped(1);
+            }
+
+            logCallback(SD_RPC_LOG_WARNING, "Event queue full, event dropped.");
+            return;
+        }
+
+        // The application gets all queued events before it waits for the descriptor again, it is
+        // only signalled when the queue is no longer empty
+        if (eventPullMode && eventQueue.size() <= 1)
+        {
+            eventNotifier->signal();
+        }
+        else if (runtime && !eventPullMode)
+        {
+            scheduleEventDispatch();
+        }
     }
     else
     {
@@ -39,67 +39,206 @@
 #include "nrf_error.h"
 #include "sd_rpc_types.h"
 #include <cstddef>
+#include <cstring>
 #include <vector>
 
-constexpr uint8_t SLIP_END     = 0xC0;
-constexpr uint8_t SLIP_ESC     = 0xDB;
-constexpr uint8_t SLIP_ESC_END = 0xDC;
-constexpr uint8_t SLIP_ESC_ESC = 0xDD;
-
 void slip_encode(const std::vector<uint8_t> &in_packet, std::vector<uint8_t> &out_packet)
 {
-    out_packet.push_back(SLIP_END);
+    // Size the output for the worst case where every byte is escaped, and shrink it afterwards
+    const auto start = out_packet.size();
+    out_packet.resize(start + in_packet.size() * 2 + 2);
+    auto out = out_packet.data() + start;
+
+    *out++ = SLIP_END;
+    out    = slip_escape(in_packet.data(), in_packet.size(), out);
+    *out++ = SLIP_END;
 
-    for (auto i : in_packet)
+    out_packet.resize(static_cast<size_t>(out - out_packet.data()));
+}
+
+uint8_t *slip_escape(const uint8_t *in, const size_t length, uint8_t *out)
+{
+    for (size_t i = 0; i < length;)
     {
-        if (i == SLIP_END)
+        // Bytes up to the next END or ESC are copied as is
+        const auto run = slip_find_special(in + i, length - i);
+        std::memcpy(out, in + i, run);
+        out += run;
+        i += run;
+
+        if (i < length)
         {
-            out_packet.push_back(SLIP_ESC);
-            out_packet.push_back(SLIP_ESC_END);
+            *out++ = SLIP_ESC;
+            *out++ = in[i] == SLIP_END ? SLIP_ESC_END : SLIP_ESC_ESC;
+            i++;
+        }
+    }
+
+    return out;
+}
+
+uint32_t slip_decode(const std::vector<uint8_t> &packet, std::vector<uint8_t> &out_packet)
+{
+    const auto in     = packet.data();
+    const auto length = packet.size();
+
+    for (size_t i = 0; i < length;)
+    {
+        // Bytes up to the next END or ESC are copied as is
+        const auto run = slip_find_special(in + i, length - i);
+        out_packet.insert(out_packet.end(), in + i, in + i + run);
+        i += run;
+
+        if (i == length)
+        {
+            break;
         }
-        else if (i == SLIP_ESC)
+
+        if (in[i] == SLIP_END)
+        {
+            i++;
+            continue;
+        }
+
+        // Escape character, the next byte must be an escaped character
+        i++;
+
+        if (i < length && in[i] == SLIP_ESC_END)
+        {
+            out_packet.push_back(SLIP_END);
+        }
+        else if (i < length && in[i] == SLIP_ESC_ESC)
         {
             out_packet.push_back(SLIP_ESC);
-            out_packet.push_back(SLIP_ESC_ESC);
         }
         else
         {
-            out_packet.push_back(i);
+            return NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_DECODING;
         }
+
+        i++;
     }
 
-    out_packet.push_back(SLIP_END);
+    return NRF_SUCCESS;
 }
 
-uint32_t slip_decode(const std::vector<uint8_t> &packet, std::vector<uint8_t> &out_packet)
+SlipDecoder::SlipDecoder(const packet_cb_t &packet_callback, const size_t max_packet_length)
+    : packetCallback(packet_callback)
+    , frame(max_packet_length)
+    , frameLength(0)
+    , frameStarted(false)
+    , escapeFound(false)
+    , frameError(NRF_SUCCESS)
+{}
+
+void SlipDecoder::decode(const uint8_t *data, const size_t length)
 {
-    for (std::size_t i = 0; i < packet.size(); i++)
+    for (size_t i = 0; i < length;)
     {
-        if (packet[i] == SLIP_END)
+        if (!escapeFound)
+        {
+            // Bytes up to the next END or ESC need no decoding
+            const auto run = slip_find_special(data + i, length - i);
+
+            if (frameStarted && frameError == NRF_SUCCESS)
+            {
+                appendToFrame(data + i, run);
+            }
+
+            i += run;
+
+            if (i == length)
+            {
+                break;
+            }
+        }
+
+        const auto byte = data[i++];
+
+        if (byte == SLIP_END)
         {
+            if (frameStarted && (frameLength > 0 || escapeFound || frameError != NRF_SUCCESS))
+            {
+                // End of packet found
+                endOfPacket();
+            }
+            else
+            {
+                // Start of packet found. If we have two 0xC0 after another we assume it is the
+                // beginning of a new packet, and not the end
+                frameStarted = true;
+            }
+
             continue;
         }
-        else if (packet[i] == SLIP_ESC)
+
+        // Data before the start of packet is irrelevant
+        if (!frameStarted || frameError != NRF_SUCCESS)
         {
-            i++;
-            if (packet[i] == SLIP_ESC_END)
+            continue;
+        }
+
+        auto decoded = byte;
+
+        if (escapeFound)
+        {
+            escapeFound = false;
+
+            if (byte == SLIP_ESC_END)
             {
-                out_packet.push_back(SLIP_END);
+                decoded = SLIP_END;
             }
-            else if (packet[i] == SLIP_ESC_ESC)
+            else if (byte == SLIP_ESC_ESC)
             {
-                out_packet.push_back(SLIP_ESC);
+                decoded = SLIP_ESC;
             }
             else
             {
-                return NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_DECODING;
+                frameError = NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_DECODING;
+                continue;
             }
         }
-        else
+        else if (byte == SLIP_ESC)
         {
-            out_packet.push_back(packet[i]);
+            escapeFound = true;
+            continue;
         }
+
+        appendToFrame(&decoded, 1);
     }
+}
 
-    return NRF_SUCCESS;
+void SlipDecoder::appendToFrame(const uint8_t *data, const size_t length)
+{
+    if (length > frame.size() - frameLength)
+    {
+        frameError = NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_PAYLOAD_SIZE;
+        return;
+    }
+
+    std::memcpy(frame.data() + frameLength, data, length);
+    frameLength += length;
+}
+
+void SlipDecoder::reset()
+{
+    frameLength  = 0;
+    frameStarted = false;
+    escapeFound  = false;
+    frameError   = NRF_SUCCESS;
+}
+
+void SlipDecoder::endOfPacket()
+{
+    // An escape character must be followed by an escaped character
+    if (escapeFound && frameError == NRF_SUCCESS)
+    {
+        frameError = NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_DECODING;
+    }
+
+    const auto err_code = frameError;
+    const auto length   = frameLength;
+
+    reset();
+    packetCallback(frame.data(), length, err_code);
 }
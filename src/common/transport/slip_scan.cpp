@@ -0,0 +1,250 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Kernels scanning for the bytes that have a special meaning in SLIP. The kernel is selected at
+// runtime based on the features of the CPU.
+
+#include "slip.h"
+
+#include <cstddef>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define SLIP_SCAN_X86
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define SLIP_SCAN_NEON
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include <arm_neon.h>
+#endif
+
+#if defined(SLIP_SCAN_X86) &&                                                                    \
+    (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define SLIP_SCAN_SSE2
+#endif
+
+#if defined(SLIP_SCAN_X86) && (defined(_MSC_VER) || defined(__GNUC__))
+#define SLIP_SCAN_AVX2
+#endif
+
+// Kernels using instructions not enabled for the whole build must be compiled for that target
+#if defined(__GNUC__)
+#define SLIP_SCAN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define SLIP_SCAN_TARGET(isa)
+#endif
+
+namespace {
+
+using scan_kernel_t = size_t (*)(const uint8_t *data, const size_t length);
+
+size_t scan_scalar(const uint8_t *data, const size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        if (data[i] == SLIP_END || data[i] == SLIP_ESC)
+        {
+            return i;
+        }
+    }
+
+    return length;
+}
+
+#if defined(SLIP_SCAN_SSE2) || defined(SLIP_SCAN_AVX2)
+inline size_t count_trailing_zeros(const uint32_t value)
+{
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return index;
+#else
+    return static_cast<size_t>(__builtin_ctz(value));
+#endif
+}
+#endif
+
+#if defined(SLIP_SCAN_SSE2)
+size_t scan_sse2(const uint8_t *data, const size_t length)
+{
+    const auto end = _mm_set1_epi8(static_cast<char>(SLIP_END));
+    const auto esc = _mm_set1_epi8(static_cast<char>(SLIP_ESC));
+    size_t i       = 0;
+
+    for (; i + 16 <= length; i += 16)
+    {
+        const auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        const auto found = _mm_or_si128(_mm_cmpeq_epi8(block, end), _mm_cmpeq_epi8(block, esc));
+        const auto mask  = static_cast<uint32_t>(_mm_movemask_epi8(found));
+
+        if (mask != 0)
+        {
+            return i + count_trailing_zeros(mask);
+        }
+    }
+
+    return i + scan_scalar(data + i, length - i);
+}
+#endif
+
+#if defined(SLIP_SCAN_AVX2)
+SLIP_SCAN_TARGET("avx2") size_t scan_avx2(const uint8_t *data, const size_t length)
+{
+    const auto end = _mm256_set1_epi8(static_cast<char>(SLIP_END));
+    const auto esc = _mm256_set1_epi8(static_cast<char>(SLIP_ESC));
+    size_t i       = 0;
+
+    for (; i + 32 <= length; i += 32)
+    {
+        const auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        const auto found =
+            _mm256_or_si256(_mm256_cmpeq_epi8(block, end), _mm256_cmpeq_epi8(block, esc));
+        const auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(found));
+
+        if (mask != 0)
+        {
+            return i + count_trailing_zeros(mask);
+        }
+    }
+
+    return i + scan_scalar(data + i, length - i);
+}
+
+bool cpu_supports_avx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+
+    if (info[0] < 7)
+    {
+        return false;
+    }
+
+    // The OS must save the AVX registers (OSXSAVE and XCR0 bits 1 and 2)
+    __cpuid(info, 1);
+
+    if ((info[2] & (1 << 27)) == 0 || (_xgetbv(0) & 0x6) != 0x6)
+    {
+        return false;
+    }
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+#if defined(SLIP_SCAN_NEON)
+size_t scan_neon(const uint8_t *data, const size_t length)
+{
+    const auto end = vdupq_n_u8(SLIP_END);
+    const auto esc = vdupq_n_u8(SLIP_ESC);
+    size_t i       = 0;
+
+    for (; i + 16 <= length; i += 16)
+    {
+        const auto block = vld1q_u8(data + i);
+        const auto found = vorrq_u8(vceqq_u8(block, end), vceqq_u8(block, esc));
+
+        if (vmaxvq_u8(found) != 0)
+        {
+            // Narrow each byte of the comparison result to four bits
+            const auto nibbles = vshrn_n_u16(vreinterpretq_u16_u8(found), 4);
+            const auto mask    = vget_lane_u64(vreinterpret_u64_u8(nibbles), 0);
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward64(&index, mask);
+            return i + index / 4;
+#else
+            return i + static_cast<size_t>(__builtin_ctzll(mask)) / 4;
+#endif
+        }
+    }
+
+    return i + scan_scalar(data + i, length - i);
+}
+#endif
+
+struct ScanImplementation
+{
+    scan_kernel_t kernel;
+    const char *name;
+};
+
+ScanImplementation select_implementation()
+{
+#if defined(SLIP_SCAN_AVX2)
+    if (cpu_supports_avx2())
+    {
+        return {scan_avx2, "avx2"};
+    }
+#endif
+
+#if defined(SLIP_SCAN_SSE2)
+    return {scan_sse2, "sse2"};
+#elif defined(SLIP_SCAN_NEON)
+    return {scan_neon, "neon"};
+#else
+    return {scan_scalar, "scalar"};
+#endif
+}
+
+const ScanImplementation &implementation()
+{
+    static const auto selected = select_implementation();
+    return selected;
+}
+
+} // namespace
+
+size_t slip_find_special(const uint8_t *data, const size_t length)
+{
+    return implementation().kernel(data, length);
+}
+
+const char *slip_find_special_implementation()
+{
+    return implementation().name;
+}
@@ -44,7 +44,10 @@
 
 using namespace std;
 
-Transport::Transport()  = default;
+Transport::Transport()
+    : logSeverityFilter(SD_RPC_LOG_TRACE)
+{}
+
 Transport::~Transport() = default;
 
 uint32_t Transport::open(const status_cb_t &status_callback, const data_cb_t &data_callback,
@@ -62,6 +65,64 @@ uint32_t Transport::open(const status_cb_t &status_callback, const data_cb_t &da
     return NRF_SUCCESS;
 }
 
+uint32_t Transport::send(const transport_segment_t *segments, const size_t count)
+{
+    size_t length = 0;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        length += segments[i].length;
+    }
+
+    std::vector<uint8_t> data;
+    data.reserve(length);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        data.insert(data.end(), segments[i].data, segments[i].data + segments[i].length);
+    }
+
+    return send(data);
+}
+
+void Transport::setBufferPool(const std::shared_ptr<BufferPool> &pool)
+{
+    bufferPool = pool;
+}
+
+void Transport::setTransportStats(const std::shared_ptr<TransportStats> &stats)
+{
+    transportStats = stats;
+}
+
+void Transport::setRuntime(const std::shared_ptr<Runtime> &sharedRuntime)
+{
+    runtime = sharedRuntime;
+}
+
+bool Transport::setTimerHandler(const timer_cb_t &)
+{
+    return false;
+}
+
+void Transport::scheduleTimer(const std::chrono::steady_clock::time_point)
+{}
+
+void Transport::setLogSeverityFilter(const sd_rpc_log_severity_t severity)
+{
+    logSeverityFilter = severity;
+}
+
+uint32_t Transport::physicalLayerStats(sd_rpc_physical_layer_stats_t *)
+{
+    return NRF_ERROR_NOT_SUPPORTED;
+}
+
+PooledBuffer Transport::acquireBuffer(const size_t size) const
+{
+    return bufferPool ? bufferPool->acquire(size) : BufferPool::allocate(size);
+}
+
 void Transport::log(const sd_rpc_log_severity_t severity, const std::string &message) const
 {
     if (upperLogCallback)
@@ -74,6 +135,11 @@ void Transport::log(const sd_rpc_log_severity_t severity, const std::string &mes
     }
 }
 
+bool Transport::logEnabled(const sd_rpc_log_severity_t severity) const
+{
+    return static_cast<uint32_t>(severity) >= static_cast<uint32_t>(logSeverityFilter.load());
+}
+
 void Transport::status(const sd_rpc_app_status_t code, const std::string &message) const
 {
     if (upperLogCallback)
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "transport_stats.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace {
+// Upper bound of the first latency bucket is 2^FIRST_BUCKET_BITS microseconds
+constexpr uint32_t FIRST_BUCKET_BITS = 7;
+
+// Duration the write rate is measured over
+const auto WRITE_RATE_WINDOW = std::chrono::seconds(1);
+
+void storeMax(std::atomic<uint32_t> &max, const uint32_t value)
+{
+    auto current = max.load(std::memory_order_relaxed);
+
+    while (value > current &&
+           !max.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+} // namespace
+
+TransportStats::TransportStats()
+    : packetsSent(0)
+    , packetsReceived(0)
+    , bytesSent(0)
+    , bytesReceived(0)
+    , retransmissionCount(0)
+    , decodeErrorCount(0)
+    , eventsReceived(0)
+    , droppedEventCount(0)
+    , eventQueueDepth(0)
+    , eventQueueHighWaterMark(0)
+    , commandTimeoutCount(0)
+{
+    for (auto &histogram : commandLatency)
+    {
+        histogram.count.store(0, std::memory_order_relaxed);
+        histogram.max.store(0, std::memory_order_relaxed);
+        histogram.total.store(0, std::memory_order_relaxed);
+
+        for (auto &bucket : histogram.buckets)
+        {
+            bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void TransportStats::packetSent(const size_t bytes)
+{
+    packetsSent.fetch_add(1, std::memory_order_relaxed);
+    bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void TransportStats::packetReceived()
+{
+    packetsReceived.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TransportStats::dataReceived(const size_t bytes)
+{
+    bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+void TransportStats::retransmission()
+{
+    retransmissionCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TransportStats::decodeError()
+{
+    decodeErrorCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TransportStats::eventQueued()
+{
+    eventsReceived.fetch_add(1, std::memory_order_relaxed);
+    const auto depth = eventQueueDepth.fetch_add(1, std::memory_order_relaxed) + 1;
+    storeMax(eventQueueHighWaterMark, depth);
+}
+
+void TransportStats::eventDequeued()
+{
+    eventQueueDepth.fetch_sub(1, std::memory_order_relaxed);
+}
+
+void TransportStats::eventsDropped(const uint32_t count)
+{
+    droppedEventCount.fetch_add(count, std::memory_order_relaxed);
+}
+
+void TransportStats::commandCompleted(const uint8_t opcode,
+                                      const std::chrono::steady_clock::duration latency)
+{
+    const auto microseconds = static_cast<uint32_t>(std::min<int64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(latency).count(),
+        std::numeric_limits<uint32_t>::max()));
+
+    size_t bucket = 0;
+
+    while (bucket + 1 < SD_RPC_LATENCY_BUCKET_COUNT &&
+           (microseconds >> (bucket + FIRST_BUCKET_BITS)) != 0)
+    {
+        bucket++;
+    }
+
+    auto &histogram = commandLatency[opcode];
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+    histogram.total.fetch_add(microseconds, std::memory_order_relaxed);
+    histogram.buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    storeMax(histogram.max, microseconds);
+}
+
+void TransportStats::commandTimedOut()
+{
+    commandTimeoutCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void TransportStats::stats(sd_rpc_stats_t *stats) const
+{
+    stats->packets_sent                = packetsSent.load(std::memory_order_relaxed);
+    stats->packets_received            = packetsReceived.load(std::memory_order_relaxed);
+    stats->bytes_sent                  = bytesSent.load(std::memory_order_relaxed);
+    stats->bytes_received              = bytesReceived.load(std::memory_order_relaxed);
+    stats->retransmissions             = retransmissionCount.load(std::memory_order_relaxed);
+    stats->decode_errors               = decodeErrorCount.load(std::memory_order_relaxed);
+    stats->events_received             = eventsReceived.load(std::memory_order_relaxed);
+    stats->events_dropped              = droppedEventCount.load(std::memory_order_relaxed);
+    stats->event_queue_depth           = eventQueueDepth.load(std::memory_order_relaxed);
+    stats->event_queue_high_water_mark = eventQueueHighWaterMark.load(std::memory_order_relaxed);
+    stats->command_timeouts            = commandTimeoutCount.load(std::memory_order_relaxed);
+
+    for (size_t opcode = 0; opcode < SD_RPC_OPCODE_COUNT; opcode++)
+    {
+        const auto &histogram = commandLatency[opcode];
+        auto &out             = stats->command_latency[opcode];
+
+        out.count = histogram.count.load(std::memory_order_relaxed);
+        out.max   = histogram.max.load(std::memory_order_relaxed);
+        out.total = histogram.total.load(std::memory_order_relaxed);
+
+        for (size_t bucket = 0; bucket < SD_RPC_LATENCY_BUCKET_COUNT; bucket++)
+        {
+            out.buckets[bucket] = histogram.buckets[bucket].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+WriteStats::WriteStats()
+    : bytesQueued(0)
+    , bytesWritten(0)
+    , writeCount(0)
+    , writesInRateWindow(0)
+    , writesPerSecond(0)
+    , rateWindowStart(std::chrono::steady_clock::now())
+{}
+
+void WriteStats::queued(const size_t bytes)
+{
+    bytesQueued += bytes;
+}
+
+void WriteStats::written(const size_t bytes)
+{
+    bytesWritten += bytes;
+    writeCount++;
+    writesInRateWindow++;
+
+    const auto now     = std::chrono::steady_clock::now();
+    const auto elapsed = now - rateWindowStart;
+
+    if (elapsed >= WRITE_RATE_WINDOW)
+    {
+        const auto elapsedMs =
+            std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count();
+        writesPerSecond    = static_cast<uint32_t>(writesInRateWindow * 1000 / elapsedMs);
+        writesInRateWindow = 0;
+        rateWindowStart    = now;
+    }
+}
+
+void WriteStats::stats(sd_rpc_physical_layer_stats_t *stats, const size_t pending) const
+{
+    stats->bytes_queued      = bytesQueued;
+    stats->bytes_written     = bytesWritten;
+    stats->write_count       = writeCount;
+    stats->bytes_pending     = static_cast<uint32_t>(pending);
+    stats->writes_per_second = writesPerSecond;
+
+    // Nothing has been written for a while
+    if (std::chrono::steady_clock::now() - rateWindowStart > WRITE_RATE_WINDOW * 2)
+    {
+        stats->writes_per_second = 0;
+    }
+}
@@ -37,8 +37,12 @@
 
 #include "uart_boost.h"
 #include "nrf_error.h"
+#include "runtime.h"
 #include "uart_settings_boost.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <mutex>
@@ -55,11 +59,20 @@
 
 constexpr uint32_t DUMMY_BAUD_RATE = 9600;
 
+// Duration send waits for room in the write ring before giving up
+const auto WRITE_RING_SPACE_TIMEOUT = std::chrono::milliseconds(1000);
+
 UartBoost::UartBoost(const UartCommunicationParameters &communicationParameters)
     : Transport()
-    , readBuffer(), isOpen(false), uartSettingsBoost(communicationParameters)
+    , readBuffer()
+    , writeRing(WRITE_RING_BUFFER_SIZE)
+    , writeRingHead(0)
+    , writeRingUsed(0)
+    , isOpen(false), uartSettingsBoost(communicationParameters)
     , asyncWriteInProgress(false)
     , ioServiceThread(nullptr)
+    , pendingOperations(0)
+    , timerDeadline(std::chrono::steady_clock::time_point::min())
 {
     ioService    = new asio::io_service();
     serialPort   = new asio::serial_port(*ioService);
@@ -72,6 +85,9 @@ UartBoost::~UartBoost() noexcept
 {
     try
     {
+        // The timer is destroyed before the I/O service it runs on
+        timer.reset();
+
         if (serialPort != nullptr)
         {
             delete serialPort;
@@ -117,6 +133,11 @@ uint32_t UartBoost::open(const status_cb_t &status_callback, const data_cb_t &da
 
     Transport::open(status_callback, data_callback, log_callback);
 
+    {
+        std::lock_guard<std::mutex> guard(operationsMutex);
+        pendingOperations = 0;
+    }
+
     const auto portName = uartSettingsBoost.getPortName();
 
     try
@@ -208,7 +229,25 @@ uint32_t UartBoost::open(const status_cb_t &status_callback, const data_cb_t &da
         callbackWriteHandle =
             std::bind(&UartBoost::writeHandler, this, std::placeholders::_1, std::placeholders::_2);
 
-        // run execution of io_service handlers in a separate thread
+        callbackTimerHandle =
+            std::bind(&UartBoost::timerWaitHandler, this, std::placeholders::_1);
+
+        if (strand)
+        {
+            // Reads, writes and timers complete on any I/O thread of the runtime, one at a time
+            callbackReadHandle  = strand->wrap(callbackReadHandle);
+            callbackWriteHandle = strand->wrap(callbackWriteHandle);
+            callbackTimerHandle = strand->wrap(callbackTimerHandle);
+        }
+
+        {
+            std::lock_guard<std::mutex> guard(timerMutex);
+            timer.reset(new asio::steady_timer(runtime ? runtime->ioService() : *ioService));
+            timerDeadline = std::chrono::steady_clock::time_point::max();
+        }
+
+        // run execution of io_service handlers in a separate thread, unless the I/O threads of
+        // the runtime run them
         if (ioServiceThread != nullptr)
         {
             std::cerr << "ioServiceThread already exists.... aborting." << std::endl;
@@ -237,7 +276,10 @@ uint32_t UartBoost::open(const status_cb_t &status_callback, const data_cb_t &da
             }
         };
 
-        ioServiceThread = new std::thread(asioWorker);
+        if (!strand)
+        {
+            ioServiceThread = new std::thread(asioWorker);
+        }
     }
     catch (std::exception &ex)
     {
@@ -307,8 +349,29 @@ uint32_t UartBoost::close()
 
     try
     {
+        {
+            // Deadlines scheduled from now on are ignored
+            std::lock_guard<std::mutex> guard(timerMutex);
+            timerDeadline = std::chrono::steady_clock::time_point::min();
+
+            if (timer)
+            {
+                timer->cancel();
+            }
+        }
+
         serialPort->close();
-        ioService->stop();
+
+        if (strand)
+        {
+            // Outstanding operations complete as aborted on the I/O threads of the runtime
+            std::unique_lock<std::mutex> guard(operationsMutex);
+            operationsCompleted.wait(guard, [this] { return pendingOperations == 0; });
+        }
+        else
+        {
+            ioService->stop();
+        }
 
         if (ioServiceThread != nullptr)
         {
@@ -333,14 +396,37 @@ uint32_t UartBoost::close()
         log(SD_RPC_LOG_ERROR, message.str());
     }
 
-    asyncWriteInProgress = false;
+    {
+        std::lock_guard<std::mutex> guard(queueMutex);
+        asyncWriteInProgress = false;
+        writeRingHead        = 0;
+        writeRingUsed        = 0;
+        writeOverflow.clear();
+    }
+
+    writeRingSpaceAvailable.notify_all();
 
     return NRF_SUCCESS;
 }
 
 uint32_t UartBoost::send(const std::vector<uint8_t> &data)
 {
-    std::lock_guard<std::mutex> lck(publicMethodMutex);
+    const transport_segment_t segment{data.data(), data.size()};
+    return send(&segment, 1);
+}
+
+uint32_t UartBoost::send(const transport_segment_t *segments, const size_t count)
+{
+    // The I/O thread frees room in the write ring, it must not wait for room itself. It does not
+    // take publicMethodMutex either, a sender waiting for room holds it. close waits for the
+    // handlers of the I/O thread before the ring is emptied.
+    const auto ioThread = runningInIoThread();
+    std::unique_lock<std::mutex> lck(publicMethodMutex, std::defer_lock);
+
+    if (!ioThread)
+    {
+        lck.lock();
+    }
 
     if (!isOpen)
     {
@@ -352,12 +438,73 @@ uint32_t UartBoost::send(const std::vector<uint8_t> &data)
         return NRF_ERROR_SD_RPC_SERIAL_PORT_STATE;
     }
 
+    size_t length = 0;
+
+    for (size_t i = 0; i < count; i++)
     {
-        std::lock_guard<std::mutex> guard(queueMutex);
-        writeQueue.insert(writeQueue.end(), data.begin(), data.end());
+        length += segments[i].length;
+    }
+
+    if (length > writeRing.size())
+    {
+        std::stringstream message;
+        message << "Trying to send " << length << " bytes, more than the "
+                << writeRing.size() << " bytes that can be queued.";
+        log(SD_RPC_LOG_ERROR, message.str());
+
+        return NRF_ERROR_SD_RPC_SERIAL_PORT;
     }
 
-    if (!asyncWriteInProgress)
+    auto startWrite = false;
+
+    {
+        std::unique_lock<std::mutex> guard(queueMutex);
+
+        const auto spaceAvailable = [&] {
+            return writeOverflow.empty() && writeRing.size() - writeRingUsed >= length;
+        };
+
+        if (ioThread && !spaceAvailable())
+        {
+            // A write is in progress while the ring is full, it moves the data to the ring
+            for (size_t i = 0; i < count; i++)
+            {
+                writeOverflow.insert(writeOverflow.end(), segments[i].data,
+                                     segments[i].data + segments[i].length);
+            }
+
+            writeStats.queued(length);
+            return NRF_SUCCESS;
+        }
+
+        // Wait for the ongoing write to make room if the ring is full
+        if (!writeRingSpaceAvailable.wait_for(guard, WRITE_RING_SPACE_TIMEOUT, spaceAvailable))
+        {
+            std::stringstream message;
+            message << "Timed out waiting for room for " << length
+                    << " bytes in the write buffer of serial port "
+                    << uartSettingsBoost.getPortName() << ".";
+            log(SD_RPC_LOG_ERROR, message.str());
+
+            return NRF_ERROR_SD_RPC_SERIAL_PORT;
+        }
+
+        for (size_t i = 0; i < count; i++)
+        {
+            copyToWriteRing(segments[i].data, segments[i].length);
+        }
+
+        writeStats.queued(length);
+
+        // Data queued while a write is in progress is written when that write completes
+        if (!asyncWriteInProgress)
+        {
+            asyncWriteInProgress = true;
+            startWrite           = true;
+        }
+    }
+
+    if (startWrite)
     {
         asyncWrite();
     }
@@ -365,6 +512,13 @@ uint32_t UartBoost::send(const std::vector<uint8_t> &data)
     return NRF_SUCCESS;
 }
 
+uint32_t UartBoost::physicalLayerStats(sd_rpc_physical_layer_stats_t *stats)
+{
+    std::lock_guard<std::mutex> guard(queueMutex);
+    writeStats.stats(stats, writeRingUsed + writeOverflow.size());
+    return NRF_SUCCESS;
+}
+
 void UartBoost::readHandler(const asio::error_code &errorCode, const size_t bytesTransferred)
 {
     if (!isOpen && !errorCode)
@@ -401,12 +555,34 @@ void UartBoost::readHandler(const asio::error_code &errorCode, const size_t byte
 
         status(IO_RESOURCES_UNAVAILABLE, message.str());
     }
+
+    operationCompleted();
 }
 
 void UartBoost::writeHandler(const asio::error_code &errorCode, const size_t bytesTransferred)
 {
     if (!errorCode)
     {
+        {
+            std::lock_guard<std::mutex> guard(queueMutex);
+
+            writeRingHead = (writeRingHead + bytesTransferred) % writeRing.size();
+            writeRingUsed -= bytesTransferred;
+
+            // Data sent by the I/O thread while the ring was full follows the data in the ring
+            if (!writeOverflow.empty())
+            {
+                const auto moved =
+                    std::min(writeOverflow.size(), writeRing.size() - writeRingUsed);
+                copyToWriteRing(writeOverflow.data(), moved);
+                writeOverflow.erase(writeOverflow.begin(), writeOverflow.begin() + moved);
+            }
+
+            writeStats.written(bytesTransferred);
+        }
+
+        writeRingSpaceAvailable.notify_all();
+
         asyncWrite();
     }
     else if (errorCode == asio::error::operation_aborted)
@@ -419,10 +595,15 @@ void UartBoost::writeHandler(const asio::error_code &errorCode, const size_t byt
 
         // In case of an aborted write operation, suppress notifications and return (i.e. no
         // asyncWrite)
-        queueMutex.lock();
-        writeQueue.clear();
-        asyncWriteInProgress = false;
-        queueMutex.unlock();
+        {
+            std::lock_guard<std::mutex> guard(queueMutex);
+            writeRingHead        = 0;
+            writeRingUsed        = 0;
+            asyncWriteInProgress = false;
+            writeOverflow.clear();
+        }
+
+        writeRingSpaceAvailable.notify_all();
     }
     else
     {
@@ -432,6 +613,8 @@ void UartBoost::writeHandler(const asio::error_code &errorCode, const size_t byt
 
         log(SD_RPC_LOG_ERROR, message.str());
     }
+
+    operationCompleted();
 }
 
 void UartBoost::startRead()
@@ -442,30 +625,135 @@ void UartBoost::startRead()
 void UartBoost::asyncRead()
 {
     const auto mutableReadBuffer = asio::buffer(readBuffer, BUFFER_SIZE);
+
+    {
+        std::lock_guard<std::mutex> guard(operationsMutex);
+        pendingOperations++;
+    }
+
     serialPort->async_read_some(mutableReadBuffer, callbackReadHandle);
 }
 
 void UartBoost::asyncWrite()
 {
+    std::array<asio::const_buffer, 2> buffers;
+
     { // lock_guard scope
         std::lock_guard<std::mutex> guard(queueMutex);
 
-        const auto numBytesPending = writeQueue.size();
-
-        if (numBytesPending == 0)
+        if (writeRingUsed == 0)
         {
             asyncWriteInProgress = false;
             return;
         }
 
         asyncWriteInProgress = true;
-        writeBufferVector.clear();
 
-        /* Write all available bytes in one operation */
-        writeBufferVector.insert(writeBufferVector.begin(), writeQueue.begin(), writeQueue.end());
-        writeQueue.clear();
+        /* Write all queued bytes in one operation, directly from the ring */
+        const auto first = std::min(writeRingUsed, writeRing.size() - writeRingHead);
+        buffers[0]       = asio::buffer(writeRing.data() + writeRingHead, first);
+        buffers[1]       = asio::buffer(writeRing.data(), writeRingUsed - first);
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(operationsMutex);
+        pendingOperations++;
+    }
+
+    asio::async_write(*serialPort, buffers, callbackWriteHandle);
+}
+
+bool UartBoost::runningInIoThread() const
+{
+    if (strand)
+    {
+        return strand->running_in_this_thread();
     }
 
-    const auto buffer = asio::buffer(writeBufferVector, writeBufferVector.size());
-    asio::async_write(*serialPort, buffer, callbackWriteHandle);
+    return ioServiceThread != nullptr && ioServiceThread->get_id() == std::this_thread::get_id();
+}
+
+void UartBoost::copyToWriteRing(const uint8_t *data, const size_t length)
+{
+    const auto tail  = (writeRingHead + writeRingUsed) % writeRing.size();
+    const auto first = std::min(length, writeRing.size() - tail);
+
+    std::memcpy(writeRing.data() + tail, data, first);
+    std::memcpy(writeRing.data(), data + first, length - first);
+    writeRingUsed += length;
+}
+
+void UartBoost::operationCompleted()
+{
+    std::lock_guard<std::mutex> guard(operationsMutex);
+    pendingOperations--;
+    operationsCompleted.notify_all();
+}
+
+bool UartBoost::setTimerHandler(const timer_cb_t &handler)
+{
+    timerHandler = handler;
+    return true;
+}
+
+void UartBoost::scheduleTimer(const std::chrono::steady_clock::time_point deadline)
+{
+    // An earlier deadline is already waited for, or the serial port is closed
+    if (deadline >= timerDeadline.load())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(timerMutex);
+
+    if (deadline >= timerDeadline.load())
+    {
+        return;
+    }
+
+    timerDeadline = deadline;
+
+    {
+        std::lock_guard<std::mutex> operationsGuard(operationsMutex);
+        pendingOperations++;
+    }
+
+    // Aborts the wait for the later deadline
+    timer->expires_at(deadline);
+    timer->async_wait(callbackTimerHandle);
+}
+
+void UartBoost::timerWaitHandler(const asio::error_code &errorCode)
+{
+    auto expired = false;
+
+    {
+        std::lock_guard<std::mutex> guard(timerMutex);
+
+        // Deadlines scheduled from now on wait again, the handler schedules the deadlines before
+        // now it still needs
+        if (!errorCode && timerDeadline.load() != std::chrono::steady_clock::time_point::min())
+        {
+            timerDeadline = std::chrono::steady_clock::time_point::max();
+            expired       = true;
+        }
+    }
+
+    if (expired && timerHandler)
+    {
+        timerHandler();
+    }
+
+    operationCompleted();
+}
+
+void UartBoost::setRuntime(const std::shared_ptr<Runtime> &sharedRuntime)
+{
+    Transport::setRuntime(sharedRuntime);
+
+    // The serial port is created again on the I/O service of the runtime, the own I/O service of
+    // the serial port is not run
+    delete serialPort;
+    serialPort = new asio::serial_port(sharedRuntime->ioService());
+    strand.reset(new asio::io_service::strand(sharedRuntime->ioService()));
 }
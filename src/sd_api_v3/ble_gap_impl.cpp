@@ -58,7 +58,7 @@ static uint32_t gap_encode_decode(adapter_t *adapter, const encode_function_t &e
         return NRF_ERROR_INVALID_PARAM;
     }
 
-    RequestReplyCodecContext context(adapterLayer->transport);
+    RequestReplyCodecContext context(adapterLayer->gapState.get());
     return encode_decode(adapter, encode_function, decode_function);
 }
 
@@ -48,7 +48,9 @@
 
 #include <cstdint>
 
-static void *mp_out_params[3];
+// Buffers of the advertisement set being configured, commands are encoded and decoded on the
+// thread calling them
+static thread_local void *mp_out_params[3];
 
 static uint32_t gap_encode_decode(adapter_t *adapter, const encode_function_t &encode_function,
                                   const decode_function_t &decode_function)
@@ -60,7 +62,7 @@ static uint32_t gap_encode_decode(adapter_t *adapter, const encode_function_t &e
         return NRF_ERROR_INVALID_PARAM;
     }
 
-    RequestReplyCodecContext context(adapterLayer->transport);
+    RequestReplyCodecContext context(adapterLayer->gapState.get());
     return encode_decode(adapter, encode_function, decode_function);
 }
 
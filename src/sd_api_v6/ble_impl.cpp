@@ -154,7 +154,7 @@ uint32_t sd_ble_enable(adapter_t *adapter,
     (void)p_app_ram_base;
 
     auto adapterLayer = static_cast<AdapterInternal *>(adapter->internal);
-    RequestReplyCodecContext context(adapterLayer->transport);
+    RequestReplyCodecContext context(adapterLayer->gapState.get());
 
     // Reset previous app_ble_gap data
     app_ble_gap_state_reset();
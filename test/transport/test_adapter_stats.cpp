@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Logging support
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#if defined(__linux__) && NRF_SD_BLE_API >= 6
+
+#include <simulator_adapter.h>
+
+#include "ble.h"
+#include "sd_rpc.h"
+
+TEST_CASE("adapter stats")
+{
+    SimulatorAdapter fixture("stats");
+    const auto adapter = fixture.adapter;
+    REQUIRE(adapter != nullptr);
+
+    sd_rpc_stats_t stats;
+    REQUIRE(sd_rpc_stats_get(nullptr, &stats) == NRF_ERROR_NULL);
+    REQUIRE(sd_rpc_stats_get(adapter, nullptr) == NRF_ERROR_NULL);
+
+    REQUIRE(fixture.open() == NRF_SUCCESS);
+
+    SECTION("commands")
+    {
+        REQUIRE(sd_ble_gap_tx_power_set(adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) == NRF_SUCCESS);
+
+        REQUIRE(sd_rpc_stats_get(adapter, &stats) == NRF_SUCCESS);
+        REQUIRE(stats.packets_sent > 0);
+        REQUIRE(stats.packets_received > 0);
+        REQUIRE(stats.bytes_sent > 0);
+        REQUIRE(stats.bytes_received > 0);
+        REQUIRE(stats.decode_errors == 0);
+        REQUIRE(stats.command_latency[SD_BLE_GAP_TX_POWER_SET].count == 1);
+        REQUIRE(stats.command_latency[SD_BLE_GAP_TX_POWER_SET].max > 0);
+        REQUIRE(stats.command_timeouts == 0);
+    }
+
+    SECTION("events")
+    {
+        REQUIRE(fixture.connect() == NRF_SUCCESS);
+        REQUIRE(fixture.waitForEvents(BLE_GAP_EVT_CONNECTED, 1));
+
+        fixture.simulator.setNotificationRate(1000, 64);
+        REQUIRE(fixture.waitForEvents(BLE_GATTC_EVT_HVX, 50));
+        fixture.simulator.setNotificationRate(0);
+
+        // Every event received is either handled or dropped at close
+        REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+        REQUIRE(sd_rpc_stats_get(adapter, &stats) == NRF_SUCCESS);
+
+        const auto events = fixture.events();
+        REQUIRE(stats.events_received == events.total() + stats.events_dropped);
+        REQUIRE(stats.event_queue_depth == 0);
+        REQUIRE(stats.event_queue_high_water_mark > 0);
+    }
+}
+
+#endif // __linux__ && NRF_SD_BLE_API >= 6
@@ -0,0 +1,361 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Logging support
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#if defined(__linux__) && NRF_SD_BLE_API >= 6
+
+#include <simulator_adapter.h>
+
+#include "ble.h"
+#include "sd_rpc.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+// Results of asynchronous commands, in the order they are completed
+struct CompletedCommands
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<std::pair<uint32_t, uint32_t>> results; // Command index and result
+
+    bool waitFor(const size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return changed.wait_for(lock, SimulatorAdapter::WaitTimeout,
+                                [&] { return results.size() >= count; });
+    }
+};
+
+// Holds up a command until the test releases it
+struct CommandGate
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool started  = false;
+    bool released = false;
+};
+
+struct AsyncCommand
+{
+    uint32_t index;
+    CompletedCommands *completed;
+    bool advStop         = false;
+    AsyncCommand *next   = nullptr;     // Queued by the completion handler of chained commands
+    CommandGate *gate    = nullptr;     // Passed before the command is run
+    uint32_t closeResult = NRF_SUCCESS; // Result of sd_rpc_close in the completion handler
+};
+
+uint32_t async_command(adapter_t *adapter, void *context)
+{
+    const auto command = static_cast<AsyncCommand *>(context);
+
+    if (command->gate != nullptr)
+    {
+        std::unique_lock<std::mutex> lock(command->gate->mutex);
+        command->gate->started = true;
+        command->gate->changed.notify_all();
+        command->gate->changed.wait(lock, [&] { return command->gate->released; });
+    }
+
+    if (command->advStop)
+    {
+        return sd_ble_gap_adv_stop(adapter, 0);
+    }
+
+    return sd_ble_gap_tx_power_set(adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0);
+}
+
+void async_command_complete(adapter_t *, uint32_t result, void *context)
+{
+    const auto command = static_cast<AsyncCommand *>(context);
+
+    std::lock_guard<std::mutex> lock(command->completed->mutex);
+    command->completed->results.emplace_back(command->index, result);
+    command->completed->changed.notify_all();
+}
+
+void chained_command_complete(adapter_t *adapter, uint32_t result, void *context)
+{
+    async_command_complete(adapter, result, context);
+
+    const auto next = static_cast<AsyncCommand *>(context)->next;
+
+    if (next == nullptr)
+    {
+        return;
+    }
+
+    // Queued from the worker thread, a failure is recorded as the result of the next command
+    const auto errorCode =
+        sd_rpc_command_async(adapter, async_command, chained_command_complete, next);
+
+    if (errorCode != NRF_SUCCESS)
+    {
+        async_command_complete(adapter, errorCode, next);
+    }
+}
+
+void closing_command_complete(adapter_t *adapter, uint32_t result, void *context)
+{
+    static_cast<AsyncCommand *>(context)->closeResult = sd_rpc_close(adapter);
+    async_command_complete(adapter, result, context);
+}
+
+} // namespace
+
+TEST_CASE("async commands")
+{
+    SimulatorAdapter fixture("async");
+    const auto adapter = fixture.adapter;
+    REQUIRE(adapter != nullptr);
+    REQUIRE(fixture.open() == NRF_SUCCESS);
+
+    auto &simulator = fixture.simulator;
+    CompletedCommands completed;
+
+    SECTION("completion_order")
+    {
+        simulator.setCommandResult(SD_BLE_GAP_ADV_STOP, NRF_ERROR_INVALID_STATE);
+
+        constexpr uint32_t CommandCount = 20;
+        std::vector<AsyncCommand> commands;
+
+        for (uint32_t i = 0; i < CommandCount; i++)
+        {
+            commands.push_back({i, &completed});
+            commands.back().advStop = i % 5 == 4;
+        }
+
+        for (auto &command : commands)
+        {
+            REQUIRE(sd_rpc_command_async(adapter, async_command, async_command_complete,
+                                         &command) == NRF_SUCCESS);
+        }
+
+        REQUIRE(completed.waitFor(CommandCount));
+
+        {
+            std::lock_guard<std::mutex> lock(completed.mutex);
+
+            for (uint32_t i = 0; i < CommandCount; i++)
+            {
+                REQUIRE(completed.results[i].first == i);
+                REQUIRE(completed.results[i].second ==
+                        (commands[i].advStop ? NRF_ERROR_INVALID_STATE : NRF_SUCCESS));
+            }
+        }
+
+        REQUIRE(simulator.commandCount() == CommandCount);
+        REQUIRE(sd_rpc_command_async(adapter, nullptr, nullptr, nullptr) == NRF_ERROR_NULL);
+        REQUIRE(sd_rpc_command_async(nullptr, async_command, nullptr, nullptr) ==
+                NRF_ERROR_NULL);
+
+        REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+        REQUIRE(sd_rpc_command_async(adapter, async_command, nullptr, &commands[0]) ==
+                NRF_ERROR_INVALID_STATE);
+    }
+
+    SECTION("chained")
+    {
+        constexpr uint32_t CommandCount = 5;
+        std::vector<AsyncCommand> commands;
+
+        for (uint32_t i = 0; i < CommandCount; i++)
+        {
+            commands.push_back({i, &completed});
+        }
+
+        for (uint32_t i = 0; i + 1 < CommandCount; i++)
+        {
+            commands[i].next = &commands[i + 1];
+        }
+
+        REQUIRE(sd_rpc_command_async(adapter, async_command, chained_command_complete,
+                                     &commands[0]) == NRF_SUCCESS);
+        REQUIRE(completed.waitFor(CommandCount));
+
+        std::lock_guard<std::mutex> lock(completed.mutex);
+
+        for (uint32_t i = 0; i < CommandCount; i++)
+        {
+            REQUIRE(completed.results[i].first == i);
+            REQUIRE(completed.results[i].second == NRF_SUCCESS);
+        }
+
+        REQUIRE(simulator.commandCount() == CommandCount);
+    }
+
+    SECTION("pipelined")
+    {
+        // Up to the size of the H5 sliding window commands wait for their responses at once
+        constexpr uint32_t PipelineDepth = 7;
+        constexpr uint32_t CommandCount  = 2 * PipelineDepth;
+        std::vector<AsyncCommand> commands;
+
+        for (uint32_t i = 0; i < CommandCount; i++)
+        {
+            commands.push_back({i, &completed});
+        }
+
+        simulator.holdResponses(true);
+
+        for (auto &command : commands)
+        {
+            REQUIRE(sd_rpc_command_async(adapter, async_command, async_command_complete,
+                                         &command) == NRF_SUCCESS);
+        }
+
+        REQUIRE(simulator.waitForHeldCommands(PipelineDepth, std::chrono::seconds(5)));
+
+        {
+            std::lock_guard<std::mutex> lock(completed.mutex);
+            REQUIRE(completed.results.empty());
+        }
+
+        simulator.holdResponses(false);
+        REQUIRE(completed.waitFor(CommandCount));
+
+        // Completed in the order the commands are queued
+        std::lock_guard<std::mutex> lock(completed.mutex);
+
+        for (uint32_t i = 0; i < CommandCount; i++)
+        {
+            REQUIRE(completed.results[i].first == i);
+            REQUIRE(completed.results[i].second == NRF_SUCCESS);
+        }
+
+        REQUIRE(simulator.commandCount() == CommandCount);
+    }
+
+    SECTION("close_with_command_in_flight")
+    {
+        constexpr uint32_t CommandCount = 3;
+        CommandGate gate;
+        std::vector<AsyncCommand> commands;
+
+        for (uint32_t i = 0; i < CommandCount; i++)
+        {
+            commands.push_back({i, &completed});
+        }
+
+        commands[0].gate = &gate;
+
+        for (auto &command : commands)
+        {
+            REQUIRE(sd_rpc_command_async(adapter, async_command, async_command_complete,
+                                         &command) == NRF_SUCCESS);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(gate.mutex);
+            REQUIRE(gate.changed.wait_for(lock, SimulatorAdapter::WaitTimeout,
+                                          [&] { return gate.started; }));
+        }
+
+        uint32_t closeResult = NRF_ERROR_INTERNAL;
+        std::thread closer([&] { closeResult = sd_rpc_close(adapter); });
+
+        // The queue rejects commands once close has stopped it, close then waits for the
+        // command in flight
+        AsyncCommand probe  = {CommandCount, &completed};
+        const auto deadline = std::chrono::steady_clock::now() + SimulatorAdapter::WaitTimeout;
+        auto stopped        = false;
+
+        while (!stopped && std::chrono::steady_clock::now() < deadline)
+        {
+            stopped = sd_rpc_command_async(adapter, async_command, nullptr, &probe) ==
+                      NRF_ERROR_INVALID_STATE;
+            std::this_thread::yield();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(gate.mutex);
+            gate.released = true;
+            gate.changed.notify_all();
+        }
+
+        closer.join();
+        REQUIRE(stopped);
+        REQUIRE(closeResult == NRF_SUCCESS);
+
+        {
+            std::lock_guard<std::mutex> lock(completed.mutex);
+            REQUIRE(completed.results.size() == CommandCount);
+
+            // The command in flight completes, the queued ones are not run
+            for (uint32_t i = 0; i < CommandCount; i++)
+            {
+                REQUIRE(completed.results[i].first == i);
+                REQUIRE(completed.results[i].second ==
+                        (i == 0 ? NRF_SUCCESS : NRF_ERROR_INVALID_STATE));
+            }
+        }
+
+        REQUIRE(simulator.commandCount() == 1);
+        REQUIRE(fixture.open() == NRF_SUCCESS);
+        REQUIRE(sd_ble_gap_tx_power_set(adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) == NRF_SUCCESS);
+    }
+
+    SECTION("close_from_completion_handler")
+    {
+        AsyncCommand command = {0, &completed};
+
+        REQUIRE(sd_rpc_command_async(adapter, async_command, closing_command_complete,
+                                     &command) == NRF_SUCCESS);
+        REQUIRE(completed.waitFor(1));
+
+        // The adapter stays open
+        REQUIRE(command.closeResult == NRF_ERROR_INVALID_STATE);
+        REQUIRE(sd_ble_gap_tx_power_set(adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) == NRF_SUCCESS);
+    }
+}
+
+#endif // __linux__ && NRF_SD_BLE_API >= 6
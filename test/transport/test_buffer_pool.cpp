@@ -0,0 +1,143 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <buffer_pool.h>
+
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+TEST_CASE("buffer_pool")
+{
+    SECTION("acquire_release")
+    {
+        BufferPool pool(64, 2);
+
+        {
+            auto first  = pool.acquire(10);
+            auto second = pool.acquire(64);
+
+            REQUIRE(first.size() == 10);
+            REQUIRE(first.capacity() == 64);
+            REQUIRE(first.data() != second.data());
+            REQUIRE(pool.stats().in_use == 2);
+
+            // Copies share the buffer, it is released with the last copy
+            auto copy = first;
+            REQUIRE(copy.data() == first.data());
+            first = PooledBuffer();
+            REQUIRE(pool.stats().in_use == 2);
+        }
+
+        const auto stats = pool.stats();
+        REQUIRE(stats.in_use == 0);
+        REQUIRE(stats.high_water_mark == 2);
+        REQUIRE(stats.exhausted_count == 0);
+        REQUIRE(stats.heap_fallback_count == 0);
+    }
+
+    SECTION("heap_fallback")
+    {
+        BufferPool pool(64, 1);
+
+        const auto pooled    = pool.acquire(64);
+        const auto exhausted = pool.acquire(64);
+        const auto tooLarge  = pool.acquire(65);
+
+        REQUIRE(exhausted.capacity() == 64);
+        REQUIRE(tooLarge.capacity() == 65);
+
+        const auto stats = pool.stats();
+        REQUIRE(stats.in_use == 1);
+        REQUIRE(stats.exhausted_count == 1);
+        REQUIRE(stats.heap_fallback_count == 2);
+    }
+
+    SECTION("concurrent")
+    {
+        const size_t bufferCount = 8;
+        BufferPool pool(32, bufferCount);
+        std::atomic<bool> corrupted(false);
+        std::vector<std::thread> threads;
+
+        for (uint8_t id = 0; id < 4; id++)
+        {
+            threads.emplace_back([&pool, &corrupted, id] {
+                for (auto i = 0; i < 20000; i++)
+                {
+                    const auto buffer = pool.acquire(32);
+                    std::memset(buffer.data(), id, buffer.size());
+
+                    // No other thread may get the same buffer while it is in use
+                    for (size_t j = 0; j < buffer.size(); j++)
+                    {
+                        if (buffer.data()[j] != id)
+                        {
+                            corrupted = true;
+                        }
+                    }
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        REQUIRE_FALSE(corrupted);
+
+        const auto stats = pool.stats();
+        REQUIRE(stats.in_use == 0);
+        REQUIRE(stats.high_water_mark <= 4);
+
+        // All buffers are back in the pool
+        std::vector<PooledBuffer> buffers;
+
+        for (size_t i = 0; i < bufferCount; i++)
+        {
+            buffers.push_back(pool.acquire(32));
+        }
+
+        REQUIRE(pool.stats().heap_fallback_count == 0);
+    }
+}
@@ -0,0 +1,189 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Logging support
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#if defined(__linux__) && NRF_SD_BLE_API >= 6
+
+#include <connectivity_simulator.h>
+#include <simulator_adapter.h>
+
+#include "ble.h"
+#include "sd_rpc.h"
+
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+void status_handler(adapter_t *, sd_rpc_app_status_t, const char *) {}
+
+void event_handler(adapter_t *, ble_evt_t *) {}
+
+void log_handler(adapter_t *, sd_rpc_log_severity_t, const char *message)
+{
+    NRF_LOG(message);
+}
+} // namespace
+
+TEST_CASE("ConnectivitySimulator")
+{
+    // Used by the event handler until the adapter is closed
+    uint8_t scanData[BLE_GAP_SCAN_BUFFER_MIN];
+    ble_data_t scanBuffer = {scanData, sizeof(scanData)};
+
+    SimulatorAdapter fixture("simulator");
+    const auto adapter = fixture.adapter;
+    auto &simulator    = fixture.simulator;
+    REQUIRE(adapter != nullptr);
+
+    fixture.onEvent = [&scanBuffer](adapter_t *eventAdapter, ble_evt_t *event) {
+        if (event->header.evt_id == BLE_GAP_EVT_ADV_REPORT)
+        {
+            // Resume scanning, the SoftDevice pauses after each report
+            sd_ble_gap_scan_start(eventAdapter, nullptr, &scanBuffer);
+        }
+    };
+
+    REQUIRE(fixture.open() == NRF_SUCCESS);
+
+    SECTION("commands")
+    {
+        REQUIRE(sd_ble_gap_tx_power_set(adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) == NRF_SUCCESS);
+
+        ble_gap_addr_t address;
+        REQUIRE(sd_ble_gap_addr_get(adapter, &address) == NRF_ERROR_NOT_SUPPORTED);
+
+        simulator.setCommandResult(SD_BLE_GAP_ADV_STOP, NRF_ERROR_INVALID_STATE);
+        REQUIRE(sd_ble_gap_adv_stop(adapter, 0) == NRF_ERROR_INVALID_STATE);
+
+        REQUIRE(simulator.commandCount() == 3);
+    }
+
+    SECTION("advertising_reports")
+    {
+        simulator.setAdvertisingReportRate(ConnectivitySimulator::Unlimited);
+
+        ble_gap_scan_params_t scanParams = {};
+        scanParams.interval              = 0x00A0;
+        scanParams.window                = 0x0050;
+        scanParams.scan_phys             = BLE_GAP_PHY_1MBPS;
+
+        REQUIRE(sd_ble_gap_scan_start(adapter, &scanParams, &scanBuffer) == NRF_SUCCESS);
+        REQUIRE(fixture.waitForEvents(BLE_GAP_EVT_ADV_REPORT, 50));
+        REQUIRE(sd_ble_gap_scan_stop(adapter) == NRF_SUCCESS);
+    }
+
+    SECTION("connection_and_notifications")
+    {
+        REQUIRE(fixture.connect() == NRF_SUCCESS);
+        REQUIRE(fixture.waitForEvents(BLE_GAP_EVT_CONNECTED, 1));
+
+        const auto connHandle = fixture.events().lastConnHandle;
+
+        simulator.setNotificationRate(ConnectivitySimulator::Unlimited, 64);
+        REQUIRE(fixture.waitForEvents(BLE_GATTC_EVT_HVX, 50));
+        simulator.setNotificationRate(0);
+        REQUIRE(fixture.events().lastHvxLength == 64);
+
+        REQUIRE(sd_ble_gap_disconnect(adapter, connHandle,
+                                      BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION) == NRF_SUCCESS);
+        REQUIRE(fixture.waitForEvents(BLE_GAP_EVT_DISCONNECTED, 1));
+        REQUIRE(sd_ble_gap_disconnect(adapter, connHandle,
+                                      BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION) ==
+                BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+
+    SECTION("connection_churn")
+    {
+        simulator.setConnectionChurnRate(200);
+        REQUIRE(fixture.waitForEvents(BLE_GAP_EVT_DISCONNECTED, 5));
+        simulator.setConnectionChurnRate(0);
+    }
+
+    SECTION("reopen")
+    {
+        REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+        REQUIRE(fixture.open() == NRF_SUCCESS);
+        REQUIRE(sd_ble_gap_tx_power_set(adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) == NRF_SUCCESS);
+    }
+
+    REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+}
+
+TEST_CASE("ConnectivitySimulator physical layer stats")
+{
+    ConnectivitySimulator simulator("/tmp/ble-driver-simulator-" + std::to_string(getpid()));
+    simulator.start();
+
+    const auto phy = sd_rpc_physical_layer_create_local(simulator.path().c_str());
+    REQUIRE(phy != nullptr);
+
+    sd_rpc_physical_layer_stats_t stats;
+    REQUIRE(sd_rpc_physical_layer_stats_get(phy, &stats) == NRF_SUCCESS);
+    REQUIRE(stats.bytes_queued == 0);
+    REQUIRE(stats.write_count == 0);
+    REQUIRE(sd_rpc_physical_layer_stats_get(phy, nullptr) == NRF_ERROR_NULL);
+    REQUIRE(sd_rpc_physical_layer_stats_get(nullptr, &stats) == NRF_ERROR_NULL);
+
+    const auto data_link_layer = sd_rpc_data_link_layer_create_bt_three_wire(phy, 250);
+    const auto transport_layer = sd_rpc_transport_layer_create(data_link_layer, 1000);
+    const auto adapter         = sd_rpc_adapter_create(transport_layer);
+    REQUIRE(adapter != nullptr);
+
+    REQUIRE(sd_rpc_open(adapter, status_handler, event_handler, log_handler) == NRF_SUCCESS);
+    REQUIRE(sd_ble_gap_tx_power_set(adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) == NRF_SUCCESS);
+
+    // The local socket takes everything written right away
+    REQUIRE(sd_rpc_physical_layer_stats_get(phy, &stats) == NRF_SUCCESS);
+    REQUIRE(stats.bytes_queued > 0);
+    REQUIRE(stats.bytes_written == stats.bytes_queued);
+    REQUIRE(stats.bytes_pending == 0);
+    REQUIRE(stats.write_count > 0);
+
+    REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+    sd_rpc_adapter_delete(adapter);
+    simulator.stop();
+}
+
+#endif // __linux__ && NRF_SD_BLE_API >= 6
@@ -0,0 +1,158 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+// Logging support
+#define NRF_LOG_SETUP
+#include <internal/log.h>
+
+#include <crc16.h>
+#include <h5.h>
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> randomData(const size_t length)
+{
+    std::vector<uint8_t> data(length);
+    uint32_t seed = 0xC0FFEE;
+
+    for (auto &byte : data)
+    {
+        seed = seed * 1103515245 + 12345;
+        byte = static_cast<uint8_t>(seed >> 16);
+    }
+
+    return data;
+}
+
+// Largest packet the serialization layer produces (SER_HAL_TRANSPORT_MAX_PKT_SIZE)
+#if NRF_SD_BLE_API == 2
+const size_t SerializationMaxPacketSize = 512;
+#else
+const size_t SerializationMaxPacketSize = 768;
+#endif
+
+} // namespace
+
+TEST_CASE("crc16")
+{
+    SECTION("self_test")
+    {
+        REQUIRE(crc16_self_test() == true);
+    }
+
+    SECTION("check_value")
+    {
+        const std::string check = "123456789";
+        const auto start        = reinterpret_cast<const uint8_t *>(check.data());
+
+        REQUIRE(crc16_calculate(start, start + check.size()) == 0x29B1);
+        REQUIRE(crc16_calculate_reference(start, start + check.size()) == 0x29B1);
+    }
+
+    SECTION("matches_reference")
+    {
+        const auto data = randomData(SerializationMaxPacketSize + H5_HEADER_LENGTH);
+
+        for (size_t length = 0; length <= data.size(); length++)
+        {
+            REQUIRE(crc16_calculate(data.data(), data.data() + length) ==
+                    crc16_calculate_reference(data.data(), data.data() + length));
+        }
+    }
+
+    SECTION("incremental")
+    {
+        const auto data  = randomData(100);
+        const auto first = crc16_calculate(data.data(), data.data() + 37);
+
+        REQUIRE(crc16_calculate(data.data() + 37, data.data() + data.size(), first) ==
+                crc16_calculate(data.data(), data.data() + data.size()));
+    }
+}
+
+// Run with: test_crc16_v<N> [.benchmark]
+TEST_CASE("crc16_benchmark", "[.benchmark]")
+{
+    const size_t sizes[] = {4, 16, 64, 256, 512, SerializationMaxPacketSize};
+    const auto bytesPerRun = static_cast<size_t>(16 * 1024 * 1024);
+    const auto data        = randomData(SerializationMaxPacketSize + H5_HEADER_LENGTH + 2);
+
+    const auto measure = [&](const size_t size, const bool reference) {
+        const auto start      = data.data();
+        const auto end        = data.data() + size;
+        const auto iterations = bytesPerRun / size;
+        uint16_t crc          = 0;
+
+        const auto begin = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < iterations; i++)
+        {
+            crc ^= reference ? crc16_calculate_reference(start, end, crc)
+                             : crc16_calculate(start, end, crc);
+        }
+
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - begin);
+
+        // Use the result so that the loop is not optimized away
+        REQUIRE(crc != 0x10000);
+
+        return static_cast<double>(iterations * size) / elapsed.count();
+    };
+
+    NRF_LOG("CRC16 implementation: H5_CRC16_SLICES=" << H5_CRC16_SLICES);
+
+    for (const auto size : sizes)
+    {
+        const auto reference = measure(size, true);
+        const auto selected  = measure(size, false);
+
+        NRF_LOG("packet size: " << size << " bytes, reference: " << reference
+                                << " bytes/ns, selected: " << selected << " bytes/ns, speedup: "
+                                << selected / reference);
+    }
+}
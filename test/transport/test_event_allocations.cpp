@@ -0,0 +1,190 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Logging support
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#if defined(__linux__) && NRF_SD_BLE_API >= 6
+
+#include <connectivity_simulator.h>
+
+#include "ble.h"
+#include "sd_rpc.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+// Heap allocations made by the current thread
+thread_local uint64_t threadAllocations = 0;
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    threadAllocations++;
+
+    if (const auto memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+namespace {
+
+constexpr uint32_t WarmupEvents   = 100;
+constexpr uint32_t MeasuredEvents = 1000;
+
+// Allocations made by the event thread, read when the notifications are received
+struct EventThreadAllocations
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    uint32_t notifications;
+    uint16_t connHandle;
+    uint64_t afterWarmup;
+    uint64_t afterMeasurement;
+} eventThread;
+
+// The handler itself must not allocate, it runs on the measured thread
+void event_handler(adapter_t *, ble_evt_t *event)
+{
+    const auto allocations = threadAllocations;
+
+    std::lock_guard<std::mutex> lock(eventThread.mutex);
+
+    if (event->header.evt_id == BLE_GAP_EVT_CONNECTED)
+    {
+        eventThread.connHandle = event->evt.gap_evt.conn_handle;
+    }
+    else if (event->header.evt_id == BLE_GATTC_EVT_HVX)
+    {
+        eventThread.notifications++;
+
+        if (eventThread.notifications == WarmupEvents)
+        {
+            eventThread.afterWarmup = allocations;
+        }
+        else if (eventThread.notifications == WarmupEvents + MeasuredEvents)
+        {
+            eventThread.afterMeasurement = allocations;
+        }
+    }
+
+    eventThread.changed.notify_all();
+}
+
+void status_handler(adapter_t *, sd_rpc_app_status_t, const char *) {}
+
+void log_handler(adapter_t *, sd_rpc_log_severity_t, const char *message)
+{
+    NRF_LOG(message);
+}
+
+} // namespace
+
+TEST_CASE("event_allocations")
+{
+    ConnectivitySimulator simulator("/tmp/ble-driver-simulator-" + std::to_string(getpid()));
+    simulator.start();
+
+    const auto phy             = sd_rpc_physical_layer_create_local(simulator.path().c_str());
+    const auto data_link_layer = sd_rpc_data_link_layer_create_bt_three_wire(phy, 250);
+    const auto transport_layer = sd_rpc_transport_layer_create(data_link_layer, 1000);
+    const auto adapter         = sd_rpc_adapter_create(transport_layer);
+    REQUIRE(adapter != nullptr);
+
+    REQUIRE(sd_rpc_open(adapter, status_handler, event_handler, log_handler) == NRF_SUCCESS);
+
+    SECTION("notifications")
+    {
+        ble_gap_addr_t peer          = {};
+        ble_gap_scan_params_t scan   = {};
+        ble_gap_conn_params_t params = {};
+        scan.interval                = 0x00A0;
+        scan.window                  = 0x0050;
+        scan.scan_phys               = BLE_GAP_PHY_1MBPS;
+        params.min_conn_interval     = BLE_GAP_CP_MIN_CONN_INTVL_MIN;
+        params.max_conn_interval     = BLE_GAP_CP_MIN_CONN_INTVL_MIN;
+        params.conn_sup_timeout      = 400;
+
+        REQUIRE(sd_ble_gap_connect(adapter, &peer, &scan, &params, BLE_CONN_CFG_TAG_DEFAULT) ==
+                NRF_SUCCESS);
+
+        // Buffers are taken from the pool of the adapter once the first events are handled
+        simulator.setNotificationRate(ConnectivitySimulator::Unlimited, 64);
+
+        uint16_t connHandle;
+
+        {
+            std::unique_lock<std::mutex> lock(eventThread.mutex);
+            REQUIRE(eventThread.changed.wait_for(lock, std::chrono::seconds(10), [] {
+                return eventThread.notifications >= WarmupEvents + MeasuredEvents;
+            }));
+
+            REQUIRE(eventThread.afterMeasurement - eventThread.afterWarmup == 0);
+            connHandle = eventThread.connHandle;
+        }
+
+        simulator.setNotificationRate(0);
+        REQUIRE(sd_ble_gap_disconnect(adapter, connHandle,
+                                      BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION) == NRF_SUCCESS);
+    }
+
+    REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+    sd_rpc_adapter_delete(adapter);
+    simulator.stop();
+}
+
+#endif // __linux__ && NRF_SD_BLE_API >= 6
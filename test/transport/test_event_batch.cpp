@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Logging support
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#if defined(__linux__) && NRF_SD_BLE_API >= 6
+
+#include <simulator_adapter.h>
+
+#include "ble.h"
+#include "sd_rpc.h"
+
+namespace {
+void status_handler(adapter_t *, sd_rpc_app_status_t, const char *) {}
+
+void event_batch_handler(adapter_t *, ble_evt_t **, uint32_t) {}
+
+void log_handler(adapter_t *, sd_rpc_log_severity_t, const char *) {}
+} // namespace
+
+TEST_CASE("batch events")
+{
+    SimulatorAdapter fixture("batch");
+    const auto adapter = fixture.adapter;
+    REQUIRE(adapter != nullptr);
+
+    SECTION("invalid_config")
+    {
+        sd_rpc_evt_batch_config_t config = {0, 0};
+        REQUIRE(fixture.openBatch(&config) == NRF_ERROR_INVALID_PARAM);
+
+        config.max_batch_size = SD_RPC_EVT_BATCH_SIZE_MAX + 1;
+        REQUIRE(fixture.openBatch(&config) == NRF_ERROR_INVALID_PARAM);
+
+        REQUIRE(fixture.openBatch(nullptr) == NRF_ERROR_NULL);
+
+        config.max_batch_size = 16;
+        REQUIRE(sd_rpc_open_batch(nullptr, status_handler, event_batch_handler, log_handler,
+                                  &config) == NRF_ERROR_NULL);
+    }
+
+    SECTION("notifications")
+    {
+        const sd_rpc_evt_batch_config_t config = {16, 20};
+        REQUIRE(fixture.openBatch(&config) == NRF_SUCCESS);
+
+        REQUIRE(fixture.connect() == NRF_SUCCESS);
+        REQUIRE(fixture.waitForEvents(BLE_GAP_EVT_CONNECTED, 1));
+
+        fixture.simulator.setNotificationRate(ConnectivitySimulator::Unlimited, 64);
+        REQUIRE(fixture.waitForEvents(BLE_GATTC_EVT_HVX, 200));
+        fixture.simulator.setNotificationRate(0);
+
+        const auto events = fixture.events();
+        REQUIRE(events.lastHvxLength == 64);
+        REQUIRE(events.largestBatch > 1);
+        REQUIRE(events.largestBatch <= config.max_batch_size);
+        REQUIRE(events.batches < events.count(BLE_GATTC_EVT_HVX));
+    }
+}
+
+#endif // __linux__ && NRF_SD_BLE_API >= 6
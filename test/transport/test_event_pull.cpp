@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Logging support
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#if defined(__linux__) && NRF_SD_BLE_API >= 6
+
+#include <simulator_adapter.h>
+
+#include "ble.h"
+#include "internal/transport/serialization_transport.h"
+#include "sd_rpc.h"
+
+#include <poll.h>
+
+TEST_CASE("pull events")
+{
+    SimulatorAdapter fixture("pull");
+    const auto adapter = fixture.adapter;
+    REQUIRE(adapter != nullptr);
+
+    // Events are fetched on this thread, the buffer is aligned for ble_evt_t
+    uint32_t eventBuffer[128];
+    const auto event = reinterpret_cast<ble_evt_t *>(eventBuffer);
+
+    // Gets the pending events, returns the number of events taken
+    const auto pull_events = [&] {
+        uint32_t pulled = 0;
+        uint16_t length = sizeof(eventBuffer);
+        uint32_t errCode;
+
+        while ((errCode = sd_rpc_evt_get(adapter, reinterpret_cast<uint8_t *>(eventBuffer),
+                                         &length)) == NRF_SUCCESS)
+        {
+            REQUIRE(length == event->header.evt_len);
+            fixture.recordEvent(event);
+            length = sizeof(eventBuffer);
+            pulled++;
+        }
+
+        REQUIRE(errCode == NRF_ERROR_NOT_FOUND);
+        return pulled;
+    };
+
+    // Polls the descriptor and gets the events until count events of eventId are received
+    const auto poll_for_events = [&](const uint16_t eventId, const uint32_t count) {
+        pollfd fd = {sd_rpc_evt_fd(adapter), POLLIN, 0};
+
+        while (fixture.events().count(eventId) < count)
+        {
+            if (poll(&fd, 1, 5000) != 1)
+            {
+                return false;
+            }
+
+            pull_events();
+        }
+
+        return true;
+    };
+
+    uint16_t length = sizeof(eventBuffer);
+    REQUIRE(sd_rpc_evt_get(adapter, nullptr, &length) == NRF_ERROR_INVALID_STATE);
+    REQUIRE(sd_rpc_evt_fd(adapter) == -1);
+
+    REQUIRE(sd_rpc_open_pull(nullptr, nullptr, nullptr) == NRF_ERROR_NULL);
+    REQUIRE(fixture.openPull() == NRF_SUCCESS);
+    REQUIRE(sd_rpc_evt_fd(adapter) >= 0);
+    REQUIRE(sd_rpc_evt_get(adapter, nullptr, &length) == NRF_ERROR_NOT_FOUND);
+    REQUIRE(sd_rpc_evt_get(adapter, nullptr, nullptr) == NRF_ERROR_NULL);
+
+    REQUIRE(fixture.connect() == NRF_SUCCESS);
+    REQUIRE(poll_for_events(BLE_GAP_EVT_CONNECTED, 1));
+
+    SECTION("notifications")
+    {
+        fixture.simulator.setNotificationRate(1000, 64);
+        REQUIRE(poll_for_events(BLE_GATTC_EVT_HVX, 50));
+        fixture.simulator.setNotificationRate(0);
+        REQUIRE(fixture.events().lastHvxLength == 64);
+    }
+
+    SECTION("events_queued_at_close")
+    {
+        // An advertising report and notifications are queued and not pulled. The report data is
+        // in the scan buffer registered in the GAP state, the notifications are for a connection
+        // the connectivity firmware no longer has after the adapter is opened again.
+        uint8_t scanData[BLE_GAP_SCAN_BUFFER_MIN];
+        ble_data_t scanBuffer      = {scanData, sizeof(scanData)};
+        ble_gap_scan_params_t scan = {};
+        scan.interval              = 0x00A0;
+        scan.window                = 0x0050;
+        scan.scan_phys             = BLE_GAP_PHY_1MBPS;
+
+        fixture.simulator.setAdvertisingReportRate(ConnectivitySimulator::Unlimited);
+        REQUIRE(sd_ble_gap_scan_start(adapter, &scan, &scanBuffer) == NRF_SUCCESS);
+        fixture.simulator.setNotificationRate(1000, 64);
+
+        pollfd fd = {sd_rpc_evt_fd(adapter), POLLIN, 0};
+        REQUIRE(poll(&fd, 1, 5000) == 1);
+        fixture.simulator.setNotificationRate(0);
+
+        REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+
+        // Every event not pulled before close is dropped
+        sd_rpc_stats_t stats = {};
+        REQUIRE(sd_rpc_stats_get(adapter, &stats) == NRF_SUCCESS);
+        REQUIRE(stats.event_queue_depth == 0);
+        REQUIRE(stats.events_dropped > 0);
+        REQUIRE(stats.events_received == fixture.events().total() + stats.events_dropped);
+
+        // None of them is passed on after the adapter is opened again
+        REQUIRE(fixture.openPull() == NRF_SUCCESS);
+        fd.fd = sd_rpc_evt_fd(adapter);
+        REQUIRE(poll(&fd, 1, 0) == 0);
+        REQUIRE(sd_rpc_evt_get(adapter, nullptr, &length) == NRF_ERROR_NOT_FOUND);
+        REQUIRE(sd_ble_gap_tx_power_set(adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) == NRF_SUCCESS);
+    }
+
+    SECTION("length")
+    {
+        REQUIRE(sd_ble_gap_disconnect(adapter, fixture.events().lastConnHandle,
+                                      BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION) == NRF_SUCCESS);
+
+        pollfd fd = {sd_rpc_evt_fd(adapter), POLLIN, 0};
+        REQUIRE(poll(&fd, 1, 5000) == 1);
+
+        // The length of the next event is returned until the event is taken
+        uint16_t eventLength = 0;
+        REQUIRE(sd_rpc_evt_get(adapter, nullptr, &eventLength) == NRF_SUCCESS);
+        REQUIRE(eventLength > 0);
+
+        length = 1;
+        REQUIRE(sd_rpc_evt_get(adapter, reinterpret_cast<uint8_t *>(eventBuffer), &length) ==
+                NRF_ERROR_DATA_SIZE);
+        REQUIRE(length == eventLength);
+
+        length = sizeof(eventBuffer);
+        REQUIRE(sd_rpc_evt_get(adapter, reinterpret_cast<uint8_t *>(eventBuffer), &length) ==
+                NRF_SUCCESS);
+        REQUIRE(length == eventLength);
+        REQUIRE(event->header.evt_id == BLE_GAP_EVT_DISCONNECTED);
+
+        REQUIRE(sd_rpc_evt_get(adapter, nullptr, &length) == NRF_ERROR_NOT_FOUND);
+        REQUIRE(poll(&fd, 1, 0) == 0);
+    }
+
+    SECTION("queue_full")
+    {
+        // Nothing is pulled until more events are received than the transport keeps, the
+        // transport drops events instead of waiting for the application
+        fixture.simulator.setNotificationRate(ConnectivitySimulator::Unlimited, 64);
+        REQUIRE(fixture.waitFor(
+            [](const SimulatorAdapter::Events &events) { return events.dropped > 0; }));
+
+        // The queue is full before events are dropped
+        sd_rpc_stats_t stats = {};
+        REQUIRE(sd_rpc_stats_get(adapter, &stats) == NRF_SUCCESS);
+        REQUIRE(stats.events_dropped > 0);
+        REQUIRE(stats.event_queue_high_water_mark >= EventQueueCapacity);
+
+        // The default buffer pool holds the first events queued, the heap is used for the rest
+        sd_rpc_buffer_pool_stats_t poolStats = {};
+        REQUIRE(sd_rpc_buffer_pool_stats_get(adapter, &poolStats) == NRF_SUCCESS);
+        REQUIRE(poolStats.buffer_count > 256);
+        REQUIRE(poolStats.high_water_mark > 256);
+
+        // Commands are answered while the events are queued
+        REQUIRE(sd_ble_gap_tx_power_set(adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) == NRF_SUCCESS);
+        fixture.simulator.setNotificationRate(0);
+
+        // Every event received is either pulled or dropped
+        pollfd fd = {sd_rpc_evt_fd(adapter), POLLIN, 0};
+
+        while (poll(&fd, 1, 500) == 1)
+        {
+            pull_events();
+        }
+
+        REQUIRE(sd_rpc_stats_get(adapter, &stats) == NRF_SUCCESS);
+        REQUIRE(stats.event_queue_depth == 0);
+        REQUIRE(stats.events_received == fixture.events().total() + stats.events_dropped);
+    }
+
+    REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+    REQUIRE(sd_rpc_evt_fd(adapter) == -1);
+}
+
+#endif // __linux__ && NRF_SD_BLE_API >= 6
@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Logging support
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#if defined(__linux__) && NRF_SD_BLE_API >= 6
+
+#include <simulator_adapter.h>
+
+#include "ble.h"
+#include "internal/adapter_internal.h"
+#include "internal/app_ble_gap.h"
+#include "sd_rpc.h"
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Scan buffer of an adapter running GAP traffic next to another adapter
+struct ScanTraffic
+{
+    uint8_t scanData[BLE_GAP_SCAN_BUFFER_MIN];
+    ble_data_t scanBuffer{scanData, sizeof(scanData)};
+    std::atomic<bool> foreignScanData{false}; // A report was decoded outside the scan buffer
+};
+
+// GAP state the codecs of an adapter use
+adapter_ble_gap_state_t *gap_state(adapter_t *adapter)
+{
+    return static_cast<AdapterInternal *>(adapter->internal)->gapState.get();
+}
+
+} // namespace
+
+TEST_CASE("GAP state isolation")
+{
+    // Used by the event handlers until the adapters are closed
+    std::vector<std::unique_ptr<ScanTraffic>> traffic;
+    std::vector<std::unique_ptr<SimulatorAdapter>> fixtures;
+
+    for (auto i = 0; i < 2; i++)
+    {
+        fixtures.emplace_back(new SimulatorAdapter("gap-" + std::to_string(i)));
+        traffic.emplace_back(new ScanTraffic());
+        REQUIRE(fixtures.back()->adapter != nullptr);
+
+        const auto scan = traffic.back().get();
+
+        fixtures.back()->onEvent = [scan](adapter_t *adapter, ble_evt_t *event) {
+            if (event->header.evt_id != BLE_GAP_EVT_ADV_REPORT)
+            {
+                return;
+            }
+
+            // The report is decoded into the scan buffer kept in the GAP state of the adapter
+            const auto &data = event->evt.gap_evt.params.adv_report.data;
+
+            if (data.p_data < scan->scanData ||
+                data.p_data + data.len > scan->scanData + sizeof(scan->scanData))
+            {
+                scan->foreignScanData = true;
+            }
+
+            sd_ble_gap_scan_start(adapter, nullptr, &scan->scanBuffer);
+        };
+    }
+
+    SECTION("scanning_and_notifications")
+    {
+        REQUIRE(gap_state(fixtures[0]->adapter) != nullptr);
+        REQUIRE(gap_state(fixtures[0]->adapter) != gap_state(fixtures[1]->adapter));
+
+        ble_gap_scan_params_t scan = {};
+        scan.interval              = 0x00A0;
+        scan.window                = 0x0050;
+        scan.scan_phys             = BLE_GAP_PHY_1MBPS;
+
+        // Each adapter decodes events with its own GAP state on its own event thread, and runs
+        // commands on this thread
+        for (auto i = 0; i < 2; i++)
+        {
+            auto &fixture = *fixtures[i];
+
+            REQUIRE(fixture.open() == NRF_SUCCESS);
+            REQUIRE(fixture.connect() == NRF_SUCCESS);
+            REQUIRE(sd_ble_gap_scan_start(fixture.adapter, &scan, &traffic[i]->scanBuffer) ==
+                    NRF_SUCCESS);
+
+            fixture.simulator.setNotificationRate(ConnectivitySimulator::Unlimited);
+            fixture.simulator.setAdvertisingReportRate(ConnectivitySimulator::Unlimited);
+        }
+
+        for (auto i = 0; i < 20; i++)
+        {
+            for (const auto &fixture : fixtures)
+            {
+                REQUIRE(sd_ble_gap_tx_power_set(fixture->adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0,
+                                                0) == NRF_SUCCESS);
+            }
+        }
+
+        for (const auto &fixture : fixtures)
+        {
+            REQUIRE(fixture->waitFor([](const SimulatorAdapter::Events &events) {
+                return events.count(BLE_GAP_EVT_ADV_REPORT) >= 200 &&
+                       events.count(BLE_GATTC_EVT_HVX) >= 200;
+            }));
+        }
+
+        for (auto i = 0; i < 2; i++)
+        {
+            fixtures[i]->simulator.setNotificationRate(0);
+            fixtures[i]->simulator.setAdvertisingReportRate(0);
+            REQUIRE(sd_ble_gap_scan_stop(fixtures[i]->adapter) == NRF_SUCCESS);
+            REQUIRE(sd_rpc_close(fixtures[i]->adapter) == NRF_SUCCESS);
+            REQUIRE_FALSE(traffic[i]->foreignScanData);
+        }
+    }
+
+    SECTION("failed_open")
+    {
+        auto &fixture    = *fixtures[0];
+        const auto other = fixtures[1]->adapter;
+
+        REQUIRE(fixtures[1]->open() == NRF_SUCCESS);
+
+        // Opening an open adapter fails and keeps it open
+        REQUIRE(fixtures[1]->open() != NRF_SUCCESS);
+        REQUIRE(sd_ble_gap_tx_power_set(other, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) == NRF_SUCCESS);
+
+        // An adapter that fails to open does not affect the other adapter
+        fixture.simulator.stop();
+        REQUIRE(fixture.open() != NRF_SUCCESS);
+        REQUIRE(sd_ble_gap_tx_power_set(other, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) == NRF_SUCCESS);
+
+        REQUIRE(sd_rpc_close(other) == NRF_SUCCESS);
+    }
+}
+
+#endif // __linux__ && NRF_SD_BLE_API >= 6
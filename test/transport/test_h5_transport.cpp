@@ -46,10 +46,13 @@
 #include <transport.h>
 #include <h5_transport.h>
 #include <h5.h>
+#include <slip.h>
+#include <transport_stats.h>
 #include <nrf_error.h>
 
 #include <test_setup.h>
 
+#include <algorithm>
 #include <sstream>
 #include <string>
 #include <utility>
@@ -57,6 +60,8 @@
 #include <thread>
 #include <iomanip>
 #include <chrono>
+#include <future>
+#include <mutex>
 
 #if defined(_MSC_VER)
 // Disable warning "This function or variable may be unsafe. Consider using _dupenv_s instead."
@@ -66,9 +71,11 @@
 class H5TransportTestSetup
 {
 public:
-    H5TransportTestSetup(std::string transportName, Transport *lowerTransport): name(std::move(transportName))
+    H5TransportTestSetup(std::string transportName, Transport *lowerTransport, uint32_t ackDelay = 0,
+                         uint8_t slidingWindowSize = SlidingWindowSizeMax): name(std::move(transportName))
     {
-        transport = std::make_shared<test::H5TransportWrapper>(lowerTransport, 250);
+        transport = std::make_shared<test::H5TransportWrapper>(lowerTransport, 250, ackDelay,
+                                                               slidingWindowSize);
     }
 
     void statusCallback(const sd_rpc_app_status_t code, const std::string &message) const
@@ -78,7 +85,9 @@ public:
 
     void dataCallback(const uint8_t *data, const size_t length)
     {
+        std::lock_guard<std::mutex> lck(incomingMutex);
         incoming.assign(data, data + length);
+        incomingCount++;
         NRF_LOG("[" << name << "][data]<- " << testutil::asHex(incoming) << " length: " << length);
     }
 
@@ -117,19 +126,254 @@ public:
         return transport->close();
     }
 
-    payload_t in() const
+    payload_t in()
     {
+        std::lock_guard<std::mutex> lck(incomingMutex);
         return incoming;
     }
 
+    uint32_t inCount()
+    {
+        std::lock_guard<std::mutex> lck(incomingMutex);
+        return incomingCount;
+    }
+
 private:
     std::shared_ptr<test::H5TransportWrapper> transport;
+    std::mutex incomingMutex;
     payload_t incoming;
+    uint32_t incomingCount = 0;
     const std::string name;
 };
 
 const auto NUMBER_OF_ITERATIONS = 100;
 
+TEST_CASE("slip")
+{
+    NRF_LOG("slip_find_special implementation: " << slip_find_special_implementation());
+
+    SECTION("find_special")
+    {
+        // Place END and ESC at every position of buffers spanning several SIMD blocks
+        for (size_t length = 0; length < 100; length++)
+        {
+            for (size_t position = 0; position < length; position++)
+            {
+                for (const uint8_t special : {0xc0, 0xdb})
+                {
+                    payload_t data(length, 0xdc);
+                    data[position] = special;
+
+                    REQUIRE(slip_find_special(data.data(), data.size()) == position);
+                }
+            }
+
+            const payload_t data(length, 0x01);
+            REQUIRE(slip_find_special(data.data(), data.size()) == length);
+        }
+    }
+
+    SECTION("encode_decode")
+    {
+        payload_t packet;
+
+        for (size_t i = 0; i < 300; i++)
+        {
+            packet.push_back(static_cast<uint8_t>(i * 7));
+        }
+
+        payload_t encoded{0xaa};
+        slip_encode(packet, encoded);
+
+        // slip_encode appends to the output
+        REQUIRE(encoded.front() == 0xaa);
+        REQUIRE(encoded[1] == 0xc0);
+        REQUIRE(encoded.back() == 0xc0);
+        REQUIRE(std::count(encoded.begin() + 2, encoded.end() - 1, 0xc0) == 0);
+
+        payload_t decoded;
+        REQUIRE(slip_decode(payload_t(encoded.begin() + 1, encoded.end()), decoded) ==
+                NRF_SUCCESS);
+        REQUIRE(decoded == packet);
+
+        payload_t invalid{0xc0, 0x01, 0xdb};
+        REQUIRE(slip_decode(invalid, decoded) == NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_DECODING);
+    }
+
+    SECTION("h5_slip_encode")
+    {
+        payload_t reused;
+
+        for (size_t length = 0; length < 300; length += 37)
+        {
+            payload_t payload;
+
+            for (size_t i = 0; i < length; i++)
+            {
+                payload.push_back(static_cast<uint8_t>(0xc0 + i % 0x20));
+            }
+
+            for (const auto crc_present : {false, true})
+            {
+                payload_t h5Packet;
+                h5_encode(payload, h5Packet, 5, 2, crc_present, crc_present,
+                          VENDOR_SPECIFIC_PACKET);
+
+                payload_t expected;
+                slip_encode(h5Packet, expected);
+
+                // The fused encoder gives the same result as encoding in separate steps
+                h5_slip_encode(payload.data(), payload.size(), reused, 5, 2, crc_present,
+                               crc_present, VENDOR_SPECIFIC_PACKET);
+                REQUIRE(reused == expected);
+
+                // Splitting the payload into segments does not change the result
+                const auto split                     = length / 3;
+                const transport_segment_t segments[] = {
+                    {payload.data(), split}, {nullptr, 0}, {payload.data() + split, length - split}};
+                h5_slip_encode(segments, 3, reused, 5, 2, crc_present, crc_present,
+                               VENDOR_SPECIFIC_PACKET);
+                REQUIRE(reused == expected);
+
+                payload_t segmented;
+                h5_encode(segments, 3, segmented, 5, 2, crc_present, crc_present,
+                          VENDOR_SPECIFIC_PACKET);
+                REQUIRE(segmented == h5Packet);
+            }
+        }
+    }
+
+    SECTION("h5_set_ack_num")
+    {
+        const auto payload = payload_t{0xc0, 0x01, 0xdb, 0x02};
+
+        for (const auto crc_present : {false, true})
+        {
+            payload_t h5Packet;
+            h5_encode(payload, h5Packet, 3, 6, crc_present, true, VENDOR_SPECIFIC_PACKET);
+
+            REQUIRE_FALSE(h5_set_ack_num(h5Packet, 6));
+
+            for (uint8_t ack_num = 0; ack_num < 8; ack_num++)
+            {
+                payload_t expected;
+                h5_encode(payload, expected, 3, ack_num, crc_present, true,
+                          VENDOR_SPECIFIC_PACKET);
+
+                REQUIRE(h5_set_ack_num(h5Packet, ack_num) == (ack_num != 6));
+                REQUIRE(h5Packet == expected);
+
+                // Restore the original acknowledgement number for the next round
+                h5_set_ack_num(h5Packet, 6);
+            }
+        }
+    }
+}
+
+TEST_CASE("SlipDecoder")
+{
+    std::vector<payload_t> packets;
+    std::vector<uint32_t> errors;
+    std::vector<const uint8_t *> frames;
+
+    SlipDecoder decoder(
+        [&](const uint8_t *packet, const size_t length, const uint32_t err_code) {
+            packets.emplace_back(packet, packet + length);
+            errors.push_back(err_code);
+            frames.push_back(packet);
+        },
+        16);
+
+    SECTION("packets_split_across_reads")
+    {
+        const payload_t data{0x01, 0xc0, 0x01, 0xdb, 0xdc, 0x02, 0xc0, 0xc0, 0xdb, 0xdd, 0xc0};
+
+        // Feed the data one byte at a time
+        for (const auto byte : data)
+        {
+            decoder.decode(&byte, 1);
+        }
+
+        REQUIRE(packets.size() == 2);
+        REQUIRE(packets[0] == payload_t{0x01, 0xc0, 0x02});
+        REQUIRE(packets[1] == payload_t{0xdb});
+        REQUIRE(errors[0] == NRF_SUCCESS);
+        REQUIRE(errors[1] == NRF_SUCCESS);
+
+        // The same frame buffer is used for all packets
+        REQUIRE(frames[0] == frames[1]);
+    }
+
+    SECTION("consecutive_c0_starts_new_packet")
+    {
+        const payload_t data{0xc0, 0xc0, 0x05, 0x06, 0xc0};
+        decoder.decode(data.data(), data.size());
+
+        REQUIRE(packets.size() == 1);
+        REQUIRE(packets[0] == payload_t{0x05, 0x06});
+    }
+
+    SECTION("invalid_escape")
+    {
+        const payload_t data{0xc0, 0x01, 0xdb, 0x01, 0xc0, 0xc0,
+                             0x02, 0xdb, 0xc0, 0xc0, 0x03, 0xc0};
+        decoder.decode(data.data(), data.size());
+
+        REQUIRE(packets.size() == 3);
+        REQUIRE(errors[0] == NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_DECODING);
+        REQUIRE(errors[1] == NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_DECODING);
+        REQUIRE(errors[2] == NRF_SUCCESS);
+        REQUIRE(packets[2] == payload_t{0x03});
+    }
+
+    SECTION("packet_too_large")
+    {
+        payload_t data(20, 0x01);
+        data.front() = 0xc0;
+        data.back()  = 0xc0;
+        decoder.decode(data.data(), data.size());
+
+        REQUIRE(packets.size() == 1);
+        REQUIRE(errors[0] == NRF_ERROR_SD_RPC_H5_TRANSPORT_SLIP_PAYLOAD_SIZE);
+    }
+
+    SECTION("h5_decode_in_place")
+    {
+        payload_t h5Packet;
+        h5_encode(payload_t{0x0a, 0x0b, 0x0c}, h5Packet, 3, 5, true, true, VENDOR_SPECIFIC_PACKET);
+
+        payload_t slipPacket;
+        slip_encode(h5Packet, slipPacket);
+        decoder.decode(slipPacket.data(), slipPacket.size());
+
+        REQUIRE(packets.size() == 1);
+        REQUIRE(packets[0] == h5Packet);
+
+        const uint8_t *payload = nullptr;
+        uint8_t seq_num;
+        uint8_t ack_num;
+        bool reliable_packet;
+        h5_pkt_type_t packet_type;
+        uint16_t payload_length;
+
+        REQUIRE(h5_decode(h5Packet.data(), h5Packet.size(), &payload, &seq_num, &ack_num, nullptr,
+                          &payload_length, nullptr, &reliable_packet,
+                          &packet_type) == NRF_SUCCESS);
+        REQUIRE(payload == h5Packet.data() + H5_HEADER_LENGTH);
+        REQUIRE(payload_length == 3);
+        REQUIRE(seq_num == 3);
+        REQUIRE(ack_num == 5);
+        REQUIRE(reliable_packet);
+        REQUIRE(packet_type == VENDOR_SPECIFIC_PACKET);
+
+        // Corrupt the payload
+        h5Packet[5] ^= 0xff;
+        REQUIRE(h5_decode(h5Packet.data(), h5Packet.size(), &payload, &seq_num, &ack_num, nullptr,
+                          &payload_length, nullptr, &reliable_packet,
+                          &packet_type) == NRF_ERROR_SD_RPC_H5_TRANSPORT_PACKET_CHECKSUM);
+    }
+}
+
 TEST_CASE("H5TransportWrapper")
 {
     SECTION("open_close")
@@ -294,4 +538,233 @@ TEST_CASE("H5Transport")
         REQUIRE(h5TransportB.close() == NRF_SUCCESS);
         REQUIRE(h5TransportB.state() == STATE_CLOSED);
     }
+
+    SECTION("sliding_window")
+    {
+        auto transportA = new VirtualUart("uartA");
+        auto transportB = new VirtualUart("uartB");
+
+        // Connect the two virtual UARTs together
+        transportA->setPeer(transportB);
+        transportB->setPeer(transportA);
+
+        // Ownership of transport is transferred to H5TransportWrapper
+        H5TransportTestSetup h5TransportA("transportA", transportA);
+        H5TransportTestSetup h5TransportB("transportB", transportB);
+
+        h5TransportA.setup();
+        h5TransportB.setup();
+
+        REQUIRE(h5TransportA.wait() == NRF_SUCCESS);
+        REQUIRE(h5TransportB.wait() == NRF_SUCCESS);
+
+        // Both ends support the largest window
+        REQUIRE(h5TransportA.get()->slidingWindowSize() == SlidingWindowSizeMax);
+        REQUIRE(h5TransportB.get()->slidingWindowSize() == SlidingWindowSizeMax);
+
+        // Send more packets than there are sequence numbers, the sender must wrap around and
+        // block when the window is full
+        const uint8_t packetCount = 20;
+
+        for (uint8_t i = 0; i < packetCount; i++)
+        {
+            REQUIRE(h5TransportA.get()->send(payload_t{i, i, i}) == NRF_SUCCESS);
+        }
+
+        // Wait for data to be sent between transports
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+
+        REQUIRE(h5TransportB.inCount() == packetCount);
+        const auto lastPayload = payload_t{packetCount - 1, packetCount - 1, packetCount - 1};
+        REQUIRE(h5TransportB.in() == lastPayload);
+
+        REQUIRE(h5TransportA.close() == NRF_SUCCESS);
+        REQUIRE(h5TransportB.close() == NRF_SUCCESS);
+    }
+
+    SECTION("close_with_sender_waiting_for_window")
+    {
+        auto transportA = new VirtualUart("uartA");
+        auto transportB = new VirtualUart("uartB");
+
+        // Connect the two virtual UARTs together
+        transportA->setPeer(transportB);
+        transportB->setPeer(transportA);
+
+        // Ownership of transport is transferred to H5TransportWrapper
+        H5TransportTestSetup h5TransportA("transportA", transportA);
+        H5TransportTestSetup h5TransportB("transportB", transportB);
+
+        h5TransportA.setup();
+        h5TransportB.setup();
+
+        REQUIRE(h5TransportA.wait() == NRF_SUCCESS);
+        REQUIRE(h5TransportB.wait() == NRF_SUCCESS);
+
+        // B stops acknowledging, A fills its window and the next sender waits for room
+        REQUIRE(h5TransportB.close() == NRF_SUCCESS);
+
+        for (uint8_t i = 0; i < SlidingWindowSizeMax; i++)
+        {
+            REQUIRE(h5TransportA.get()->send(payload_t{i}) == NRF_SUCCESS);
+        }
+
+        auto blockedSend = std::async(std::launch::async, [&h5TransportA] {
+            return h5TransportA.get()->send(payload_t{0xff});
+        });
+
+        REQUIRE(blockedSend.wait_for(std::chrono::milliseconds(100)) ==
+                std::future_status::timeout);
+
+        // close does not wait for the sender, the sender returns when the transport is closed
+        const auto start = std::chrono::steady_clock::now();
+        REQUIRE(h5TransportA.close() == NRF_SUCCESS);
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(250));
+
+        REQUIRE(blockedSend.wait_for(std::chrono::seconds(1)) == std::future_status::ready);
+        REQUIRE(blockedSend.get() == NRF_ERROR_SD_RPC_H5_TRANSPORT_STATE);
+    }
+
+    SECTION("delayed_ack")
+    {
+        auto transportA = new VirtualUart("uartA");
+        auto transportB = new VirtualUart("uartB");
+
+        // Connect the two virtual UARTs together
+        transportA->setPeer(transportB);
+        transportB->setPeer(transportA);
+
+        // Ownership of transport is transferred to H5TransportWrapper
+        H5TransportTestSetup h5TransportA("transportA", transportA);
+        H5TransportTestSetup h5TransportB("transportB", transportB, 100);
+
+        h5TransportA.setup();
+        h5TransportB.setup();
+
+        REQUIRE(h5TransportA.wait() == NRF_SUCCESS);
+        REQUIRE(h5TransportB.wait() == NRF_SUCCESS);
+
+        // Transport B acknowledges the packets from A with ACK packets when the delay expires
+        // or when half of the sliding window is used
+        const uint8_t packetCount = 20;
+
+        for (uint8_t i = 0; i < packetCount; i++)
+        {
+            REQUIRE(h5TransportA.get()->send(payload_t{i}) == NRF_SUCCESS);
+        }
+
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        REQUIRE(h5TransportB.inCount() == packetCount);
+
+        // Acknowledgement of the packet from A is sent with the reply from B
+        REQUIRE(h5TransportA.get()->send(payload_t{0x01, 0x02}) == NRF_SUCCESS);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        REQUIRE(h5TransportB.get()->send(payload_t{0x03, 0x04}) == NRF_SUCCESS);
+
+        std::this_thread::sleep_for(std::chrono::seconds(1));
+        REQUIRE(h5TransportB.inCount() == packetCount + 1);
+        REQUIRE(h5TransportA.inCount() == 1);
+        REQUIRE(h5TransportA.in() == payload_t{0x03, 0x04});
+
+        REQUIRE(h5TransportA.close() == NRF_SUCCESS);
+        REQUIRE(h5TransportB.close() == NRF_SUCCESS);
+    }
+
+    SECTION("delayed_ack_window_one")
+    {
+        auto transportA = new VirtualUart("uartA");
+        auto transportB = new VirtualUart("uartB");
+
+        // Connect the two virtual UARTs together
+        transportA->setPeer(transportB);
+        transportB->setPeer(transportA);
+
+        // Ownership of transport is transferred to H5TransportWrapper. A only supports a window
+        // of one packet, like the connectivity firmware.
+        H5TransportTestSetup h5TransportA("transportA", transportA, 0, 1);
+        H5TransportTestSetup h5TransportB("transportB", transportB, 100);
+
+        const auto statsB = std::make_shared<TransportStats>();
+        h5TransportB.get()->setTransportStats(statsB);
+
+        const auto packetsSentByB = [&statsB] {
+            sd_rpc_stats_t stats = {};
+            statsB->stats(&stats);
+            return stats.packets_sent;
+        };
+
+        h5TransportA.setup();
+        h5TransportB.setup();
+
+        REQUIRE(h5TransportA.wait() == NRF_SUCCESS);
+        REQUIRE(h5TransportB.wait() == NRF_SUCCESS);
+
+        REQUIRE(h5TransportA.get()->slidingWindowSize() == 1);
+        REQUIRE(h5TransportB.get()->slidingWindowSize() == 1);
+
+        // A sends the second packet when B acknowledges the first one, B delays the
+        // acknowledgement until the delay expires
+        auto sent        = packetsSentByB();
+        const auto start = std::chrono::steady_clock::now();
+
+        REQUIRE(h5TransportA.get()->send(payload_t{0x01}) == NRF_SUCCESS);
+        REQUIRE(h5TransportA.get()->send(payload_t{0x02}) == NRF_SUCCESS);
+
+        const auto elapsed = std::chrono::steady_clock::now() - start;
+        REQUIRE(elapsed >= std::chrono::milliseconds(90));
+        REQUIRE(elapsed < std::chrono::milliseconds(250)); // Before A retransmits
+        REQUIRE(packetsSentByB() == sent + 1);
+
+        // Acknowledgement of the second packet is sent with the reply from B
+        sent = packetsSentByB();
+        REQUIRE(h5TransportB.get()->send(payload_t{0x03}) == NRF_SUCCESS);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        REQUIRE(h5TransportB.inCount() == 2);
+        REQUIRE(h5TransportA.inCount() == 1);
+        REQUIRE(packetsSentByB() == sent + 1);
+
+        REQUIRE(h5TransportA.close() == NRF_SUCCESS);
+        REQUIRE(h5TransportB.close() == NRF_SUCCESS);
+    }
+
+    SECTION("rtt_estimate")
+    {
+        auto transportA = new VirtualUart("uartA");
+        auto transportB = new VirtualUart("uartB");
+
+        // Connect the two virtual UARTs together
+        transportA->setPeer(transportB);
+        transportB->setPeer(transportA);
+
+        // Ownership of transport is transferred to H5TransportWrapper
+        H5TransportTestSetup h5TransportA("transportA", transportA);
+        H5TransportTestSetup h5TransportB("transportB", transportB);
+
+        h5TransportA.setup();
+        h5TransportB.setup();
+
+        REQUIRE(h5TransportA.wait() == NRF_SUCCESS);
+        REQUIRE(h5TransportB.wait() == NRF_SUCCESS);
+
+        // No round-trip time measured yet, the retransmission interval is used
+        auto estimate = h5TransportA.get()->rttEstimate();
+        REQUIRE(estimate.sample_count == 0);
+        REQUIRE(estimate.rto == 250);
+
+        for (uint8_t i = 0; i < 5; i++)
+        {
+            REQUIRE(h5TransportA.get()->send(payload_t{i}) == NRF_SUCCESS);
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+
+        // The virtual UARTs are fast, the retransmission timeout is lowered towards the minimum
+        estimate = h5TransportA.get()->rttEstimate();
+        REQUIRE(estimate.sample_count == 5);
+        REQUIRE(estimate.rto < 250);
+        REQUIRE(estimate.rto >= 20);
+
+        REQUIRE(h5TransportA.close() == NRF_SUCCESS);
+        REQUIRE(h5TransportB.close() == NRF_SUCCESS);
+    }
 }
@@ -0,0 +1,258 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Logging support
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#if defined(__linux__) && NRF_SD_BLE_API >= 6
+
+#include <simulator_adapter.h>
+
+#include "ble.h"
+#include "sd_rpc.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Checks the order and concurrency of the events handled for an adapter
+struct EventOrder
+{
+    std::atomic<bool> inHandler{false};
+    std::atomic<bool> overlapped{false}; // The handler was entered while handling an event
+    std::atomic<bool> outOfOrder{false}; // A notification was handled before the connection
+    std::atomic<bool> connected{false};
+
+    void handle(const ble_evt_t *event)
+    {
+        if (inHandler.exchange(true))
+        {
+            overlapped = true;
+        }
+
+        if (event->header.evt_id == BLE_GAP_EVT_CONNECTED)
+        {
+            connected = true;
+        }
+        else if (event->header.evt_id == BLE_GATTC_EVT_HVX && !connected)
+        {
+            outOfOrder = true;
+        }
+
+        inHandler = false;
+    }
+};
+
+// Holds up the event handler of an adapter at the first notification, until the test releases it
+struct StalledConsumer
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    bool stalled  = false;
+    bool released = false;
+
+    void handle(const ble_evt_t *event)
+    {
+        if (event->header.evt_id != BLE_GATTC_EVT_HVX)
+        {
+            return;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        stalled = true;
+        changed.notify_all();
+        changed.wait(lock, [this] { return released; });
+    }
+
+    void release()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        released = true;
+        changed.notify_all();
+    }
+};
+
+// Releases a stalled consumer when it goes out of scope, also when a check fails, so the adapters
+// can be closed
+struct ReleaseOnExit
+{
+    StalledConsumer &consumer;
+
+    ~ReleaseOnExit()
+    {
+        consumer.release();
+    }
+};
+
+} // namespace
+
+TEST_CASE("shared runtime")
+{
+    sd_rpc_runtime_config_t config = {0, 1};
+    REQUIRE(sd_rpc_runtime_create(&config) == nullptr);
+
+    config = {1, SD_RPC_RUNTIME_THREADS_MAX + 1};
+    REQUIRE(sd_rpc_runtime_create(&config) == nullptr);
+    REQUIRE(sd_rpc_runtime_create(nullptr) == nullptr);
+    REQUIRE(sd_rpc_adapter_create_with_runtime(nullptr, nullptr) == nullptr);
+
+    // All adapters share one I/O and one dispatch thread
+    config             = {1, 1};
+    const auto runtime = sd_rpc_runtime_create(&config);
+    REQUIRE(runtime != nullptr);
+
+    // Used by the event handlers until the adapters are closed
+    std::vector<std::unique_ptr<EventOrder>> order;
+    std::vector<std::unique_ptr<SimulatorAdapter>> fixtures;
+
+    for (auto i = 0; i < 2; i++)
+    {
+        fixtures.emplace_back(new SimulatorAdapter("runtime-" + std::to_string(i), runtime));
+        order.emplace_back(new EventOrder());
+        REQUIRE(fixtures.back()->adapter != nullptr);
+
+        const auto events        = order.back().get();
+        fixtures.back()->onEvent = [events](adapter_t *, ble_evt_t *event) {
+            events->handle(event);
+        };
+    }
+
+    // The adapters keep the runtime running
+    REQUIRE(sd_rpc_runtime_delete(runtime) == NRF_SUCCESS);
+    REQUIRE(sd_rpc_runtime_delete(runtime) == NRF_ERROR_INVALID_STATE);
+    REQUIRE(sd_rpc_runtime_delete(nullptr) == NRF_ERROR_NULL);
+
+    for (const auto &fixture : fixtures)
+    {
+        REQUIRE(fixture->open() == NRF_SUCCESS);
+        REQUIRE(fixture->connect() == NRF_SUCCESS);
+    }
+
+    for (const auto &fixture : fixtures)
+    {
+        fixture->simulator.setNotificationRate(ConnectivitySimulator::Unlimited, 64);
+    }
+
+    for (const auto &fixture : fixtures)
+    {
+        REQUIRE(fixture->waitForEvents(BLE_GATTC_EVT_HVX, 200));
+    }
+
+    for (const auto &fixture : fixtures)
+    {
+        fixture->simulator.setNotificationRate(0);
+    }
+
+    for (auto i = 0; i < 2; i++)
+    {
+        REQUIRE(sd_rpc_close(fixtures[i]->adapter) == NRF_SUCCESS);
+        REQUIRE(fixtures[i]->events().count(BLE_GAP_EVT_CONNECTED) == 1);
+        REQUIRE_FALSE(order[i]->outOfOrder);
+        REQUIRE_FALSE(order[i]->overlapped);
+    }
+}
+
+TEST_CASE("shared runtime isolation")
+{
+    // The adapters share one I/O thread, the event handler of the stalled adapter holds one of the
+    // dispatch threads
+    sd_rpc_runtime_config_t config = {1, 2};
+    const auto runtime             = sd_rpc_runtime_create(&config);
+    REQUIRE(runtime != nullptr);
+
+    StalledConsumer consumer;
+    SimulatorAdapter stalled("stalled", runtime);
+    SimulatorAdapter running("running", runtime);
+    REQUIRE(stalled.adapter != nullptr);
+    REQUIRE(running.adapter != nullptr);
+    REQUIRE(sd_rpc_runtime_delete(runtime) == NRF_SUCCESS);
+
+    const ReleaseOnExit releaseOnExit{consumer};
+    stalled.onEvent = [&consumer](adapter_t *, ble_evt_t *event) { consumer.handle(event); };
+
+    REQUIRE(stalled.open() == NRF_SUCCESS);
+    REQUIRE(running.open() == NRF_SUCCESS);
+    REQUIRE(stalled.connect() == NRF_SUCCESS);
+    REQUIRE(running.connect() == NRF_SUCCESS);
+
+    // The stalled adapter receives events until it runs out of room for them
+    stalled.simulator.setNotificationRate(ConnectivitySimulator::Unlimited, 64);
+
+    {
+        std::unique_lock<std::mutex> lock(consumer.mutex);
+        REQUIRE(consumer.changed.wait_for(lock, SimulatorAdapter::WaitTimeout,
+                                          [&] { return consumer.stalled; }));
+    }
+
+    REQUIRE(stalled.waitFor(
+        [](const SimulatorAdapter::Events &events) { return events.dropped > 0; }));
+
+    sd_rpc_stats_t stats = {};
+    REQUIRE(sd_rpc_stats_get(stalled.adapter, &stats) == NRF_SUCCESS);
+    REQUIRE(stats.events_dropped > 0);
+
+    // The other adapter keeps running commands and handling events on the shared threads
+    running.simulator.setNotificationRate(ConnectivitySimulator::Unlimited, 64);
+
+    for (auto i = 0; i < 10; i++)
+    {
+        REQUIRE(sd_ble_gap_tx_power_set(running.adapter, BLE_GAP_TX_POWER_ROLE_ADV, 0, 0) ==
+                NRF_SUCCESS);
+    }
+
+    REQUIRE(running.waitForEvents(BLE_GATTC_EVT_HVX, 200));
+
+    running.simulator.setNotificationRate(0);
+    stalled.simulator.setNotificationRate(0);
+    consumer.release();
+
+    REQUIRE(sd_rpc_close(running.adapter) == NRF_SUCCESS);
+    REQUIRE(sd_rpc_close(stalled.adapter) == NRF_SUCCESS);
+    REQUIRE(running.events().count(BLE_GAP_EVT_CONNECTED) == 1);
+}
+
+#endif // __linux__ && NRF_SD_BLE_API >= 6
@@ -0,0 +1,141 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <spsc_ring.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+TEST_CASE("spsc_ring")
+{
+    SECTION("push_pop")
+    {
+        SpscRing<std::unique_ptr<int>> ring(3);
+        REQUIRE(ring.capacity() == 4);
+        REQUIRE(ring.empty());
+
+        for (auto i = 0; i < 4; i++)
+        {
+            REQUIRE(ring.push(std::unique_ptr<int>(new int(i))));
+        }
+
+        // A failed push leaves the item with the caller
+        std::unique_ptr<int> extra(new int(4));
+        REQUIRE_FALSE(ring.push(std::move(extra)));
+        REQUIRE(extra != nullptr);
+        REQUIRE(ring.size() == 4);
+
+        std::unique_ptr<int> item;
+
+        for (auto i = 0; i < 4; i++)
+        {
+            REQUIRE(ring.pop(item));
+            REQUIRE(*item == i);
+        }
+
+        REQUIRE_FALSE(ring.pop(item));
+        REQUIRE(ring.empty());
+
+        // Indexes wrap around
+        for (auto i = 0; i < 10; i++)
+        {
+            REQUIRE(ring.push(std::unique_ptr<int>(new int(i))));
+            REQUIRE(ring.pop(item));
+            REQUIRE(*item == i);
+        }
+    }
+
+    SECTION("producer_consumer")
+    {
+        constexpr uint32_t itemCount = 200000;
+
+        SpscRing<uint32_t> ring(16);
+        std::atomic<bool> stopped(false);
+        uint32_t received = 0;
+        bool inOrder      = true;
+
+        std::thread consumer([&] {
+            uint32_t item;
+
+            while (received < itemCount)
+            {
+                ring.waitWhileEmpty([&] { return stopped.load(); });
+
+                while (ring.pop(item))
+                {
+                    inOrder = inOrder && item == received;
+                    received++;
+                }
+            }
+        });
+
+        for (uint32_t i = 0; i < itemCount; i++)
+        {
+            auto item = i;
+
+            while (!ring.push(std::move(item)))
+            {
+                ring.waitWhileFull([&] { return stopped.load(); });
+            }
+        }
+
+        consumer.join();
+
+        REQUIRE(received == itemCount);
+        REQUIRE(inOrder);
+    }
+
+    SECTION("wake_all")
+    {
+        SpscRing<uint32_t> ring(4);
+        std::atomic<bool> stopped(false);
+
+        std::thread consumer([&] { ring.waitWhileEmpty([&] { return stopped.load(); }); });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        stopped = true;
+        ring.wakeAll();
+        consumer.join();
+
+        REQUIRE(ring.empty());
+    }
+}
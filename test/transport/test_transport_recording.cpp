@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Logging support
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#if defined(__linux__) && NRF_SD_BLE_API >= 6
+
+#include <connectivity_simulator.h>
+
+#include "ble.h"
+#include "replay_transport.h"
+#include "sd_rpc.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <unistd.h>
+
+namespace {
+
+struct ReceivedEvents
+{
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::map<uint16_t, uint32_t> counts;
+    uint16_t lastConnHandle;
+} received;
+
+void event_handler(adapter_t *, ble_evt_t *event)
+{
+    std::lock_guard<std::mutex> lock(received.mutex);
+    received.counts[event->header.evt_id]++;
+    received.lastConnHandle = event->evt.gap_evt.conn_handle;
+    received.changed.notify_all();
+}
+
+void status_handler(adapter_t *, sd_rpc_app_status_t, const char *) {}
+
+void log_handler(adapter_t *, sd_rpc_log_severity_t, const char *message)
+{
+    NRF_LOG(message);
+}
+
+bool wait_for_events(const uint16_t eventId, const uint32_t count)
+{
+    std::unique_lock<std::mutex> lock(received.mutex);
+    return received.changed.wait_for(lock, std::chrono::seconds(5),
+                                     [&] { return received.counts[eventId] >= count; });
+}
+
+std::map<uint16_t, uint32_t> take_events()
+{
+    std::lock_guard<std::mutex> lock(received.mutex);
+    std::map<uint16_t, uint32_t> counts;
+    std::swap(counts, received.counts);
+    return counts;
+}
+
+adapter_t *create_adapter(physical_layer_t *phy)
+{
+    const auto data_link_layer = sd_rpc_data_link_layer_create_bt_three_wire(phy, 250);
+    const auto transport_layer = sd_rpc_transport_layer_create(data_link_layer, 1000);
+    return sd_rpc_adapter_create(transport_layer);
+}
+
+// Connects, receives notifications until at least notificationCount are received and disconnects.
+// Returns the number of notifications received before disconnecting.
+uint32_t run_session(adapter_t *adapter, const uint32_t notificationCount,
+                     ConnectivitySimulator *simulator)
+{
+    ble_gap_addr_t peer          = {};
+    ble_gap_scan_params_t scan   = {};
+    ble_gap_conn_params_t params = {};
+    scan.interval                = 0x00A0;
+    scan.window                  = 0x0050;
+    scan.scan_phys               = BLE_GAP_PHY_1MBPS;
+    params.min_conn_interval     = BLE_GAP_CP_MIN_CONN_INTVL_MIN;
+    params.max_conn_interval     = BLE_GAP_CP_MIN_CONN_INTVL_MIN;
+    params.conn_sup_timeout      = 400;
+
+    REQUIRE(sd_rpc_open(adapter, status_handler, event_handler, log_handler) == NRF_SUCCESS);
+    REQUIRE(sd_ble_gap_connect(adapter, &peer, &scan, &params, BLE_CONN_CFG_TAG_DEFAULT) ==
+            NRF_SUCCESS);
+    REQUIRE(wait_for_events(BLE_GAP_EVT_CONNECTED, 1));
+
+    if (simulator != nullptr)
+    {
+        simulator->setNotificationRate(ConnectivitySimulator::Unlimited, 64);
+    }
+
+    REQUIRE(wait_for_events(BLE_GATTC_EVT_HVX, notificationCount));
+
+    if (simulator != nullptr)
+    {
+        simulator->setNotificationRate(0);
+    }
+
+    uint16_t connHandle;
+    uint32_t notificationsReceived;
+
+    {
+        std::lock_guard<std::mutex> lock(received.mutex);
+        connHandle            = received.lastConnHandle;
+        notificationsReceived = received.counts[BLE_GATTC_EVT_HVX];
+    }
+
+    REQUIRE(sd_ble_gap_disconnect(adapter, connHandle,
+                                  BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION) == NRF_SUCCESS);
+    REQUIRE(wait_for_events(BLE_GAP_EVT_DISCONNECTED, 1));
+
+    return notificationsReceived;
+}
+
+} // namespace
+
+TEST_CASE("transport_recording")
+{
+    const auto recordingPath =
+        "/tmp/ble-driver-recording-" + std::to_string(getpid()) + ".h5rec";
+
+    // Record a session with the simulator
+    ConnectivitySimulator simulator("/tmp/ble-driver-simulator-" + std::to_string(getpid()));
+    simulator.start();
+
+    const auto recording = sd_rpc_physical_layer_create_recording(
+        sd_rpc_physical_layer_create_local(simulator.path().c_str()), recordingPath.c_str());
+    REQUIRE(recording != nullptr);
+
+    auto adapter = create_adapter(recording);
+    REQUIRE(adapter != nullptr);
+
+    take_events();
+    const auto notificationsBeforeDisconnect = run_session(adapter, 50, &simulator);
+    REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+    sd_rpc_adapter_delete(adapter);
+    simulator.stop();
+
+    const auto recordedEvents = take_events();
+    REQUIRE(recordedEvents.at(BLE_GATTC_EVT_HVX) >= 50);
+
+    SECTION("replay")
+    {
+        const auto timing = GENERATE(SD_RPC_REPLAY_TIMING_FAST, SD_RPC_REPLAY_TIMING_ORIGINAL);
+
+        const auto replay = sd_rpc_physical_layer_create_replay(recordingPath.c_str(), timing);
+        REQUIRE(replay != nullptr);
+        const auto replayTransport = static_cast<ReplayTransport *>(replay->internal);
+
+        adapter = create_adapter(replay);
+        REQUIRE(adapter != nullptr);
+
+        // The application issues the same commands as when recording, the simulator is gone.
+        // Notifications received after disconnecting are replayed once disconnect is sent.
+        run_session(adapter, notificationsBeforeDisconnect, nullptr);
+        REQUIRE(replayTransport->waitForCompletion(std::chrono::seconds(5)));
+        REQUIRE(sd_rpc_close(adapter) == NRF_SUCCESS);
+        sd_rpc_adapter_delete(adapter);
+
+        REQUIRE(take_events() == recordedEvents);
+    }
+
+    SECTION("missing_recording")
+    {
+        const auto replay = sd_rpc_physical_layer_create_replay(
+            (recordingPath + ".missing").c_str(), SD_RPC_REPLAY_TIMING_FAST);
+        REQUIRE(replay != nullptr);
+
+        adapter = create_adapter(replay);
+        REQUIRE(adapter != nullptr);
+        REQUIRE(sd_rpc_open(adapter, status_handler, event_handler, log_handler) != NRF_SUCCESS);
+        sd_rpc_close(adapter);
+        sd_rpc_adapter_delete(adapter);
+    }
+
+    std::remove(recordingPath.c_str());
+}
+
+#endif // __linux__ && NRF_SD_BLE_API >= 6
@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#include <transport_stats.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace {
+sd_rpc_stats_t snapshot(const TransportStats &transportStats)
+{
+    sd_rpc_stats_t stats;
+    transportStats.stats(&stats);
+    return stats;
+}
+} // namespace
+
+TEST_CASE("transport_stats")
+{
+    SECTION("counters")
+    {
+        TransportStats transportStats;
+
+        transportStats.packetSent(10);
+        transportStats.packetSent(6);
+        transportStats.packetReceived();
+        transportStats.dataReceived(32);
+        transportStats.retransmission();
+        transportStats.decodeError();
+        transportStats.commandTimedOut();
+
+        const auto stats = snapshot(transportStats);
+        REQUIRE(stats.packets_sent == 2);
+        REQUIRE(stats.bytes_sent == 16);
+        REQUIRE(stats.packets_received == 1);
+        REQUIRE(stats.bytes_received == 32);
+        REQUIRE(stats.retransmissions == 1);
+        REQUIRE(stats.decode_errors == 1);
+        REQUIRE(stats.command_timeouts == 1);
+    }
+
+    SECTION("event_queue")
+    {
+        TransportStats transportStats;
+
+        transportStats.eventQueued();
+        transportStats.eventQueued();
+        transportStats.eventDequeued();
+        transportStats.eventQueued();
+        transportStats.eventDequeued();
+        transportStats.eventsDropped(1);
+
+        const auto stats = snapshot(transportStats);
+        REQUIRE(stats.events_received == 3);
+        REQUIRE(stats.event_queue_depth == 1);
+        REQUIRE(stats.event_queue_high_water_mark == 2);
+        REQUIRE(stats.events_dropped == 1);
+    }
+
+    SECTION("command_latency")
+    {
+        using std::chrono::microseconds;
+
+        TransportStats transportStats;
+
+        transportStats.commandCompleted(0x7C, microseconds(100));
+        transportStats.commandCompleted(0x7C, microseconds(128));
+        transportStats.commandCompleted(0x7C, microseconds(1000));
+        transportStats.commandCompleted(0x7C, std::chrono::seconds(100));
+        transportStats.commandCompleted(0x60, microseconds(255));
+
+        const auto stats    = snapshot(transportStats);
+        const auto &latency = stats.command_latency[0x7C];
+        REQUIRE(latency.count == 4);
+        REQUIRE(latency.max == 100000000);
+        REQUIRE(latency.total == 100001228);
+        REQUIRE(latency.buckets[0] == 1);
+        REQUIRE(latency.buckets[1] == 1);
+        REQUIRE(latency.buckets[3] == 1); // 512 to 1023 microseconds
+        REQUIRE(latency.buckets[SD_RPC_LATENCY_BUCKET_COUNT - 1] == 1);
+
+        REQUIRE(stats.command_latency[0x60].count == 1);
+        REQUIRE(stats.command_latency[0x60].buckets[1] == 1);
+        REQUIRE(stats.command_latency[0x61].count == 0);
+    }
+
+    SECTION("concurrent")
+    {
+        TransportStats transportStats;
+        std::vector<std::thread> threads;
+
+        for (auto i = 0; i < 4; i++)
+        {
+            threads.emplace_back([&transportStats] {
+                for (auto j = 0; j < 10000; j++)
+                {
+                    transportStats.packetSent(1);
+                    transportStats.commandCompleted(0x01, std::chrono::microseconds(j));
+                }
+            });
+        }
+
+        for (auto &thread : threads)
+        {
+            thread.join();
+        }
+
+        const auto stats = snapshot(transportStats);
+        REQUIRE(stats.packets_sent == 40000);
+        REQUIRE(stats.command_latency[0x01].count == 40000);
+        REQUIRE(stats.command_latency[0x01].max == 9999);
+    }
+}
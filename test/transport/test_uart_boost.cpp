@@ -224,6 +224,14 @@ TEST_CASE("open_close")
 
     REQUIRE(error == false);
 
+    // All queued data is written, in as many writes as were needed
+    sd_rpc_physical_layer_stats_t statsA;
+    REQUIRE(a->physicalLayerStats(&statsA) == NRF_SUCCESS);
+    REQUIRE(statsA.bytes_queued == sendOnA.size());
+    REQUIRE(statsA.bytes_written == sendOnA.size());
+    REQUIRE(statsA.bytes_pending == 0);
+    REQUIRE(statsA.write_count >= 1);
+
     b->close();
     a->close();
 
@@ -0,0 +1,304 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Logging support
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#if defined(__linux__)
+
+#include <uart_boost.h>
+#include <uart_linux.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+namespace {
+
+// The master side of a pseudo terminal, the transports under test open the slave side
+struct PseudoTerminal
+{
+    int master;
+    std::string slaveName;
+
+    PseudoTerminal()
+        : master(posix_openpt(O_RDWR | O_NOCTTY))
+    {
+        REQUIRE(master >= 0);
+        REQUIRE(grantpt(master) == 0);
+        REQUIRE(unlockpt(master) == 0);
+
+        termios tio;
+        REQUIRE(tcgetattr(master, &tio) == 0);
+        cfmakeraw(&tio);
+        REQUIRE(tcsetattr(master, TCSANOW, &tio) == 0);
+
+        slaveName = ptsname(master);
+    }
+
+    ~PseudoTerminal()
+    {
+        ::close(master);
+    }
+
+    std::vector<uint8_t> read(const size_t length) const
+    {
+        std::vector<uint8_t> data;
+        uint8_t buffer[256];
+
+        while (data.size() < length)
+        {
+            pollfd fd = {master, POLLIN, 0};
+
+            if (poll(&fd, 1, 1000) <= 0)
+            {
+                break;
+            }
+
+            const auto result = ::read(master, buffer, sizeof(buffer));
+
+            if (result <= 0)
+            {
+                break;
+            }
+
+            data.insert(data.end(), buffer, buffer + result);
+        }
+
+        return data;
+    }
+};
+
+UartCommunicationParameters settings(const std::string &portName)
+{
+    UartCommunicationParameters parameters = {};
+    parameters.portName                    = portName.c_str();
+    parameters.baudRate                    = 1000000;
+    parameters.flowControl                 = UartFlowControlNone;
+    parameters.parity                      = UartParityNone;
+    parameters.stopBits                    = UartStopBitsOne;
+    parameters.dataBits                    = UartDataBitsEight;
+    return parameters;
+}
+
+// Collects data received by a transport
+struct Receiver
+{
+    std::mutex mutex;
+    std::condition_variable received;
+    std::vector<uint8_t> data;
+
+    data_cb_t callback()
+    {
+        return [this](const uint8_t *buffer, const size_t length) {
+            std::lock_guard<std::mutex> lck(mutex);
+            data.insert(data.end(), buffer, buffer + length);
+            received.notify_all();
+        };
+    }
+
+    bool waitFor(const size_t length)
+    {
+        std::unique_lock<std::mutex> lck(mutex);
+        return received.wait_for(lck, std::chrono::seconds(1),
+                                 [&] { return data.size() >= length; });
+    }
+};
+
+const auto ignore_status = [](const sd_rpc_app_status_t, const std::string &) {};
+const auto log_message   = [](const sd_rpc_log_severity_t, const std::string &message) {
+    NRF_LOG(message);
+};
+
+} // namespace
+
+TEST_CASE("UartLinux")
+{
+    PseudoTerminal pty;
+    UartLinux uart(settings(pty.slaveName));
+    Receiver receiver;
+
+    REQUIRE(uart.open(ignore_status, receiver.callback(), log_message) == NRF_SUCCESS);
+    REQUIRE(uart.open(ignore_status, receiver.callback(), log_message) ==
+            NRF_ERROR_SD_RPC_SERIAL_PORT_ALREADY_OPEN);
+
+    SECTION("send")
+    {
+        const std::vector<uint8_t> header{0xC0, 0x01, 0x02};
+        const std::vector<uint8_t> payload(1000, 0x55);
+        const transport_segment_t segments[] = {{header.data(), header.size()},
+                                                {payload.data(), payload.size()}};
+
+        REQUIRE(uart.send(segments, 2) == NRF_SUCCESS);
+        REQUIRE(uart.send(header) == NRF_SUCCESS);
+
+        auto expected = header;
+        expected.insert(expected.end(), payload.begin(), payload.end());
+        expected.insert(expected.end(), header.begin(), header.end());
+
+        REQUIRE(pty.read(expected.size()) == expected);
+    }
+
+    SECTION("receive")
+    {
+        std::vector<uint8_t> expected(3000);
+
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            expected[i] = static_cast<uint8_t>(i);
+        }
+
+        REQUIRE(::write(pty.master, expected.data(), expected.size()) ==
+                static_cast<ssize_t>(expected.size()));
+
+        REQUIRE(receiver.waitFor(expected.size()));
+        REQUIRE(receiver.data == expected);
+    }
+
+    REQUIRE(uart.close() == NRF_SUCCESS);
+    REQUIRE(uart.close() == NRF_ERROR_SD_RPC_SERIAL_PORT_ALREADY_CLOSED);
+    REQUIRE(uart.send(std::vector<uint8_t>{0x00}) == NRF_ERROR_SD_RPC_SERIAL_PORT_STATE);
+}
+
+TEST_CASE("UartLinux_open_failure")
+{
+    UartLinux uart(settings("/dev/nonexistent_serial_port"));
+    Receiver receiver;
+    auto status = PKT_SEND_MAX_RETRIES_REACHED;
+
+    const auto status_callback = [&](const sd_rpc_app_status_t code, const std::string &) {
+        status = code;
+    };
+
+    REQUIRE(uart.open(status_callback, receiver.callback(), log_message) ==
+            NRF_ERROR_SD_RPC_SERIAL_PORT);
+    REQUIRE(status == IO_RESOURCES_UNAVAILABLE);
+}
+
+// Compares round trip latency of UartBoost and UartLinux over a pseudo terminal echoing all data.
+// Run with: test_uart_linux_v<N> [.benchmark]
+TEST_CASE("uart_latency_benchmark", "[.benchmark]")
+{
+    const auto iterations = 2000;
+    const std::vector<uint8_t> packet(16, 0xAA);
+
+    const auto measure = [&](Transport &uart, PseudoTerminal &pty) {
+        std::atomic<bool> running(true);
+
+        std::thread echo([&] {
+            uint8_t buffer[256];
+
+            while (running)
+            {
+                pollfd fd = {pty.master, POLLIN, 0};
+
+                if (poll(&fd, 1, 100) <= 0)
+                {
+                    continue;
+                }
+
+                const auto result = ::read(pty.master, buffer, sizeof(buffer));
+
+                if (result > 0 && ::write(pty.master, buffer, result) != result)
+                {
+                    break;
+                }
+            }
+        });
+
+        Receiver receiver;
+        REQUIRE(uart.open(ignore_status, receiver.callback(), log_message) == NRF_SUCCESS);
+
+        std::vector<double> latencies;
+
+        for (auto i = 1; i <= iterations; i++)
+        {
+            const auto begin = std::chrono::steady_clock::now();
+            REQUIRE(uart.send(packet) == NRF_SUCCESS);
+            REQUIRE(receiver.waitFor(i * packet.size()));
+
+            latencies.push_back(std::chrono::duration<double, std::micro>(
+                                    std::chrono::steady_clock::now() - begin)
+                                    .count());
+        }
+
+        uart.close();
+        running = false;
+        echo.join();
+
+        std::sort(latencies.begin(), latencies.end());
+        return latencies;
+    };
+
+    const auto report = [&](const std::string &name, const std::vector<double> &latencies) {
+        NRF_LOG(name << " round trip latency of " << packet.size() << " byte packets, median: "
+                     << latencies[latencies.size() / 2]
+                     << " us, p90: " << latencies[latencies.size() * 9 / 10]
+                     << " us, p99: " << latencies[latencies.size() * 99 / 100]
+                     << " us, max: " << latencies.back() << " us");
+    };
+
+    {
+        PseudoTerminal pty;
+        UartBoost uart(settings(pty.slaveName));
+        report("UartBoost", measure(uart, pty));
+    }
+
+    {
+        PseudoTerminal pty;
+        UartLinux uart(settings(pty.slaveName));
+        report("UartLinux", measure(uart, pty));
+    }
+}
+
+#endif // __linux__
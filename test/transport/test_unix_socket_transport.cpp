@@ -0,0 +1,221 @@
+/*
+ * Copyright (c) 2018 Nordic Semiconductor ASA
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ *   1. Redistributions of source code must retain the above copyright notice, this
+ *   list of conditions and the following disclaimer.
+ *
+ *   2. Redistributions in binary form must reproduce the above copyright notice, this
+ *   list of conditions and the following disclaimer in the documentation and/or
+ *   other materials provided with the distribution.
+ *
+ *   3. Neither the name of Nordic Semiconductor ASA nor the names of other
+ *   contributors to this software may be used to endorse or promote products
+ *   derived from this software without specific prior written permission.
+ *
+ *   4. This software must only be used in or with a processor manufactured by Nordic
+ *   Semiconductor ASA, or in or with a processor manufactured by a third party that
+ *   is used in combination with a processor manufactured by Nordic Semiconductor.
+ *
+ *   5. Any software provided in binary or object form under this license must not be
+ *   reverse engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND
+ * ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED
+ * WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR
+ * ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+// Logging support
+#define NRF_LOG_SETUP
+#include "internal/log.h"
+
+// Test framework
+#define CATCH_CONFIG_MAIN
+#include "catch2/catch.hpp"
+
+#if defined(__linux__)
+
+#include <sd_rpc.h>
+#include <transport.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+// A peer listening on a Unix domain socket in a temporary directory
+struct SocketPeer
+{
+    std::string directory;
+    std::string path;
+    int listener;
+    int connection;
+
+    SocketPeer()
+        : listener(socket(AF_UNIX, SOCK_STREAM, 0))
+        , connection(-1)
+    {
+        char directoryTemplate[] = "/tmp/ble-driver-test-XXXXXX";
+        REQUIRE(mkdtemp(directoryTemplate) != nullptr);
+        directory = directoryTemplate;
+        path      = directory + "/peer.sock";
+
+        sockaddr_un address = {};
+        address.sun_family  = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+
+        REQUIRE(listener >= 0);
+        REQUIRE(bind(listener, reinterpret_cast<sockaddr *>(&address), sizeof(address)) == 0);
+        REQUIRE(listen(listener, 1) == 0);
+    }
+
+    ~SocketPeer()
+    {
+        closeConnection();
+        ::close(listener);
+        unlink(path.c_str());
+        rmdir(directory.c_str());
+    }
+
+    void accept()
+    {
+        connection = ::accept(listener, nullptr, nullptr);
+        REQUIRE(connection >= 0);
+    }
+
+    void closeConnection()
+    {
+        if (connection >= 0)
+        {
+            ::close(connection);
+            connection = -1;
+        }
+    }
+
+    std::vector<uint8_t> read(const size_t length) const
+    {
+        std::vector<uint8_t> data;
+        uint8_t buffer[256];
+
+        while (data.size() < length)
+        {
+            pollfd fd = {connection, POLLIN, 0};
+
+            if (poll(&fd, 1, 1000) <= 0)
+            {
+                break;
+            }
+
+            const auto result = ::read(connection, buffer, sizeof(buffer));
+
+            if (result <= 0)
+            {
+                break;
+            }
+
+            data.insert(data.end(), buffer, buffer + result);
+        }
+
+        return data;
+    }
+};
+
+} // namespace
+
+TEST_CASE("UnixSocketTransport")
+{
+    SocketPeer peer;
+
+    const auto physicalLayer = sd_rpc_physical_layer_create_local(peer.path.c_str());
+    REQUIRE(physicalLayer != nullptr);
+
+    const auto transport = static_cast<Transport *>(physicalLayer->internal);
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<uint8_t> received;
+    auto status = PKT_SEND_MAX_RETRIES_REACHED;
+
+    const auto status_callback = [&](const sd_rpc_app_status_t code, const std::string &) {
+        std::lock_guard<std::mutex> lck(mutex);
+        status = code;
+        changed.notify_all();
+    };
+
+    const auto data_callback = [&](const uint8_t *data, const size_t length) {
+        std::lock_guard<std::mutex> lck(mutex);
+        received.insert(received.end(), data, data + length);
+        changed.notify_all();
+    };
+
+    const auto log_callback = [](const sd_rpc_log_severity_t, const std::string &message) {
+        NRF_LOG(message);
+    };
+
+    REQUIRE(transport->open(status_callback, data_callback, log_callback) == NRF_SUCCESS);
+    peer.accept();
+
+    SECTION("send")
+    {
+        const std::vector<uint8_t> header{0xC0, 0x01, 0x02};
+        const std::vector<uint8_t> payload(20000, 0x55);
+        const transport_segment_t segments[] = {{header.data(), header.size()},
+                                                {payload.data(), payload.size()}};
+
+        REQUIRE(transport->send(segments, 2) == NRF_SUCCESS);
+
+        auto expected = header;
+        expected.insert(expected.end(), payload.begin(), payload.end());
+
+        REQUIRE(peer.read(expected.size()) == expected);
+    }
+
+    SECTION("receive")
+    {
+        const std::vector<uint8_t> expected{0xC0, 0x10, 0x20, 0x30, 0xC0};
+        REQUIRE(::write(peer.connection, expected.data(), expected.size()) ==
+                static_cast<ssize_t>(expected.size()));
+
+        std::unique_lock<std::mutex> lck(mutex);
+        REQUIRE(changed.wait_for(lck, std::chrono::seconds(1),
+                                 [&] { return received.size() >= expected.size(); }));
+        REQUIRE(received == expected);
+    }
+
+    SECTION("peer_closed")
+    {
+        peer.closeConnection();
+
+        std::unique_lock<std::mutex> lck(mutex);
+        REQUIRE(changed.wait_for(lck, std::chrono::seconds(1),
+                                 [&] { return status == IO_RESOURCES_UNAVAILABLE; }));
+    }
+
+    REQUIRE(transport->close() == NRF_SUCCESS);
+
+    delete transport;
+    free(physicalLayer);
+}
+
+#endif // __linux__
@@ -0,0 +1,137 @@
+#pragma once
+
+#if defined(__linux__)
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+class H5Transport;
+
+/**
+ * @brief Simulator of the connectivity firmware, for running the driver end to end without
+ * hardware.
+ *
+ * The simulator listens on a Unix domain socket an adapter connects to with
+ * sd_rpc_physical_layer_create_local(). It speaks the H5 link layer and the serialization protocol,
+ * answers commands with a result code and generates events at configurable rates. A new
+ * connection is accepted each time the adapter is closed and opened again.
+ *
+ * Commands without output parameters are answered with NRF_SUCCESS, other commands with
+ * NRF_ERROR_NOT_SUPPORTED unless a result is set with setCommandResult(). Events are generated
+ * for SoftDevice API v5 and later.
+ */
+class ConnectivitySimulator
+{
+  public:
+    /**@brief Rate for sending events as fast as the link allows. */
+    static constexpr uint32_t Unlimited = UINT32_MAX;
+
+    explicit ConnectivitySimulator(const std::string &socketPath);
+    ~ConnectivitySimulator();
+
+    /**@brief Starts listening on the socket, the socket exists when this function returns. */
+    void start();
+    void stop();
+
+    const std::string &path() const;
+
+    /**@brief Sets the result code command opcode is answered with. */
+    void setCommandResult(const uint8_t opcode, const uint32_t result);
+
+    /**@brief Sends advertising reports while scanning, 0 disables them.
+     *
+     * With SoftDevice API v6 scanning pauses after each report until the application provides a
+     * new report buffer, as the SoftDevice does.
+     */
+    void setAdvertisingReportRate(const uint32_t perSecond, const uint8_t dataLength = 31);
+
+    /**@brief Sends notifications on the open connections, 0 disables them. */
+    void setNotificationRate(const uint32_t perSecond, const uint16_t length = 20);
+
+    /**@brief Connects and disconnects a peripheral connection, 0 disables it. */
+    void setConnectionChurnRate(const uint32_t perSecond);
+
+    /**@brief Holds back the responses to the commands received, they are answered in order when
+     * the responses are no longer held. */
+    void holdResponses(const bool hold);
+
+    /**@brief Waits until count commands wait for their responses, returns false on timeout. */
+    bool waitForHeldCommands(const size_t count, const std::chrono::milliseconds timeout);
+
+    uint64_t commandCount() const;
+    uint64_t eventCount() const;
+
+  private:
+    using clock = std::chrono::steady_clock;
+
+    // An event stream sending at a fixed interval
+    struct EventStream
+    {
+        bool enabled;
+        clock::duration interval;
+        clock::time_point due;
+
+        EventStream();
+        void setRate(const uint32_t perSecond);
+        void schedule(const clock::time_point now);
+    };
+
+    void serve();
+    void runSession();
+    void resetState();
+
+    void handleCommand(const std::vector<uint8_t> &command);
+    bool reportingAdvertisements() const;
+    void sendDueEvents(const clock::time_point now);
+    clock::time_point nextEventDue() const;
+
+    bool sendResponse(const uint8_t opcode, const uint32_t result);
+    bool sendEvent(const std::vector<uint8_t> &event);
+    bool sendAdvertisingReport();
+    bool sendConnected(const uint16_t connHandle, const uint8_t role);
+    bool sendDisconnected(const uint16_t connHandle, const uint8_t reason);
+    bool sendNotification(const uint16_t connHandle);
+
+    std::string socketPath;
+    int listenFd;
+
+    std::unique_ptr<H5Transport> h5;
+    std::thread serverThread;
+    std::atomic<bool> running;
+
+    // Protects the members below, commands are received on the H5 thread
+    mutable std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::vector<uint8_t>> commands;
+    bool linkLost;
+    bool responsesHeld;
+    std::map<uint8_t, uint32_t> commandResults;
+    EventStream advertisingReports;
+    EventStream notifications;
+    EventStream connectionChurn;
+    uint8_t advertisingDataLength;
+    uint16_t notificationLength;
+
+    // BLE state, only used by the simulator thread
+    bool scanning;
+    uint32_t scanBufferId;
+    uint16_t scanBufferLength;
+    std::vector<uint16_t> connections;
+    uint16_t nextConnHandle;
+    uint16_t churnConnHandle;
+    size_t nextNotificationConnection;
+
+    std::atomic<uint64_t> commandsReceived;
+    std::atomic<uint64_t> eventsSent;
+};
+
+#endif // __linux__
@@ -0,0 +1,96 @@
+#pragma once
+
+#if defined(__linux__) && NRF_SD_BLE_API >= 6
+
+#include "connectivity_simulator.h"
+
+#include "ble.h"
+#include "sd_rpc.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+
+/**
+ * @brief An adapter connected to a ConnectivitySimulator of its own, for running the driver end to
+ * end in a test.
+ *
+ * The simulator is started and the adapter created in the constructor, the adapter is closed and
+ * deleted and the simulator stopped in the destructor. The events the adapter receives are
+ * recorded, tests wait for them with waitFor instead of sleeping.
+ */
+class SimulatorAdapter
+{
+  public:
+    /**@brief Time waitFor waits for a condition. */
+    static constexpr std::chrono::seconds WaitTimeout{5};
+
+    /**@brief Events received by the adapter. */
+    struct Events
+    {
+        std::map<uint16_t, uint32_t> counts;
+        uint16_t lastConnHandle = BLE_CONN_HANDLE_INVALID;
+        uint16_t lastHvxLength  = 0;
+        uint32_t batches        = 0;
+        uint32_t largestBatch   = 0;
+        uint32_t dropped        = 0; // Events the transport logged as dropped
+
+        uint32_t count(const uint16_t eventId) const;
+        uint64_t total() const;
+    };
+
+    /**@brief Creates the adapter, on the shared runtime if runtime is not NULL. */
+    explicit SimulatorAdapter(const std::string &name, sd_rpc_runtime_t *runtime = nullptr);
+    ~SimulatorAdapter();
+
+    SimulatorAdapter(const SimulatorAdapter &) = delete;
+    SimulatorAdapter &operator=(const SimulatorAdapter &) = delete;
+
+    uint32_t open();
+    uint32_t openBatch(const sd_rpc_evt_batch_config_t *config);
+    uint32_t openPull();
+
+    /**@brief Connects to a peer as central, the simulator connects right away. */
+    uint32_t connect();
+
+    /**@brief Records an event, called for the events the adapter handles and the events a test
+     * pulls. */
+    void recordEvent(ble_evt_t *event);
+
+    /**@brief Waits until condition holds for the events received, returns false on timeout. */
+    bool waitFor(const std::function<bool(const Events &events)> &condition);
+
+    /**@brief Waits until count events of eventId are received, returns false on timeout. */
+    bool waitForEvents(const uint16_t eventId, const uint32_t count);
+
+    Events events();
+
+    ConnectivitySimulator simulator;
+    adapter_t *adapter;
+
+    /**@brief Called with each event before it is recorded, set before the adapter is opened. */
+    std::function<void(adapter_t *adapter, ble_evt_t *event)> onEvent;
+
+  private:
+    static SimulatorAdapter *find(adapter_t *adapter);
+
+    static void eventHandler(adapter_t *adapter, ble_evt_t *event);
+    static void eventBatchHandler(adapter_t *adapter, ble_evt_t **events, uint32_t count);
+    static void statusHandler(adapter_t *adapter, sd_rpc_app_status_t code, const char *message);
+    static void logHandler(adapter_t *adapter, sd_rpc_log_severity_t severity,
+                           const char *message);
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    Events received;
+
+    // Fixtures by internal adapter, handlers are not passed the adapter_t of the application
+    static std::mutex adaptersMutex;
+    static std::map<void *, SimulatorAdapter *> adapters;
+};
+
+#endif // __linux__ && NRF_SD_BLE_API >= 6
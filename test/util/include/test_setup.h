@@ -114,7 +114,9 @@ class VirtualTransportSendSync : public Transport
 class H5TransportWrapper : public H5Transport
 {
   public:
-    H5TransportWrapper(Transport *nextTransportLayer, uint32_t retransmission_interval) noexcept;
+    H5TransportWrapper(Transport *nextTransportLayer, uint32_t retransmission_interval,
+                       uint32_t ack_delay = 0,
+                       uint8_t sliding_window_size = SlidingWindowSizeMax) noexcept;
     ~H5TransportWrapper();
 
     void openThread(status_cb_t status_callback, data_cb_t data_callback, log_cb_t log_callback);
@@ -0,0 +1,765 @@
+#include "connectivity_simulator.h"
+
+#if defined(__linux__)
+
+#include "internal/log.h"
+
+#include "ble.h"
+#include "ble_hci.h"
+#include "fd_transport.h"
+#include "h5_transport.h"
+#include "nrf_error.h"
+#include "serialization_transport.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr uint32_t RetransmissionInterval = 250;
+
+// Size of the scan parameters in a SD_BLE_GAP_SCAN_START command
+constexpr size_t ScanParamsLength = 14;
+
+// Events are encoded for the structure layout of SoftDevice API v5 and later
+constexpr bool EventsSupported = NRF_SD_BLE_API >= 5;
+
+// Accepts one connection on a listening socket each time it is opened
+class AcceptingSocket : public FdTransport
+{
+  public:
+    AcceptingSocket(const int listenFd, const std::string &path)
+        : FdTransport(path)
+        , listenFd(listenFd)
+    {}
+
+  protected:
+    int openDescriptor() override
+    {
+        const auto socketFd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+
+        if (socketFd < 0)
+        {
+            throw std::system_error(std::error_code(errno, std::system_category()),
+                                    "Failed to accept connection");
+        }
+
+        return socketFd;
+    }
+
+    ssize_t writeDescriptor(const iovec *iov, const int count) override
+    {
+        msghdr message     = {};
+        message.msg_iov    = const_cast<iovec *>(iov);
+        message.msg_iovlen = static_cast<size_t>(count);
+        return sendmsg(fd, &message, MSG_NOSIGNAL);
+    }
+
+  private:
+    int listenFd;
+};
+
+// Appends fields in the little endian byte order of the serialization protocol
+struct Encoder
+{
+    std::vector<uint8_t> &buffer;
+
+    void u8(const uint8_t value)
+    {
+        buffer.push_back(value);
+    }
+
+    void u16(const uint16_t value)
+    {
+        u8(static_cast<uint8_t>(value));
+        u8(static_cast<uint8_t>(value >> 8));
+    }
+
+    void u32(const uint32_t value)
+    {
+        u16(static_cast<uint16_t>(value));
+        u16(static_cast<uint16_t>(value >> 16));
+    }
+
+    void bytes(const uint8_t value, const size_t count)
+    {
+        buffer.insert(buffer.end(), count, value);
+    }
+
+    void address(const uint8_t lastByte)
+    {
+        u8(BLE_GAP_ADDR_TYPE_RANDOM_STATIC << 1);
+        bytes(0xC0, BLE_GAP_ADDR_LEN - 1);
+        u8(lastByte);
+    }
+};
+
+uint16_t decode_u16(const std::vector<uint8_t> &data, const size_t index)
+{
+    return static_cast<uint16_t>(data.at(index) | (data.at(index + 1) << 8));
+}
+
+#if NRF_SD_BLE_API >= 6
+uint32_t decode_u32(const std::vector<uint8_t> &data, const size_t index)
+{
+    return decode_u16(data, index) | (static_cast<uint32_t>(decode_u16(data, index + 2)) << 16);
+}
+#endif
+
+// Result of commands whose response only contains the result code
+bool is_result_only(const uint8_t opcode)
+{
+    switch (opcode)
+    {
+        case SD_BLE_ENABLE:
+        case SD_BLE_OPT_SET:
+        case SD_BLE_GAP_ADV_START:
+        case SD_BLE_GAP_ADV_STOP:
+        case SD_BLE_GAP_SCAN_START:
+        case SD_BLE_GAP_SCAN_STOP:
+        case SD_BLE_GAP_CONNECT:
+        case SD_BLE_GAP_CONNECT_CANCEL:
+        case SD_BLE_GAP_DISCONNECT:
+        case SD_BLE_GAP_CONN_PARAM_UPDATE:
+        case SD_BLE_GAP_DEVICE_NAME_SET:
+        case SD_BLE_GAP_APPEARANCE_SET:
+        case SD_BLE_GAP_PPCP_SET:
+        case SD_BLE_GAP_TX_POWER_SET:
+        case SD_BLE_GATTC_PRIMARY_SERVICES_DISCOVER:
+        case SD_BLE_GATTC_CHARACTERISTICS_DISCOVER:
+        case SD_BLE_GATTC_DESCRIPTORS_DISCOVER:
+        case SD_BLE_GATTC_READ:
+        case SD_BLE_GATTC_WRITE:
+        case SD_BLE_GATTC_HV_CONFIRM:
+#if NRF_SD_BLE_API >= 5
+        case SD_BLE_CFG_SET:
+#endif
+            return true;
+        default:
+            return false;
+    }
+}
+
+} // namespace
+
+ConnectivitySimulator::EventStream::EventStream()
+    : enabled(false)
+    , interval(clock::duration::zero())
+    , due(clock::now())
+{}
+
+void ConnectivitySimulator::EventStream::setRate(const uint32_t perSecond)
+{
+    enabled  = perSecond > 0;
+    interval = perSecond == Unlimited || perSecond == 0
+                   ? clock::duration::zero()
+                   : std::chrono::duration_cast<clock::duration>(std::chrono::seconds(1)) /
+                         perSecond;
+    due = clock::now();
+}
+
+void ConnectivitySimulator::EventStream::schedule(const clock::time_point now)
+{
+    // Do not catch up with events missed while the stream was idle
+    due = std::max(due + interval, now - interval);
+}
+
+ConnectivitySimulator::ConnectivitySimulator(const std::string &socketPath)
+    : socketPath(socketPath)
+    , listenFd(-1)
+    , running(false)
+    , linkLost(false)
+    , responsesHeld(false)
+    , advertisingDataLength(31)
+    , notificationLength(20)
+    , scanning(false)
+    , scanBufferId(0)
+    , scanBufferLength(0)
+    , nextConnHandle(0)
+    , churnConnHandle(BLE_CONN_HANDLE_INVALID)
+    , nextNotificationConnection(0)
+    , commandsReceived(0)
+    , eventsSent(0)
+{}
+
+ConnectivitySimulator::~ConnectivitySimulator()
+{
+    stop();
+}
+
+void ConnectivitySimulator::start()
+{
+    if (running)
+    {
+        return;
+    }
+
+    sockaddr_un address = {};
+    address.sun_family  = AF_UNIX;
+
+    if (socketPath.size() >= sizeof(address.sun_path))
+    {
+        throw std::invalid_argument("Socket path too long: " + socketPath);
+    }
+
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size());
+    unlink(socketPath.c_str());
+
+    listenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+    if (listenFd < 0 ||
+        bind(listenFd, reinterpret_cast<const sockaddr *>(&address), sizeof(address)) < 0 ||
+        listen(listenFd, 1) < 0)
+    {
+        const auto error = errno;
+
+        if (listenFd >= 0)
+        {
+            close(listenFd);
+            listenFd = -1;
+        }
+
+        throw std::system_error(std::error_code(error, std::system_category()),
+                                "Failed to listen on " + socketPath);
+    }
+
+    running      = true;
+    serverThread = std::thread([this] { serve(); });
+}
+
+void ConnectivitySimulator::stop()
+{
+    if (!running)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        running = false;
+    }
+
+    // Wakes up a pending accept
+    shutdown(listenFd, SHUT_RDWR);
+    changed.notify_all();
+
+    if (serverThread.joinable())
+    {
+        serverThread.join();
+    }
+
+    close(listenFd);
+    listenFd = -1;
+    unlink(socketPath.c_str());
+}
+
+const std::string &ConnectivitySimulator::path() const
+{
+    return socketPath;
+}
+
+void ConnectivitySimulator::setCommandResult(const uint8_t opcode, const uint32_t result)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    commandResults[opcode] = result;
+}
+
+void ConnectivitySimulator::setAdvertisingReportRate(const uint32_t perSecond,
+                                                     const uint8_t dataLength)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    advertisingReports.setRate(perSecond);
+    advertisingDataLength = dataLength;
+    changed.notify_all();
+}
+
+void ConnectivitySimulator::setNotificationRate(const uint32_t perSecond, const uint16_t length)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    notifications.setRate(perSecond);
+    notificationLength = length;
+    changed.notify_all();
+}
+
+void ConnectivitySimulator::setConnectionChurnRate(const uint32_t perSecond)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    connectionChurn.setRate(perSecond);
+    changed.notify_all();
+}
+
+void ConnectivitySimulator::holdResponses(const bool hold)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    responsesHeld = hold;
+    changed.notify_all();
+}
+
+bool ConnectivitySimulator::waitForHeldCommands(const size_t count,
+                                                const std::chrono::milliseconds timeout)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return changed.wait_for(lock, timeout,
+                            [this, count] { return responsesHeld && commands.size() >= count; });
+}
+
+uint64_t ConnectivitySimulator::commandCount() const
+{
+    return commandsReceived;
+}
+
+uint64_t ConnectivitySimulator::eventCount() const
+{
+    return eventsSent;
+}
+
+void ConnectivitySimulator::serve()
+{
+    const auto status_callback = [this](const sd_rpc_app_status_t code, const std::string &) {
+        if (code == IO_RESOURCES_UNAVAILABLE || code == PKT_SEND_MAX_RETRIES_REACHED)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            linkLost = true;
+            changed.notify_all();
+        }
+    };
+
+    const auto data_callback = [this](const uint8_t *data, const size_t length) {
+        if (length < 2 || data[0] != SERIALIZATION_COMMAND)
+        {
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        commands.emplace_back(data + 1, data + length);
+        changed.notify_all();
+    };
+
+    const auto log_callback = [](const sd_rpc_log_severity_t severity, const std::string &message) {
+        if (severity >= SD_RPC_LOG_WARNING)
+        {
+            NRF_LOG("[simulator] " << message);
+        }
+    };
+
+    while (running)
+    {
+        // The link layer does not recover from a lost link, each session gets a new one
+        h5.reset(
+            new H5Transport(new AcceptingSocket(listenFd, socketPath), RetransmissionInterval));
+
+        // The adapter may close the link again before open returns
+        resetState();
+
+        // Blocks until an adapter connects and the link is established
+        if (h5->open(status_callback, data_callback, log_callback) == NRF_SUCCESS)
+        {
+            runSession();
+        }
+
+        h5->close();
+    }
+
+    h5.reset();
+}
+
+void ConnectivitySimulator::resetState()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        commands.clear();
+        linkLost = false;
+    }
+
+    scanning                   = false;
+    scanBufferId               = 0;
+    scanBufferLength           = 0;
+    nextConnHandle             = 0;
+    churnConnHandle            = BLE_CONN_HANDLE_INVALID;
+    nextNotificationConnection = 0;
+    connections.clear();
+}
+
+void ConnectivitySimulator::runSession()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+
+    while (running && !linkLost)
+    {
+        if (!commands.empty() && !responsesHeld)
+        {
+            const auto command = std::move(commands.front());
+            commands.pop_front();
+
+            lock.unlock();
+            handleCommand(command);
+            lock.lock();
+            continue;
+        }
+
+        const auto now = clock::now();
+        const auto due = nextEventDue();
+
+        if (due <= now)
+        {
+            lock.unlock();
+            sendDueEvents(now);
+            lock.lock();
+            continue;
+        }
+
+        if (due == clock::time_point::max())
+        {
+            changed.wait(lock);
+        }
+        else
+        {
+            changed.wait_until(lock, due);
+        }
+    }
+}
+
+ConnectivitySimulator::clock::time_point ConnectivitySimulator::nextEventDue() const
+{
+    auto due = clock::time_point::max();
+
+    if (!EventsSupported)
+    {
+        return due;
+    }
+
+    if (advertisingReports.enabled && reportingAdvertisements())
+    {
+        due = std::min(due, advertisingReports.due);
+    }
+
+    if (notifications.enabled && !connections.empty())
+    {
+        due = std::min(due, notifications.due);
+    }
+
+    if (connectionChurn.enabled)
+    {
+        due = std::min(due, connectionChurn.due);
+    }
+
+    return due;
+}
+
+// Scanning with SoftDevice API v6 is paused while the application has not provided a buffer for
+// the next report
+bool ConnectivitySimulator::reportingAdvertisements() const
+{
+    return scanning && (NRF_SD_BLE_API < 6 || scanBufferId != 0);
+}
+
+void ConnectivitySimulator::sendDueEvents(const clock::time_point now)
+{
+    bool advertisingReportDue;
+    bool notificationDue;
+    bool churnDue;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto due = [&](EventStream &stream) {
+            if (!stream.enabled || stream.due > now)
+            {
+                return false;
+            }
+
+            stream.schedule(now);
+            return true;
+        };
+
+        advertisingReportDue = reportingAdvertisements() && due(advertisingReports);
+        notificationDue      = !connections.empty() && due(notifications);
+        churnDue             = due(connectionChurn);
+    }
+
+    auto sent = true;
+
+    if (advertisingReportDue)
+    {
+        sent = sendAdvertisingReport();
+    }
+
+    if (sent && notificationDue)
+    {
+        const auto connection = nextNotificationConnection++ % connections.size();
+        sent                  = sendNotification(connections[connection]);
+    }
+
+    if (sent && churnDue)
+    {
+        if (churnConnHandle == BLE_CONN_HANDLE_INVALID)
+        {
+            churnConnHandle = nextConnHandle++;
+            connections.push_back(churnConnHandle);
+            sent = sendConnected(churnConnHandle, BLE_GAP_ROLE_PERIPH);
+        }
+        else
+        {
+            connections.erase(std::remove(connections.begin(), connections.end(), churnConnHandle),
+                              connections.end());
+            sent = sendDisconnected(churnConnHandle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+            churnConnHandle = BLE_CONN_HANDLE_INVALID;
+        }
+    }
+
+    if (!sent)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        linkLost = true;
+    }
+}
+
+void ConnectivitySimulator::handleCommand(const std::vector<uint8_t> &command)
+{
+    commandsReceived++;
+
+    const auto opcode = command[0];
+    auto result       = is_result_only(opcode) ? NRF_SUCCESS : NRF_ERROR_NOT_SUPPORTED;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        const auto commandResult = commandResults.find(opcode);
+
+        if (commandResult != commandResults.end())
+        {
+            result = commandResult->second;
+        }
+    }
+
+    uint16_t connHandle = BLE_CONN_HANDLE_INVALID;
+
+    if (opcode == SD_BLE_GAP_DISCONNECT && result == NRF_SUCCESS)
+    {
+        connHandle = decode_u16(command, 1);
+
+        if (std::find(connections.begin(), connections.end(), connHandle) == connections.end())
+        {
+            result = BLE_ERROR_INVALID_CONN_HANDLE;
+        }
+    }
+
+    auto sent = sendResponse(opcode, result);
+
+    if (result == NRF_SUCCESS)
+    {
+        switch (opcode)
+        {
+            case SD_BLE_GAP_SCAN_START:
+                scanning = true;
+#if NRF_SD_BLE_API >= 6
+                {
+                    // Parameters are only present when starting, not when resuming, scanning
+                    auto index = command[1] == 0 ? 2 : 2 + ScanParamsLength;
+
+                    if (command.at(index) != 0)
+                    {
+                        scanBufferId     = decode_u32(command, index + 1);
+                        scanBufferLength = decode_u16(command, index + 5);
+                    }
+                }
+#endif
+                break;
+            case SD_BLE_GAP_SCAN_STOP:
+                scanning = false;
+                break;
+            case SD_BLE_GAP_CONNECT:
+                scanning   = false;
+                connHandle = nextConnHandle++;
+                connections.push_back(connHandle);
+                sent = sent && sendConnected(connHandle, BLE_GAP_ROLE_CENTRAL);
+                break;
+            case SD_BLE_GAP_DISCONNECT:
+                connections.erase(std::remove(connections.begin(), connections.end(), connHandle),
+                                  connections.end());
+
+                if (connHandle == churnConnHandle)
+                {
+                    churnConnHandle = BLE_CONN_HANDLE_INVALID;
+                }
+
+                sent = sent && sendDisconnected(connHandle, BLE_HCI_LOCAL_HOST_TERMINATED_CONNECTION);
+                break;
+            default:
+                break;
+        }
+    }
+
+    if (!sent)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        linkLost = true;
+    }
+}
+
+bool ConnectivitySimulator::sendResponse(const uint8_t opcode, const uint32_t result)
+{
+    std::vector<uint8_t> response;
+    Encoder encoder{response};
+    encoder.u8(SERIALIZATION_RESPONSE);
+    encoder.u8(opcode);
+    encoder.u32(result);
+
+    return h5->send(response) == NRF_SUCCESS;
+}
+
+bool ConnectivitySimulator::sendEvent(const std::vector<uint8_t> &event)
+{
+    if (h5->send(event) != NRF_SUCCESS)
+    {
+        return false;
+    }
+
+    eventsSent++;
+    return true;
+}
+
+bool ConnectivitySimulator::sendAdvertisingReport()
+{
+#if NRF_SD_BLE_API >= 5
+    uint8_t dataLength;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        dataLength = advertisingDataLength;
+    }
+
+    std::vector<uint8_t> event;
+    Encoder encoder{event};
+    encoder.u8(SERIALIZATION_EVENT);
+    encoder.u16(BLE_GAP_EVT_ADV_REPORT);
+    encoder.u16(BLE_CONN_HANDLE_INVALID);
+#if NRF_SD_BLE_API >= 6
+    // The report is stored in the buffer provided when starting scanning
+    dataLength = static_cast<uint8_t>(std::min<uint16_t>(dataLength, scanBufferLength));
+
+    encoder.u16(0x0003); // Connectable and scannable, complete
+    encoder.address(static_cast<uint8_t>(eventsSent));
+    encoder.address(0);
+    encoder.u8(BLE_GAP_PHY_1MBPS);
+    encoder.u8(BLE_GAP_PHY_NOT_SET);
+    encoder.u8(static_cast<uint8_t>(BLE_GAP_POWER_LEVEL_INVALID));
+    encoder.u8(static_cast<uint8_t>(-60)); // RSSI
+    encoder.u8(37);                        // Channel index
+    encoder.u8(BLE_GAP_ADV_REPORT_SET_ID_NOT_AVAILABLE);
+    encoder.u16(0); // Data id
+    encoder.u32(scanBufferId);
+    encoder.u16(dataLength);
+    encoder.u8(1); // Data present
+    encoder.bytes(0xAD, dataLength);
+    encoder.u16(0); // Aux pointer offset
+    encoder.u8(0);  // Aux pointer PHY
+
+    // Scanning is paused until the application provides a new buffer
+    scanBufferId = 0;
+#else
+    dataLength = std::min<uint8_t>(dataLength, BLE_GAP_ADV_MAX_SIZE);
+
+    encoder.address(static_cast<uint8_t>(eventsSent));
+    encoder.address(0);
+    encoder.u8(static_cast<uint8_t>(-60)); // RSSI
+    encoder.u8(0);                         // Connectable undirected, not a scan response
+    encoder.u8(dataLength);
+    encoder.u8(1); // Data present
+    encoder.bytes(0xAD, dataLength);
+#endif
+
+    return sendEvent(event);
+#else
+    return true;
+#endif
+}
+
+bool ConnectivitySimulator::sendConnected(const uint16_t connHandle, const uint8_t role)
+{
+#if NRF_SD_BLE_API >= 5
+    std::vector<uint8_t> event;
+    Encoder encoder{event};
+    encoder.u8(SERIALIZATION_EVENT);
+    encoder.u16(BLE_GAP_EVT_CONNECTED);
+    encoder.u16(connHandle);
+    encoder.address(static_cast<uint8_t>(connHandle));
+    encoder.u8(role);
+    encoder.u16(BLE_GAP_CP_MIN_CONN_INTVL_MIN);
+    encoder.u16(BLE_GAP_CP_MIN_CONN_INTVL_MIN);
+    encoder.u16(0);   // Slave latency
+    encoder.u16(400); // Supervision timeout
+#if NRF_SD_BLE_API >= 6
+    encoder.u8(role == BLE_GAP_ROLE_PERIPH ? 0 : BLE_GAP_ADV_SET_HANDLE_NOT_SET);
+
+    // No advertising and scan response data buffers
+    for (auto i = 0; i < 2; i++)
+    {
+        encoder.u32(0);
+        encoder.u16(0);
+        encoder.u8(0);
+    }
+#endif
+
+    return sendEvent(event);
+#else
+    (void)connHandle;
+    (void)role;
+    return true;
+#endif
+}
+
+bool ConnectivitySimulator::sendDisconnected(const uint16_t connHandle, const uint8_t reason)
+{
+#if NRF_SD_BLE_API >= 5
+    std::vector<uint8_t> event;
+    Encoder encoder{event};
+    encoder.u8(SERIALIZATION_EVENT);
+    encoder.u16(BLE_GAP_EVT_DISCONNECTED);
+    encoder.u16(connHandle);
+    encoder.u8(reason);
+
+    return sendEvent(event);
+#else
+    (void)connHandle;
+    (void)reason;
+    return true;
+#endif
+}
+
+bool ConnectivitySimulator::sendNotification(const uint16_t connHandle)
+{
+#if NRF_SD_BLE_API >= 5
+    uint16_t length;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        length = notificationLength;
+    }
+
+    std::vector<uint8_t> event;
+    Encoder encoder{event};
+    encoder.u8(SERIALIZATION_EVENT);
+    encoder.u16(BLE_GATTC_EVT_HVX);
+    encoder.u16(connHandle);
+    encoder.u16(BLE_GATT_STATUS_SUCCESS);
+    encoder.u16(0); // Error handle
+    encoder.u16(0x000E);
+    encoder.u8(BLE_GATT_HVX_NOTIFICATION);
+    encoder.u16(length);
+    encoder.bytes(0x5A, length);
+
+    return sendEvent(event);
+#else
+    (void)connHandle;
+    return true;
+#endif
+}
+
+#endif // __linux__
@@ -0,0 +1,215 @@
+#include "simulator_adapter.h"
+
+#if defined(__linux__) && NRF_SD_BLE_API >= 6
+
+#include "internal/log.h"
+
+#include "nrf_error.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include <unistd.h>
+
+constexpr std::chrono::seconds SimulatorAdapter::WaitTimeout;
+
+std::mutex SimulatorAdapter::adaptersMutex;
+std::map<void *, SimulatorAdapter *> SimulatorAdapter::adapters;
+
+namespace {
+adapter_t *create_adapter(const std::string &path, sd_rpc_runtime_t *runtime)
+{
+    const auto phy             = sd_rpc_physical_layer_create_local(path.c_str());
+    const auto data_link_layer = sd_rpc_data_link_layer_create_bt_three_wire(phy, 250);
+    const auto transport_layer = sd_rpc_transport_layer_create(data_link_layer, 1000);
+
+    if (runtime != nullptr)
+    {
+        return sd_rpc_adapter_create_with_runtime(transport_layer, runtime);
+    }
+
+    return sd_rpc_adapter_create(transport_layer);
+}
+} // namespace
+
+uint32_t SimulatorAdapter::Events::count(const uint16_t eventId) const
+{
+    const auto eventCount = counts.find(eventId);
+    return eventCount == counts.end() ? 0 : eventCount->second;
+}
+
+uint64_t SimulatorAdapter::Events::total() const
+{
+    uint64_t eventCount = 0;
+
+    for (const auto &count : counts)
+    {
+        eventCount += count.second;
+    }
+
+    return eventCount;
+}
+
+SimulatorAdapter::SimulatorAdapter(const std::string &name, sd_rpc_runtime_t *runtime)
+    : simulator("/tmp/ble-driver-simulator-" + std::to_string(getpid()) + "-" + name)
+    , adapter(nullptr)
+{
+    simulator.start();
+    adapter = create_adapter(simulator.path(), runtime);
+
+    if (adapter != nullptr)
+    {
+        std::lock_guard<std::mutex> lock(adaptersMutex);
+        adapters[adapter->internal] = this;
+    }
+}
+
+SimulatorAdapter::~SimulatorAdapter()
+{
+    if (adapter != nullptr)
+    {
+        // The handlers are not called after the adapter is closed
+        sd_rpc_close(adapter);
+
+        {
+            std::lock_guard<std::mutex> lock(adaptersMutex);
+            adapters.erase(adapter->internal);
+        }
+
+        sd_rpc_adapter_delete(adapter);
+    }
+
+    simulator.stop();
+}
+
+uint32_t SimulatorAdapter::open()
+{
+    return sd_rpc_open(adapter, statusHandler, eventHandler, logHandler);
+}
+
+uint32_t SimulatorAdapter::openBatch(const sd_rpc_evt_batch_config_t *config)
+{
+    return sd_rpc_open_batch(adapter, statusHandler, eventBatchHandler, logHandler, config);
+}
+
+uint32_t SimulatorAdapter::openPull()
+{
+    return sd_rpc_open_pull(adapter, statusHandler, logHandler);
+}
+
+uint32_t SimulatorAdapter::connect()
+{
+    ble_gap_addr_t peer          = {};
+    ble_gap_scan_params_t scan   = {};
+    ble_gap_conn_params_t params = {};
+    scan.interval                = 0x00A0;
+    scan.window                  = 0x0050;
+    scan.scan_phys               = BLE_GAP_PHY_1MBPS;
+    params.min_conn_interval     = BLE_GAP_CP_MIN_CONN_INTVL_MIN;
+    params.max_conn_interval     = BLE_GAP_CP_MIN_CONN_INTVL_MIN;
+    params.conn_sup_timeout      = 400;
+
+    return sd_ble_gap_connect(adapter, &peer, &scan, &params, BLE_CONN_CFG_TAG_DEFAULT);
+}
+
+void SimulatorAdapter::recordEvent(ble_evt_t *event)
+{
+    if (onEvent)
+    {
+        onEvent(adapter, event);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    received.counts[event->header.evt_id]++;
+
+    if (event->header.evt_id >= BLE_GAP_EVT_BASE && event->header.evt_id <= BLE_GAP_EVT_LAST)
+    {
+        received.lastConnHandle = event->evt.gap_evt.conn_handle;
+    }
+    else if (event->header.evt_id == BLE_GATTC_EVT_HVX)
+    {
+        received.lastHvxLength = event->evt.gattc_evt.params.hvx.len;
+    }
+
+    changed.notify_all();
+}
+
+bool SimulatorAdapter::waitFor(const std::function<bool(const Events &events)> &condition)
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    return changed.wait_for(lock, WaitTimeout, [&] { return condition(received); });
+}
+
+bool SimulatorAdapter::waitForEvents(const uint16_t eventId, const uint32_t count)
+{
+    return waitFor([&](const Events &events) { return events.count(eventId) >= count; });
+}
+
+SimulatorAdapter::Events SimulatorAdapter::events()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return received;
+}
+
+SimulatorAdapter *SimulatorAdapter::find(adapter_t *adapter)
+{
+    std::lock_guard<std::mutex> lock(adaptersMutex);
+    const auto fixture = adapters.find(adapter->internal);
+    return fixture == adapters.end() ? nullptr : fixture->second;
+}
+
+void SimulatorAdapter::eventHandler(adapter_t *adapter, ble_evt_t *event)
+{
+    const auto fixture = find(adapter);
+
+    if (fixture != nullptr)
+    {
+        fixture->recordEvent(event);
+    }
+}
+
+void SimulatorAdapter::eventBatchHandler(adapter_t *adapter, ble_evt_t **events, uint32_t count)
+{
+    const auto fixture = find(adapter);
+
+    if (fixture == nullptr)
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(fixture->mutex);
+        fixture->received.batches++;
+        fixture->received.largestBatch = std::max(fixture->received.largestBatch, count);
+    }
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        fixture->recordEvent(events[i]);
+    }
+}
+
+void SimulatorAdapter::statusHandler(adapter_t *, sd_rpc_app_status_t, const char *) {}
+
+void SimulatorAdapter::logHandler(adapter_t *adapter, sd_rpc_log_severity_t severity,
+                                  const char *message)
+{
+    NRF_LOG(message);
+
+    // The transport logs each event it drops because the event queue is full
+    if (severity != SD_RPC_LOG_WARNING || std::strstr(message, "event dropped") == nullptr)
+    {
+        return;
+    }
+
+    const auto fixture = find(adapter);
+
+    if (fixture != nullptr)
+    {
+        std::lock_guard<std::mutex> lock(fixture->mutex);
+        fixture->received.dropped++;
+        fixture->changed.notify_all();
+    }
+}
+
+#endif // __linux__ && NRF_SD_BLE_API >= 6
@@ -178,14 +178,21 @@ uint32_t VirtualTransportSendSync::send(const std::vector<uint8_t> &data)
 // we need to run open in separate threads to
 // make the two H5Transports communicate
 H5TransportWrapper::H5TransportWrapper(Transport *nextTransportLayer,
-                                       uint32_t retransmission_interval) noexcept
-    : H5Transport(nextTransportLayer, retransmission_interval)
+                                       uint32_t retransmission_interval,
+                                       uint32_t ack_delay,
+                                       uint8_t sliding_window_size) noexcept
+    : H5Transport(nextTransportLayer, retransmission_interval, sliding_window_size, ack_delay)
     , isOpenDone(false)
     , result(-1)
 {}
 
 H5TransportWrapper::~H5TransportWrapper()
 {
+    if (h5Thread.joinable())
+    {
+        h5Thread.join();
+    }
+
     H5Transport::close();
 }
 
@@ -43,7 +43,14 @@ uint32_t VirtualUart::open(const status_cb_t &status_callback, const data_cb_t &
 
             if (outData.size() > 0)
             {
-                std::for_each(outData.begin(), outData.end(), [&](std::vector<uint8_t> data) {
+                // Deliver data without holding the lock, peer may send data back to us while
+                // processing it
+                std::vector<std::vector<uint8_t>> pendingData;
+                pendingData.swap(outData);
+                lock.unlock();
+
+                for (const auto &data : pendingData)
+                {
                     // TODO: do a proper SLIP decoding later on in case header hits SLIP encoding
                     // rules
                     if (H5Transport::isResetPacket(data, 2))
@@ -71,8 +78,9 @@ uint32_t VirtualUart::open(const status_cb_t &status_callback, const data_cb_t &
                                         << "error sending " << e.what());
                         }
                     }
-                });
-                outData.erase(outData.begin(), outData.end());
+                }
+
+                lock.lock();
             }
 
             outDataAvailable.wait(lock, [&] {
@@ -88,7 +96,12 @@ uint32_t VirtualUart::open(const status_cb_t &status_callback, const data_cb_t &
 
             if (inData.size() > 0)
             {
-                std::for_each(inData.begin(), inData.end(), [&](std::vector<uint8_t> data) {
+                std::vector<std::vector<uint8_t>> pendingData;
+                pendingData.swap(inData);
+                lock.unlock();
+
+                for (const auto &data : pendingData)
+                {
                     // TODO: do a proper SLIP decoding later on in case 
                     // TODO: header hits SLIP encoding rules
 
@@ -139,8 +152,9 @@ uint32_t VirtualUart::open(const status_cb_t &status_callback, const data_cb_t &
                                         << "] error calling data callback: " << e.what());
                         }
                     }
-                });
-                inData.erase(inData.begin(), inData.end());
+                }
+
+                lock.lock();
             }
 
             inDataAvailable.wait(lock, [&] { return !(isOpen == true && inData.size() == 0); });